@@ -62,10 +62,18 @@ namespace itk
  *               Requires the same order of Spline for each dimension.
  *               Can only process LargestPossibleRegion
  *
+ * The lines along each dimension are independent, so for each dimension they
+ * are split over the threads.  Adjacent lines are filtered together so that
+ * the recursions run over contiguous memory.
+ *
+ * The coefficients can be written into a buffer provided by the caller (see
+ * SetCoefficientsBuffer()).  If that buffer is also the buffer of the input
+ * image, the input is overwritten by the coefficients.
+ *
  * \sa itkBSplineInterpolateImageFunction
  *
  * \ingroup ImageFilters
- * \ingroup SingleThreaded
+ * \ingroup MultiThreaded
  * \ingroup CannotBeStreamed
  * \ingroup ITKImageFunction
  */
@@ -92,6 +100,8 @@ public:
   typedef typename Superclass::InputImageConstPointer InputImageConstPointer;
   typedef typename Superclass::OutputImagePointer     OutputImagePointer;
 
+  typedef typename TOutputImage::PixelType OutputPixelType;
+
   typedef typename itk::NumericTraits< typename TOutputImage::PixelType >::RealType CoeffType;
 
   /** Dimension underlying input image. */
@@ -108,6 +118,14 @@ public:
 
   itkGetConstMacro(SplineOrder, int);
 
+  /** Set/Get a buffer, owned by the caller, into which the coefficients are
+   * written instead of into memory allocated by the filter.  It must hold the
+   * whole output image.  It is not released by the filter.  Set to NULL to
+   * let the filter allocate the output (default). */
+  void SetCoefficientsBuffer(OutputPixelType *buffer);
+
+  itkGetConstMacro(CoefficientsBuffer, OutputPixelType *);
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro( DimensionCheck,
@@ -132,9 +150,9 @@ protected:
   /** This filter must produce all of its output at once. */
   void EnlargeOutputRequestedRegion(DataObject *output);
 
-  /** These are needed by the smoothing spline routine. */
-  std::vector< CoeffType >           m_Scratch;   // temp storage for processing
-                                                  // of Coefficients
+  /** Number of adjacent lines filtered together. */
+  itkStaticConstMacro(LinesPerBatch, unsigned int, 8);
+
   typename TInputImage::SizeType m_DataLength;    // Image size
 
   unsigned int m_SplineOrder;                // User specified spline order (3rd
@@ -145,8 +163,8 @@ protected:
 
   double m_Tolerance;                        // Tolerance used for determining
                                              // initial causal coefficient
-  unsigned int m_IteratorDirection;          // Direction for iterator
-                                             // incrementing
+
+  OutputPixelType *m_CoefficientsBuffer;     // Caller provided output buffer
 private:
   BSplineDecompositionImageFilter(const Self &); //purposely not implemented
   void operator=(const Self &);                  //purposely not implemented
@@ -154,29 +172,42 @@ private:
   /** Determines the poles given the Spline Order. */
   virtual void SetPoles();
 
-  /** Converts a vector of data to a vector of Spline coefficients. */
-  virtual bool DataToCoefficients1D();
+  /** Converts a batch of interleaved vectors of data to vectors of Spline
+   * coefficients.  Sample n of line b is scratch[n * batch + b]. */
+  virtual bool DataToCoefficients1D(CoeffType *scratch, SizeValueType length,
+                                    unsigned int batch) const;
 
   /** Converts an N-dimension image of data to an equivalent sized image
    *    of spline coefficients. */
   void DataToCoefficientsND();
 
+  /** Converts the lines along one direction starting in the given region. If
+   * readInput is set, the data are read from the input instead of the output. */
+  void ThreadedDataToCoefficients(unsigned int direction,
+                                  const typename TOutputImage::RegionType & lineRegion,
+                                  bool readInput);
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE DataToCoefficientsThreaderCallback(void *arg);
+
+  struct DataToCoefficientsThreadStruct {
+    BSplineDecompositionImageFilter *Filter;
+    unsigned int Direction;
+    bool ReadInput;
+    typename TOutputImage::RegionType LineRegion;
+  };
+
   /** Determines the first coefficient for the causal filtering of the data. */
-  virtual void SetInitialCausalCoefficient(double z);
+  virtual void SetInitialCausalCoefficient(double z, CoeffType *scratch,
+                                           SizeValueType length, unsigned int batch) const;
 
   /** Determines the first coefficient for the anti-causal filtering of the
     data. */
-  virtual void SetInitialAntiCausalCoefficient(double z);
+  virtual void SetInitialAntiCausalCoefficient(double z, CoeffType *scratch,
+                                               SizeValueType length, unsigned int batch) const;
 
   /** Used to initialize the Coefficients image before calculation. */
   void CopyImageToImage();
-
-  /** Copies a vector of data from the Coefficients image to the m_Scratch
-    vector. */
-  void CopyCoefficientsToScratch(OutputLinearIterator &);
-
-  /** Copies a vector of data from m_Scratch to the Coefficients image. */
-  void CopyScratchToCoefficients(OutputLinearIterator &);
 };
 } // namespace itk
 
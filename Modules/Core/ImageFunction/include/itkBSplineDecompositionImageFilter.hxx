@@ -30,6 +30,7 @@
 #include "itkBSplineDecompositionImageFilter.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkImageRegionIterator.h"
+#include "itkImageRegionSplitter.h"
 #include "itkProgressReporter.h"
 #include "itkVector.h"
 
@@ -45,7 +46,7 @@ BSplineDecompositionImageFilter< TInputImage, TOutputImage >
   m_SplineOrder = 0;
   int SplineOrder = 3;
   m_Tolerance = 1e-10;   // Need some guidance on this one...what is reasonable?
-  m_IteratorDirection = 0;
+  m_CoefficientsBuffer = NULL;
   this->SetSplineOrder(SplineOrder);
 }
 
@@ -61,19 +62,20 @@ BSplineDecompositionImageFilter< TInputImage, TOutputImage >
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "Spline Order: " << m_SplineOrder << std::endl;
+  os << indent << "Coefficients Buffer: " << m_CoefficientsBuffer << std::endl;
 }
 
 template< class TInputImage, class TOutputImage >
 bool
 BSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::DataToCoefficients1D()
+::DataToCoefficients1D(CoeffType *scratch, SizeValueType length, unsigned int batch) const
 {
   // See Unser, 1993, Part II, Equation 2.5,
   //   or Unser, 1999, Box 2. for an explanation.
 
   double c0 = 1.0;
 
-  if ( m_DataLength[m_IteratorDirection] == 1 ) //Required by mirror boundaries
+  if ( length == 1 ) //Required by mirror boundaries
     {
     return false;
     }
@@ -86,28 +88,38 @@ BSplineDecompositionImageFilter< TInputImage, TOutputImage >
     }
 
   // apply the gain
-  for ( unsigned int n = 0; n < m_DataLength[m_IteratorDirection]; n++ )
+  for ( SizeValueType n = 0; n < length * batch; n++ )
     {
-    m_Scratch[n] *= c0;
+    scratch[n] *= c0;
     }
 
   // loop over all poles
   for ( int k = 0; k < m_NumberOfPoles; k++ )
     {
     // causal initialization
-    this->SetInitialCausalCoefficient(m_SplinePoles[k]);
+    this->SetInitialCausalCoefficient(m_SplinePoles[k], scratch, length, batch);
     // causal recursion
-    for ( unsigned int n = 1; n < m_DataLength[m_IteratorDirection]; n++ )
+    for ( SizeValueType n = 1; n < length; n++ )
       {
-      m_Scratch[n] += m_SplinePoles[k] * m_Scratch[n - 1];
+      CoeffType *      current = scratch + n * batch;
+      const CoeffType *previous = current - batch;
+      for ( unsigned int b = 0; b < batch; b++ )
+        {
+        current[b] += m_SplinePoles[k] * previous[b];
+        }
       }
 
     // anticausal initialization
-    this->SetInitialAntiCausalCoefficient(m_SplinePoles[k]);
+    this->SetInitialAntiCausalCoefficient(m_SplinePoles[k], scratch, length, batch);
     // anticausal recursion
-    for ( int n = m_DataLength[m_IteratorDirection] - 2; 0 <= n; n-- )
+    for ( OffsetValueType n = static_cast< OffsetValueType >( length ) - 2; 0 <= n; n-- )
       {
-      m_Scratch[n] = m_SplinePoles[k] * ( m_Scratch[n + 1] - m_Scratch[n] );
+      CoeffType *      current = scratch + n * batch;
+      const CoeffType *next = current + batch;
+      for ( unsigned int b = 0; b < batch; b++ )
+        {
+        current[b] = m_SplinePoles[k] * ( next[b] - current[b] );
+        }
       }
     }
   return true;
@@ -177,61 +189,79 @@ BSplineDecompositionImageFilter< TInputImage, TOutputImage >
 template< class TInputImage, class TOutputImage >
 void
 BSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::SetInitialCausalCoefficient(double z)
+::SetInitialCausalCoefficient(double z, CoeffType *scratch, SizeValueType length,
+                              unsigned int batch) const
 {
   /* beginning InitialCausalCoefficient */
   /* See Unser, 1999, Box 2 for explanation */
-  CoeffType     sum;
+  /* The sums are accumulated in the first sample of each line. */
   double        zn, z2n, iz;
   typename TInputImage::SizeValueType horizon;
 
   /* this initialization corresponds to mirror boundaries */
-  horizon = m_DataLength[m_IteratorDirection];
+  horizon = length;
   zn = z;
   if ( m_Tolerance > 0.0 )
     {
     horizon = (typename TInputImage::SizeValueType)
       vcl_ceil( vcl_log(m_Tolerance) / vcl_log( vcl_fabs(z) ) );
     }
-  if ( horizon < m_DataLength[m_IteratorDirection] )
+  if ( horizon < length )
     {
     /* accelerated loop */
-    sum = m_Scratch[0];   // verify this
-    for ( unsigned int n = 1; n < horizon; n++ )
+    for ( SizeValueType n = 1; n < horizon; n++ )
       {
-      sum += zn * m_Scratch[n];
+      const CoeffType *current = scratch + n * batch;
+      for ( unsigned int b = 0; b < batch; b++ )
+        {
+        scratch[b] += zn * current[b];
+        }
       zn *= z;
       }
-    m_Scratch[0] = sum;
     }
   else
     {
     /* full loop */
     iz = 1.0 / z;
-    z2n = vcl_pow( z, (double)( m_DataLength[m_IteratorDirection] - 1L ) );
-    sum = m_Scratch[0] + z2n * m_Scratch[m_DataLength[m_IteratorDirection] - 1L];
+    z2n = vcl_pow( z, (double)( length - 1L ) );
+    const CoeffType *last = scratch + ( length - 1 ) * batch;
+    for ( unsigned int b = 0; b < batch; b++ )
+      {
+      scratch[b] = scratch[b] + z2n * last[b];
+      }
     z2n *= z2n * iz;
-    for ( unsigned int n = 1; n <= ( m_DataLength[m_IteratorDirection] - 2 ); n++ )
+    for ( SizeValueType n = 1; n <= ( length - 2 ); n++ )
       {
-      sum += ( zn + z2n ) * m_Scratch[n];
+      const CoeffType *current = scratch + n * batch;
+      for ( unsigned int b = 0; b < batch; b++ )
+        {
+        scratch[b] += ( zn + z2n ) * current[b];
+        }
       zn *= z;
       z2n *= iz;
       }
-    m_Scratch[0] = sum / ( 1.0 - zn * zn );
+    for ( unsigned int b = 0; b < batch; b++ )
+      {
+      scratch[b] = scratch[b] / ( 1.0 - zn * zn );
+      }
     }
 }
 
 template< class TInputImage, class TOutputImage >
 void
 BSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::SetInitialAntiCausalCoefficient(double z)
+::SetInitialAntiCausalCoefficient(double z, CoeffType *scratch, SizeValueType length,
+                                  unsigned int batch) const
 {
   // this initialization corresponds to mirror boundaries
   /* See Unser, 1999, Box 2 for explanation */
   //  Also see erratum at http://bigwww.epfl.ch/publications/unser9902.html
-  m_Scratch[m_DataLength[m_IteratorDirection] - 1] =
-    ( z / ( z * z - 1.0 ) )
-    * ( z * m_Scratch[m_DataLength[m_IteratorDirection] - 2] + m_Scratch[m_DataLength[m_IteratorDirection] - 1] );
+  CoeffType *      last = scratch + ( length - 1 ) * batch;
+  const CoeffType *previous = scratch + ( length - 2 ) * batch;
+  for ( unsigned int b = 0; b < batch; b++ )
+    {
+    last[b] = ( z / ( z * z - 1.0 ) ) * ( z * previous[b] + last[b] );
+    }
 }
 
 template< class TInputImage, class TOutputImage >
@@ -241,101 +271,174 @@ BSplineDecompositionImageFilter< TInputImage, TOutputImage >
 {
   OutputImagePointer output = this->GetOutput();
 
-  Size< ImageDimension > size = output->GetBufferedRegion().GetSize();
-
-  unsigned int count = output->GetBufferedRegion().GetNumberOfPixels() / size[0] * ImageDimension;
-
-  ProgressReporter progress(this, 0, count, 10);
-
-  // Initialize coeffient array
-  this->CopyImageToImage();   // Coefficients are initialized to the input data
+  // The first pass reads the input directly when it is buffered like the
+  // output; otherwise the input is copied into the output first.
+  bool readInput = ( this->GetInput()->GetBufferedRegion() == output->GetBufferedRegion() );
+  if ( !readInput )
+    {
+    this->CopyImageToImage();   // Coefficients are initialized to the input data
+    }
 
   for ( unsigned int n = 0; n < ImageDimension; n++ )
     {
-    m_IteratorDirection = n;
     // Loop through each dimension
 
-    // Initialize iterators
-    OutputLinearIterator CIterator( output, output->GetBufferedRegion() );
-    CIterator.SetDirection(m_IteratorDirection);
-    // For each data vector
-    while ( !CIterator.IsAtEnd() )
-      {
-      // Copy coefficients to scratch
-      this->CopyCoefficientsToScratch(CIterator);
-
-      // Perform 1D BSpline calculations
-      this->DataToCoefficients1D();
-
-      // Copy scratch back to coefficients.
-      // Brings us back to the end of the line we were working on.
-      CIterator.GoToBeginOfLine();
-      this->CopyScratchToCoefficients(CIterator);   // m_Scratch = m_Image;
-      CIterator.NextLine();
-      progress.CompletedPixel();
-      }
+    // The start of each line along the direction
+    typename TOutputImage::RegionType lineRegion = output->GetBufferedRegion();
+    typename TOutputImage::SizeType   lineRegionSize = lineRegion.GetSize();
+    lineRegionSize[n] = 1;
+    lineRegion.SetSize(lineRegionSize);
+
+    DataToCoefficientsThreadStruct str;
+    str.Filter = this;
+    str.Direction = n;
+    str.ReadInput = readInput;
+    str.LineRegion = lineRegion;
+
+    this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+    this->GetMultiThreader()->SetSingleMethod(this->DataToCoefficientsThreaderCallback, &str);
+    this->GetMultiThreader()->SingleMethodExecute();
+
+    readInput = false;
+    this->UpdateProgress( static_cast< float >( n + 1 ) / static_cast< float >( ImageDimension ) );
     }
 }
 
-/**
- * Copy the input image into the output image
- */
 template< class TInputImage, class TOutputImage >
-void
+ITK_THREAD_RETURN_TYPE
 BSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::CopyImageToImage()
+::DataToCoefficientsThreaderCallback(void *arg)
 {
-  typedef ImageRegionConstIteratorWithIndex< TInputImage > InputIterator;
-  typedef ImageRegionIterator< TOutputImage >              OutputIterator;
-  typedef typename TOutputImage::PixelType                 OutputPixelType;
+  ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+  ThreadIdType threadCount = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->NumberOfThreads;
 
-  InputIterator  inIt( this->GetInput(), this->GetInput()->GetBufferedRegion() );
-  OutputIterator outIt( this->GetOutput(), this->GetOutput()->GetBufferedRegion() );
+  DataToCoefficientsThreadStruct *str = (DataToCoefficientsThreadStruct *)
+    ( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
 
-  inIt = inIt.Begin();
-  outIt = outIt.Begin();
+  typedef ImageRegionSplitter< ImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
 
-  while ( !outIt.IsAtEnd() )
+  ThreadIdType total = splitter->GetNumberOfSplits(str->LineRegion, threadCount);
+  if ( threadId < total )
     {
-    outIt.Set( static_cast< OutputPixelType >( inIt.Get() ) );
-    ++inIt;
-    ++outIt;
+    str->Filter->ThreadedDataToCoefficients( str->Direction,
+                                             splitter->GetSplit(threadId, total, str->LineRegion),
+                                             str->ReadInput );
     }
+
+  return ITK_THREAD_RETURN_VALUE;
 }
 
-/**
- * Copy the scratch to one line of the output image
- */
 template< class TInputImage, class TOutputImage >
 void
 BSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::CopyScratchToCoefficients(OutputLinearIterator & Iter)
+::ThreadedDataToCoefficients(unsigned int direction,
+                             const typename TOutputImage::RegionType & lineRegion,
+                             bool readInput)
 {
-  typedef typename TOutputImage::PixelType OutputPixelType;
-  typename TOutputImage::SizeValueType j = 0;
-  while ( !Iter.IsAtEndOfLine() )
+  typedef typename TInputImage::PixelType   InputPixelType;
+  typedef typename TOutputImage::IndexType  IndexType;
+
+  TOutputImage *          output = this->GetOutput();
+  OutputPixelType *       outputBuffer = output->GetBufferPointer();
+  const InputPixelType *  inputBuffer = this->GetInput()->GetBufferPointer();
+  const OffsetValueType * offsetTable = output->GetOffsetTable();
+
+  const SizeValueType length = m_DataLength[direction];
+  const OffsetValueType lineStride = offsetTable[direction];
+
+  // Lines adjacent along the batch dimension are filtered together.
+  const unsigned int batchDimension = ( direction == 0 && ImageDimension > 1 ) ? 1 : 0;
+  const OffsetValueType batchStride = offsetTable[batchDimension];
+
+  std::vector< CoeffType > scratch(length * LinesPerBatch);
+
+  const IndexType start = lineRegion.GetIndex();
+  IndexType       end;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
     {
-    Iter.Set( static_cast< OutputPixelType >( m_Scratch[j] ) );
-    ++Iter;
-    ++j;
+    end[d] = start[d] + static_cast< IndexValueType >( lineRegion.GetSize()[d] );
+    }
+  if ( lineRegion.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  IndexType index = start;
+  bool      done = false;
+  while ( !done )
+    {
+    const unsigned int batch = static_cast< unsigned int >(
+      vnl_math_min( static_cast< IndexValueType >( LinesPerBatch ),
+                    end[batchDimension] - index[batchDimension] ) );
+    const OffsetValueType lineOffset = output->ComputeOffset(index);
+
+    // Copy the lines to scratch
+    for ( unsigned int b = 0; b < batch; b++ )
+      {
+      OffsetValueType offset = lineOffset + b * batchStride;
+      for ( SizeValueType j = 0; j < length; j++, offset += lineStride )
+        {
+        if ( readInput )
+          {
+          scratch[j * batch + b] =
+            static_cast< CoeffType >( static_cast< OutputPixelType >( inputBuffer[offset] ) );
+          }
+        else
+          {
+          scratch[j * batch + b] = static_cast< CoeffType >( outputBuffer[offset] );
+          }
+        }
+      }
+
+    // Perform 1D BSpline calculations
+    this->DataToCoefficients1D(&scratch[0], length, batch);
+
+    // Copy scratch back to coefficients.
+    for ( unsigned int b = 0; b < batch; b++ )
+      {
+      OffsetValueType offset = lineOffset + b * batchStride;
+      for ( SizeValueType j = 0; j < length; j++, offset += lineStride )
+        {
+        outputBuffer[offset] = static_cast< OutputPixelType >( scratch[j * batch + b] );
+        }
+      }
+
+    // Move to the next batch of lines, batch dimension fastest
+    done = true;
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      const unsigned int dim = ( d == 0 ) ? batchDimension : ( ( d - 1 < batchDimension ) ? d - 1 : d );
+      index[dim] += ( dim == batchDimension ) ? static_cast< IndexValueType >( batch ) : 1;
+      if ( index[dim] < end[dim] )
+        {
+        done = false;
+        break;
+        }
+      index[dim] = start[dim];
+      }
     }
 }
 
-/**
- * Copy one line of the output image to the scratch
- */
 template< class TInputImage, class TOutputImage >
 void
 BSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::CopyCoefficientsToScratch(OutputLinearIterator & Iter)
+::CopyImageToImage()
 {
-  typename TOutputImage::SizeValueType j = 0;
+  typedef ImageRegionConstIteratorWithIndex< TInputImage > InputIterator;
+  typedef ImageRegionIterator< TOutputImage >              OutputIterator;
+
+  InputIterator  inIt( this->GetInput(), this->GetInput()->GetBufferedRegion() );
+  OutputIterator outIt( this->GetOutput(), this->GetOutput()->GetBufferedRegion() );
 
-  while ( !Iter.IsAtEndOfLine() )
+  inIt = inIt.Begin();
+  outIt = outIt.Begin();
+
+  while ( !outIt.IsAtEnd() )
     {
-    m_Scratch[j] = static_cast< CoeffType >( Iter.Get() );
-    ++Iter;
-    ++j;
+    outIt.Set( static_cast< OutputPixelType >( inIt.Get() ) );
+    ++inIt;
+    ++outIt;
     }
 }
 
@@ -385,31 +488,43 @@ void
 BSplineDecompositionImageFilter< TInputImage, TOutputImage >
 ::GenerateData()
 {
-  // Allocate scratch memory
   InputImageConstPointer inputPtr = this->GetInput();
 
   m_DataLength = inputPtr->GetBufferedRegion().GetSize();
 
-  typename TOutputImage::SizeValueType maxLength = 0;
-  for ( unsigned int n = 0; n < ImageDimension; n++ )
-    {
-    if ( m_DataLength[n] > maxLength )
-      {
-      maxLength = m_DataLength[n];
-      }
-    }
-  m_Scratch.resize(maxLength);
-
   // Allocate memory for output image
   OutputImagePointer outputPtr = this->GetOutput();
   outputPtr->SetBufferedRegion( outputPtr->GetRequestedRegion() );
-  outputPtr->Allocate();
+  if ( m_CoefficientsBuffer )
+    {
+    outputPtr->GetPixelContainer()->SetImportPointer(
+      m_CoefficientsBuffer, outputPtr->GetRequestedRegion().GetNumberOfPixels(), false);
+    }
+  else
+    {
+    outputPtr->Allocate();
+    }
 
   // Calculate actual output
   this->DataToCoefficientsND();
+}
 
-  // Clean up
-  m_Scratch.clear();
+template< class TInputImage, class TOutputImage >
+void
+BSplineDecompositionImageFilter< TInputImage, TOutputImage >
+::SetCoefficientsBuffer(OutputPixelType *buffer)
+{
+  if ( buffer == m_CoefficientsBuffer )
+    {
+    return;
+    }
+  m_CoefficientsBuffer = buffer;
+  if ( !buffer )
+    {
+    // stop referencing the caller's memory
+    this->GetOutput()->Initialize();
+    }
+  this->Modified();
 }
 } // namespace itk
 
@@ -133,6 +133,18 @@ public:
                            itkGetStaticConstMacro(ImageDimension) >
   CovariantVectorType;
 
+  /** Maximum spline order supported by the interpolator. */
+  itkStaticConstMacro(MaximumSplineOrder, unsigned int, 5);
+
+  /** Working space of one evaluation.  An evaluation given its own context
+   * neither allocates memory nor writes to shared state, so one context per
+   * thread, e.g. on the stack, makes the evaluations thread safe. */
+  struct EvaluationContext {
+    long   EvaluateIndex[ImageDimension][MaximumSplineOrder + 1];
+    double Weights[ImageDimension][MaximumSplineOrder + 1];
+    double WeightsDerivative[ImageDimension][MaximumSplineOrder + 1];
+  };
+
   /** Evaluate the function at a ContinuousIndex position.
    *
    * Returns the B-Spline interpolated image intensity at a
@@ -164,16 +176,10 @@ public:
   virtual OutputType EvaluateAtContinuousIndex(const ContinuousIndexType &
                                                index) const
   {
-    // Don't know thread information, make evaluateIndex, weights on the stack.
-    // Slower, but safer.
-    vnl_matrix< long >   evaluateIndex( ImageDimension, ( m_SplineOrder + 1 ) );
-    vnl_matrix< double > weights( ImageDimension, ( m_SplineOrder + 1 ) );
-
-    // Pass evaluateIndex, weights by reference. They're only good as long
-    // as this method is in scope.
-    return this->EvaluateAtContinuousIndexInternal(index,
-                                                   evaluateIndex,
-                                                   weights);
+    // Don't know thread information, use working space on the stack.
+    EvaluationContext context;
+
+    return this->EvaluateAtContinuousIndex(index, context);
   }
 
   virtual OutputType EvaluateAtContinuousIndex(const ContinuousIndexType &
@@ -203,21 +209,10 @@ public:
   CovariantVectorType EvaluateDerivativeAtContinuousIndex(
     const ContinuousIndexType & x) const
   {
-    // Don't know thread information, make evaluateIndex, weights,
-    // weightsDerivative
-    // on the stack.
-    // Slower, but safer.
-    vnl_matrix< long >   evaluateIndex( ImageDimension, ( m_SplineOrder + 1 ) );
-    vnl_matrix< double > weights( ImageDimension, ( m_SplineOrder + 1 ) );
-    vnl_matrix< double > weightsDerivative( ImageDimension, ( m_SplineOrder + 1 ) );
-
-    // Pass evaluateIndex, weights, weightsDerivative by reference. They're only
-    // good
-    // as long as this method is in scope.
-    return this->EvaluateDerivativeAtContinuousIndexInternal(x,
-                                                             evaluateIndex,
-                                                             weights,
-                                                             weightsDerivative);
+    // Don't know thread information, use working space on the stack.
+    EvaluationContext context;
+
+    return this->EvaluateDerivativeAtContinuousIndex(x, context);
   }
 
   CovariantVectorType EvaluateDerivativeAtContinuousIndex(
@@ -260,23 +255,10 @@ public:
     CovariantVectorType & deriv
     ) const
   {
-    // Don't know thread information, make evaluateIndex, weights,
-    // weightsDerivative
-    // on the stack.
-    // Slower, but safer.
-    vnl_matrix< long >   evaluateIndex( ImageDimension, ( m_SplineOrder + 1 ) );
-    vnl_matrix< double > weights( ImageDimension, ( m_SplineOrder + 1 ) );
-    vnl_matrix< double > weightsDerivative( ImageDimension, ( m_SplineOrder + 1 ) );
-
-    // Pass evaluateIndex, weights, weightsDerivative by reference. They're only
-    // good
-    // as long as this method is in scope.
-    this->EvaluateValueAndDerivativeAtContinuousIndexInternal(x,
-                                                              value,
-                                                              deriv,
-                                                              evaluateIndex,
-                                                              weights,
-                                                              weightsDerivative);
+    // Don't know thread information, use working space on the stack.
+    EvaluationContext context;
+
+    this->EvaluateValueAndDerivativeAtContinuousIndex(x, value, deriv, context);
   }
 
   void EvaluateValueAndDerivativeAtContinuousIndex(
@@ -285,6 +267,35 @@ public:
     CovariantVectorType & deriv,
     ThreadIdType threadID) const;
 
+  /** Evaluate the value and/or the derivative using the given working
+   * space. */
+  OutputType EvaluateAtContinuousIndex(const ContinuousIndexType & x,
+                                       EvaluationContext & context) const;
+
+  CovariantVectorType EvaluateDerivativeAtContinuousIndex(const ContinuousIndexType & x,
+                                                          EvaluationContext & context) const;
+
+  void EvaluateValueAndDerivativeAtContinuousIndex(const ContinuousIndexType & x,
+                                                   OutputType & value,
+                                                   CovariantVectorType & deriv,
+                                                   EvaluationContext & context) const;
+
+  /** Compute the support (after the mirror boundary conditions) and the
+   * weights of the interpolation at the continuous index x along one
+   * dimension.  Both arrays must hold SplineOrder + 1 values.  The weights are
+   * separable, so when sampling on a grid aligned with the image axes they
+   * can be computed once per grid position along each axis and combined with
+   * EvaluateWithSeparableWeights(). */
+  void ComputeSeparableWeights(unsigned int dimension, double x,
+                               long *evaluateIndex, double *weights) const;
+
+  /** Evaluate the function from the supports and weights computed by
+   * ComputeSeparableWeights() for each dimension.  The result is the same,
+   * up to round-off, as EvaluateAtContinuousIndex() at the corresponding
+   * continuous index. */
+  OutputType EvaluateWithSeparableWeights(const long * const evaluateIndex[],
+                                          const double * const weights[]) const;
+
   /** Get/Sets the Spline Order, supports 0th - 5th order splines. The default
    *  is a 3rd order spline. */
   void SetSplineOrder(unsigned int SplineOrder);
@@ -367,16 +378,39 @@ private:
   BSplineInterpolateImageFunction(const Self &); //purposely not implemented
   void operator=(const Self &);                  //purposely not implemented
 
+  /** The evaluations, for the working space given either as vnl_matrix or
+   * as the arrays of an EvaluationContext. */
+  template< class TIndexMatrix, class TWeightMatrix >
+  OutputType EvaluateAtContinuousIndexWithWorkspace(const ContinuousIndexType & x,
+                                                    TIndexMatrix & evaluateIndex,
+                                                    TWeightMatrix & weights) const;
+
+  template< class TIndexMatrix, class TWeightMatrix >
+  void EvaluateValueAndDerivativeAtContinuousIndexWithWorkspace(const ContinuousIndexType & x,
+                                                                OutputType & value,
+                                                                CovariantVectorType & derivativeValue,
+                                                                TIndexMatrix & evaluateIndex,
+                                                                TWeightMatrix & weights,
+                                                                TWeightMatrix & weightsDerivative) const;
+
+  template< class TIndexMatrix, class TWeightMatrix >
+  CovariantVectorType EvaluateDerivativeAtContinuousIndexWithWorkspace(const ContinuousIndexType & x,
+                                                                       TIndexMatrix & evaluateIndex,
+                                                                       TWeightMatrix & weights,
+                                                                       TWeightMatrix & weightsDerivative) const;
+
   /** Determines the weights for interpolation of the value x */
+  template< class TIndexMatrix, class TWeightMatrix >
   void SetInterpolationWeights(const ContinuousIndexType & x,
-                               const vnl_matrix< long > & EvaluateIndex,
-                               vnl_matrix< double > & weights,
+                               const TIndexMatrix & EvaluateIndex,
+                               TWeightMatrix & weights,
                                unsigned int splineOrder) const;
 
   /** Determines the weights for the derivative portion of the value x */
+  template< class TIndexMatrix, class TWeightMatrix >
   void SetDerivativeWeights(const ContinuousIndexType & x,
-                            const vnl_matrix< long > & EvaluateIndex,
-                            vnl_matrix< double > & weights,
+                            const TIndexMatrix & EvaluateIndex,
+                            TWeightMatrix & weights,
                             unsigned int splineOrder) const;
 
   /** Precomputation for converting the 1D index of the interpolation
@@ -384,13 +418,15 @@ private:
   void GeneratePointsToIndex();
 
   /** Determines the indices to use give the splines region of support */
-  void DetermineRegionOfSupport(vnl_matrix< long > & evaluateIndex,
+  template< class TIndexMatrix >
+  void DetermineRegionOfSupport(TIndexMatrix & evaluateIndex,
                                 const ContinuousIndexType & x,
                                 unsigned int splineOrder) const;
 
   /** Set the indices in evaluateIndex at the boundaries based on mirror
     * boundary conditions. */
-  void ApplyMirrorBoundaryConditions(vnl_matrix< long > & evaluateIndex,
+  template< class TIndexMatrix >
+  void ApplyMirrorBoundaryConditions(TIndexMatrix & evaluateIndex,
                                      unsigned int splineOrder) const;
 
   Iterator m_CIterator;                                    // Iterator for
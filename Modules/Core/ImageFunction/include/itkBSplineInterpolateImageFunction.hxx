@@ -386,11 +386,12 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 }
 
 template< class TImageType, class TCoordRep, class TCoefficientType >
+template< class TIndexMatrix, class TWeightMatrix >
 void
 BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 ::SetInterpolationWeights(const ContinuousIndexType & x,
-                          const vnl_matrix< long > & EvaluateIndex,
-                          vnl_matrix< double > & weights,
+                          const TIndexMatrix & EvaluateIndex,
+                          TWeightMatrix & weights,
                           unsigned int splineOrder) const
 {
   // For speed improvements we could make each case a separate function and use
@@ -499,11 +500,12 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 }
 
 template< class TImageType, class TCoordRep, class TCoefficientType >
+template< class TIndexMatrix, class TWeightMatrix >
 void
 BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 ::SetDerivativeWeights(const ContinuousIndexType & x,
-                       const vnl_matrix< long > & EvaluateIndex,
-                       vnl_matrix< double > & weights,
+                       const TIndexMatrix & EvaluateIndex,
+                       TWeightMatrix & weights,
                        unsigned int splineOrder) const
 {
   // For speed improvements we could make each case a separate function and use
@@ -674,9 +676,10 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 }
 
 template< class TImageType, class TCoordRep, class TCoefficientType >
+template< class TIndexMatrix >
 void
 BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
-::DetermineRegionOfSupport(vnl_matrix< long > & evaluateIndex,
+::DetermineRegionOfSupport(TIndexMatrix & evaluateIndex,
                            const ContinuousIndexType & x,
                            unsigned int splineOrder) const
 {
@@ -692,9 +695,10 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 }
 
 template< class TImageType, class TCoordRep, class TCoefficientType >
+template< class TIndexMatrix >
 void
 BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
-::ApplyMirrorBoundaryConditions(vnl_matrix< long > & evaluateIndex,
+::ApplyMirrorBoundaryConditions(TIndexMatrix & evaluateIndex,
                                 unsigned int splineOrder) const
 {
   const IndexType startIndex = this->GetStartIndex();
@@ -738,6 +742,156 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 ::EvaluateAtContinuousIndexInternal(const ContinuousIndexType & x,
                                     vnl_matrix< long > & evaluateIndex,
                                     vnl_matrix< double > & weights) const
+{
+  return this->EvaluateAtContinuousIndexWithWorkspace(x, evaluateIndex, weights);
+}
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+void
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::EvaluateValueAndDerivativeAtContinuousIndexInternal(const ContinuousIndexType & x,
+                                                      OutputType & value,
+                                                      CovariantVectorType & derivativeValue,
+                                                      vnl_matrix< long > & evaluateIndex,
+                                                      vnl_matrix< double > & weights,
+                                                      vnl_matrix< double > & weightsDerivative
+                                                      ) const
+{
+  this->EvaluateValueAndDerivativeAtContinuousIndexWithWorkspace(x, value, derivativeValue,
+                                                                 evaluateIndex, weights, weightsDerivative);
+}
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+typename
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::CovariantVectorType
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::EvaluateDerivativeAtContinuousIndexInternal(const ContinuousIndexType & x,
+                                              vnl_matrix< long > & evaluateIndex,
+                                              vnl_matrix< double > & weights,
+                                              vnl_matrix< double > & weightsDerivative
+                                              ) const
+{
+  return this->EvaluateDerivativeAtContinuousIndexWithWorkspace(x, evaluateIndex, weights, weightsDerivative);
+}
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+typename
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::OutputType
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::EvaluateAtContinuousIndex(const ContinuousIndexType & x,
+                            EvaluationContext & context) const
+{
+  return this->EvaluateAtContinuousIndexWithWorkspace(x, context.EvaluateIndex, context.Weights);
+}
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+typename
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::CovariantVectorType
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::EvaluateDerivativeAtContinuousIndex(const ContinuousIndexType & x,
+                                      EvaluationContext & context) const
+{
+  return this->EvaluateDerivativeAtContinuousIndexWithWorkspace(x, context.EvaluateIndex, context.Weights,
+                                                                context.WeightsDerivative);
+}
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+void
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::EvaluateValueAndDerivativeAtContinuousIndex(const ContinuousIndexType & x,
+                                              OutputType & value,
+                                              CovariantVectorType & derivativeValue,
+                                              EvaluationContext & context) const
+{
+  this->EvaluateValueAndDerivativeAtContinuousIndexWithWorkspace(x, value, derivativeValue,
+                                                                 context.EvaluateIndex, context.Weights,
+                                                                 context.WeightsDerivative);
+}
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+void
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::ComputeSeparableWeights(unsigned int dimension, double x,
+                          long *evaluateIndex, double *weights) const
+{
+  // The computations are separable, so do them with x along every dimension
+  // and keep the requested one.
+  ContinuousIndexType index;
+  index.Fill(x);
+
+  EvaluationContext context;
+  this->DetermineRegionOfSupport(context.EvaluateIndex, index, m_SplineOrder);
+  this->SetInterpolationWeights(index, context.EvaluateIndex, context.Weights, m_SplineOrder);
+  this->ApplyMirrorBoundaryConditions(context.EvaluateIndex, m_SplineOrder);
+
+  for ( unsigned int k = 0; k <= m_SplineOrder; k++ )
+    {
+    evaluateIndex[k] = context.EvaluateIndex[dimension][k];
+    weights[k] = context.Weights[dimension][k];
+    }
+}
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+typename
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::OutputType
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::EvaluateWithSeparableWeights(const long * const evaluateIndex[],
+                               const double * const weights[]) const
+{
+  const unsigned int support = m_SplineOrder + 1;
+
+  // Offsets of the support along each dimension in the coefficient buffer
+  const TCoefficientType *buffer = m_Coefficients->GetBufferPointer();
+  const OffsetValueType * offsetTable = m_Coefficients->GetOffsetTable();
+  const IndexType &       bufferStart = m_Coefficients->GetBufferedRegion().GetIndex();
+  OffsetValueType         supportOffset[ImageDimension][MaximumSplineOrder + 1];
+  for ( unsigned int n = 0; n < ImageDimension; n++ )
+    {
+    for ( unsigned int k = 0; k < support; k++ )
+      {
+      supportOffset[n][k] = ( evaluateIndex[n][k] - bufferStart[n] ) * offsetTable[n];
+      }
+    }
+
+  // Step through the rows of the interpolation cube along the first
+  // dimension, which are the points with consecutive entries in
+  // m_PointsToIndex.
+  double interpolated = 0.0;
+  for ( unsigned int p = 0; p < m_MaxNumberInterpolationPoints; p += support )
+    {
+    double          w = 1.0;
+    OffsetValueType offset = 0;
+    for ( unsigned int n = 1; n < ImageDimension; n++ )
+      {
+      unsigned int indx = m_PointsToIndex[p][n];
+      w *= weights[n][indx];
+      offset += supportOffset[n][indx];
+      }
+
+    double row = 0.0;
+    for ( unsigned int k = 0; k < support; k++ )
+      {
+      row += weights[0][k] * buffer[offset + supportOffset[0][k]];
+      }
+    interpolated += w * row;
+    }
+
+  return ( interpolated );
+}
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+template< class TIndexMatrix, class TWeightMatrix >
+typename
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::OutputType
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::EvaluateAtContinuousIndexWithWorkspace(const ContinuousIndexType & x,
+                                         TIndexMatrix & evaluateIndex,
+                                         TWeightMatrix & weights) const
 {
   // compute the interpolation indexes
   this->DetermineRegionOfSupport( ( evaluateIndex ), x, m_SplineOrder );
@@ -749,34 +903,28 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
   this->ApplyMirrorBoundaryConditions( ( evaluateIndex ), m_SplineOrder );
 
   // perform interpolation
-  double    interpolated = 0.0;
-  IndexType coefficientIndex;
-  // Step through eachpoint in the N-dimensional interpolation cube.
-  for ( unsigned int p = 0; p < m_MaxNumberInterpolationPoints; p++ )
+  const long *   evaluateIndexRows[ImageDimension];
+  const double * weightsRows[ImageDimension];
+  for ( unsigned int n = 0; n < ImageDimension; n++ )
     {
-    double w = 1.0;
-    for ( unsigned int n = 0; n < ImageDimension; n++ )
-      {
-      unsigned int indx = m_PointsToIndex[p][n];
-      w *= ( weights )[n][indx];
-      coefficientIndex[n] = ( evaluateIndex )[n][indx];
-      }
-    interpolated += w * m_Coefficients->GetPixel(coefficientIndex);
+    evaluateIndexRows[n] = &evaluateIndex[n][0];
+    weightsRows[n] = &weights[n][0];
     }
 
-  return ( interpolated );
+  return this->EvaluateWithSeparableWeights(evaluateIndexRows, weightsRows);
 }
 
 template< class TImageType, class TCoordRep, class TCoefficientType >
+template< class TIndexMatrix, class TWeightMatrix >
 void
 BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
-::EvaluateValueAndDerivativeAtContinuousIndexInternal(const ContinuousIndexType & x,
-                                                      OutputType & value,
-                                                      CovariantVectorType & derivativeValue,
-                                                      vnl_matrix< long > & evaluateIndex,
-                                                      vnl_matrix< double > & weights,
-                                                      vnl_matrix< double > & weightsDerivative
-                                                      ) const
+::EvaluateValueAndDerivativeAtContinuousIndexWithWorkspace(const ContinuousIndexType & x,
+                                                           OutputType & value,
+                                                           CovariantVectorType & derivativeValue,
+                                                           TIndexMatrix & evaluateIndex,
+                                                           TWeightMatrix & weights,
+                                                           TWeightMatrix & weightsDerivative
+                                                           ) const
 {
   this->DetermineRegionOfSupport( ( evaluateIndex ), x, m_SplineOrder );
 
@@ -845,15 +993,16 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 }
 
 template< class TImageType, class TCoordRep, class TCoefficientType >
+template< class TIndexMatrix, class TWeightMatrix >
 typename
 BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 ::CovariantVectorType
 BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
-::EvaluateDerivativeAtContinuousIndexInternal(const ContinuousIndexType & x,
-                                              vnl_matrix< long > & evaluateIndex,
-                                              vnl_matrix< double > & weights,
-                                              vnl_matrix< double > & weightsDerivative
-                                              ) const
+::EvaluateDerivativeAtContinuousIndexWithWorkspace(const ContinuousIndexType & x,
+                                                   TIndexMatrix & evaluateIndex,
+                                                   TWeightMatrix & weights,
+                                                   TWeightMatrix & weightsDerivative
+                                                   ) const
 {
   this->DetermineRegionOfSupport( ( evaluateIndex ), x, m_SplineOrder );
 
@@ -32,6 +32,8 @@
 
 #include "vnl/vnl_sample.h"
 
+#include <algorithm>
+
 /** Note:  This is the same test used for the itkBSplineResampleImageFunctionTest
   *        It is duplicated here because it excercises the itkBSplineDecompositionFilter
   *        and demonstrates its use.
@@ -123,6 +125,56 @@ int itkBSplineDecompositionImageFilterTest(int, char* [] )
 
     }
 
+  /** The coefficients must not depend on the number of threads, and can be
+   *  written into a caller provided buffer, even the one of the input. */
+  ImageType::Pointer input = source->GetOutput();
+  const ImageType::SizeValueType numberOfPixels = input->GetBufferedRegion().GetNumberOfPixels();
+
+  FilterType::Pointer singleThreadedFilter = FilterType::New();
+  singleThreadedFilter->SetSplineOrder( SplineOrder );
+  singleThreadedFilter->SetInput( input );
+  singleThreadedFilter->SetNumberOfThreads( 1 );
+  singleThreadedFilter->Update();
+
+  std::vector<PixelType> coefficients( numberOfPixels );
+  FilterType::Pointer bufferFilter = FilterType::New();
+  bufferFilter->SetSplineOrder( SplineOrder );
+  bufferFilter->SetInput( input );
+  bufferFilter->SetCoefficientsBuffer( &coefficients[0] );
+  bufferFilter->Update();
+
+  if ( bufferFilter->GetOutput()->GetBufferPointer() != &coefficients[0] )
+    {
+    std::cout << "Coefficients were not written into the provided buffer." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ImageType::Pointer inPlaceInput = ImageType::New();
+  inPlaceInput->CopyInformation( input );
+  inPlaceInput->SetRegions( input->GetBufferedRegion() );
+  inPlaceInput->Allocate();
+  std::copy( input->GetBufferPointer(), input->GetBufferPointer() + numberOfPixels,
+             inPlaceInput->GetBufferPointer() );
+
+  FilterType::Pointer inPlaceFilter = FilterType::New();
+  inPlaceFilter->SetSplineOrder( SplineOrder );
+  inPlaceFilter->SetInput( inPlaceInput );
+  inPlaceFilter->SetCoefficientsBuffer( inPlaceInput->GetBufferPointer() );
+  inPlaceFilter->Update();
+
+  const PixelType * expected = filter->GetOutput()->GetBufferPointer();
+  for ( ImageType::SizeValueType i = 0; i < numberOfPixels; i++ )
+    {
+    if ( singleThreadedFilter->GetOutput()->GetBufferPointer()[i] != expected[i]
+         || coefficients[i] != expected[i]
+         || inPlaceInput->GetBufferPointer()[i] != expected[i] )
+      {
+      std::cout << "Coefficients differ at offset " << i << std::endl;
+      std::cout << " Test failed. " << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
   /** Instantiation test with a std::complex pixel */
   typedef std::complex<float>                                                     ComplexPixelType;
   typedef itk::Image<ComplexPixelType,ImageDimension>                             ComplexImageType;
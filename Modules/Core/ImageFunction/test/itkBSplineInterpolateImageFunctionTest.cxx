@@ -579,6 +579,66 @@ int testInteger3DSpline()
   return (flag);
 }
 
+int testSeparableWeights3DSpline()
+{
+  int flag = 0;
+
+  /* Allocate a simple test image */
+  ImageTypePtr3D image = ImageType3D::New();
+
+  set3DInterpData<ImageType3D> (image);
+
+  /* The evaluation with an explicit context, with a thread workspace and
+   * from separable weights must all match the plain evaluation */
+  for (unsigned int splineOrder = 0; splineOrder <= InterpolatorType3D::MaximumSplineOrder; splineOrder++)
+    {
+    InterpolatorType3D::Pointer interp = InterpolatorType3D::New();
+    interp->SetSplineOrder(splineOrder);
+    interp->SetInputImage(image);
+
+    std::cout << "Testing separable weights of 3D B-Spline of Order "<< splineOrder << std::endl;
+
+#define NPOINTS5 4  // number of points
+
+    double darray1[NPOINTS5][ImageDimension3D]
+      = {{0.1, 20.1, 28.4}, {21.58, 34.5, 17.2}, {10, 20, 12}, {2, 0.3, 0.4}};
+
+    for (int ii=0; ii < NPOINTS5; ii++)
+      {
+      ContinuousIndexType3D cindex = ContinuousIndexType3D(&darray1[ii][0]);
+      const double expected = interp->EvaluateAtContinuousIndex( cindex );
+
+      InterpolatorType3D::EvaluationContext context;
+      const double contextValue = interp->EvaluateAtContinuousIndex( cindex, context );
+      const double threadValue = interp->EvaluateAtContinuousIndex( cindex, 0 );
+
+      long         evaluateIndex[ImageDimension3D][InterpolatorType3D::MaximumSplineOrder + 1];
+      double       weights[ImageDimension3D][InterpolatorType3D::MaximumSplineOrder + 1];
+      const long   *evaluateIndexRows[ImageDimension3D];
+      const double *weightsRows[ImageDimension3D];
+      for (unsigned int d = 0; d < ImageDimension3D; d++)
+        {
+        interp->ComputeSeparableWeights( d, cindex[d], evaluateIndex[d], weights[d] );
+        evaluateIndexRows[d] = evaluateIndex[d];
+        weightsRows[d] = weights[d];
+        }
+      const double separableValue = interp->EvaluateWithSeparableWeights( evaluateIndexRows, weightsRows );
+
+      if ( contextValue != expected || threadValue != expected
+           || vnl_math_abs( separableValue - expected ) > 1e-9 )
+        {
+        std::cout << "*** Error: at " << cindex << " expected " << expected
+                  << " but got " << contextValue << " (context), "
+                  << threadValue << " (thread) and "
+                  << separableValue << " (separable weights)" << std::endl;
+        flag += 1;
+        }
+      }
+    }  // end of splineOrder
+
+  return (flag);
+}
+
 int
 itkBSplineInterpolateImageFunctionTest(
     int itkNotUsed(argc),
@@ -598,6 +658,8 @@ itkBSplineInterpolateImageFunctionTest(
 
   flag += testInteger3DSpline();
 
+  flag += testSeparableWeights3DSpline();
+
   /* Return results of test */
   if (flag != 0) {
     std::cout << "*** " << flag << " tests failed" << std::endl;
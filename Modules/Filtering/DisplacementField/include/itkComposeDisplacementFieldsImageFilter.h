@@ -29,6 +29,20 @@ namespace itk
  *
  * \brief Compose two displacement fields.
  *
+ * The output at each voxel \f$x\f$ of the warping field \f$w\f$ is
+ * \f$w(x) + d(x + w(x))\f$, where the displacement field \f$d\f$ is
+ * evaluated with the interpolator and taken as zero where the interpolator
+ * reports a point outside its buffer.
+ *
+ * When the interpolator is the default VectorLinearInterpolateImageFunction
+ * or a VectorLinearInterpolateNearestNeighborExtrapolateImageFunction, the
+ * composition is computed directly in the index space of the displacement
+ * field: the mapping from
+ * warping field indices to displacement field continuous indices is
+ * precomputed once, and the linear interpolation reads the displacement
+ * buffer with a fixed offset table, so there is no per voxel conversion
+ * to and from physical points.
+ *
  * \author Nick Tustison
  * \author Brian Avants
  *
@@ -137,6 +151,11 @@ protected:
   /** Multithreaded function which generates the output field. */
   void ThreadedGenerateData( const RegionType &, ThreadIdType );
 
+  /** Compose in the index space of the displacement field with linear
+   * interpolation. Called by ThreadedGenerateData for the linear
+   * interpolators. */
+  void ThreadedGenerateDataGridAligned( const RegionType &, ThreadIdType );
+
 private:
   ComposeDisplacementFieldsImageFilter( const Self& ); //purposely not implemented
   void operator=( const Self& );                 //purposely not implemented
@@ -144,6 +163,18 @@ private:
   /** The interpolator. */
   typename InterpolatorType::Pointer             m_Interpolator;
 
+  /** Use ThreadedGenerateDataGridAligned, and extrapolate the displacement
+   * field there. Set in BeforeThreadedGenerateData. */
+  bool                                           m_UseGridAlignedComposition;
+  bool                                           m_ExtrapolateDisplacementField;
+
+  /** Mapping from warping field indices to displacement field continuous
+   * indices, c = m_IndexToContinuousIndexOffset + m_IndexToContinuousIndex * i,
+   * and from physical vectors to continuous index vectors. */
+  Matrix<double, ImageDimension, ImageDimension> m_IndexToContinuousIndex;
+  Vector<double, ImageDimension>                 m_IndexToContinuousIndexOffset;
+  Matrix<double, ImageDimension, ImageDimension> m_PhysicalToContinuousIndex;
+
 };
 
 } // end namespace itk
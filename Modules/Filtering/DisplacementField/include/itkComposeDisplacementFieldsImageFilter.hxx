@@ -23,6 +23,8 @@
 #include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkImageRegionIterator.h"
 #include "itkVectorLinearInterpolateImageFunction.h"
+#include "itkVectorLinearInterpolateNearestNeighborExtrapolateImageFunction.h"
+#include "itkMath.h"
 
 namespace itk
 {
@@ -39,6 +41,9 @@ ComposeDisplacementFieldsImageFilter<InputImage, TOutputImage>
   typedef VectorLinearInterpolateImageFunction<InputFieldType, RealType> DefaultInterpolatorType;
   typename DefaultInterpolatorType::Pointer interpolator = DefaultInterpolatorType::New();
   this->m_Interpolator = interpolator;
+
+  this->m_UseGridAlignedComposition = false;
+  this->m_ExtrapolateDisplacementField = false;
 }
 
 template<class InputImage, class TOutputImage>
@@ -77,13 +82,59 @@ ComposeDisplacementFieldsImageFilter<InputImage, TOutputImage>
     {
     itkExceptionMacro( "Displacement field not set in interpolator." );
     }
+
+  typedef VectorLinearInterpolateImageFunction<InputFieldType, RealType> LinearInterpolatorType;
+  typedef VectorLinearInterpolateNearestNeighborExtrapolateImageFunction<InputFieldType, RealType>
+    LinearExtrapolateInterpolatorType;
+  this->m_ExtrapolateDisplacementField =
+    dynamic_cast<LinearExtrapolateInterpolatorType *>( this->m_Interpolator.GetPointer() ) != NULL;
+  this->m_UseGridAlignedComposition =
+    ( this->m_ExtrapolateDisplacementField ||
+      dynamic_cast<LinearInterpolatorType *>( this->m_Interpolator.GetPointer() ) != NULL ) &&
+    this->m_Interpolator->GetInputImage() == this->GetDisplacementField();
+
+  if( this->m_UseGridAlignedComposition )
+    {
+    const InputFieldType * displacementField = this->GetDisplacementField();
+    const InputFieldType * warpingField = this->GetWarpingField();
+
+    // physical vector to displacement field continuous index vector
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      for( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        this->m_PhysicalToContinuousIndex[i][j] =
+          displacementField->GetInverseDirection()[i][j] / displacementField->GetSpacing()[i];
+        }
+      }
+
+    // warping field index to displacement field continuous index
+    Matrix<double, ImageDimension, ImageDimension> indexToPhysical;
+    Vector<double, ImageDimension> originOffset;
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      for( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        indexToPhysical[i][j] = warpingField->GetDirection()[i][j] * warpingField->GetSpacing()[j];
+        }
+      originOffset[i] = warpingField->GetOrigin()[i] - displacementField->GetOrigin()[i];
+      }
+    this->m_IndexToContinuousIndex = this->m_PhysicalToContinuousIndex * indexToPhysical;
+    this->m_IndexToContinuousIndexOffset = this->m_PhysicalToContinuousIndex * originOffset;
+    }
 }
 
 template<class InputImage, class TOutputImage>
 void
 ComposeDisplacementFieldsImageFilter<InputImage, TOutputImage>
-::ThreadedGenerateData( const RegionType & region, ThreadIdType itkNotUsed( threadId ) )
+::ThreadedGenerateData( const RegionType & region, ThreadIdType threadId )
 {
+  if( this->m_UseGridAlignedComposition )
+    {
+    this->ThreadedGenerateDataGridAligned( region, threadId );
+    return;
+    }
+
   typename OutputFieldType::Pointer output = this->GetOutput();
   typename InputFieldType::ConstPointer warpingField = this->GetWarpingField();
 
@@ -124,6 +175,130 @@ ComposeDisplacementFieldsImageFilter<InputImage, TOutputImage>
     }
 }
 
+template<class InputImage, class TOutputImage>
+void
+ComposeDisplacementFieldsImageFilter<InputImage, TOutputImage>
+::ThreadedGenerateDataGridAligned( const RegionType & region, ThreadIdType itkNotUsed( threadId ) )
+{
+  typedef typename InputFieldType::PixelType  InputVectorType;
+  typedef typename InputFieldType::IndexType  InputIndexType;
+
+  const unsigned int VectorDimension = InputVectorType::Dimension;
+  const unsigned int NumberOfNeighbors = 1 << ImageDimension;
+
+  typename OutputFieldType::Pointer output = this->GetOutput();
+  const InputFieldType * warpingField = this->GetWarpingField();
+  const InputFieldType * displacementField = this->GetDisplacementField();
+
+  const RegionType bufferedRegion = displacementField->GetBufferedRegion();
+  const InputVectorType * buffer = displacementField->GetBufferPointer();
+  const OffsetValueType * offsetTable = displacementField->GetOffsetTable();
+
+  double startContinuousIndex[ImageDimension];
+  double endContinuousIndex[ImageDimension];
+  IndexValueType startIndex[ImageDimension];
+  IndexValueType endIndex[ImageDimension];
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    startIndex[d] = bufferedRegion.GetIndex()[d];
+    endIndex[d] = startIndex[d] + static_cast<IndexValueType>( bufferedRegion.GetSize()[d] ) - 1;
+    startContinuousIndex[d] = startIndex[d] - 0.5;
+    endContinuousIndex[d] = endIndex[d] + 0.5;
+    }
+
+  ImageRegionConstIteratorWithIndex<InputFieldType> ItW( warpingField, region );
+  ImageRegionIterator<OutputFieldType> ItF( output, region );
+
+  double cindex[ImageDimension];
+  IndexValueType baseIndex[ImageDimension];
+  double distance[ImageDimension];
+  double displacement[VectorDimension];
+  VectorType outDisplacement;
+
+  for( ItW.GoToBegin(), ItF.GoToBegin(); !ItW.IsAtEnd(); ++ItW, ++ItF )
+    {
+    const InputIndexType & index = ItW.GetIndex();
+    const InputVectorType & warpVector = ItW.Get();
+
+    // continuous index of x + w(x) in the displacement field
+    bool isInside = true;
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      double c = this->m_IndexToContinuousIndexOffset[i];
+      for( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        c += this->m_IndexToContinuousIndex[i][j] * index[j]
+          + this->m_PhysicalToContinuousIndex[i][j] * warpVector[j];
+        }
+      if( this->m_ExtrapolateDisplacementField )
+        {
+        // nearest neighbor extrapolation, linear interpolation inside
+        c = vnl_math_max( vnl_math_min( c, static_cast<double>( endIndex[i] ) ),
+                          static_cast<double>( startIndex[i] ) );
+        }
+      // negated test so that NaN is outside
+      else if( !( c >= startContinuousIndex[i] && c < endContinuousIndex[i] ) )
+        {
+        isInside = false;
+        }
+      cindex[i] = c;
+      }
+
+    for( unsigned int k = 0; k < VectorDimension; k++ )
+      {
+      displacement[k] = 0.0;
+      }
+
+    if( isInside )
+      {
+      for( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        baseIndex[i] = Math::Floor<IndexValueType>( cindex[i] );
+        distance[i] = cindex[i] - static_cast<double>( baseIndex[i] );
+        }
+
+      // linear interpolation, with the neighbors clamped to the buffer
+      for( unsigned int counter = 0; counter < NumberOfNeighbors; counter++ )
+        {
+        double overlap = 1.0;
+        OffsetValueType offset = 0;
+        unsigned int upper = counter;
+        for( unsigned int i = 0; i < ImageDimension; i++ )
+          {
+          IndexValueType neighbor;
+          if( upper & 1 )
+            {
+            neighbor = vnl_math_min( baseIndex[i] + 1, endIndex[i] );
+            overlap *= distance[i];
+            }
+          else
+            {
+            neighbor = vnl_math_max( baseIndex[i], startIndex[i] );
+            overlap *= 1.0 - distance[i];
+            }
+          offset += ( i == 0 ) ? ( neighbor - startIndex[i] )
+                               : ( neighbor - startIndex[i] ) * offsetTable[i];
+          upper >>= 1;
+          }
+        if( overlap != 0.0 )
+          {
+          const InputVectorType & neighborValue = buffer[offset];
+          for( unsigned int k = 0; k < VectorDimension; k++ )
+            {
+            displacement[k] += overlap * neighborValue[k];
+            }
+          }
+        }
+      }
+
+    for( unsigned int k = 0; k < VectorDimension; k++ )
+      {
+      outDisplacement[k] = static_cast<RealType>( warpVector[k] + displacement[k] );
+      }
+    ItF.Set( outDisplacement );
+    }
+}
+
 template<class InputImage, class TOutputImage>
 void
 ComposeDisplacementFieldsImageFilter<InputImage, TOutputImage>
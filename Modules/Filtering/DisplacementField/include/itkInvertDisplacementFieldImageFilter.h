@@ -29,6 +29,18 @@ namespace itk
  *
  * \brief Iteratively estimate the inverse field of a displacement field.
  *
+ * The field is partitioned into a fixed number of convergence regions which
+ * are distributed over the threads.  When UseRegionalConvergence is on, a
+ * region whose maximum error norm has dropped below the maximum error
+ * tolerance is frozen, i.e. neither its composition nor its update are
+ * recomputed in the remaining iterations.  This saves time but changes the
+ * result, so it is off by default.
+ *
+ * Every iteration composes the whole field with the current inverse
+ * estimate, so the filter needs the whole displacement field and does not
+ * stream.  IterativeInverseDisplacementFieldImageFilter can be used to
+ * compute the inverse piece by piece.
+ *
  * \author Nick Tustison
  * \author Brian Avants
  *
@@ -129,6 +141,18 @@ public:
   itkSetMacro( EnforceBoundaryCondition, bool );
   itkGetMacro( EnforceBoundaryCondition, bool );
 
+  /* Set/Get whether converged regions are excluded from further iterations.
+   * Default is false, which gives the results of the unpartitioned filter. */
+  itkSetMacro( UseRegionalConvergence, bool );
+  itkGetConstMacro( UseRegionalConvergence, bool );
+  itkBooleanMacro( UseRegionalConvergence );
+
+  /* Set/Get the number of regions the field is partitioned into for
+   * convergence tracking and multithreading.  The actual number of regions
+   * can be smaller, depending on the size of the field. */
+  itkSetClampMacro( NumberOfConvergenceRegions, unsigned int, 1, NumericTraits<unsigned int>::max() );
+  itkGetConstMacro( NumberOfConvergenceRegions, unsigned int );
+
 protected:
 
   /** Constructor */
@@ -143,8 +167,13 @@ protected:
   /** preprocessing function */
   void GenerateData();
 
-  /** Multithreaded function which generates the output field. */
-  void ThreadedGenerateData( const RegionType &, ThreadIdType );
+  /** Process one convergence region, either computing the error norms of the
+   * composed field or updating the inverse field estimate. */
+  void ThreadedProcessConvergenceRegion( unsigned int );
+
+  /** Static function used as a "callback" by the MultiThreader.  Each thread
+   * processes every NumberOfThreads-th unconverged region. */
+  static ITK_THREAD_RETURN_TYPE ConvergenceRegionThreaderCallback( void *arg );
 
 private:
   InvertDisplacementFieldImageFilter( const Self& ); //purposely not implemented
@@ -170,6 +199,13 @@ private:
   bool                                              m_DoThreadedEstimateInverse;
   bool                                              m_EnforceBoundaryCondition;
 
+  bool                                              m_UseRegionalConvergence;
+  unsigned int                                      m_NumberOfConvergenceRegions;
+  std::vector<RegionType>                           m_ConvergenceRegions;
+  std::vector<RealType>                             m_RegionMaxErrorNorm;
+  std::vector<RealType>                             m_RegionErrorNormSum;
+  std::vector<unsigned char>                        m_RegionHasConverged;
+
 };
 
 } // end namespace itk
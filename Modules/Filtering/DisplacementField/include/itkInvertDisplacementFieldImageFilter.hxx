@@ -20,9 +20,10 @@
 
 #include "itkInvertDisplacementFieldImageFilter.h"
 
-#include "itkComposeDisplacementFieldsImageFilter.h"
 #include "itkImageDuplicator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkImageRegionIterator.h"
+#include "itkImageRegionSplitter.h"
 #include "itkVectorLinearInterpolateImageFunction.h"
 
 namespace itk
@@ -36,7 +37,9 @@ InvertDisplacementFieldImageFilter<TInputImage, TOutputImage>
 ::InvertDisplacementFieldImageFilter() :
  m_MaximumNumberOfIterations( 20 ),
  m_MaxErrorToleranceThreshold( 0.1 ),
- m_MeanErrorToleranceThreshold( 0.001 )
+ m_MeanErrorToleranceThreshold( 0.001 ),
+ m_UseRegionalConvergence( false ),
+ m_NumberOfConvergenceRegions( 64 )
 {
   this->SetNumberOfRequiredInputs( 1 );
 
@@ -107,12 +110,37 @@ InvertDisplacementFieldImageFilter<TInputImage, TOutputImage>
     this->m_DisplacementFieldSpacing[d] = displacementField->GetSpacing()[d];
     }
 
+  this->m_Interpolator->SetInputImage( displacementField );
+
+  this->m_ComposedField->CopyInformation( displacementField );
+  this->m_ComposedField->SetRegions( displacementField->GetRequestedRegion() );
+  this->m_ComposedField->Allocate();
+
   this->m_ScaledNormImage->CopyInformation( displacementField );
   this->m_ScaledNormImage->SetRegions( displacementField->GetRequestedRegion() );
   this->m_ScaledNormImage->Allocate();
   this->m_ScaledNormImage->FillBuffer( 0.0 );
 
-  SizeValueType numberOfPixelsInRegion = ( displacementField->GetRequestedRegion() ).GetNumberOfPixels();
+  // Partition the field into the convergence regions.  The partition only
+  // depends on the field size, so the result does not depend on the number
+  // of threads.
+  typedef ImageRegionSplitter<ImageDimension> SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+
+  const RegionType requestedRegion = displacementField->GetRequestedRegion();
+  const unsigned int numberOfRegions =
+    splitter->GetNumberOfSplits( requestedRegion, this->m_NumberOfConvergenceRegions );
+
+  this->m_ConvergenceRegions.resize( numberOfRegions );
+  for( unsigned int n = 0; n < numberOfRegions; n++ )
+    {
+    this->m_ConvergenceRegions[n] = splitter->GetSplit( n, numberOfRegions, requestedRegion );
+    }
+  this->m_RegionMaxErrorNorm.assign( numberOfRegions, NumericTraits<RealType>::Zero );
+  this->m_RegionErrorNormSum.assign( numberOfRegions, NumericTraits<RealType>::Zero );
+  this->m_RegionHasConverged.assign( numberOfRegions, 0 );
+
+  SizeValueType numberOfPixelsInRegion = requestedRegion.GetNumberOfPixels();
   this->m_MaxErrorNorm = NumericTraits<RealType>::max();
   this->m_MeanErrorNorm = NumericTraits<RealType>::max();
   unsigned int iteration = 0;
@@ -124,28 +152,23 @@ InvertDisplacementFieldImageFilter<TInputImage, TOutputImage>
     itkDebugMacro( "Iteration " << iteration << ": mean error norm = " << this->m_MeanErrorNorm
       << ", max error norm = " << this->m_MaxErrorNorm );
 
-    typedef ComposeDisplacementFieldsImageFilter<DisplacementFieldType> ComposerType;
-    typename ComposerType::Pointer composer = ComposerType::New();
-    composer->SetDisplacementField( displacementField );
-    composer->SetWarpingField( inverseDisplacementField );
-
-    this->m_ComposedField = composer->GetOutput();
-    this->m_ComposedField->Update();
-    this->m_ComposedField->DisconnectPipeline();
-
     /**
-     * Multithread processing to multiply each element of the composed field by 1 / spacing
+     * Multithread processing to compose the inverse field with the displacement
+     * field and to multiply each element of the composed field by 1 / spacing
      */
-    this->m_MeanErrorNorm = NumericTraits<RealType>::Zero;
-    this->m_MaxErrorNorm = NumericTraits<RealType>::Zero;
-
     this->m_DoThreadedEstimateInverse = false;
-    typename ImageSource<TOutputImage>::ThreadStruct str0;
-    str0.Filter = this;
     this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
-    this->GetMultiThreader()->SetSingleMethod( this->ThreaderCallback, &str0 );
+    this->GetMultiThreader()->SetSingleMethod( this->ConvergenceRegionThreaderCallback, this );
     this->GetMultiThreader()->SingleMethodExecute();
 
+    // Frozen regions keep contributing the error norms of their last update.
+    this->m_MeanErrorNorm = NumericTraits<RealType>::Zero;
+    this->m_MaxErrorNorm = NumericTraits<RealType>::Zero;
+    for( unsigned int n = 0; n < numberOfRegions; n++ )
+      {
+      this->m_MeanErrorNorm += this->m_RegionErrorNormSum[n];
+      this->m_MaxErrorNorm = vnl_math_max( this->m_MaxErrorNorm, this->m_RegionMaxErrorNorm[n] );
+      }
     this->m_MeanErrorNorm /= static_cast<RealType>( numberOfPixelsInRegion );
 
     this->m_Epsilon = 0.5;
@@ -158,19 +181,54 @@ InvertDisplacementFieldImageFilter<TInputImage, TOutputImage>
      * Multithread processing to estimate inverse field
      */
     this->m_DoThreadedEstimateInverse = true;
-    typename ImageSource<TOutputImage>::ThreadStruct str1;
-    str1.Filter = this;
     this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
-    this->GetMultiThreader()->SetSingleMethod( this->ThreaderCallback, &str1 );
+    this->GetMultiThreader()->SetSingleMethod( this->ConvergenceRegionThreaderCallback, this );
     this->GetMultiThreader()->SingleMethodExecute();
+
+    // As for the whole field, a region stops after the update of the
+    // iteration in which its maximum error norm met the tolerance.
+    if( this->m_UseRegionalConvergence )
+      {
+      for( unsigned int n = 0; n < numberOfRegions; n++ )
+        {
+        if( this->m_RegionMaxErrorNorm[n] <= this->m_MaxErrorToleranceThreshold )
+          {
+          this->m_RegionHasConverged[n] = 1;
+          }
+        }
+      }
     }
 }
 
+template<class TInputImage, class TOutputImage>
+ITK_THREAD_RETURN_TYPE
+InvertDisplacementFieldImageFilter<TInputImage, TOutputImage>
+::ConvergenceRegionThreaderCallback( void *arg )
+{
+  ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+  ThreadIdType threadCount = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->NumberOfThreads;
+
+  Self *filter = (Self *)( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+
+  const unsigned int numberOfRegions = filter->m_ConvergenceRegions.size();
+  for( unsigned int n = threadId; n < numberOfRegions; n += threadCount )
+    {
+    if( !filter->m_RegionHasConverged[n] )
+      {
+      filter->ThreadedProcessConvergenceRegion( n );
+      }
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 template<class TInputImage, class TOutputImage>
 void
 InvertDisplacementFieldImageFilter<TInputImage, TOutputImage>
-::ThreadedGenerateData( const RegionType & region, ThreadIdType itkNotUsed( threadId ) )
+::ThreadedProcessConvergenceRegion( unsigned int regionNumber )
 {
+  const RegionType & region = this->m_ConvergenceRegions[regionNumber];
+
   const typename DisplacementFieldType::RegionType fullRegion = this->m_ComposedField->GetRequestedRegion();
   const typename DisplacementFieldType::SizeType size = fullRegion.GetSize();
   const typename DisplacementFieldType::IndexType startIndex = fullRegion.GetIndex();
@@ -210,9 +268,38 @@ InvertDisplacementFieldImageFilter<TInputImage, TOutputImage>
     }
   else
     {
-    for( ItE.GoToBegin(), ItS.GoToBegin(); !ItE.IsAtEnd(); ++ItE, ++ItS )
+    const InverseDisplacementFieldType * inverseField = this->GetOutput();
+
+    ImageRegionConstIteratorWithIndex<InverseDisplacementFieldType> ItI( inverseField, region );
+
+    RealType errorNormSum = NumericTraits<RealType>::Zero;
+    RealType maxErrorNorm = NumericTraits<RealType>::Zero;
+
+    PointType point;
+    PointType mappedPoint;
+
+    for( ItI.GoToBegin(), ItE.GoToBegin(), ItS.GoToBegin(); !ItI.IsAtEnd(); ++ItI, ++ItE, ++ItS )
       {
-      VectorType displacement = ItE.Get();
+      // compose the displacement field with the current inverse estimate
+      const VectorType inverse = ItI.Get();
+      inverseField->TransformIndexToPhysicalPoint( ItI.GetIndex(), point );
+      for( unsigned int d = 0; d < ImageDimension; d++ )
+        {
+        mappedPoint[d] = point[d] + inverse[d];
+        }
+
+      typename InterpolatorType::OutputType forward( 0.0 );
+      if( this->m_Interpolator->IsInsideBuffer( mappedPoint ) )
+        {
+        forward = this->m_Interpolator->Evaluate( mappedPoint );
+        }
+
+      VectorType displacement;
+      for( unsigned int d = 0; d < ImageDimension; d++ )
+        {
+        displacement[d] = static_cast<RealType>( mappedPoint[d] + forward[d] - point[d] );
+        }
+
       RealType scaledNorm = 0.0;
       for( unsigned int d = 0; d < ImageDimension; d++ )
         {
@@ -220,15 +307,18 @@ InvertDisplacementFieldImageFilter<TInputImage, TOutputImage>
         }
       scaledNorm = vcl_sqrt( scaledNorm );
 
-      this->m_MeanErrorNorm += scaledNorm;
-      if( this->m_MaxErrorNorm < scaledNorm )
+      errorNormSum += scaledNorm;
+      if( maxErrorNorm < scaledNorm )
         {
-        this->m_MaxErrorNorm = scaledNorm;
+        maxErrorNorm = scaledNorm;
         }
 
       ItS.Set( scaledNorm );
       ItE.Set( -displacement );
       }
+
+    this->m_RegionErrorNormSum[regionNumber] = errorNormSum;
+    this->m_RegionMaxErrorNorm[regionNumber] = maxErrorNorm;
     }
 }
 
@@ -245,6 +335,8 @@ InvertDisplacementFieldImageFilter<TInputImage, TOutputImage>
   os << "Maximum number of iterations: " << this->m_MaximumNumberOfIterations << std::endl;
   os << "Max error tolerance threshold: " << this->m_MaxErrorToleranceThreshold << std::endl;
   os << "Mean error tolerance threshold: " << this->m_MeanErrorToleranceThreshold << std::endl;
+  os << "Use regional convergence: " << this->m_UseRegionalConvergence << std::endl;
+  os << "Number of convergence regions: " << this->m_NumberOfConvergenceRegions << std::endl;
 }
 
 }  //end namespace itk
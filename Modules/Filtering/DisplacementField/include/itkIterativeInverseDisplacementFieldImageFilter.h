@@ -43,6 +43,9 @@ namespace itk
  *
  * This method was discussed in the users-list during February 2004.
  *
+ * Every output pixel is computed independently from the whole input field,
+ * so the filter is multithreaded and supports streaming of the output.
+ *
  * \author  Corinne Mattmann
  *
  * \ingroup ITKDisplacementField
@@ -77,6 +80,7 @@ public:
   typedef typename OutputImageType::PixelType      OutputImagePixelType;
   typedef typename OutputImageType::PointType      OutputImagePointType;
   typedef typename OutputImageType::IndexType      OutputImageIndexType;
+  typedef typename OutputImageType::RegionType     OutputImageRegionType;
   typedef typename OutputImagePixelType::ValueType OutputImageValueType;
 
   typedef TimeProbe TimeType;
@@ -113,12 +117,23 @@ protected:
 
   void PrintSelf(std::ostream & os, Indent indent) const;
 
-  void GenerateData();
+  /** The whole input field is required to compute any output region. */
+  void GenerateInputRequestedRegion();
+
+  void BeforeThreadedGenerateData();
+
+  void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                            ThreadIdType threadId);
+
+  void AfterThreadedGenerateData();
 
   unsigned int m_NumberOfIterations;
 
   double m_StopValue;
   double m_Time;
+
+  TimeType                 m_TimeProbe;
+  FieldInterpolatorPointer m_InputFieldInterpolator;
 private:
   IterativeInverseDisplacementFieldImageFilter(const Self &); //purposely not implemented
   void operator=(const Self &);                              //purposely not implemented
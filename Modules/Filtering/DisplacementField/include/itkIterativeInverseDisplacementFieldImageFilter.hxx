@@ -36,15 +36,28 @@ IterativeInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >::Itera
 //----------------------------------------------------------------------------
 template< class TInputImage, class TOutputImage >
 void IterativeInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
-::GenerateData()
+::GenerateInputRequestedRegion()
 {
-  const unsigned int ImageDimension = InputImageType::ImageDimension;
-  TimeType           time;
+  // call the superclass's implementation
+  Superclass::GenerateInputRequestedRegion();
 
-  time.Start(); //time measurement
+  // the inverse at any output pixel may depend on any input pixel
+  InputImagePointer inputPtr = const_cast< InputImageType * >( this->GetInput() );
+  if ( inputPtr )
+    {
+    inputPtr->SetRequestedRegionToLargestPossibleRegion();
+    }
+}
+
+//----------------------------------------------------------------------------
+template< class TInputImage, class TOutputImage >
+void IterativeInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
+::BeforeThreadedGenerateData()
+{
+  m_TimeProbe = TimeType();
+  m_TimeProbe.Start(); //time measurement
 
   InputImageConstPointer inputPtr = this->GetInput(0);
-  OutputImagePointer     outputPtr = this->GetOutput(0);
 
   // some checks
   if ( inputPtr.IsNull() )
@@ -56,192 +69,188 @@ void IterativeInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
     itkExceptionMacro("\n Image Dimensions must be the same.");
     }
 
-  // calculate a first guess
-  // (calculate negative displacement field and apply it to itself)
-  InputImagePointer negField = InputImageType::New();
-  negField->SetRegions( inputPtr->GetLargestPossibleRegion() );
-  negField->SetOrigin( inputPtr->GetOrigin() );
-  negField->SetSpacing( inputPtr->GetSpacing() );
-  negField->SetDirection( inputPtr->GetDirection() );
-  negField->Allocate();
+  m_InputFieldInterpolator = FieldInterpolatorType::New();
+  m_InputFieldInterpolator->SetInputImage(inputPtr);
+}
 
-  InputConstIterator InputIt = InputConstIterator( inputPtr, inputPtr->GetRequestedRegion() );
-  InputIterator      negImageIt = InputIterator( negField, negField->GetRequestedRegion() );
+//----------------------------------------------------------------------------
+template< class TInputImage, class TOutputImage >
+void IterativeInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                       ThreadIdType threadId)
+{
+  const unsigned int ImageDimension = InputImageType::ImageDimension;
 
-  for ( negImageIt.GoToBegin(); !negImageIt.IsAtEnd(); ++negImageIt )
-    {
-    negImageIt.Set( -InputIt.Get() );
-    ++InputIt;
-    }
+  InputImageConstPointer inputPtr = this->GetInput(0);
+  OutputImagePointer     outputPtr = this->GetOutput(0);
 
-  outputPtr->SetRegions( inputPtr->GetRequestedRegion() );
-  outputPtr->SetOrigin( inputPtr->GetOrigin() );
-  outputPtr->SetSpacing( inputPtr->GetSpacing() );
-  outputPtr->SetDirection( inputPtr->GetDirection() );
-  outputPtr->Allocate();
-
-  typename VectorWarperType::Pointer vectorWarper = VectorWarperType::New();
-  typename FieldInterpolatorType::Pointer VectorInterpolator = FieldInterpolatorType::New();
-  vectorWarper->SetInput(negField);
-  vectorWarper->SetInterpolator(VectorInterpolator);
-  vectorWarper->SetOutputOrigin( inputPtr->GetOrigin() );
-  vectorWarper->SetOutputSpacing( inputPtr->GetSpacing() );
-  vectorWarper->SetOutputDirection( inputPtr->GetDirection() );
-  vectorWarper->SetDisplacementField(negField);
-  vectorWarper->GraftOutput(outputPtr);
-  vectorWarper->UpdateLargestPossibleRegion();
-
-  // If the number of iterations is zero, just output the first guess
-  // (negative deformable field applied to itself)
-  if ( m_NumberOfIterations == 0 )
-    {
-    this->GraftOutput( vectorWarper->GetOutput() );
-    }
-  else
+  const FieldInterpolatorType *inputFieldInterpolator = m_InputFieldInterpolator;
+
+  InputImagePointType         mappedPoint, newPoint;
+  OutputImagePointType        point, originalPoint, newRemappedPoint;
+  OutputImageIndexType        index;
+  OutputImagePixelType        displacement, outputValue;
+  FieldInterpolatorOutputType forwardVector;
+  double                      spacing = inputPtr->GetSpacing()[0];
+  double                      smallestError = 0;
+  int                         stillSamePoint;
+
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+  OutputIterator   OutputIt = OutputIterator(outputPtr, outputRegionForThread);
+
+  OutputIt.GoToBegin();
+  while ( !OutputIt.IsAtEnd() )
     {
-    // calculate the inverted field
-    InputImagePointType         mappedPoint, newPoint;
-    OutputImagePointType        point, originalPoint, newRemappedPoint;
-    OutputImageIndexType        index;
-    OutputImagePixelType        displacement, outputValue;
-    FieldInterpolatorOutputType forwardVector;
-    double                      spacing = inputPtr->GetSpacing()[0];
-    double                      smallestError = 0;
-    int                         stillSamePoint;
-    InputImageRegionType        region = inputPtr->GetLargestPossibleRegion();
-    unsigned int                numberOfPoints = 1;
-    for ( unsigned int i = 0; i < ImageDimension; i++ )
+    // get the output image index
+    index = OutputIt.GetIndex();
+    outputPtr->TransformIndexToPhysicalPoint(index, originalPoint);
+
+    // calculate a first guess
+    // (apply the negative displacement field to itself)
+    displacement = inputPtr->GetPixel(index);
+    for ( unsigned int j = 0; j < ImageDimension; j++ )
       {
-      numberOfPoints *= region.GetSize()[i];
+      point[j] = originalPoint[j] - displacement[j];
+      }
+    if ( inputFieldInterpolator->IsInsideBuffer(point) )
+      {
+      forwardVector = inputFieldInterpolator->Evaluate(point);
+      for ( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        displacement[j] = static_cast< OutputImageValueType >( -forwardVector[j] );
+        }
+      }
+    else
+      {
+      displacement.Fill(0);
       }
 
-    ProgressReporter progress( this, 0,
-                               inputPtr->GetLargestPossibleRegion().GetNumberOfPixels() );
-    OutputIterator           OutputIt = OutputIterator( outputPtr, outputPtr->GetRequestedRegion() );
-    FieldInterpolatorPointer inputFieldInterpolator = FieldInterpolatorType::New();
-    inputFieldInterpolator->SetInputImage(inputPtr);
-
-    InputIt.GoToBegin();
-    OutputIt.GoToBegin();
-    while ( !OutputIt.IsAtEnd() )
+    // If the number of iterations is zero, just output the first guess
+    if ( m_NumberOfIterations == 0 )
       {
-      // get the output image index
-      index = OutputIt.GetIndex();
-      outputPtr->TransformIndexToPhysicalPoint(index, originalPoint);
+      OutputIt.Set(displacement);
+      ++OutputIt;
+      progress.CompletedPixel();
+      continue;
+      }
 
-      stillSamePoint = 0;
-      double step = spacing;
+    stillSamePoint = 0;
+    double step = spacing;
 
-      // get the required displacement
-      displacement = OutputIt.Get();
+    // compute the required input image point
+    for ( unsigned int j = 0; j < ImageDimension; j++ )
+      {
+      mappedPoint[j] = originalPoint[j] + displacement[j];
+      newPoint[j] = mappedPoint[j];
+      }
 
-      // compute the required input image point
+    // calculate the error of the last iteration
+    smallestError = NumericTraits< double >::max();
+    if ( inputFieldInterpolator->IsInsideBuffer(mappedPoint) )
+      {
+      forwardVector = inputFieldInterpolator->Evaluate(mappedPoint);
+
+      smallestError = 0;
       for ( unsigned int j = 0; j < ImageDimension; j++ )
         {
-        mappedPoint[j] = originalPoint[j] + displacement[j];
-        newPoint[j] = mappedPoint[j];
+        smallestError += vcl_pow(mappedPoint[j] + forwardVector[j] - originalPoint[j], 2);
         }
+      smallestError = vcl_sqrt(smallestError);
+      }
 
-      // calculate the error of the last iteration
-      if ( inputFieldInterpolator->IsInsideBuffer(mappedPoint) )
-        {
-        forwardVector = inputFieldInterpolator->Evaluate(mappedPoint);
+    // iteration loop
+    for ( unsigned int i = 0; i < m_NumberOfIterations; i++ )
+      {
+      double tmp;
 
-        smallestError = 0;
-        for ( unsigned int j = 0; j < ImageDimension; j++ )
-          {
-          smallestError += vcl_pow(mappedPoint[j] + forwardVector[j] - originalPoint[j], 2);
-          }
-        smallestError = vcl_sqrt(smallestError);
+      if ( stillSamePoint )
+        {
+        step = step / 2;
         }
 
-      // iteration loop
-      for ( unsigned int i = 0; i < m_NumberOfIterations; i++ )
+      for ( unsigned int k = 0; k < ImageDimension; k++ )
         {
-        double tmp;
-
-        if ( stillSamePoint )
+        mappedPoint[k] += step;
+        if ( inputFieldInterpolator->IsInsideBuffer(mappedPoint) )
           {
-          step = step / 2;
-          }
-
-        for ( unsigned int k = 0; k < ImageDimension; k++ )
-          {
-          mappedPoint[k] += step;
-          if ( inputFieldInterpolator->IsInsideBuffer(mappedPoint) )
+          forwardVector = inputFieldInterpolator->Evaluate(mappedPoint);
+          tmp = 0;
+          for ( unsigned int l = 0; l < ImageDimension; l++ )
             {
-            forwardVector = inputFieldInterpolator->Evaluate(mappedPoint);
-            tmp = 0;
-            for ( unsigned int l = 0; l < ImageDimension; l++ )
-              {
-              tmp += vcl_pow(mappedPoint[l] + forwardVector[l] - originalPoint[l], 2);
-              }
-            tmp = vcl_sqrt(tmp);
-            if ( tmp < smallestError )
-              {
-              smallestError = tmp;
-              for ( unsigned int l = 0; l < ImageDimension; l++ )
-                {
-                newPoint[l] = mappedPoint[l];
-                }
-              }
+            tmp += vcl_pow(mappedPoint[l] + forwardVector[l] - originalPoint[l], 2);
             }
-
-          mappedPoint[k] -= 2 * step;
-          if ( inputFieldInterpolator->IsInsideBuffer(mappedPoint) )
+          tmp = vcl_sqrt(tmp);
+          if ( tmp < smallestError )
             {
-            forwardVector = inputFieldInterpolator->Evaluate(mappedPoint);
-            tmp = 0;
+            smallestError = tmp;
             for ( unsigned int l = 0; l < ImageDimension; l++ )
               {
-              tmp += vcl_pow(mappedPoint[l] + forwardVector[l] - originalPoint[l], 2);
-              }
-            tmp = vcl_sqrt(tmp);
-            if ( tmp < smallestError )
-              {
-              smallestError = tmp;
-              for ( unsigned int l = 0; l < ImageDimension; l++ )
-                {
-                newPoint[l] = mappedPoint[l];
-                }
+              newPoint[l] = mappedPoint[l];
               }
             }
+          }
 
-          mappedPoint[k] += step;
-          } //end for loop over image dimension
-
-        stillSamePoint = 1;
-        for ( unsigned int j = 0; j < ImageDimension; j++ )
+        mappedPoint[k] -= 2 * step;
+        if ( inputFieldInterpolator->IsInsideBuffer(mappedPoint) )
           {
-          if ( newPoint[j] != mappedPoint[j] )
+          forwardVector = inputFieldInterpolator->Evaluate(mappedPoint);
+          tmp = 0;
+          for ( unsigned int l = 0; l < ImageDimension; l++ )
             {
-            stillSamePoint = 0;
+            tmp += vcl_pow(mappedPoint[l] + forwardVector[l] - originalPoint[l], 2);
+            }
+          tmp = vcl_sqrt(tmp);
+          if ( tmp < smallestError )
+            {
+            smallestError = tmp;
+            for ( unsigned int l = 0; l < ImageDimension; l++ )
+              {
+              newPoint[l] = mappedPoint[l];
+              }
             }
-          mappedPoint[j] = newPoint[j];
           }
 
-        if ( smallestError < m_StopValue )
+        mappedPoint[k] += step;
+        } //end for loop over image dimension
+
+      stillSamePoint = 1;
+      for ( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        if ( newPoint[j] != mappedPoint[j] )
           {
-          break;
+          stillSamePoint = 0;
           }
-        } //end iteration loop
+        mappedPoint[j] = newPoint[j];
+        }
 
-      for ( unsigned int k = 0; k < ImageDimension; k++ )
+      if ( smallestError < m_StopValue )
         {
-        outputValue[k] = static_cast< OutputImageValueType >( mappedPoint[k] - originalPoint[k] );
+        break;
         }
+      } //end iteration loop
+
+    for ( unsigned int k = 0; k < ImageDimension; k++ )
+      {
+      outputValue[k] = static_cast< OutputImageValueType >( mappedPoint[k] - originalPoint[k] );
+      }
 
-      OutputIt.Set(outputValue);
+    OutputIt.Set(outputValue);
 
-      ++InputIt;
-      ++OutputIt;
+    ++OutputIt;
 
-      progress.CompletedPixel();
-      } //end while loop
-    }   //end else
+    progress.CompletedPixel();
+    } //end while loop
+}
+
+//----------------------------------------------------------------------------
+template< class TInputImage, class TOutputImage >
+void IterativeInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
+::AfterThreadedGenerateData()
+{
+  m_InputFieldInterpolator = NULL;
 
-  time.Stop();
-  m_Time = time.GetMeanTime();
+  m_TimeProbe.Stop();
+  m_Time = m_TimeProbe.GetMeanTime();
 }
 
 //----------------------------------------------------------------------------
@@ -18,6 +18,9 @@
 
 #include "itkComposeDisplacementFieldsImageFilter.h"
 #include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkVectorLinearInterpolateImageFunction.h"
+#include "itkTimeProbe.h"
 
 int itkComposeDisplacementFieldsImageFilterTest( int, char * [] )
 {
@@ -80,5 +83,95 @@ int itkComposeDisplacementFieldsImageFilterTest( int, char * [] )
 
   composer->Print( std::cout, 3 );
 
+  // Compare the grid aligned composition with the interpolator on
+  // oblique, anisotropic 3-D fields.
+  typedef itk::Vector<float, 3>                   Vector3DType;
+  typedef itk::Image<Vector3DType, 3>             DisplacementField3DType;
+
+  DisplacementField3DType::SizeType size3D;
+  size3D.Fill( 48 );
+  DisplacementField3DType::SpacingType spacing3D;
+  spacing3D[0] = 1.0;
+  spacing3D[1] = 0.8;
+  spacing3D[2] = 1.5;
+  DisplacementField3DType::PointType origin3D;
+  origin3D[0] = -10.0;
+  origin3D[1] = 5.0;
+  origin3D[2] = 2.0;
+  DisplacementField3DType::DirectionType direction3D;
+  direction3D.SetIdentity();
+  const double angle = 0.3;
+  direction3D[0][0] = vcl_cos( angle );
+  direction3D[0][1] = -vcl_sin( angle );
+  direction3D[1][0] = vcl_sin( angle );
+  direction3D[1][1] = vcl_cos( angle );
+
+  DisplacementField3DType::Pointer fields3D[2];
+  for( unsigned int n = 0; n < 2; n++ )
+    {
+    fields3D[n] = DisplacementField3DType::New();
+    fields3D[n]->SetRegions( size3D );
+    fields3D[n]->SetSpacing( spacing3D );
+    fields3D[n]->SetOrigin( origin3D );
+    fields3D[n]->SetDirection( direction3D );
+    fields3D[n]->Allocate();
+
+    itk::ImageRegionIteratorWithIndex<DisplacementField3DType> It( fields3D[n],
+      fields3D[n]->GetLargestPossibleRegion() );
+    for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+      {
+      Vector3DType value;
+      for( unsigned int d = 0; d < 3; d++ )
+        {
+        value[d] = 3.0 * vcl_sin( 0.1 * ( n + 1 ) * It.GetIndex()[( d + n ) % 3] + d );
+        }
+      It.Set( value );
+      }
+    }
+
+  typedef itk::ComposeDisplacementFieldsImageFilter<DisplacementField3DType> Composer3DType;
+  Composer3DType::Pointer composer3D = Composer3DType::New();
+  composer3D->SetDisplacementField( fields3D[0] );
+  composer3D->SetWarpingField( fields3D[1] );
+
+  itk::TimeProbe timer;
+  timer.Start();
+  composer3D->Update();
+  timer.Stop();
+  std::cout << "Grid aligned composition of " << size3D << " fields: "
+            << timer.GetMean() << " s" << std::endl;
+
+  typedef itk::VectorLinearInterpolateImageFunction<DisplacementField3DType, float> Interpolator3DType;
+  Interpolator3DType::Pointer interpolator3D = Interpolator3DType::New();
+  interpolator3D->SetInputImage( fields3D[0] );
+
+  float maxError = 0.0;
+  itk::ImageRegionIteratorWithIndex<DisplacementField3DType> ItW( fields3D[1],
+    fields3D[1]->GetLargestPossibleRegion() );
+  for( ItW.GoToBegin(); !ItW.IsAtEnd(); ++ItW )
+    {
+    DisplacementField3DType::PointType point;
+    fields3D[1]->TransformIndexToPhysicalPoint( ItW.GetIndex(), point );
+    point += ItW.Get();
+    Vector3DType expected = ItW.Get();
+    if( interpolator3D->IsInsideBuffer( point ) )
+      {
+      Interpolator3DType::OutputType displacement = interpolator3D->Evaluate( point );
+      for( unsigned int d = 0; d < 3; d++ )
+        {
+        expected[d] += displacement[d];
+        }
+      }
+    const float error = ( expected - composer3D->GetOutput()->GetPixel( ItW.GetIndex() ) ).GetNorm();
+    maxError = vnl_math_max( maxError, error );
+    }
+
+  std::cout << "Maximum error of grid aligned composition: " << maxError << std::endl;
+  if( maxError > 1e-3 )
+    {
+    std::cerr << "Grid aligned composition differs from interpolated composition." << std::endl;
+    return EXIT_FAILURE;
+    }
+
   return EXIT_SUCCESS;
 }
@@ -89,6 +89,7 @@ int itkInvertDisplacementFieldImageFilterTest( int, char * [] )
   inverter->SetMeanErrorToleranceThreshold( meanTolerance );
   inverter->SetMaxErrorToleranceThreshold( maxTolerance );
   inverter->SetEnforceBoundaryCondition( false );
+  inverter->UseRegionalConvergenceOn();
   std::cout << "number of iterations: " << inverter->GetMaximumNumberOfIterations() << std::endl;
   std::cout << "mean error tolerance: " << inverter->GetMeanErrorToleranceThreshold() << std::endl;
   std::cout << "max error tolerance: " << inverter->GetMaxErrorToleranceThreshold() << std::endl;
@@ -124,5 +125,48 @@ int itkInvertDisplacementFieldImageFilterTest( int, char * [] )
 
   inverter->Print( std::cout, 3 );
 
+  // Without freezing the converged regions, as by default, the inverse must
+  // be as accurate, and with a single thread the result must be the same.
+  InverterType::Pointer referenceInverter = InverterType::New();
+  if( referenceInverter->GetUseRegionalConvergence() )
+    {
+    std::cerr << "Regional convergence is on by default." << std::endl;
+    return EXIT_FAILURE;
+    }
+  referenceInverter->SetInput( field );
+  referenceInverter->SetMaximumNumberOfIterations( numberOfIterations );
+  referenceInverter->SetMeanErrorToleranceThreshold( meanTolerance );
+  referenceInverter->SetMaxErrorToleranceThreshold( maxTolerance );
+  referenceInverter->SetEnforceBoundaryCondition( false );
+  referenceInverter->Update();
+
+  delta = referenceInverter->GetOutput()->GetPixel( index ) + ones;
+  if( delta.GetNorm() > 0.05 )
+    {
+    std::cerr << "Failed to find proper inverse without regional convergence." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  InverterType::Pointer singleThreadedInverter = InverterType::New();
+  singleThreadedInverter->SetInput( field );
+  singleThreadedInverter->SetMaximumNumberOfIterations( numberOfIterations );
+  singleThreadedInverter->SetMeanErrorToleranceThreshold( meanTolerance );
+  singleThreadedInverter->SetMaxErrorToleranceThreshold( maxTolerance );
+  singleThreadedInverter->SetEnforceBoundaryCondition( false );
+  singleThreadedInverter->UseRegionalConvergenceOn();
+  singleThreadedInverter->SetNumberOfThreads( 1 );
+  singleThreadedInverter->Update();
+
+  itk::ImageRegionConstIterator<DisplacementFieldType> ItM( inverter->GetOutput(), region );
+  itk::ImageRegionConstIterator<DisplacementFieldType> ItS( singleThreadedInverter->GetOutput(), region );
+  for( ItM.GoToBegin(), ItS.GoToBegin(); !ItM.IsAtEnd(); ++ItM, ++ItS )
+    {
+    if( ItM.Get() != ItS.Get() )
+      {
+      std::cerr << "Result depends on the number of threads." << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
   return EXIT_SUCCESS;
 }
@@ -19,6 +19,7 @@
 #include "itkIterativeInverseDisplacementFieldImageFilter.h"
 #include "itkImageFileWriter.h"
 #include "itkFilterWatcher.h"
+#include "itkStreamingImageFilter.h"
 
 
 int itkIterativeInverseDisplacementFieldImageFilterTest( int argc, char * argv[] )
@@ -117,6 +118,39 @@ int itkIterativeInverseDisplacementFieldImageFilterTest( int argc, char * argv[]
     return EXIT_FAILURE;
     }
 
+  // The output must not depend on the number of threads nor on streaming
+  FilterType::Pointer streamedFilter = FilterType::New();
+  streamedFilter->SetInput( field );
+  streamedFilter->SetNumberOfThreads( 1 );
+
+  typedef itk::StreamingImageFilter< DisplacementFieldType, DisplacementFieldType > StreamerType;
+  StreamerType::Pointer streamer = StreamerType::New();
+  streamer->SetInput( streamedFilter->GetOutput() );
+  streamer->SetNumberOfStreamDivisions( 4 );
+
+  try
+    {
+    streamer->Update();
+    }
+  catch( itk::ExceptionObject & excp )
+    {
+    std::cerr << "Exception thrown by the streamed filter" << std::endl;
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  itk::ImageRegionConstIterator< DisplacementFieldType > fullIt( filter->GetOutput(), region );
+  itk::ImageRegionConstIterator< DisplacementFieldType > streamedIt( streamer->GetOutput(), region );
+  for( fullIt.GoToBegin(), streamedIt.GoToBegin(); !fullIt.IsAtEnd(); ++fullIt, ++streamedIt )
+    {
+    if( fullIt.Get() != streamedIt.Get() )
+      {
+      std::cerr << "Streamed single-threaded output differs from the multithreaded output at "
+                << fullIt.GetIndex() << ": " << streamedIt.Get() << " != " << fullIt.Get() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
   // Write an image for regression testing
   typedef itk::ImageFileWriter<  DisplacementFieldType  > WriterType;
 
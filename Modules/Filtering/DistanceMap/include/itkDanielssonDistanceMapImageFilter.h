@@ -20,6 +20,7 @@
 
 #include "itkImageToImageFilter.h"
 #include "itkImageRegionIteratorWithIndex.h"
+#include <vector>
 
 namespace itk
 {
@@ -29,8 +30,8 @@ namespace itk
  * \tparam TOutputImage Output Image Type
  * \tparam TVoronoiImage Voronoi Image Type. Note the default value is TInputImage.
  *
- * \brief This filter computes the distance map of the input image
- * as an approximation with pixel accuracy to the Euclidean distance.
+ * \brief This filter computes the Euclidean distance map of the input
+ * image, along with the closest object to each pixel.
  *
  * The input is assumed to contain numeric codes defining objects.
  * The filter will produce as output the following images:
@@ -45,13 +46,30 @@ namespace itk
  *   computed in "pixels", the vector is represented by an
  *   itk::Offset. That is, physical coordinates are not used.
  *
- * This filter is N-dimensional and known to be efficient
- * in computational time. The algorithm is the N-dimensional version
- * of the 4SED algorithm given for two dimensions in:
+ * The vector map takes as much memory as InputImageDimension offsets per
+ * pixel; it can be skipped with ComputeVectorDistanceMapOff() when it is
+ * not needed.
+ *
+ * The filter was originally an N-dimensional version of the 4SED
+ * algorithm given for two dimensions in:
  *
  * Danielsson, Per-Erik.  Euclidean Distance Mapping.  Computer
  * Graphics and Image Processing 14, 227-248 (1980).
  *
+ * It now computes the exact closest object pixel with the separable
+ * algorithm of:
+ *
+ * Maurer, Calvin R., Rensheng Qi, and Vijay Raghavan.  A Linear Time
+ * Algorithm for Computing Exact Euclidean Distance Transforms of Binary
+ * Images in Arbitrary Dimensions.  IEEE Transactions on Pattern Analysis
+ * and Machine Intelligence 25(2), 265-270 (2003).
+ *
+ * which processes the image one dimension after the other, the lines along
+ * each dimension being split over the threads.  Only the buffer offset of
+ * the closest object pixel is kept per pixel during the computation.
+ *
+ * \sa SignedMaurerDistanceMapImageFilter
+ *
  * \ingroup ImageFeatureExtraction
  * \ingroup ITKDistanceMap
  */
@@ -91,6 +109,9 @@ public:
   /** Type for the index of the input image. */
   typedef typename InputImageType::OffsetType OffsetType;
 
+  /** Type for the offsets in the buffer of the input image. */
+  typedef typename InputImageType::OffsetValueType OffsetValueType;
+
   /** Type for the spacing of the input image. */
   typedef typename InputImageType::SpacingType      SpacingType;
   typedef typename InputImageType::SpacingValueType SpacingValueType;
@@ -160,6 +181,12 @@ public:
   /** Set On/Off whether spacing is used. */
   itkBooleanMacro(UseImageSpacing);
 
+  /** Set/Get whether the vector distance map is computed.  When off, the
+   * vector map output is left empty.  The default is on. */
+  itkSetMacro(ComputeVectorDistanceMap, bool);
+  itkGetConstReferenceMacro(ComputeVectorDistanceMap, bool);
+  itkBooleanMacro(ComputeVectorDistanceMap);
+
   /** Get Voronoi Map
    * This map shows for each pixel what object is closest to it.
    * Each object should be labeled by a number (larger than 0),
@@ -217,10 +244,25 @@ protected:
   /**  Compute Voronoi Map. */
   void ComputeVoronoiMap();
 
-  /** Update distance map locally.  Used by GenerateData(). */
-  void UpdateLocalDistance(VectorImageType *,
-                           const IndexType &,
-                           const OffsetType &);
+  /** Find the closest object pixel along the lines of the given dimension
+   * which start in lineRegion, among the closest object pixels found along
+   * the previous dimensions. */
+  void ThreadedComputeClosestObject(unsigned int dimension,
+                                    const RegionType & lineRegion);
+
+  /** Fill the output maps in the given region from the closest object
+   * pixels. */
+  void ThreadedComputeVoronoiMap(const RegionType & region);
+
+  /** Static function used as a "callback" by the MultiThreader.  The
+   * dimension InputImageDimension stands for the Voronoi map. */
+  static ITK_THREAD_RETURN_TYPE DistanceThreaderCallback(void *arg);
+
+  struct DistanceThreadStruct {
+    DanielssonDistanceMapImageFilter *Filter;
+    unsigned int Dimension;
+    RegionType LineRegion;
+  };
 
 private:
   DanielssonDistanceMapImageFilter(const Self &); //purposely not implemented
@@ -229,6 +271,11 @@ private:
   bool m_SquaredDistance;
   bool m_InputIsBinary;
   bool m_UseImageSpacing;
+  bool m_ComputeVectorDistanceMap;
+
+  // Buffer offset in the Voronoi map of the closest object pixel, or -1
+  // where none has been found yet
+  std::vector< OffsetValueType > m_ClosestObject;
 }; // end of DanielssonDistanceMapImageFilter class
 } //end namespace itk
 
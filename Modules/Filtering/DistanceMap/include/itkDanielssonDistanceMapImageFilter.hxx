@@ -21,8 +21,8 @@
 #include <iostream>
 
 #include "itkDanielssonDistanceMapImageFilter.h"
-#include "itkReflectiveImageRegionConstIterator.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionSplitter.h"
 
 namespace itk
 {
@@ -47,6 +47,7 @@ DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
   m_SquaredDistance     = false;
   m_InputIsBinary       = false;
   m_UseImageSpacing     = true;
+  m_ComputeVectorDistanceMap = true;
 }
 
 template< class TInputImage, class TOutputImage, class TVoronoiImage >
@@ -148,18 +149,6 @@ DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
 
   typename OutputImageType::RegionType region  = voronoiMap->GetRequestedRegion();
 
-  // find the largest of the image dimensions
-  SizeType size = region.GetSize();
-  SizeValueType maxLength = 0;
-
-  for ( unsigned int dim = 0; dim < InputImageDimension; dim++ )
-    {
-    if ( maxLength < size[dim] )
-      {
-      maxLength = size[dim];
-      }
-    }
-
   ImageRegionConstIteratorWithIndex< InputImageType >  it(inputImage,  region);
   ImageRegionIteratorWithIndex< VoronoiImageType >     ot(voronoiMap,  region);
 
@@ -196,44 +185,38 @@ DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
 
   VectorImagePointer distanceComponents = GetVectorDistanceMap();
 
-  distanceComponents->SetLargestPossibleRegion(
-    inputImage->GetLargestPossibleRegion() );
-
-  distanceComponents->SetBufferedRegion(
-    inputImage->GetBufferedRegion() );
-
-  distanceComponents->SetRequestedRegion(
-    inputImage->GetRequestedRegion() );
-
-  distanceComponents->Allocate();
+  if ( m_ComputeVectorDistanceMap )
+    {
+    distanceComponents->SetLargestPossibleRegion(
+      inputImage->GetLargestPossibleRegion() );
 
-  ImageRegionIteratorWithIndex< VectorImageType > ct(distanceComponents,  region);
+    distanceComponents->SetBufferedRegion(
+      inputImage->GetBufferedRegion() );
 
-  OffsetType maxValue;
-  OffsetType minValue;
+    distanceComponents->SetRequestedRegion(
+      inputImage->GetRequestedRegion() );
 
-  for ( unsigned int j = 0; j < InputImageDimension; j++ )
+    distanceComponents->Allocate();
+    }
+  else
     {
-    maxValue[j] =  2 * maxLength;
-    minValue[j] =              0;
+    distanceComponents->ReleaseData();
     }
 
-  itkDebugMacro(<< "PrepareData: Copy output to ct");
+  itkDebugMacro(<< "PrepareData: Initialize the closest object pixels");
+
+  // The object pixels are their own closest object pixels
+  m_ClosestObject.assign(voronoiMap->GetBufferedRegion().GetNumberOfPixels(), -1);
 
   ot.GoToBegin();
-  ct.GoToBegin();
   while ( !ot.IsAtEnd() )
     {
     if ( ot.Get() )
       {
-      ct.Set(minValue);
-      }
-    else
-      {
-      ct.Set(maxValue);
+      const OffsetValueType offset = voronoiMap->ComputeOffset( ot.GetIndex() );
+      m_ClosestObject[offset] = offset;
       }
     ++ot;
-    ++ct;
     }
   itkDebugMacro(<< "PrepareData End");
 }
@@ -247,32 +230,78 @@ DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
 ::ComputeVoronoiMap()
 {
   itkDebugMacro(<< "ComputeVoronoiMap Start");
+
+  DistanceThreadStruct str;
+  str.Filter = this;
+  str.Dimension = InputImageDimension;
+  str.LineRegion = this->GetVoronoiMap()->GetRequestedRegion();
+
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod(this->DistanceThreaderCallback, &str);
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  itkDebugMacro(<< "ComputeVoronoiMap End");
+}
+
+/**
+ *  Fill the output maps from the closest object pixels
+ */
+template< class TInputImage, class TOutputImage, class TVoronoiImage >
+void
+DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
+::ThreadedComputeVoronoiMap(const RegionType & region)
+{
   VoronoiImagePointer voronoiMap          =  this->GetVoronoiMap();
   OutputImagePointer  distanceMap         =  this->GetDistanceMap();
   VectorImagePointer  distanceComponents  =  this->GetVectorDistanceMap();
 
-  typename OutputImageType::RegionType region  = voronoiMap->GetRequestedRegion();
-
   ImageRegionIteratorWithIndex< VoronoiImageType > ot(voronoiMap,          region);
-  ImageRegionIteratorWithIndex< VectorImageType >  ct(distanceComponents,  region);
   ImageRegionIteratorWithIndex< OutputImageType >  dt(distanceMap,         region);
 
   typename InputImageType::SpacingType spacing = Self::GetInput()->GetSpacing();
 
-  itkDebugMacro(<< "ComputeVoronoiMap Region: " << region);
-  ot.GoToBegin();
-  ct.GoToBegin();
-  dt.GoToBegin();
+  // Pixels without any object keep the offset used by the original
+  // algorithm, twice the largest dimension of the image.
+  const SizeType & size = voronoiMap->GetRequestedRegion().GetSize();
+  SizeValueType    maxLength = 0;
+  for ( unsigned int dim = 0; dim < InputImageDimension; dim++ )
+    {
+    if ( maxLength < size[dim] )
+      {
+      maxLength = size[dim];
+      }
+    }
+  OffsetType noObjectOffset;
+  noObjectOffset.Fill(2 * maxLength);
+
+  const VoronoiPixelType *voronoiBuffer = voronoiMap->GetBufferPointer();
+
   while ( !ot.IsAtEnd() )
     {
-    IndexType index = ct.GetIndex() + ct.Get();
-    if ( region.IsInside(index) )
+    const IndexType       here = ot.GetIndex();
+    const OffsetValueType hereOffset = voronoiMap->ComputeOffset(here);
+    const OffsetValueType closest = m_ClosestObject[hereOffset];
+
+    OffsetType distanceVector;
+    if ( closest < 0 )
+      {
+      distanceVector = noObjectOffset;
+      }
+    else
       {
-      ot.Set( voronoiMap->GetPixel(index) );
+      distanceVector = voronoiMap->ComputeIndex(closest) - here;
+      // The object pixels are not written, they are read by other threads
+      if ( closest != hereOffset )
+        {
+        ot.Set(voronoiBuffer[closest]);
+        }
+      }
+    if ( m_ComputeVectorDistanceMap )
+      {
+      distanceComponents->SetPixel(here, distanceVector);
       }
 
-    OffsetType distanceVector = ct.Get();
-    double     distance = 0.0;
+    double distance = 0.0;
     if ( m_UseImageSpacing )
       {
       for ( unsigned int i = 0; i < InputImageDimension; i++ )
@@ -298,147 +327,194 @@ DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
       dt.Set( static_cast< OutputPixelType >( vcl_sqrt(distance) ) );
       }
     ++ot;
-    ++ct;
     ++dt;
     }
-  itkDebugMacro(<< "ComputeVoronoiMap End");
 }
 
 /**
- *  Locally update the distance.
+ *  Find the closest object pixels along the lines of one dimension
  */
 template< class TInputImage, class TOutputImage, class TVoronoiImage >
 void
 DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
-::UpdateLocalDistance(VectorImageType *components,
-                      const IndexType & here,
-                      const OffsetType & offset)
+::ThreadedComputeClosestObject(unsigned int dimension,
+                               const RegionType & lineRegion)
 {
-  IndexType  there            = here + offset;
-  OffsetType offsetValueHere  = components->GetPixel(here);
-  OffsetType offsetValueThere = components->GetPixel(there) + offset;
+  VoronoiImagePointer voronoiMap = this->GetVoronoiMap();
 
-  SpacingType spacing = this->GetInput()->GetSpacing();
+  const SizeValueType   length = voronoiMap->GetRequestedRegion().GetSize()[dimension];
+  const OffsetValueType stride = voronoiMap->GetOffsetTable()[dimension];
 
-  double norm1 = 0.0;
-  double norm2 = 0.0;
+  // Squared weight of a unit offset along each dimension
+  double weight[InputImageDimension];
   for ( unsigned int i = 0; i < InputImageDimension; i++ )
     {
-    double v1 = static_cast< double >(  offsetValueHere[i]  );
-    double v2 = static_cast< double >(  offsetValueThere[i] );
-
+    weight[i] = 1.0;
     if ( m_UseImageSpacing )
       {
-      double spacingComponent = static_cast< double >( spacing[i] );
-      v1 *= spacingComponent;
-      v2 *= spacingComponent;
+      const double spacing = static_cast< double >( this->GetInput()->GetSpacing()[i] );
+      weight[i] = spacing * spacing;
       }
-
-    norm1 += v1 * v1;
-    norm2 += v2 * v2;
     }
+  const double step = vcl_sqrt(weight[dimension]);
+
+  // Lower envelope of the parabolas centered on the positions along the
+  // line which have a closest object pixel, whose height is the squared
+  // distance to it.
+  std::vector< double >          height(length);
+  std::vector< double >          position(length);
+  std::vector< OffsetValueType > object(length);
 
-  if ( norm1 > norm2 )
+  ImageRegionConstIteratorWithIndex< VoronoiImageType > lineIt(voronoiMap, lineRegion);
+  while ( !lineIt.IsAtEnd() )
     {
-    components->SetPixel( here, offsetValueThere );
+    IndexType             lineStart = lineIt.GetIndex();
+    const OffsetValueType lineOffset = voronoiMap->ComputeOffset(lineStart);
+
+    int l = -1;
+    for ( SizeValueType i = 0; i < length; i++ )
+      {
+      const OffsetValueType closest = m_ClosestObject[lineOffset + i * stride];
+      if ( closest < 0 )
+        {
+        continue;
+        }
+
+      // The closest object pixel only differs from the pixel along the
+      // dimensions already processed
+      const IndexType closestIndex = voronoiMap->ComputeIndex(closest);
+      double          g = 0.0;
+      for ( unsigned int j = 0; j < dimension; j++ )
+        {
+        const double component = static_cast< double >( closestIndex[j] - lineStart[j] );
+        g += weight[j] * component * component;
+        }
+      const double h = static_cast< double >( i ) * step;
+
+      while ( l >= 1 )
+        {
+        // Remove the previous parabola if it is nowhere the lowest
+        const double a = position[l] - position[l - 1];
+        const double b = h - position[l];
+        const double c = h - position[l - 1];
+        if ( c * height[l] - b * height[l - 1] - a * g - a * b * c > 0 )
+          {
+          l--;
+          }
+        else
+          {
+          break;
+          }
+        }
+      l++;
+      height[l] = g;
+      position[l] = h;
+      object[l] = closest;
+      }
+
+    if ( l >= 0 )
+      {
+      const int ns = l;
+      l = 0;
+      for ( SizeValueType i = 0; i < length; i++ )
+        {
+        const double h = static_cast< double >( i ) * step;
+        double       d1 = height[l] + ( position[l] - h ) * ( position[l] - h );
+        while ( l < ns )
+          {
+          const double d2 = height[l + 1] + ( position[l + 1] - h ) * ( position[l + 1] - h );
+          if ( d1 <= d2 )
+            {
+            break;
+            }
+          l++;
+          d1 = d2;
+          }
+        m_ClosestObject[lineOffset + i * stride] = object[l];
+        }
+      }
+    ++lineIt;
     }
 }
 
 /**
- *  Compute Distance and Voronoi maps
+ *  Static function used as a "callback" by the MultiThreader
  */
 template< class TInputImage, class TOutputImage, class TVoronoiImage >
-void
+ITK_THREAD_RETURN_TYPE
 DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
-::GenerateData()
+::DistanceThreaderCallback(void *arg)
 {
-  this->PrepareData();
-
-  // Specify images and regions.
+  ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+  ThreadIdType threadCount = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->NumberOfThreads;
 
-  VoronoiImagePointer voronoiMap             =  this->GetVoronoiMap();
-  VectorImagePointer  distanceComponents     =  this->GetVectorDistanceMap();
+  DistanceThreadStruct *str = (DistanceThreadStruct *)
+    ( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
 
-  RegionType region  = voronoiMap->GetRequestedRegion();
-
-  itkDebugMacro (<< "Region to process: " << region);
+  typedef ImageRegionSplitter< InputImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
 
-  // Instantiate reflective iterator
-
-  ReflectiveImageRegionConstIterator< VectorImageType >
-  it(distanceComponents, region);
-
-  typename VectorImageType::OffsetType voffset;
-  for ( unsigned int dim = 0; dim < InputImageDimension; dim++ )
+  ThreadIdType total = splitter->GetNumberOfSplits(str->LineRegion, threadCount);
+  if ( threadId < total )
     {
-    if ( region.GetSize()[dim] > 1 )
+    const RegionType region = splitter->GetSplit(threadId, total, str->LineRegion);
+    if ( str->Dimension < InputImageDimension )
       {
-      voffset[dim] = 1;
+      str->Filter->ThreadedComputeClosestObject(str->Dimension, region);
       }
     else
       {
-      voffset[dim] = 0;
+      str->Filter->ThreadedComputeVoronoiMap(region);
       }
     }
-  it.SetBeginOffset(voffset);
-  it.SetEndOffset(voffset);
 
-  it.GoToBegin();
+  return ITK_THREAD_RETURN_VALUE;
+}
 
-  // Support progress methods/callbacks.
+/**
+ *  Compute Distance and Voronoi maps
+ */
+template< class TInputImage, class TOutputImage, class TVoronoiImage >
+void
+DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
+::GenerateData()
+{
+  this->PrepareData();
 
-  // Each pixel is visited 2^InputImageDimension times, and the number
-  // of visits per pixel needs to be computed for progress reporting.
-  SizeValueType visitsPerPixel = ( 1 << InputImageDimension );
-  SizeValueType updateVisits = region.GetNumberOfPixels() * visitsPerPixel / 10;
-  if ( updateVisits < 1 )
-    {
-    updateVisits = 1;
-    }
-  const float updatePeriod = static_cast< float >( updateVisits ) * 10.0;
+  RegionType region  = this->GetVoronoiMap()->GetRequestedRegion();
 
-  // Process image.
+  itkDebugMacro (<< "Region to process: " << region);
 
-  OffsetType offset;
-  offset.Fill(0);
+  // Process the lines along one dimension after the other.  The threads
+  // split the lines, that is the region of their first pixels.
+  itkDebugMacro(<< "GenerateData: Computing distance transform");
 
-  SizeValueType i = 0;
+  DistanceThreadStruct str;
+  str.Filter = this;
 
-  itkDebugMacro(<< "GenerateData: Computing distance transform");
-  while ( !it.IsAtEnd() )
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod(this->DistanceThreaderCallback, &str);
+
+  for ( unsigned int dim = 0; dim < InputImageDimension; dim++ )
     {
-    if ( !( i % updateVisits ) )
-      {
-      this->UpdateProgress( static_cast< float >( i ) / updatePeriod );
-      }
+    this->UpdateProgress( static_cast< float >( dim ) / ( InputImageDimension + 1 ) );
 
-    IndexType here = it.GetIndex();
-    for ( unsigned int dim = 0; dim < InputImageDimension; dim++ )
-      {
-      if ( region.GetSize()[dim] <= 1 )
-        {
-        continue;
-        }
-      if ( it.IsReflected(dim) )
-        {
-        offset[dim]++;
-        UpdateLocalDistance(distanceComponents, here, offset);
-        offset[dim] = 0;
-        }
-      else
-        {
-        offset[dim]--;
-        UpdateLocalDistance(distanceComponents, here, offset);
-        offset[dim] = 0;
-        }
-      }
-    ++it;
-    ++i;
+    str.Dimension = dim;
+    str.LineRegion = region;
+    str.LineRegion.SetSize(dim, 1);
+    this->GetMultiThreader()->SingleMethodExecute();
     }
 
+  this->UpdateProgress( static_cast< float >( InputImageDimension ) / ( InputImageDimension + 1 ) );
+
   itkDebugMacro(<< "GenerateData: ComputeVoronoiMap");
 
   this->ComputeVoronoiMap();
+
+  // Release the working memory
+  std::vector< OffsetValueType >().swap(m_ClosestObject);
+
+  this->UpdateProgress(1.0f);
 } // end GenerateData()
 
 /**
@@ -455,6 +531,7 @@ DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
   os << indent << "Input Is Binary   : " << m_InputIsBinary << std::endl;
   os << indent << "Use Image Spacing : " << m_UseImageSpacing << std::endl;
   os << indent << "Squared Distance  : " << m_SquaredDistance << std::endl;
+  os << indent << "Compute Vector Distance Map : " << m_ComputeVectorDistanceMap << std::endl;
 }
 } // end namespace itk
 
@@ -145,6 +145,7 @@ DirectedHausdorffDistanceImageFilter< TInputImage1, TInputImage2 >
 
   filter->SetInput( this->GetInput2() );
   filter->SetUseImageSpacing(m_UseImageSpacing);
+  filter->ComputeVectorDistanceMapOff();
   filter->Update();
 
   m_DistanceMap = filter->GetOutput();
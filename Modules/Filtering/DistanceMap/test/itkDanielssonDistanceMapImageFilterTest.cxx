@@ -300,5 +300,124 @@ int itkDanielssonDistanceMapImageFilterTest(int, char* [] )
     it2D2.NextSlice();
     }
 
+  /* Compare with the exact distances in 3D, for several numbers of threads */
+  std::cout << "Compare with the exact distances of a 3D image" << std::endl;
+
+  typedef itk::Image<unsigned char, 3>  myImageType3D1;
+  typedef itk::Image<float, 3>          myImageType3D2;
+
+  myImageType3D1::SizeType size3D = {{13,9,11}};
+  myImageType3D1::RegionType region3D;
+  region3D.SetSize( size3D );
+
+  myImageType3D1::SpacingType spacing3D;
+  spacing3D[0] = 1.0;
+  spacing3D[1] = 2.5;
+  spacing3D[2] = 0.7;
+
+  myImageType3D1::Pointer inputImage3D = myImageType3D1::New();
+  inputImage3D->SetRegions( region3D );
+  inputImage3D->SetSpacing( spacing3D );
+  inputImage3D->Allocate();
+  inputImage3D->FillBuffer( 0 );
+
+  const unsigned int numberOfObjects = 5;
+  const itk::IndexValueType objects[numberOfObjects][3] =
+    { {0,0,0}, {12,3,7}, {5,8,2}, {6,4,10}, {2,5,5} };
+  for( unsigned int k = 0; k < numberOfObjects; k++ )
+    {
+    myImageType3D1::IndexType objectIndex;
+    for( unsigned int i = 0; i < 3; i++ )
+      {
+      objectIndex[i] = objects[k][i];
+      }
+    inputImage3D->SetPixel( objectIndex, k + 1 );
+    }
+
+  typedef itk::DanielssonDistanceMapImageFilter<
+                                            myImageType3D1,
+                                            myImageType3D2 > myFilterType3D;
+
+  myFilterType3D::Pointer filter3D = myFilterType3D::New();
+  filter3D->SetInput( inputImage3D );
+  filter3D->UseImageSpacingOn();
+
+  const unsigned int numberOfThreads[3] = { 1, 3, 8 };
+  for( unsigned int t = 0; t < 3; t++ )
+    {
+    filter3D->SetNumberOfThreads( numberOfThreads[t] );
+    filter3D->SetComputeVectorDistanceMap( t != 2 );
+    filter3D->Update();
+
+    itk::ImageRegionConstIteratorWithIndex<myImageType3D2> it3D(
+                                filter3D->GetDistanceMap(), region3D );
+    for( it3D.GoToBegin(); !it3D.IsAtEnd(); ++it3D )
+      {
+      const myImageType3D1::IndexType here = it3D.GetIndex();
+      double expected = itk::NumericTraits<double>::max();
+      unsigned int closest = 0;
+      for( unsigned int k = 0; k < numberOfObjects; k++ )
+        {
+        double distance = 0.0;
+        for( unsigned int i = 0; i < 3; i++ )
+          {
+          const double component = ( here[i] - objects[k][i] ) * spacing3D[i];
+          distance += component * component;
+          }
+        if( distance < expected )
+          {
+          expected = distance;
+          closest = k + 1;
+          }
+        }
+      expected = vcl_sqrt( expected );
+
+      if( vcl_fabs( expected - it3D.Get() ) > epsilon )
+        {
+        std::cerr << "Error in the 3D distance map with " << numberOfThreads[t]
+                  << " threads at " << here << ": " << it3D.Get()
+                  << ", expected " << expected << std::endl;
+        return EXIT_FAILURE;
+        }
+
+      // Check the Voronoi label and the vector when the closest object is unique
+      const myFilterType3D::VoronoiImageType::PixelType label =
+        filter3D->GetVoronoiMap()->GetPixel( here );
+      double labelDistance = 0.0;
+      for( unsigned int i = 0; i < 3; i++ )
+        {
+        const double component = ( here[i] - objects[label - 1][i] ) * spacing3D[i];
+        labelDistance += component * component;
+        }
+      if( vcl_fabs( vcl_sqrt( labelDistance ) - expected ) > epsilon )
+        {
+        std::cerr << "Error in the 3D Voronoi map with " << numberOfThreads[t]
+                  << " threads at " << here << ": " << label
+                  << ", expected " << closest << std::endl;
+        return EXIT_FAILURE;
+        }
+      if( filter3D->GetComputeVectorDistanceMap() )
+        {
+        const myFilterType3D::OffsetType vector =
+          filter3D->GetVectorDistanceMap()->GetPixel( here );
+        for( unsigned int i = 0; i < 3; i++ )
+          {
+          if( here[i] + vector[i] != objects[label - 1][i] )
+            {
+            std::cerr << "Error in the 3D vector map with " << numberOfThreads[t]
+                      << " threads at " << here << ": " << vector << std::endl;
+            return EXIT_FAILURE;
+            }
+          }
+        }
+      }
+    }
+
+  if( filter3D->GetVectorDistanceMap()->GetBufferPointer() != NULL )
+    {
+    std::cerr << "The vector distance map was computed although disabled" << std::endl;
+    return EXIT_FAILURE;
+    }
+
   return EXIT_SUCCESS;
 }
@@ -133,6 +133,9 @@ protected:
 
   virtual void UpdateValue( OutputImageType* oImage, const NodeType& iValue );
 
+  /** The auxiliary values are only extended by the fast marching. */
+  virtual void GenerateData();
+
   /** Generate the output image meta information */
   virtual void GenerateOutputInformation();
 
@@ -211,6 +211,21 @@ FastMarchingExtensionImageFilterBase< TInput, TOutput, TAuxValue, VAuxDimension
     }   // if AuxTrialValues set
 }
 
+template< class TInput, class TOutput,
+         class TAuxValue,
+         unsigned int VAuxDimension >
+void
+FastMarchingExtensionImageFilterBase< TInput, TOutput, TAuxValue, VAuxDimension >
+::GenerateData()
+{
+  if( this->GetUseFastIterativeMethod() )
+    {
+    itkWarningMacro( << "The auxiliary values are not extended by the fast "
+                     << "iterative method, the fast marching is used instead." );
+    }
+  FastMarchingBase< TInput, TOutput >::GenerateData();
+}
+
 template< class TInput, class TOutput,
          class TAuxValue,
          unsigned int VAuxDimension >
@@ -24,6 +24,9 @@
 #include "itkNeighborhoodIterator.h"
 #include "itkArray.h"
 
+#include <string>
+#include <vector>
+
 namespace itk
 {
 /**
@@ -60,6 +63,11 @@ namespace itk
  * "Level Set Methods and Fast Marching Methods", J.A. Sethian,
  * Cambridge Press, Second edition, 1999.
  *
+ * The arrival times can alternatively be computed on several threads with
+ * the fast iterative method (see SetUseFastIterativeMethod()) of
+ * "A Fast Iterative Method for Eikonal Equations", W.-K. Jeong and
+ * R.T. Whitaker, SIAM Journal on Scientific Computing, 30(5), 2008.
+ *
  * \tparam TTraits traits
  *
  * \sa ImageFastMarchingTraits
@@ -154,6 +162,18 @@ public:
   itkGetConstReferenceMacro(OverrideOutputInformation, bool);
   itkBooleanMacro(OverrideOutputInformation);
 
+  /** Set/Get whether the arrival times are computed with the fast iterative
+   * method instead of the priority queue.  The image is split in slabs over
+   * the threads, and the nodes whose neighbors changed are updated until the
+   * values converge.  The nodes are then set alive in increasing order of
+   * arrival time so that the stopping criterion, the collected points and
+   * the values of the trial nodes are the ones of the fast marching.  This
+   * requires one sorted offset per reached node.  Topology checks are only
+   * supported by the fast marching, which is the default. */
+  itkSetMacro(UseFastIterativeMethod, bool);
+  itkGetConstReferenceMacro(UseFastIterativeMethod, bool);
+  itkBooleanMacro(UseFastIterativeMethod);
+
 protected:
 
   /** Constructor */
@@ -173,6 +193,9 @@ protected:
   OutputSpacingType   m_OutputSpacing;
   OutputDirectionType m_OutputDirection;
   bool                m_OverrideOutputInformation;
+  bool                m_UseFastIterativeMethod;
+
+  typedef typename OutputImageType::OffsetValueType OutputOffsetValueType;
 
   /** Generate the output image meta information. */
   virtual void GenerateOutputInformation();
@@ -223,6 +246,74 @@ protected:
                const NodeType& iNode,
                std::vector< InternalNodeStructure >& ioNeighbors ) const;
 
+  /** Compute the output with the fast marching or the fast iterative
+   * method */
+  virtual void GenerateData();
+
+  /** Called by the fast iterative method on each node set alive, in the
+   * order of the fast marching, once its neighbors are known. */
+  virtual void UpdateAliveNode( OutputImageType* itkNotUsed( oImage ),
+                                const NodeType& itkNotUsed( iNode ) ) {}
+
+  /** Order the nodes by arrival time, then by offset. */
+  class FastIterativeNodeCompare
+    {
+  public:
+    FastIterativeNodeCompare( const OutputPixelType* iBuffer ) :
+      m_Buffer( iBuffer ) {}
+
+    bool operator()( OutputOffsetValueType iLeft,
+                     OutputOffsetValueType iRight ) const
+      {
+      return ( m_Buffer[iLeft] < m_Buffer[iRight] ) ||
+        ( ( m_Buffer[iLeft] == m_Buffer[iRight] ) && ( iLeft < iRight ) );
+      }
+
+    const OutputPixelType* m_Buffer;
+    };
+
+  /** Data shared by the threads of the fast iterative method.  Each thread
+   * owns a slab of slices along the last dimension. */
+  struct FastIterativeThreadStruct
+    {
+    enum StageType { Activate, Compute, Update, Sort };
+
+    FastMarchingImageFilterBase*                  Filter;
+    StageType                                     Stage;
+    OutputOffsetValueType                         SliceStride;
+    std::vector< OutputOffsetValueType >          SlabBegin;
+    std::vector< ThreadIdType >                   SliceOwner;
+    std::vector< unsigned char >                  Active;
+
+    // Nodes to update, by source and destination thread
+    std::vector< std::vector< std::vector< OutputOffsetValueType > > > Candidates;
+    std::vector< std::vector< std::pair< OutputOffsetValueType, OutputPixelType > > >
+                                                  Updates;
+    std::vector< std::vector< OutputOffsetValueType > > Sorted;
+    std::vector< std::string >                    Errors;
+    };
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE FastIterativeThreaderCallback( void *arg );
+
+  /** Run the current stage of the fast iterative method on the slab of
+   * the given thread. */
+  void ThreadedFastIterativeStage( FastIterativeThreadStruct* str,
+                                   ThreadIdType threadId );
+
+  /** Queue the neighbors of the given node which have to be updated. */
+  void FastIterativeActivateNeighbors( FastIterativeThreadStruct* str,
+                                       ThreadIdType threadId,
+                                       OutputOffsetValueType iOffset,
+                                       const NodeType& iNode ) const;
+
+  /** Run one stage of the fast iterative method on all the threads. */
+  void ExecuteFastIterativeStage( FastIterativeThreadStruct& str,
+                                  typename FastIterativeThreadStruct::StageType iStage );
+
+  /** Compute the output with the fast iterative method. */
+  void FastIterativeGenerateData();
+
   // --------------------------------------------------------------------------
   // --------------------------------------------------------------------------
 
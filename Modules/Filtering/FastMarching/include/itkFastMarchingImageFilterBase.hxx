@@ -24,6 +24,9 @@
 #include "itkImageRegionIterator.h"
 #include "itkConnectedComponentImageFilter.h"
 #include "itkRelabelComponentImageFilter.h"
+#include "itkProgressReporter.h"
+
+#include <algorithm>
 
 namespace itk
 {
@@ -66,6 +69,7 @@ FastMarchingImageFilterBase()
   m_OutputSpacing.Fill(1.0);
   m_OutputDirection.SetIdentity();
   m_OverrideOutputInformation = false;
+  m_UseFastIterativeMethod = false;
 
   m_LabelImage = LabelImageType::New();
   }
@@ -203,17 +207,19 @@ UpdateNeighbors( OutputImageType* oImage, const NodeType& iNode )
 
     for( s = -1; s < 2; s+= 2 )
       {
-      if ( ( v > start ) && ( v < last ) )
+      // make sure the neighbor is inside the image
+      if ( ( v + s >= start ) && ( v + s <= last ) )
         {
         neighIndex[j] = v + s;
-        }
-      label = m_LabelImage->GetPixel(neighIndex);
 
-      if ( ( label != Traits::Alive ) &&
-           ( label != Traits::InitialTrial ) &&
-           ( label != Traits::Forbidden ) )
-        {
-        this->UpdateValue( oImage, neighIndex );
+        label = m_LabelImage->GetPixel(neighIndex);
+
+        if ( ( label != Traits::Alive ) &&
+             ( label != Traits::InitialTrial ) &&
+             ( label != Traits::Forbidden ) )
+          {
+          this->UpdateValue( oImage, neighIndex );
+          }
         }
       }
 
@@ -387,6 +393,421 @@ Solve( OutputImageType* oImage,
   }
 // -----------------------------------------------------------------------------
 
+// -----------------------------------------------------------------------------
+template< class TInput, class TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+GenerateData()
+  {
+  if( !m_UseFastIterativeMethod )
+    {
+    Superclass::GenerateData();
+    return;
+    }
+
+  if( this->m_TopologyCheck != Superclass::Nothing )
+    {
+    itkWarningMacro( << "Topology checks are not supported by the fast "
+                     << "iterative method, the fast marching is used instead." );
+    Superclass::GenerateData();
+    return;
+    }
+
+  this->FastIterativeGenerateData();
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< class TInput, class TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+FastIterativeGenerateData()
+  {
+  OutputImageType* output = this->GetOutput();
+
+  this->Initialize( output );
+
+  // the trial points are read back from the label image
+  while( !this->m_Heap.empty() )
+    {
+    this->m_Heap.pop();
+    }
+
+  // split the image in slabs of slices along the last dimension
+  const unsigned int lastDimension = ImageDimension - 1;
+  const OutputSizeType size = m_BufferedRegion.GetSize();
+
+  ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+  if( numberOfThreads > size[lastDimension] )
+    {
+    numberOfThreads = static_cast< ThreadIdType >( size[lastDimension] );
+    }
+
+  FastIterativeThreadStruct str;
+  str.Filter = this;
+  str.SliceStride = output->GetOffsetTable()[lastDimension];
+  str.SlabBegin.resize( numberOfThreads + 1 );
+  str.SliceOwner.resize( size[lastDimension] );
+
+  for( ThreadIdType t = 0; t <= numberOfThreads; t++ )
+    {
+    const typename OutputSizeType::SizeValueType slice =
+      ( size[lastDimension] * t ) / numberOfThreads;
+    str.SlabBegin[t] = static_cast< OutputOffsetValueType >( slice ) * str.SliceStride;
+    if( t < numberOfThreads )
+      {
+      const typename OutputSizeType::SizeValueType nextSlice =
+        ( size[lastDimension] * ( t + 1 ) ) / numberOfThreads;
+      std::fill( str.SliceOwner.begin() + slice,
+                 str.SliceOwner.begin() + nextSlice, t );
+      }
+    }
+
+  str.Active.assign( m_BufferedRegion.GetNumberOfPixels(), 0 );
+  str.Candidates.resize( numberOfThreads );
+  for( ThreadIdType t = 0; t < numberOfThreads; t++ )
+    {
+    str.Candidates[t].resize( numberOfThreads );
+    }
+  str.Updates.resize( numberOfThreads );
+  str.Sorted.resize( numberOfThreads );
+  str.Errors.resize( numberOfThreads );
+
+  this->GetMultiThreader()->SetNumberOfThreads( numberOfThreads );
+  this->GetMultiThreader()->SetSingleMethod( this->FastIterativeThreaderCallback, &str );
+
+  // update the neighbors of the alive and trial nodes until convergence
+  this->ExecuteFastIterativeStage( str, FastIterativeThreadStruct::Activate );
+
+  bool converged = false;
+  while( !converged )
+    {
+    this->ExecuteFastIterativeStage( str, FastIterativeThreadStruct::Compute );
+    this->ExecuteFastIterativeStage( str, FastIterativeThreadStruct::Update );
+
+    converged = true;
+    for( ThreadIdType s = 0; ( s < numberOfThreads ) && converged; s++ )
+      {
+      for( ThreadIdType t = 0; t < numberOfThreads; t++ )
+        {
+        if( !str.Candidates[s][t].empty() )
+          {
+          converged = false;
+          break;
+          }
+        }
+      }
+    }
+
+  std::vector< unsigned char >().swap( str.Active );
+
+  // sort the reached nodes of each slab by arrival time
+  this->ExecuteFastIterativeStage( str, FastIterativeThreadStruct::Sort );
+
+  // set the nodes alive in the order of the fast marching, merging the
+  // sorted slabs, until the stopping criterion is satisfied
+  typedef std::pair< OutputPixelType, OutputOffsetValueType > MergeKeyType;
+  typedef std::pair< MergeKeyType, ThreadIdType >              MergeElementType;
+  typedef std::priority_queue< MergeElementType,
+                               std::vector< MergeElementType >,
+                               std::greater< MergeElementType > > MergeQueueType;
+
+  const OutputPixelType* buffer = output->GetBufferPointer();
+
+  MergeQueueType merge;
+  std::vector< size_t > position( numberOfThreads, 0 );
+  for( ThreadIdType t = 0; t < numberOfThreads; t++ )
+    {
+    if( !str.Sorted[t].empty() )
+      {
+      const OutputOffsetValueType offset = str.Sorted[t].front();
+      merge.push( MergeElementType( MergeKeyType( buffer[offset], offset ), t ) );
+      }
+    }
+
+  ProgressReporter progress( this, 0, this->GetTotalNumberOfNodes() );
+
+  this->m_StoppingCriterion->Reinitialize();
+
+  OutputPixelType current_value = 0.;
+
+  while( !merge.empty() )
+    {
+    const MergeElementType element = merge.top();
+
+    const NodeType current_node = output->ComputeIndex( element.first.second );
+    current_value = element.first.first;
+
+    NodePairType current_node_pair( current_node, current_value );
+    this->m_StoppingCriterion->SetCurrentNodePair( current_node_pair );
+
+    if( this->m_StoppingCriterion->IsSatisfied() )
+      {
+      break;
+      }
+
+    merge.pop();
+
+    const ThreadIdType t = element.second;
+    if( ++position[t] < str.Sorted[t].size() )
+      {
+      const OutputOffsetValueType offset = str.Sorted[t][position[t]];
+      merge.push( MergeElementType( MergeKeyType( buffer[offset], offset ), t ) );
+      }
+
+    if ( this->m_CollectPoints )
+      {
+      this->m_ProcessedPoints->push_back( current_node_pair );
+      }
+
+    this->SetLabelValueForGivenNode( current_node, Traits::Alive );
+    this->UpdateAliveNode( output, current_node );
+
+    progress.CompletedPixel();
+    }
+
+  this->m_TargetReachedValue = current_value;
+
+  // the nodes which were not set alive get the values of the fast marching:
+  // the trial nodes are only computed from their alive neighbors
+  std::vector< InternalNodeStructure > NodesUsed( ImageDimension );
+
+  for( ThreadIdType t = 0; t < numberOfThreads; t++ )
+    {
+    for( size_t i = position[t]; i < str.Sorted[t].size(); i++ )
+      {
+      const NodeType node = output->ComputeIndex( str.Sorted[t][i] );
+
+      if( this->GetLabelValueForGivenNode( node ) != Traits::Far )
+        {
+        continue;
+        }
+
+      this->SetOutputValue( output, node, this->m_LargeValue );
+
+      this->GetInternalNodesUsed( output, node, NodesUsed );
+      for( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        if( NodesUsed[j].m_Value < this->m_LargeValue )
+          {
+          this->UpdateValue( output, node );
+          break;
+          }
+        }
+      }
+    }
+
+  while( !this->m_Heap.empty() )
+    {
+    this->m_Heap.pop();
+    }
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< class TInput, class TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+ExecuteFastIterativeStage( FastIterativeThreadStruct& str,
+                           typename FastIterativeThreadStruct::StageType iStage )
+  {
+  str.Stage = iStage;
+
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  for( size_t t = 0; t < str.Errors.size(); t++ )
+    {
+    if( !str.Errors[t].empty() )
+      {
+      itkExceptionMacro( << str.Errors[t] );
+      }
+    }
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< class TInput, class TOutput >
+ITK_THREAD_RETURN_TYPE
+FastMarchingImageFilterBase< TInput, TOutput >::
+FastIterativeThreaderCallback( void *arg )
+  {
+  ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+
+  FastIterativeThreadStruct *str = (FastIterativeThreadStruct *)
+    ( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+
+  try
+    {
+    str->Filter->ThreadedFastIterativeStage( str, threadId );
+    }
+  catch( ExceptionObject & err )
+    {
+    str->Errors[threadId] = err.GetDescription();
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< class TInput, class TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+FastIterativeActivateNeighbors( FastIterativeThreadStruct* str,
+                                ThreadIdType threadId,
+                                OutputOffsetValueType iOffset,
+                                const NodeType& iNode ) const
+  {
+  const typename LabelImageType::PixelType* labels = m_LabelImage->GetBufferPointer();
+  const OutputOffsetValueType* offsetTable = m_LabelImage->GetOffsetTable();
+
+  for ( unsigned int j = 0; j < ImageDimension; j++ )
+    {
+    for( int s = -1; s < 2; s += 2 )
+      {
+      const typename NodeType::IndexValueType temp = iNode[j] + s;
+      if ( ( temp <= m_LastIndex[j] ) && ( temp >= m_StartIndex[j] ) )
+        {
+        const OutputOffsetValueType neighbor = iOffset + s * offsetTable[j];
+        if( labels[neighbor] == Traits::Far )
+          {
+          const ThreadIdType owner = str->SliceOwner[neighbor / str->SliceStride];
+          str->Candidates[threadId][owner].push_back( neighbor );
+          }
+        }
+      }
+    }
+  }
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< class TInput, class TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+ThreadedFastIterativeStage( FastIterativeThreadStruct* str,
+                            ThreadIdType threadId )
+  {
+  OutputImageType* output = this->GetOutput();
+  OutputPixelType* buffer = output->GetBufferPointer();
+
+  const typename LabelImageType::PixelType* labels = m_LabelImage->GetBufferPointer();
+
+  const OutputOffsetValueType slabBegin = str->SlabBegin[threadId];
+  const OutputOffsetValueType slabEnd = str->SlabBegin[threadId + 1];
+
+  switch( str->Stage )
+    {
+    case FastIterativeThreadStruct::Activate:
+      {
+      for( OutputOffsetValueType offset = slabBegin; offset < slabEnd; ++offset )
+        {
+        if( ( labels[offset] == Traits::Alive ) ||
+            ( labels[offset] == Traits::InitialTrial ) )
+          {
+          this->FastIterativeActivateNeighbors( str, threadId, offset,
+                                                output->ComputeIndex( offset ) );
+          }
+        }
+      break;
+      }
+    case FastIterativeThreadStruct::Compute:
+      {
+      // gather the nodes of the slab queued by all the threads
+      std::vector< OutputOffsetValueType > activeNodes;
+      for( size_t s = 0; s < str->Candidates.size(); s++ )
+        {
+        std::vector< OutputOffsetValueType > & candidates = str->Candidates[s][threadId];
+        for( size_t i = 0; i < candidates.size(); i++ )
+          {
+          if( !str->Active[candidates[i]] )
+            {
+            str->Active[candidates[i]] = 1;
+            activeNodes.push_back( candidates[i] );
+            }
+          }
+        candidates.clear();
+        }
+
+      // solve with the current values of all the reached neighbors
+      const OutputOffsetValueType* offsetTable = output->GetOffsetTable();
+
+      std::vector< InternalNodeStructure > NodesUsed( ImageDimension );
+      std::vector< std::pair< OutputOffsetValueType, OutputPixelType > > & updates =
+        str->Updates[threadId];
+
+      for( size_t i = 0; i < activeNodes.size(); i++ )
+        {
+        const OutputOffsetValueType offset = activeNodes[i];
+        str->Active[offset] = 0;
+
+        const NodeType node = output->ComputeIndex( offset );
+
+        for ( unsigned int j = 0; j < ImageDimension; j++ )
+          {
+          InternalNodeStructure & temp_node = NodesUsed[j];
+          temp_node.m_Value = this->m_LargeValue;
+          temp_node.m_Node = node;
+          temp_node.m_Axis = j;
+
+          for( int s = -1; s < 2; s += 2 )
+            {
+            const typename NodeType::IndexValueType temp = node[j] + s;
+            if ( ( temp <= m_LastIndex[j] ) && ( temp >= m_StartIndex[j] ) )
+              {
+              const OutputOffsetValueType neighbor = offset + s * offsetTable[j];
+              if( ( labels[neighbor] != Traits::Forbidden ) &&
+                  ( temp_node.m_Value > buffer[neighbor] ) )
+                {
+                temp_node.m_Value = buffer[neighbor];
+                temp_node.m_Node[j] = temp;
+                }
+              }
+            }
+          }
+
+        const OutputPixelType outputPixel =
+          static_cast< OutputPixelType >( this->Solve( output, node, NodesUsed ) );
+
+        if( outputPixel < buffer[offset] )
+          {
+          updates.push_back( std::make_pair( offset, outputPixel ) );
+          }
+        }
+      break;
+      }
+    case FastIterativeThreadStruct::Update:
+      {
+      std::vector< std::pair< OutputOffsetValueType, OutputPixelType > > & updates =
+        str->Updates[threadId];
+
+      for( size_t i = 0; i < updates.size(); i++ )
+        {
+        buffer[updates[i].first] = updates[i].second;
+        this->FastIterativeActivateNeighbors( str, threadId, updates[i].first,
+                                              output->ComputeIndex( updates[i].first ) );
+        }
+      updates.clear();
+      break;
+      }
+    case FastIterativeThreadStruct::Sort:
+      {
+      std::vector< OutputOffsetValueType > & sorted = str->Sorted[threadId];
+      for( OutputOffsetValueType offset = slabBegin; offset < slabEnd; ++offset )
+        {
+        if( ( labels[offset] == Traits::InitialTrial ) ||
+            ( ( labels[offset] == Traits::Far ) &&
+              ( buffer[offset] < this->m_LargeValue ) ) )
+          {
+          sorted.push_back( offset );
+          }
+        }
+      std::sort( sorted.begin(), sorted.end(), FastIterativeNodeCompare( buffer ) );
+      break;
+      }
+    }
+  }
+// -----------------------------------------------------------------------------
+
 // -----------------------------------------------------------------------------
 template< class TInput, class TOutput >
 bool
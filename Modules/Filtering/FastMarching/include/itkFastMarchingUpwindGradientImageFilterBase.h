@@ -102,6 +102,9 @@ protected:
   virtual void ComputeGradient(OutputImageType* oImage,
                                const NodeType& iNode );
 
+  virtual void UpdateAliveNode( OutputImageType* oImage,
+                                const NodeType& iNode );
+
 private:
   FastMarchingUpwindGradientImageFilterBase(const Self &); //purposely not
                                                        // implemented
@@ -104,6 +104,16 @@ UpdateNeighbors(
   this->ComputeGradient( oImage, iNode );
 }
 
+template< class TInput, class TOutput >
+void
+FastMarchingUpwindGradientImageFilterBase< TInput, TOutput >::
+UpdateAliveNode(
+  OutputImageType* oImage,
+  const NodeType& iNode )
+{
+  this->ComputeGradient( oImage, iNode );
+}
+
 /**
  *
  */
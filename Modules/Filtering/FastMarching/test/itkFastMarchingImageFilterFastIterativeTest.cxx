@@ -0,0 +1,227 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkFastMarchingUpwindGradientImageFilterBase.h"
+#include "itkFastMarchingThresholdStoppingCriterion.h"
+#include "itkFastMarchingNumberOfElementsStoppingCriterion.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+namespace
+{
+typedef itk::Image< float, 3 >  FloatImageType;
+
+typedef itk::FastMarchingUpwindGradientImageFilterBase< FloatImageType, FloatImageType >
+  FastMarchingType;
+
+typedef FastMarchingType::NodePairType           NodePairType;
+typedef FastMarchingType::NodePairContainerType  NodePairContainerType;
+typedef FastMarchingType::StoppingCriterionType  StoppingCriterionType;
+typedef FastMarchingType::GradientImageType      GradientImageType;
+
+// Run the fast marching on the given speed image and keep its outputs
+FastMarchingType::Pointer
+RunFastMarching( FloatImageType* speed,
+                 NodePairContainerType* trial,
+                 NodePairContainerType* forbidden,
+                 StoppingCriterionType* criterion,
+                 bool useFastIterativeMethod,
+                 itk::ThreadIdType numberOfThreads )
+{
+  FastMarchingType::Pointer marcher = FastMarchingType::New();
+  marcher->SetInput( speed );
+  marcher->SetTrialPoints( trial );
+  marcher->SetForbiddenPoints( forbidden );
+  marcher->SetStoppingCriterion( criterion );
+  marcher->CollectPointsOn();
+  marcher->SetUseFastIterativeMethod( useFastIterativeMethod );
+  marcher->SetNumberOfThreads( numberOfThreads );
+  marcher->Update();
+
+  return marcher;
+}
+
+// Compare the outputs of the fast iterative method with the fast marching
+bool
+CompareOutputs( FastMarchingType* reference, FastMarchingType* test )
+{
+  const double tolerance = 1e-4;
+
+  bool passed = true;
+
+  if( reference->GetProcessedPoints()->Size() != test->GetProcessedPoints()->Size() )
+    {
+    std::cerr << "Number of alive nodes: " << test->GetProcessedPoints()->Size()
+              << ", expected " << reference->GetProcessedPoints()->Size() << std::endl;
+    passed = false;
+    }
+
+  if( vnl_math_abs( reference->GetTargetReachedValue() - test->GetTargetReachedValue() )
+      > tolerance * ( 1. + vnl_math_abs( reference->GetTargetReachedValue() ) ) )
+    {
+    std::cerr << "Target reached value: " << test->GetTargetReachedValue()
+              << ", expected " << reference->GetTargetReachedValue() << std::endl;
+    passed = false;
+    }
+
+  itk::ImageRegionIteratorWithIndex< FloatImageType >
+    it( reference->GetOutput(), reference->GetOutput()->GetBufferedRegion() );
+
+  unsigned int numberOfErrors = 0;
+
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const FastMarchingType::NodeType index = it.GetIndex();
+    const double expected = it.Get();
+    const double value = test->GetOutput()->GetPixel( index );
+
+    bool failed = ( reference->GetLabelImage()->GetPixel( index ) !=
+                    test->GetLabelImage()->GetPixel( index ) );
+    if( expected < itk::NumericTraits< float >::max() )
+      {
+      failed = failed ||
+        ( vnl_math_abs( expected - value ) > tolerance * ( 1. + expected ) );
+
+      for( unsigned int j = 0; j < 3; j++ )
+        {
+        failed = failed ||
+          ( vnl_math_abs( reference->GetGradientImage()->GetPixel( index )[j] -
+                          test->GetGradientImage()->GetPixel( index )[j] ) > 1e-3 );
+        }
+      }
+    else
+      {
+      failed = failed || ( value != expected );
+      }
+
+    if( failed && ( numberOfErrors++ < 10 ) )
+      {
+      std::cerr << "At " << index << ": " << value << " label "
+                << static_cast< int >( test->GetLabelImage()->GetPixel( index ) )
+                << ", expected " << expected << " label "
+                << static_cast< int >( reference->GetLabelImage()->GetPixel( index ) )
+                << std::endl;
+      }
+    }
+
+  return passed && ( numberOfErrors == 0 );
+}
+}
+
+int itkFastMarchingImageFilterFastIterativeTest( int, char* [] )
+{
+  // setup a speed image with varying speeds
+  FloatImageType::SizeType size = {{ 37, 29, 23 }};
+  FloatImageType::RegionType region;
+  region.SetSize( size );
+
+  FloatImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 0.8;
+  spacing[2] = 1.5;
+
+  FloatImageType::Pointer speed = FloatImageType::New();
+  speed->SetRegions( region );
+  speed->SetSpacing( spacing );
+  speed->Allocate();
+
+  unsigned int seed = 12345;
+  itk::ImageRegionIteratorWithIndex< FloatImageType > speedIt( speed, region );
+  for( speedIt.GoToBegin(); !speedIt.IsAtEnd(); ++speedIt )
+    {
+    seed = seed * 1103515245 + 12345;
+    speedIt.Set( 0.2 + ( ( seed >> 16 ) % 1000 ) / 1000.0 );
+    }
+
+  // two sources on the front
+  NodePairContainerType::Pointer trial = NodePairContainerType::New();
+
+  FastMarchingType::NodeType node;
+  node[0] = 5;
+  node[1] = 7;
+  node[2] = 3;
+  trial->push_back( NodePairType( node, 0. ) );
+  node[0] = 30;
+  node[1] = 20;
+  node[2] = 17;
+  trial->push_back( NodePairType( node, 2. ) );
+
+  // a wall with a hole in the middle
+  NodePairContainerType::Pointer forbidden = NodePairContainerType::New();
+  node[0] = 18;
+  for( node[1] = 0; node[1] < 29; node[1]++ )
+    {
+    for( node[2] = 0; node[2] < 23; node[2]++ )
+      {
+      if( ( node[1] < 12 ) || ( node[1] > 15 ) )
+        {
+        forbidden->push_back( NodePairType( node, 0. ) );
+        }
+      }
+    }
+
+  typedef itk::FastMarchingThresholdStoppingCriterion< FloatImageType, FloatImageType >
+    ThresholdCriterionType;
+  typedef itk::FastMarchingNumberOfElementsStoppingCriterion< FloatImageType, FloatImageType >
+    NumberOfElementsCriterionType;
+
+  std::vector< StoppingCriterionType::Pointer > criteria;
+
+  ThresholdCriterionType::Pointer fullCriterion = ThresholdCriterionType::New();
+  fullCriterion->SetThreshold( 1e6 );
+  criteria.push_back( fullCriterion.GetPointer() );
+
+  ThresholdCriterionType::Pointer thresholdCriterion = ThresholdCriterionType::New();
+  thresholdCriterion->SetThreshold( 12. );
+  criteria.push_back( thresholdCriterion.GetPointer() );
+
+  NumberOfElementsCriterionType::Pointer numberCriterion = NumberOfElementsCriterionType::New();
+  numberCriterion->SetTargetNumberOfElements( 5000 );
+  criteria.push_back( numberCriterion.GetPointer() );
+
+  const itk::ThreadIdType numberOfThreads[3] = { 1, 3, 8 };
+
+  bool passed = true;
+
+  for( size_t c = 0; c < criteria.size(); c++ )
+    {
+    FastMarchingType::Pointer reference =
+      RunFastMarching( speed, trial, forbidden, criteria[c], false, 1 );
+
+    for( unsigned int t = 0; t < 3; t++ )
+      {
+      std::cout << "Criterion " << c << ", " << numberOfThreads[t] << " threads" << std::endl;
+
+      FastMarchingType::Pointer marcher =
+        RunFastMarching( speed, trial, forbidden, criteria[c], true, numberOfThreads[t] );
+
+      if( !CompareOutputs( reference, marcher ) )
+        {
+        passed = false;
+        }
+      }
+    }
+
+  if( !passed )
+    {
+    std::cout << "Fast iterative method test failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Fast iterative method test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
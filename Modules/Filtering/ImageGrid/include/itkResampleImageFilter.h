@@ -26,6 +26,7 @@
 #include "itkLinearInterpolateImageFunction.h"
 #include "itkSize.h"
 #include "itkDefaultConvertPixelTraits.h"
+#include "itkIsSame.h"
 
 namespace itk
 {
@@ -329,6 +330,59 @@ protected:
                                   outputRegionForThread,
                                   ThreadIdType threadId);
 
+  /** Implementation for resampling with a B-spline interpolator when the
+   *  output grid maps onto the input grid axis by axis, e.g. through a
+   *  scaling and a translation.  The interpolation weights along each axis
+   *  are computed once per position along that axis.  Returns false, without
+   *  processing the region, when it does not apply.  B-spline interpolation
+   *  only supports scalar pixels, hence the overload for the other pixels. */
+  bool SeparableBSplineThreadedGenerateData(const OutputImageRegionType &
+                                            outputRegionForThread,
+                                            ThreadIdType threadId,
+                                            const TrueType &);
+
+  bool SeparableBSplineThreadedGenerateData(const OutputImageRegionType &,
+                                            ThreadIdType,
+                                            const FalseType &)
+  {
+    return false;
+  }
+
+  /** Implementation of LinearThreadedGenerateData() for a known
+   *  interpolator type: the interpolator is called without virtual dispatch
+   *  and the bounds check is skipped on the part of each scanline that maps
+   *  inside the input buffer. */
+  template< class TInterpolator >
+  void LinearThreadedGenerateDataWithInterpolator(const OutputImageRegionType &
+                                                  outputRegionForThread,
+                                                  ThreadIdType threadId,
+                                                  const TInterpolator *interpolator);
+
+  /** Call LinearThreadedGenerateDataWithInterpolator() if the interpolator is
+   *  a BSplineInterpolateImageFunction, and return whether it did. */
+  bool BSplineLinearThreadedGenerateData(const OutputImageRegionType &
+                                         outputRegionForThread,
+                                         ThreadIdType threadId,
+                                         const TrueType &);
+
+  bool BSplineLinearThreadedGenerateData(const OutputImageRegionType &,
+                                         ThreadIdType,
+                                         const FalseType &)
+  {
+    return false;
+  }
+
+  /** Compute the range [first, end) of the positions along a scanline of
+   *  the given length which are certainly inside the input buffer, when
+   *  the continuous index at position i is startIndex + i * delta.  The
+   *  positions next to the buffer boundary are excluded, so that they are
+   *  checked explicitly despite round-off in the incremental computation. */
+  void ComputeInsideBufferSpan(const ContinuousInputIndexType & startIndex,
+                               const typename PointType::VectorType & delta,
+                               SizeValueType length,
+                               SizeValueType & first,
+                               SizeValueType & end) const;
+
   virtual PixelType CastPixelWithBoundsChecking( const InterpolatorOutputType value,
                                                  const ComponentType minComponent,
                                                  const ComponentType maxComponent) const;
@@ -352,6 +406,14 @@ private:
   IndexType       m_OutputStartIndex;          // output image start index
   bool            m_UseReferenceImage;
 
+  /** Determine whether the mapping from output index to input continuous
+   *  index is separable, and if so, its scale and offset along each axis. */
+  void ComputeSeparableIndexMapping();
+
+  bool                                 m_IndexMappingIsSeparable;
+  FixedArray< double, ImageDimension > m_IndexMappingScale;
+  FixedArray< double, ImageDimension > m_IndexMappingOffset;  // at index zero
+
 };
 } // end namespace itk
 
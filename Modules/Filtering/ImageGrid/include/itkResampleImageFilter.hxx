@@ -26,6 +26,9 @@
 #include "itkImageLinearIteratorWithIndex.h"
 #include "itkSpecialCoordinatesImage.h"
 #include "itkDefaultConvertPixelTraits.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkNearestNeighborInterpolateImageFunction.h"
+#include <typeinfo>
 
 namespace itk
 {
@@ -43,6 +46,7 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
   m_OutputDirection.SetIdentity();
 
   m_UseReferenceImage = false;
+  m_IndexMappingIsSeparable = false;
 
   m_Size.Fill(0);
   m_OutputStartIndex.Fill(0);
@@ -182,6 +186,69 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
                                          zeroComponent );
       }
     }
+
+  this->ComputeSeparableIndexMapping();
+}
+
+/**
+ * Determine whether each input continuous index component only depends on
+ * the output index component along the same axis.
+ */
+template< class TInputImage,
+          class TOutputImage,
+          class TInterpolatorPrecisionType >
+void
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
+::ComputeSeparableIndexMapping()
+{
+  m_IndexMappingIsSeparable = false;
+
+  if ( !m_Transform->IsLinear() )
+    {
+    return;
+    }
+
+  OutputImagePointer     outputPtr = this->GetOutput();
+  InputImageConstPointer inputPtr = this->GetInput();
+
+  const OutputImageRegionType & largestRegion = outputPtr->GetLargestPossibleRegion();
+
+  // Map the start of the largest region and its neighbors along each axis
+  IndexType                index = largestRegion.GetIndex();
+  PointType                outputPoint;
+  ContinuousInputIndexType startIndex;
+  outputPtr->TransformIndexToPhysicalPoint(index, outputPoint);
+  inputPtr->TransformPhysicalPointToContinuousIndex(m_Transform->TransformPoint(outputPoint), startIndex);
+
+  for ( unsigned int j = 0; j < ImageDimension; j++ )
+    {
+    ContinuousInputIndexType neighborIndex;
+    ++index[j];
+    outputPtr->TransformIndexToPhysicalPoint(index, outputPoint);
+    inputPtr->TransformPhysicalPointToContinuousIndex(m_Transform->TransformPoint(outputPoint), neighborIndex);
+    --index[j];
+
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      const double delta = neighborIndex[i] - startIndex[i];
+      if ( i == j )
+        {
+        m_IndexMappingScale[i] = delta;
+        }
+      // Ignore round-off: the cross terms must move the input continuous
+      // index by less than 1e-6 pixels over the whole output image.
+      else if ( vnl_math_abs(delta) * largestRegion.GetSize()[j] > 1e-6 )
+        {
+        return;
+        }
+      }
+    }
+
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    m_IndexMappingOffset[i] = startIndex[i] - m_IndexMappingScale[i] * largestRegion.GetIndex()[i];
+    }
+  m_IndexMappingIsSeparable = true;
 }
 
 /**
@@ -235,6 +302,12 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
   // to the IsLinear() call.
   if ( m_Transform->IsLinear() )
     {
+    if ( this->SeparableBSplineThreadedGenerateData(
+           outputRegionForThread, threadId,
+           IsSame< InputPixelType, typename NumericTraits< InputPixelType >::ValueType >() ) )
+      {
+      return;
+      }
     this->LinearThreadedGenerateData(outputRegionForThread, threadId);
     return;
     }
@@ -244,6 +317,144 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
   this->NonlinearThreadedGenerateData(outputRegionForThread, threadId);
 }
 
+/**
+ * SeparableBSplineThreadedGenerateData
+ */
+template< class TInputImage,
+          class TOutputImage,
+          class TInterpolatorPrecisionType >
+bool
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
+::SeparableBSplineThreadedGenerateData(const OutputImageRegionType &
+                                       outputRegionForThread,
+                                       ThreadIdType threadId,
+                                       const TrueType &)
+{
+  typedef BSplineInterpolateImageFunction< InputImageType, TInterpolatorPrecisionType >
+  BSplineInterpolatorType;
+
+  if ( !m_IndexMappingIsSeparable
+       || typeid( *m_Interpolator ) != typeid( BSplineInterpolatorType ) )
+    {
+    return false;
+    }
+
+  const BSplineInterpolatorType *interpolator =
+    static_cast< const BSplineInterpolatorType * >( m_Interpolator.GetPointer() );
+
+  OutputImagePointer outputPtr = this->GetOutput();
+
+  // Support for progress methods/callbacks
+  ProgressReporter progress( this,
+                             threadId,
+                             outputRegionForThread.GetNumberOfPixels() );
+
+  // Min/max values of the output pixel type AND these values
+  // represented as the output type of the interpolator
+  const PixelComponentType minValue =  NumericTraits< PixelComponentType >::NonpositiveMin();
+  const PixelComponentType maxValue =  NumericTraits< PixelComponentType >::max();
+
+  typedef typename InterpolatorType::OutputType OutputType;
+  const ComponentType minOutputValue = static_cast< ComponentType >( minValue );
+  const ComponentType maxOutputValue = static_cast< ComponentType >( maxValue );
+
+  PixelType defaultValue = this->GetDefaultPixelValue();
+
+  // Compute the input continuous index, whether it is inside the buffer,
+  // and the interpolation support and weights for every output position
+  // along every axis of the region.
+  const unsigned int supportSize = interpolator->GetSplineOrder() + 1;
+
+  const typename BSplineInterpolatorType::ContinuousIndexType & startContinuousIndex =
+    interpolator->GetStartContinuousIndex();
+  const typename BSplineInterpolatorType::ContinuousIndexType & endContinuousIndex =
+    interpolator->GetEndContinuousIndex();
+
+  std::vector< double >        axisContinuousIndex[ImageDimension];
+  std::vector< unsigned char > axisIsInside[ImageDimension];
+  std::vector< long >          axisEvaluateIndex[ImageDimension];
+  std::vector< double >        axisWeights[ImageDimension];
+
+  const IndexType regionIndex = outputRegionForThread.GetIndex();
+  const SizeType  regionSize = outputRegionForThread.GetSize();
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    axisContinuousIndex[d].resize(regionSize[d]);
+    axisIsInside[d].resize(regionSize[d]);
+    axisEvaluateIndex[d].resize(regionSize[d] * supportSize);
+    axisWeights[d].resize(regionSize[d] * supportSize);
+    for ( SizeValueType i = 0; i < regionSize[d]; i++ )
+      {
+      const TInterpolatorPrecisionType x = static_cast< TInterpolatorPrecisionType >(
+        m_IndexMappingOffset[d] + m_IndexMappingScale[d] * ( regionIndex[d] + static_cast< IndexValueType >( i ) ) );
+      axisContinuousIndex[d][i] = x;
+      axisIsInside[d][i] = ( x >= startContinuousIndex[d] && x < endContinuousIndex[d] );
+      if ( axisIsInside[d][i] )
+        {
+        interpolator->ComputeSeparableWeights(d, x,
+                                              &axisEvaluateIndex[d][i * supportSize],
+                                              &axisWeights[d][i * supportSize]);
+        }
+      }
+    }
+
+  typedef ImageLinearIteratorWithIndex< TOutputImage > OutputIterator;
+  OutputIterator outIt(outputPtr, outputRegionForThread);
+  outIt.SetDirection(0);
+
+  const long *             evaluateIndex[ImageDimension];
+  const double *           weights[ImageDimension];
+  ContinuousInputIndexType inputIndex;
+
+  while ( !outIt.IsAtEnd() )
+    {
+    // The positions along the other axes are fixed along a scanline
+    const IndexType lineIndex = outIt.GetIndex();
+    bool            lineIsInside = true;
+    for ( unsigned int d = 1; d < ImageDimension; d++ )
+      {
+      const SizeValueType i = lineIndex[d] - regionIndex[d];
+      inputIndex[d] = axisContinuousIndex[d][i];
+      lineIsInside = lineIsInside && axisIsInside[d][i];
+      evaluateIndex[d] = &axisEvaluateIndex[d][i * supportSize];
+      weights[d] = &axisWeights[d][i * supportSize];
+      }
+
+    SizeValueType i = 0;
+    while ( !outIt.IsAtEndOfLine() )
+      {
+      // Evaluate input at right position and copy to the output
+      if ( lineIsInside && axisIsInside[0][i] )
+        {
+        evaluateIndex[0] = &axisEvaluateIndex[0][i * supportSize];
+        weights[0] = &axisWeights[0][i * supportSize];
+        const OutputType value = interpolator->EvaluateWithSeparableWeights(evaluateIndex, weights);
+        outIt.Set( this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue ) );
+        }
+      else
+        {
+        if ( m_Extrapolator.IsNull() )
+          {
+          outIt.Set(defaultValue); // default background value
+          }
+        else
+          {
+          inputIndex[0] = axisContinuousIndex[0][i];
+          const OutputType value = m_Extrapolator->EvaluateAtContinuousIndex(inputIndex);
+          outIt.Set( this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue ) );
+          }
+        }
+
+      progress.CompletedPixel();
+      ++outIt;
+      ++i;
+      }
+    outIt.NextLine();
+    }
+
+  return true;
+}
+
 /**
  * Cast from interpolotor output to pixel type
  */
@@ -380,6 +591,34 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
                              outputRegionForThread,
                              ThreadIdType threadId)
 {
+  // The interpolators of ITK are called directly when the exact type is
+  // known.  Subclasses may override the evaluation, hence the test on the
+  // exact type.
+  typedef NearestNeighborInterpolateImageFunction< InputImageType, TInterpolatorPrecisionType >
+  NearestNeighborInterpolatorType;
+
+  const std::type_info & interpolatorType = typeid( *m_Interpolator );
+  if ( interpolatorType == typeid( LinearInterpolatorType ) )
+    {
+    this->LinearThreadedGenerateDataWithInterpolator(
+      outputRegionForThread, threadId,
+      static_cast< const LinearInterpolatorType * >( m_Interpolator.GetPointer() ) );
+    return;
+    }
+  if ( interpolatorType == typeid( NearestNeighborInterpolatorType ) )
+    {
+    this->LinearThreadedGenerateDataWithInterpolator(
+      outputRegionForThread, threadId,
+      static_cast< const NearestNeighborInterpolatorType * >( m_Interpolator.GetPointer() ) );
+    return;
+    }
+  if ( this->BSplineLinearThreadedGenerateData(
+         outputRegionForThread, threadId,
+         IsSame< InputPixelType, typename NumericTraits< InputPixelType >::ValueType >() ) )
+    {
+    return;
+    }
+
   // Get the output pointers
   OutputImagePointer outputPtr = this->GetOutput();
 
@@ -507,6 +746,211 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
   return;
 }
 
+/**
+ * LinearThreadedGenerateDataWithInterpolator
+ */
+template< class TInputImage,
+          class TOutputImage,
+          class TInterpolatorPrecisionType >
+template< class TInterpolator >
+void
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
+::LinearThreadedGenerateDataWithInterpolator(const OutputImageRegionType &
+                                             outputRegionForThread,
+                                             ThreadIdType threadId,
+                                             const TInterpolator *interpolator)
+{
+  // Get the output pointers
+  OutputImagePointer outputPtr = this->GetOutput();
+
+  // Get this input pointers
+  InputImageConstPointer inputPtr = this->GetInput();
+
+  // Create an iterator that will walk the output region for this thread.
+  typedef ImageLinearIteratorWithIndex< TOutputImage > OutputIterator;
+
+  OutputIterator outIt(outputPtr, outputRegionForThread);
+  outIt.SetDirection(0);
+
+  PointType outputPoint;         // Coordinates of current output pixel
+  PointType inputPoint;          // Coordinates of current input pixel
+
+  ContinuousInputIndexType inputIndex;
+  ContinuousInputIndexType tmpInputIndex;
+
+  typedef typename PointType::VectorType VectorType;
+  VectorType delta;          // delta in input continuous index coordinate frame
+
+  IndexType index;
+
+  // Support for progress methods/callbacks
+  ProgressReporter progress( this,
+                             threadId,
+                             outputRegionForThread.GetNumberOfPixels() );
+
+  typedef typename InterpolatorType::OutputType OutputType;
+
+  // Cache information from the superclass
+  PixelType defaultValue = this->GetDefaultPixelValue();
+
+  // Min/max values of the output pixel type AND these values
+  // represented as the output type of the interpolator
+  const PixelComponentType minValue =  NumericTraits< PixelComponentType >::NonpositiveMin();
+  const PixelComponentType maxValue =  NumericTraits< PixelComponentType >::max();
+
+  const ComponentType minOutputValue = static_cast< ComponentType >( minValue );
+  const ComponentType maxOutputValue = static_cast< ComponentType >( maxValue );
+
+  // Compute the delta along a scanline in the input continuous index
+  // frame, as in the generic implementation
+  index = outIt.GetIndex();
+  outputPtr->TransformIndexToPhysicalPoint(index, outputPoint);
+  inputPoint = this->m_Transform->TransformPoint(outputPoint);
+  inputPtr->TransformPhysicalPointToContinuousIndex(inputPoint, inputIndex);
+
+  ++index[0];
+  outputPtr->TransformIndexToPhysicalPoint(index, outputPoint);
+  inputPoint = this->m_Transform->TransformPoint(outputPoint);
+  inputPtr->TransformPhysicalPointToContinuousIndex(inputPoint, tmpInputIndex);
+  delta = tmpInputIndex - inputIndex;
+
+  const SizeValueType lineLength = outputRegionForThread.GetSize()[0];
+
+  while ( !outIt.IsAtEnd() )
+    {
+    // Continuous index of the first pixel of the scanline in the input
+    index = outIt.GetIndex();
+    outputPtr->TransformIndexToPhysicalPoint(index, outputPoint);
+    inputPoint = this->m_Transform->TransformPoint(outputPoint);
+    inputPtr->TransformPhysicalPointToContinuousIndex(inputPoint, inputIndex);
+
+    SizeValueType first;
+    SizeValueType end;
+    this->ComputeInsideBufferSpan(inputIndex, delta, lineLength, first, end);
+
+    for ( SizeValueType i = 0; i < lineLength; ++i )
+      {
+      OutputType value;
+      if ( ( i >= first && i < end ) || interpolator->IsInsideBuffer(inputIndex) )
+        {
+        value = interpolator->TInterpolator::EvaluateAtContinuousIndex(inputIndex);
+        outIt.Set( this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue ) );
+        }
+      else if ( m_Extrapolator.IsNull() )
+        {
+        outIt.Set(defaultValue); // default background value
+        }
+      else
+        {
+        value = m_Extrapolator->EvaluateAtContinuousIndex( inputIndex );
+        outIt.Set( this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue ) );
+        }
+
+      progress.CompletedPixel();
+      ++outIt;
+      inputIndex += delta;
+      }
+    outIt.NextLine();
+    }
+}
+
+/**
+ * BSplineLinearThreadedGenerateData
+ */
+template< class TInputImage,
+          class TOutputImage,
+          class TInterpolatorPrecisionType >
+bool
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
+::BSplineLinearThreadedGenerateData(const OutputImageRegionType &
+                                    outputRegionForThread,
+                                    ThreadIdType threadId,
+                                    const TrueType &)
+{
+  typedef BSplineInterpolateImageFunction< InputImageType, TInterpolatorPrecisionType >
+  BSplineInterpolatorType;
+
+  if ( typeid( *m_Interpolator ) != typeid( BSplineInterpolatorType ) )
+    {
+    return false;
+    }
+
+  this->LinearThreadedGenerateDataWithInterpolator(
+    outputRegionForThread, threadId,
+    static_cast< const BSplineInterpolatorType * >( m_Interpolator.GetPointer() ) );
+  return true;
+}
+
+/**
+ * ComputeInsideBufferSpan
+ */
+template< class TInputImage,
+          class TOutputImage,
+          class TInterpolatorPrecisionType >
+void
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
+::ComputeInsideBufferSpan(const ContinuousInputIndexType & startIndex,
+                          const typename PointType::VectorType & delta,
+                          SizeValueType length,
+                          SizeValueType & first,
+                          SizeValueType & end) const
+{
+  first = 0;
+  end = 0;
+
+  // The positions inside the buffer along each axis form an interval
+  // [begin, finish) of real positions along the scanline.  The tests are
+  // written so that NaN's give an empty interval.
+  double begin = 0.0;
+  double finish = static_cast< double >( length );
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    const double start = m_Interpolator->GetStartContinuousIndex()[d];
+    const double stop = m_Interpolator->GetEndContinuousIndex()[d];
+    if ( delta[d] == 0.0 )
+      {
+      if ( !( startIndex[d] >= start && startIndex[d] < stop ) )
+        {
+        return;
+        }
+      continue;
+      }
+    // The incremental computation could drift by more than a tiny step
+    if ( !( vnl_math_abs(delta[d]) > 1e-6 ) )
+      {
+      return;
+      }
+    double t1 = ( start - startIndex[d] ) / delta[d];
+    double t2 = ( stop - startIndex[d] ) / delta[d];
+    if ( delta[d] < 0.0 )
+      {
+      std::swap(t1, t2);
+      }
+    if ( !( t1 <= begin ) )
+      {
+      begin = t1;
+      }
+    if ( !( t2 >= finish ) )
+      {
+      finish = t2;
+      }
+    }
+
+  if ( !( begin < finish ) )
+    {
+    return;
+    }
+
+  // Leave out the positions next to the bounds of the interval
+  const double firstPosition = vcl_ceil(begin) + 1.0;
+  const double endPosition = vcl_ceil(finish) - 1.0;
+  if ( firstPosition < endPosition )
+    {
+    first = static_cast< SizeValueType >( firstPosition );
+    end = static_cast< SizeValueType >( endPosition );
+    }
+}
+
 /**
  * Inform pipeline of necessary input image region
  *
@@ -275,6 +275,47 @@ private:
    */
   DisplacementType EvaluateDisplacementAtPhysicalPoint(const PointType & p);
 
+  typedef ContinuousIndex< CoordRepType, itkGetStaticConstMacro(ImageDimension) > ContinuousIndexType;
+
+  /** Warp when the displacement field shares the output grid.  The input
+   * continuous index is stepped along each output scanline and the
+   * displacement is mapped to the input index space with a precomputed
+   * matrix, instead of going through physical points for each pixel. */
+  template< class TInterpolator >
+  void IndexSpaceThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                                      ThreadIdType threadId,
+                                      const TInterpolator *interpolator);
+
+  /** Evaluate a known interpolator type without virtual dispatch. */
+  template< class TInterpolator >
+  static bool IsInsideBuffer(const TInterpolator *interpolator,
+                             const ContinuousIndexType & index)
+  {
+    return interpolator->TInterpolator::IsInsideBuffer(index);
+  }
+
+  template< class TInterpolator >
+  static typename InterpolatorType::OutputType
+  EvaluateAtContinuousIndex(const TInterpolator *interpolator,
+                            const ContinuousIndexType & index)
+  {
+    return interpolator->TInterpolator::EvaluateAtContinuousIndex(index);
+  }
+
+  /** Any other interpolator is called through its virtual methods. */
+  static bool IsInsideBuffer(const InterpolatorType *interpolator,
+                             const ContinuousIndexType & index)
+  {
+    return interpolator->IsInsideBuffer(index);
+  }
+
+  static typename InterpolatorType::OutputType
+  EvaluateAtContinuousIndex(const InterpolatorType *interpolator,
+                            const ContinuousIndexType & index)
+  {
+    return interpolator->EvaluateAtContinuousIndex(index);
+  }
+
   PixelType     m_EdgePaddingValue;
   SpacingType   m_OutputSpacing;
   PointType     m_OutputOrigin;
@@ -286,6 +327,9 @@ private:
   bool                m_DefFieldSizeSame;
   // variables for deffield interpoator
   IndexType m_StartIndex, m_EndIndex;
+  // maps a displacement, or an offset from the input origin, to the input
+  // index space
+  DirectionType m_InputPhysicalPointToIndex;
 };
 } // end namespace itk
 
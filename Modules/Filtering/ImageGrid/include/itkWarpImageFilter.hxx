@@ -24,7 +24,9 @@
 #include "itkNumericTraits.h"
 #include "itkProgressReporter.h"
 #include "itkContinuousIndex.h"
+#include "itkImageLinearIteratorWithIndex.h"
 #include "vnl/vnl_math.h"
+#include <typeinfo>
 namespace itk
 {
 /**
@@ -169,7 +171,24 @@ WarpImageFilter< TInputImage, TOutputImage, TDisplacementField >
   typename OutputImageType::RegionType outRegion =
     this->GetOutput()->GetLargestPossibleRegion();
   m_DefFieldSizeSame = outRegion == defRegion;
-  if ( !m_DefFieldSizeSame )
+  if ( m_DefFieldSizeSame )
+    {
+    // Same as the physical point to index matrix of the input image
+    const typename InputImageType::DirectionType & inputDirection =
+      this->GetInput()->GetDirection();
+    const typename InputImageType::SpacingType & inputSpacing =
+      this->GetInput()->GetSpacing();
+    DirectionType indexToPhysicalPoint;
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      for ( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        indexToPhysicalPoint[i][j] = inputDirection[i][j] * inputSpacing[j];
+        }
+      }
+    m_InputPhysicalPointToIndex = indexToPhysicalPoint.GetInverse();
+    }
+  else
     {
     m_StartIndex = fieldPtr->GetBufferedRegion().GetIndex();
     for ( unsigned i = 0; i < ImageDimension; i++ )
@@ -314,19 +333,29 @@ WarpImageFilter< TInputImage, TOutputImage, TDisplacementField >
   DisplacementType displacement;
   if ( this->m_DefFieldSizeSame )
     {
-    // iterator for the deformation field
-    ImageRegionIterator< DisplacementFieldType >
-    fieldIt(fieldPtr, outputRegionForThread);
-
+    // The default interpolator is called without virtual dispatch
+    if ( typeid( *m_Interpolator ) == typeid( DefaultInterpolatorType ) )
+      {
+      this->IndexSpaceThreadedGenerateData(
+        outputRegionForThread, threadId,
+        static_cast< const DefaultInterpolatorType * >( m_Interpolator.GetPointer() ) );
+      }
+    else
+      {
+      this->IndexSpaceThreadedGenerateData(
+        outputRegionForThread, threadId,
+        static_cast< const InterpolatorType * >( m_Interpolator.GetPointer() ) );
+      }
+    }
+  else
+    {
     while ( !outputIt.IsAtEnd() )
       {
       // get the output image index
       index = outputIt.GetIndex();
       outputPtr->TransformIndexToPhysicalPoint(index, point);
 
-      // get the required displacement
-      displacement = fieldIt.Get();
-
+      displacement = this->EvaluateDisplacementAtPhysicalPoint(point);
       // compute the required input image point
       for ( unsigned int j = 0; j < ImageDimension; j++ )
         {
@@ -345,39 +374,105 @@ WarpImageFilter< TInputImage, TOutputImage, TDisplacementField >
         outputIt.Set(m_EdgePaddingValue);
         }
       ++outputIt;
-      ++fieldIt;
       progress.CompletedPixel();
       }
     }
-  else
+}
+
+/**
+ * Compute the output for the region specified by outputRegionForThread when
+ * the displacement field shares the output grid.
+ */
+template< class TInputImage, class TOutputImage, class TDisplacementField >
+template< class TInterpolator >
+void
+WarpImageFilter< TInputImage, TOutputImage, TDisplacementField >
+::IndexSpaceThreadedGenerateData(
+  const OutputImageRegionType & outputRegionForThread,
+  ThreadIdType threadId,
+  const TInterpolator *interpolator)
+{
+  InputImageConstPointer   inputPtr = this->GetInput();
+  OutputImagePointer       outputPtr = this->GetOutput();
+  DisplacementFieldPointer fieldPtr = this->GetDisplacementField();
+
+  // support progress methods/callbacks
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  // iterators for the output image and the deformation field, along the
+  // same scanlines
+  typedef ImageLinearIteratorWithIndex< OutputImageType >            OutputIteratorType;
+  typedef ImageLinearConstIteratorWithIndex< DisplacementFieldType > FieldIteratorType;
+  OutputIteratorType outputIt(outputPtr, outputRegionForThread);
+  FieldIteratorType  fieldIt(fieldPtr, outputRegionForThread);
+  outputIt.SetDirection(0);
+  fieldIt.SetDirection(0);
+
+  // Step of the input continuous index along a scanline of the output
+  ContinuousIndexType scanlineStep;
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
     {
-    while ( !outputIt.IsAtEnd() )
+    double step = 0.0;
+    for ( unsigned int j = 0; j < ImageDimension; j++ )
       {
-      // get the output image index
-      index = outputIt.GetIndex();
-      outputPtr->TransformIndexToPhysicalPoint(index, point);
+      step += m_InputPhysicalPointToIndex[i][j]
+              * outputPtr->GetDirection()[j][0] * outputPtr->GetSpacing()[0];
+      }
+    scanlineStep[i] = step;
+    }
 
-      displacement = this->EvaluateDisplacementAtPhysicalPoint(point);
-      // compute the required input image point
+  const PointType &   inputOrigin = inputPtr->GetOrigin();
+  PointType           point;
+  ContinuousIndexType lineIndex;
+  ContinuousIndexType inputIndex;
+
+  while ( !outputIt.IsAtEnd() )
+    {
+    // input continuous index of the first output pixel of the scanline,
+    // before displacement
+    outputPtr->TransformIndexToPhysicalPoint(outputIt.GetIndex(), point);
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      double value = 0.0;
       for ( unsigned int j = 0; j < ImageDimension; j++ )
         {
-        point[j] += displacement[j];
+        value += m_InputPhysicalPointToIndex[i][j] * ( point[j] - inputOrigin[j] );
+        }
+      lineIndex[i] = value;
+      }
+
+    SizeValueType position = 0;
+    while ( !outputIt.IsAtEndOfLine() )
+      {
+      // compute the required input image continuous index
+      const DisplacementType & displacement = fieldIt.Get();
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        double value = lineIndex[i] + position * scanlineStep[i];
+        for ( unsigned int j = 0; j < ImageDimension; j++ )
+          {
+          value += m_InputPhysicalPointToIndex[i][j] * displacement[j];
+          }
+        inputIndex[i] = value;
         }
 
       // get the interpolated value
-      if ( m_Interpolator->IsInsideBuffer(point) )
+      if ( Self::IsInsideBuffer(interpolator, inputIndex) )
         {
-        PixelType value =
-          static_cast< PixelType >( m_Interpolator->Evaluate(point) );
-        outputIt.Set(value);
+        outputIt.Set( static_cast< PixelType >(
+                        Self::EvaluateAtContinuousIndex(interpolator, inputIndex) ) );
         }
       else
         {
         outputIt.Set(m_EdgePaddingValue);
         }
       ++outputIt;
+      ++fieldIt;
+      ++position;
       progress.CompletedPixel();
       }
+    outputIt.NextLine();
+    fieldIt.NextLine();
     }
 }
 
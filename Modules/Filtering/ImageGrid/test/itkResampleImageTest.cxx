@@ -20,6 +20,8 @@
 
 #include "itkAffineTransform.h"
 #include "itkResampleImageFilter.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkNearestNeighborInterpolateImageFunction.h"
 
 int itkResampleImageTest(int, char* [] )
 {
@@ -153,6 +155,76 @@ int itkResampleImageTest(int, char* [] )
     return EXIT_FAILURE;
   }
 
+  // Resample with B-spline and nearest neighbor interpolators, both with a
+  // scaling, which maps the output grid onto the input grid axis by axis,
+  // and with a rotation.  The output must match the interpolator evaluated
+  // at each mapped point.
+  typedef itk::InterpolateImageFunction<ImageType,CoordRepType>              InterpolatorBaseType;
+  typedef itk::BSplineInterpolateImageFunction<ImageType,CoordRepType>       BSplineInterpolatorType;
+  typedef itk::NearestNeighborInterpolateImageFunction<ImageType,CoordRepType> NearestInterpolatorType;
+  BSplineInterpolatorType::Pointer bsplineInterp = BSplineInterpolatorType::New();
+  bsplineInterp->SetSplineOrder(3);
+
+  InterpolatorBaseType::Pointer interpolators[2];
+  interpolators[0] = bsplineInterp;
+  interpolators[1] = NearestInterpolatorType::New();
+
+  resample->SetDefaultPixelValue(-1.0);
+
+  for (unsigned int interpolatorIndex = 0; interpolatorIndex < 2; interpolatorIndex++)
+    {
+    InterpolatorBaseType * otherInterp = interpolators[interpolatorIndex];
+    resample->SetInterpolator(otherInterp);
+
+    AffineTransformType::Pointer otherAff = AffineTransformType::New();
+    AffineTransformType::OutputVectorType translation;
+    translation[0] = 0.35;
+    translation[1] = -1.45;
+    otherAff->Scale(0.7);
+    otherAff->Translate(translation);
+    resample->SetTransform(otherAff);
+
+    for (unsigned int transformIndex = 0; transformIndex < 2; transformIndex++)
+      {
+      if (transformIndex == 1)
+        {
+        otherAff->Rotate2D(0.2);
+        resample->Modified();
+        }
+      resample->Update();
+
+      // The filter disconnects the interpolator from its input when done
+      otherInterp->SetInputImage(image);
+
+      itk::ImageRegionIteratorWithIndex<ImageType>
+          iter3(resample->GetOutput(), resample->GetOutput()->GetRequestedRegion());
+      for (iter3.GoToBegin(); !iter3.IsAtEnd(); ++iter3)
+        {
+        ImageType::PointType point;
+        resample->GetOutput()->TransformIndexToPhysicalPoint(iter3.GetIndex(), point);
+        point = otherAff->TransformPoint(point);
+        double expectedValue = -1.0;
+        if (otherInterp->IsInsideBuffer(point))
+          {
+          expectedValue = otherInterp->Evaluate(point);
+          }
+        if ( vcl_fabs( expectedValue - iter3.Get() ) > 1e-4 )
+          {
+          std::cout << "Error in resampled image with " << otherInterp->GetNameOfClass()
+                    << ": Pixel " << iter3.GetIndex()
+                    << " value = " << iter3.Get() << "  "
+                    << "expected = " << expectedValue << std::endl;
+          passed = false;
+          }
+        }
+      }
+    }
+
+  if (!passed) {
+    std::cout << "Resampling test failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+
  std::cout << "Test passed." << std::endl;
  return EXIT_SUCCESS;
 
@@ -190,5 +190,76 @@ itkWarpImageFilterTest2(int, char * [])
     return EXIT_FAILURE;
     }
 
+  // With an oriented, anisotropic input and a displacement field on the
+  // output grid, the warped image must match the interpolator evaluated at
+  // the displaced physical points.
+  ImageType::Pointer orientedImage = MakeCheckerboard();
+  ImageType::SpacingType orientedSpacing;
+  orientedSpacing[0] = 0.8;
+  orientedSpacing[1] = 1.2;
+  orientedSpacing[2] = 1.5;
+  orientedImage->SetSpacing(orientedSpacing);
+  ImageType::PointType orientedOrigin;
+  orientedOrigin[0] = 1.5;
+  orientedOrigin[1] = -2.0;
+  orientedOrigin[2] = 0.5;
+  orientedImage->SetOrigin(orientedOrigin);
+  ImageType::DirectionType orientedDirection;
+  orientedDirection.Fill(0.0);
+  orientedDirection[0][1] = 1.0;
+  orientedDirection[1][0] = -1.0;
+  orientedDirection[2][2] = 1.0;
+  orientedImage->SetDirection(orientedDirection);
+
+  DisplacementFieldType::Pointer orientedField = MakeDisplacementField(16);
+  orientedField->CopyInformation(orientedImage);
+  itk::ImageRegionIterator<DisplacementFieldType>
+    fieldIt(orientedField, orientedField->GetLargestPossibleRegion());
+  for(fieldIt.GoToBegin(); !fieldIt.IsAtEnd(); ++fieldIt)
+    {
+    DisplacementFieldType::IndexType ind(fieldIt.GetIndex());
+    DisplacementFieldType::PixelType pix;
+    pix[0] = 0.3 * ind[1] - 2.0;
+    pix[1] = 0.7;
+    pix[2] = -0.1 * ind[0];
+    fieldIt.Set(pix);
+    }
+
+  WarpFilterType::Pointer filter3 = WarpFilterType::New();
+  filter3->SetDisplacementField(orientedField);
+  filter3->SetInput(orientedImage);
+  filter3->SetOutputParametersFromImage(orientedImage);
+  filter3->SetEdgePaddingValue(-1.0);
+  filter3->Update();
+
+  WarpFilterType::DefaultInterpolatorType::Pointer interpolator =
+    WarpFilterType::DefaultInterpolatorType::New();
+  interpolator->SetInputImage(orientedImage);
+  itk::ImageRegionIteratorWithIndex<ImageType>
+    orientedIt(filter3->GetOutput(), filter3->GetOutput()->GetLargestPossibleRegion());
+  for(orientedIt.GoToBegin(); !orientedIt.IsAtEnd(); ++orientedIt)
+    {
+    ImageType::PointType point;
+    filter3->GetOutput()->TransformIndexToPhysicalPoint(orientedIt.GetIndex(), point);
+    DisplacementFieldType::PixelType displacement =
+      orientedField->GetPixel(orientedIt.GetIndex());
+    for(unsigned i = 0; i < 3; i++)
+      {
+      point[i] += displacement[i];
+      }
+    double expected = -1.0;
+    if(interpolator->IsInsideBuffer(point))
+      {
+      expected = interpolator->Evaluate(point);
+      }
+    if(vcl_fabs(expected - orientedIt.Value()) > 1e-3)
+      {
+      std::cout << "Oriented warp differs at " << orientedIt.GetIndex()
+                << ": " << orientedIt.Value() << " expected " << expected
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
   return EXIT_SUCCESS;
 }
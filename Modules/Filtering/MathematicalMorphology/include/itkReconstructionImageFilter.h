@@ -23,6 +23,7 @@
 #include "itkImageRegionIterator.h"
 #include "itkProgressReporter.h"
 #include <queue>
+#include <string>
 
 //#define BASIC
 #define COPY
@@ -43,6 +44,13 @@ namespace itk
  * applications and efficient algorithms" -- IEEE Transactions on
  * Image processing, Vol 2, No 2, pp 176-201, April 1993
  *
+ * When UseInternalCopy is on (the default), the reconstruction is
+ * multi-threaded: each thread runs the raster, antiraster and FIFO
+ * steps on a slab of slices along the last dimension, and the
+ * propagation across the slab boundaries is handed over to the
+ * neighboring threads until no more pixel changes. The output is
+ * identical to the one of the single threaded algorithm.
+ *
  * \author Richard Beare. Department of Medicine, Monash University,
  * Melbourne, Australia.
  *
@@ -129,8 +137,8 @@ public:
 
   /**
    * Perform a padding of the image internally to increase the performance
-   * of the filter. UseInternalCopy can be set to false to reduce the memory
-   * usage.
+   * of the filter and to enable the multi-threaded reconstruction.
+   * UseInternalCopy can be set to false to reduce the memory usage.
    */
   itkSetMacro(UseInternalCopy, bool);
   itkGetConstReferenceMacro(UseInternalCopy, bool);
@@ -173,6 +181,41 @@ private:
   typedef typename InputImageType::IndexType                InIndexType;
   typedef ConstShapedNeighborhoodIterator< InputImageType > CNInputIterator;
   typedef ShapedNeighborhoodIterator< OutputImageType >     NOutputIterator;
+
+  typedef typename InputImageType::OffsetValueType          OffsetValueType;
+  typedef std::pair< OffsetValueType, InputImagePixelType > HandOverType;
+
+  /** Data shared by the threads of the reconstruction.  Each thread owns a
+   * slab of slices along the last dimension of the padded images. */
+  struct ReconstructionThreadStruct
+    {
+    ReconstructionImageFilter*                Filter;
+    InputImagePixelType*                      Marker;
+    const InputImagePixelType*                Mask;
+    ISizeType                                 Size;
+    const OffsetValueType*                    OffsetTable;
+    std::vector< OffsetValueType >            SlabBegin;
+    std::vector< OffsetValueType >            PreviousOffsets;
+    std::vector< OffsetValueType >            LaterOffsets;
+    unsigned int                              Round;
+    std::vector< std::queue< OffsetValueType > > Fifo;
+
+    // Pixels whose value has to be propagated into the slab of another
+    // thread, by source and destination thread, for the even and the odd
+    // rounds
+    std::vector< std::vector< std::vector< HandOverType > > > HandOver[2];
+    std::vector< std::string >                Errors;
+    };
+
+  /** Reconstruct the padded marker image in place, with several threads. */
+  void ThreadedReconstruction(MarkerImageType *marker, const MaskImageType *mask);
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ReconstructionThreaderCallback(void *arg);
+
+  /** Run the current round of the reconstruction on the slab of the given
+   * thread. */
+  void ThreadedReconstructSlab(ReconstructionThreadStruct *str, ThreadIdType threadId);
 }; // end of class
 } // end namespace itk
 
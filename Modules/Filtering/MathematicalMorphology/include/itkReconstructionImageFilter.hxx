@@ -106,13 +106,6 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
 {
   // Allocate the output
   this->AllocateOutputs();
-  // there are 2 passes that use all pixels and a 3rd that uses some
-  // subset of the pixels. We'll just pretend that the third pass
-  // takes the same as each of the others. Is it OK to update more
-  // often than pixels?
-  ProgressReporter progress(this, 0, this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() * 3);
-
-  TCompare compare;
 
   MarkerImageConstPointer markerImage = this->GetMarkerImage();
   MaskImageConstPointer   maskImage = this->GetMaskImage();
@@ -124,18 +117,14 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
     itkExceptionMacro(<< "Marker and mask must have the same size.");
     }
 
-  // create padded versions of the marker image and the mask image
-  typedef typename itk::ConstantPadImageFilter< InputImageType, InputImageType > PadType;
-
-  MarkerImageConstPointer markerImageP;
-  MaskImageConstPointer   maskImageP;
-
-  ISizeType padSize;
-
   if ( m_UseInternalCopy )
     {
+    // create padded versions of the marker image and the mask image
+    typedef typename itk::ConstantPadImageFilter< InputImageType, InputImageType > PadType;
+
     typename PadType::Pointer MaskPad = PadType::New();
     typename PadType::Pointer MarkerPad = PadType::New();
+    ISizeType padSize;
     padSize.Fill(1);
 
     MaskPad->SetConstant(m_MarkerValue);
@@ -150,76 +139,60 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
     MaskPad->Update();
     MarkerPad->Update();
 
-    markerImageP = MarkerPad->GetOutput();
-    maskImageP = MaskPad->GetOutput();
+    MarkerImagePointer markerImageP = MarkerPad->GetOutput();
+    this->ThreadedReconstruction( markerImageP, MaskPad->GetOutput() );
+
+    typedef typename itk::CropImageFilter< InputImageType, OutputImageType > CropType;
+    typename CropType::Pointer crop = CropType::New();
+
+    crop->SetInput(markerImageP);
+    crop->SetUpperBoundaryCropSize(padSize);
+    crop->SetLowerBoundaryCropSize(padSize);
+    crop->GraftOutput( this->GetOutput() );
+    /** execute the minipipeline */
+    crop->Update();
+
+    /** graft the minipipeline output back into this filter's output */
+    this->GraftOutput( crop->GetOutput() );
+    return;
     }
-  else
-    {
-    maskImageP = this->GetMaskImage();
-    InputIteratorType inIt( markerImage,
+
+  // there are 2 passes that use all pixels and a 3rd that uses some
+  // subset of the pixels. We'll just pretend that the third pass
+  // takes the same as each of the others. Is it OK to update more
+  // often than pixels?
+  ProgressReporter progress(this, 0, this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() * 3);
+
+  TCompare compare;
+
+  MaskImageConstPointer maskImageP = this->GetMaskImage();
+  InputIteratorType inIt( markerImage,
+                          output->GetRequestedRegion() );
+  OutputIteratorType outIt( output,
                             output->GetRequestedRegion() );
-    OutputIteratorType outIt( output,
-                              output->GetRequestedRegion() );
-    // copy marker to output - isn't there a better way?
-    while ( !outIt.IsAtEnd() )
-      {
-      MarkerImagePixelType currentValue = inIt.Get();
-      outIt.Set( static_cast< OutputImagePixelType >( currentValue ) );
-      ++inIt;
-      ++outIt;
-      }
-    markerImageP = output;
+  // copy marker to output - isn't there a better way?
+  while ( !outIt.IsAtEnd() )
+    {
+    MarkerImagePixelType currentValue = inIt.Get();
+    outIt.Set( static_cast< OutputImagePixelType >( currentValue ) );
+    ++inIt;
+    ++outIt;
     }
 
   // declare our queue type
   typedef typename std::queue< OutputImageIndexType > FifoType;
   FifoType IndexFifo;
 
-  NOutputIterator   outNIt;
-  InputIteratorType mskIt;
-  CNInputIterator   mskNIt;
-  ISizeType         kernelRadius;
+  ISizeType kernelRadius;
   kernelRadius.Fill(1);
-  if ( m_UseInternalCopy )
-    {
-    FaceCalculatorType faceCalculator;
-
-    FaceListType   faceList;
-    FaceListTypeIt fit;
-
-    faceList = faceCalculator(maskImageP, maskImageP->GetLargestPossibleRegion(),
-                              kernelRadius);
-    // we will only be processing the body region
-    fit = faceList.begin();
-    // must be a better way of doing this
-    NOutputIterator tt(kernelRadius,
-                       markerImageP,
-                       *fit);
-    outNIt = tt;
-
-    InputIteratorType ttt(maskImageP,
-                          *fit);
-    mskIt = ttt;
-    CNInputIterator tttt(kernelRadius,
-                         maskImageP,
-                         *fit);
-    mskNIt = tttt;
-    }
-  else
-    {
-    NOutputIterator tt( kernelRadius,
-                        markerImageP,
-                        output->GetRequestedRegion() );
-    outNIt = tt;
-
-    InputIteratorType ttt( maskImageP,
+  NOutputIterator outNIt( kernelRadius,
+                          output,
+                          output->GetRequestedRegion() );
+  InputIteratorType mskIt( maskImageP,
                            output->GetRequestedRegion() );
-    mskIt = ttt;
-    CNInputIterator tttt( kernelRadius,
+  CNInputIterator mskNIt( kernelRadius,
                           maskImageP,
                           output->GetRequestedRegion() );
-    mskNIt = tttt;
-    }
 
   setConnectivityPrevious(&outNIt, m_FullyConnected);
 
@@ -369,21 +342,393 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
       }
     progress.CompletedPixel();
     }
+}
 
-  if ( m_UseInternalCopy )
+template< class TInputImage, class TOutputImage, class TCompare >
+void
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::ThreadedReconstruction(MarkerImageType *marker, const MaskImageType *mask)
+{
+  const unsigned int Dimension = InputImageType::ImageDimension;
+
+  ReconstructionThreadStruct str;
+  str.Filter = this;
+  str.Marker = marker->GetBufferPointer();
+  str.Mask = mask->GetBufferPointer();
+  str.Size = marker->GetBufferedRegion().GetSize();
+  str.OffsetTable = marker->GetOffsetTable();
+
+  // the previous neighbors come before the pixel in raster order, the later
+  // ones after
+  SizeValueType numberOfNeighbors = 1;
+  for ( unsigned int d = 0; d < Dimension; d++ )
     {
-    typedef typename itk::CropImageFilter< InputImageType, OutputImageType > CropType;
-    typename CropType::Pointer crop = CropType::New();
+    numberOfNeighbors *= 3;
+    }
+  for ( SizeValueType n = 0; n < numberOfNeighbors; n++ )
+    {
+    OffsetValueType offset = 0;
+    unsigned int    numberOfMoves = 0;
+    SizeValueType   position = n;
+    for ( unsigned int d = 0; d < Dimension; d++ )
+      {
+      const OffsetValueType move = static_cast< OffsetValueType >( position % 3 ) - 1;
+      position /= 3;
+      offset += move * str.OffsetTable[d];
+      numberOfMoves += ( move != 0 );
+      }
+    if ( numberOfMoves == 0 || ( !m_FullyConnected && numberOfMoves > 1 ) )
+      {
+      continue;
+      }
+    if ( offset < 0 )
+      {
+      str.PreviousOffsets.push_back(offset);
+      }
+    else
+      {
+      str.LaterOffsets.push_back(offset);
+      }
+    }
 
-    crop->SetInput(markerImageP);
-    crop->SetUpperBoundaryCropSize(padSize);
-    crop->SetLowerBoundaryCropSize(padSize);
-    crop->GraftOutput( this->GetOutput() );
-    /** execute the minipipeline */
-    crop->Update();
+  // split the slices between the padding in slabs
+  const OffsetValueType sliceStride = str.OffsetTable[Dimension - 1];
+  const SizeValueType   numberOfSlices = str.Size[Dimension - 1] - 2;
 
-    /** graft the minipipeline output back into this filter's output */
-    this->GraftOutput( crop->GetOutput() );
+  ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+  if ( Dimension == 1 )
+    {
+    numberOfThreads = 1;
+    }
+  if ( numberOfThreads > numberOfSlices )
+    {
+    numberOfThreads = static_cast< ThreadIdType >( numberOfSlices );
+    }
+
+  str.SlabBegin.resize(numberOfThreads + 1);
+  for ( ThreadIdType t = 0; t <= numberOfThreads; t++ )
+    {
+    str.SlabBegin[t] = ( 1 + static_cast< OffsetValueType >( t * numberOfSlices / numberOfThreads ) ) * sliceStride;
+    }
+
+  str.Fifo.resize(numberOfThreads);
+  str.Errors.resize(numberOfThreads);
+  for ( unsigned int r = 0; r < 2; r++ )
+    {
+    str.HandOver[r].assign( numberOfThreads,
+                            std::vector< std::vector< HandOverType > >(numberOfThreads) );
+    }
+
+  this->GetMultiThreader()->SetNumberOfThreads(numberOfThreads);
+  this->GetMultiThreader()->SetSingleMethod(this->ReconstructionThreaderCallback, &str);
+
+  // run rounds until no more value is propagated across the slabs
+  str.Round = 0;
+  bool converged = false;
+  while ( !converged )
+    {
+    this->GetMultiThreader()->SingleMethodExecute();
+
+    for ( ThreadIdType t = 0; t < numberOfThreads; t++ )
+      {
+      if ( !str.Errors[t].empty() )
+        {
+        itkExceptionMacro(<< str.Errors[t]);
+        }
+      }
+
+    ++str.Round;
+
+    converged = true;
+    for ( ThreadIdType s = 0; ( s < numberOfThreads ) && converged; s++ )
+      {
+      for ( ThreadIdType t = 0; t < numberOfThreads; t++ )
+        {
+        if ( !str.HandOver[str.Round % 2][s][t].empty() )
+          {
+          converged = false;
+          break;
+          }
+        }
+      }
+    }
+}
+
+template< class TInputImage, class TOutputImage, class TCompare >
+ITK_THREAD_RETURN_TYPE
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::ReconstructionThreaderCallback(void *arg)
+{
+  ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+
+  ReconstructionThreadStruct *str = (ReconstructionThreadStruct *)
+    ( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+
+  try
+    {
+    str->Filter->ThreadedReconstructSlab(str, threadId);
+    }
+  catch ( ExceptionObject & err )
+    {
+    str->Errors[threadId] = err.GetDescription();
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TInputImage, class TOutputImage, class TCompare >
+void
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::ThreadedReconstructSlab(ReconstructionThreadStruct *str, ThreadIdType threadId)
+{
+  const unsigned int Dimension = InputImageType::ImageDimension;
+
+  TCompare compare;
+
+  InputImagePixelType *      marker = str->Marker;
+  const InputImagePixelType *mask = str->Mask;
+
+  const OffsetValueType slabBegin = str->SlabBegin[threadId];
+  const OffsetValueType slabEnd = str->SlabBegin[threadId + 1];
+  const ThreadIdType    numberOfThreads = static_cast< ThreadIdType >( str->Fifo.size() );
+
+  const std::vector< OffsetValueType > & previousOffsets = str->PreviousOffsets;
+  const std::vector< OffsetValueType > & laterOffsets = str->LaterOffsets;
+
+  std::queue< OffsetValueType > & fifo = str->Fifo[threadId];
+
+  std::vector< std::vector< HandOverType > > & next = str->HandOver[( str->Round + 1 ) % 2][threadId];
+
+  if ( str->Round == 0 )
+    {
+    // first pixel of each line of the slab, without the padding
+    std::vector< OffsetValueType > lines;
+    const OffsetValueType          lineLength = static_cast< OffsetValueType >( str->Size[0] ) - 2;
+    if ( Dimension == 1 )
+      {
+      lines.push_back(1);
+      }
+    else
+      {
+      InputImageIndexType index;
+      index.Fill(1);
+      index[Dimension - 1] = slabBegin / str->OffsetTable[Dimension - 1];
+      const OffsetValueType slabEndSlice = slabEnd / str->OffsetTable[Dimension - 1];
+      while ( index[Dimension - 1] < slabEndSlice )
+        {
+        OffsetValueType offset = 0;
+        for ( unsigned int d = 0; d < Dimension; d++ )
+          {
+          offset += index[d] * str->OffsetTable[d];
+          }
+        lines.push_back(offset);
+
+        unsigned int d = 1;
+        for (; d < Dimension - 1; d++ )
+          {
+          if ( ++index[d] < static_cast< OffsetValueType >( str->Size[d] ) - 1 )
+            {
+            break;
+            }
+          index[d] = 1;
+          }
+        if ( d == Dimension - 1 )
+          {
+          ++index[Dimension - 1];
+          }
+        }
+      }
+
+    // the raster and antiraster passes are two thirds of the work
+    ProgressReporter progress(this, threadId, 2 * lines.size(), 100, 0.0f, 0.66f);
+
+    // scan in forward raster order, only looking at the pixels of the slab
+    for ( size_t l = 0; l < lines.size(); l++ )
+      {
+      const OffsetValueType lineEnd = lines[l] + lineLength;
+      for ( OffsetValueType p = lines[l]; p < lineEnd; ++p )
+        {
+        InputImagePixelType V = marker[p];
+        const InputImagePixelType iV = mask[p];
+
+        // be sure that the pixels in the images follow the preconditions
+        if ( compare(V, iV) )
+          {
+          if ( compare(0, 1) )
+            {
+            str->Errors[threadId] = "Marker pixels must be <= mask pixels.";
+            }
+          else
+            {
+            str->Errors[threadId] = "Marker pixels must be >= mask pixels.";
+            }
+          return;
+          }
+
+        // visit the previous neighbours
+        for ( size_t n = 0; n < previousOffsets.size(); n++ )
+          {
+          const OffsetValueType q = p + previousOffsets[n];
+          if ( q >= slabBegin && compare(marker[q], V) )
+            {
+            V = marker[q];
+            }
+          }
+
+        // this step clamps to the mask
+        if ( compare(V, iV) )
+          {
+          V = iV;
+          }
+        marker[p] = V;
+        }
+      progress.CompletedPixel();
+      }
+
+    // now for the reverse raster order pass
+    for ( size_t l = lines.size(); l > 0; l-- )
+      {
+      for ( OffsetValueType p = lines[l - 1] + lineLength - 1; p >= lines[l - 1]; --p )
+        {
+        InputImagePixelType V = marker[p];
+        for ( size_t n = 0; n < laterOffsets.size(); n++ )
+          {
+          const OffsetValueType q = p + laterOffsets[n];
+          if ( q < slabEnd && compare(marker[q], V) )
+            {
+            V = marker[q];
+            }
+          }
+        const InputImagePixelType iV = mask[p];
+        if ( compare(V, iV) )
+          {
+          V = iV;
+          }
+        marker[p] = V;
+
+        // now put indexes in the fifo
+        for ( size_t n = 0; n < laterOffsets.size(); n++ )
+          {
+          const OffsetValueType q = p + laterOffsets[n];
+          if ( q < slabEnd && compare(V, marker[q]) && compare(mask[q], marker[q]) )
+            {
+            fifo.push(p);
+            break;
+            }
+          }
+        }
+      progress.CompletedPixel();
+      }
+
+    // hand the slices on the boundaries of the slab over to the neighbor
+    // slabs
+    const OffsetValueType sliceStride = str->OffsetTable[Dimension - 1];
+    if ( threadId > 0 )
+      {
+      for ( OffsetValueType p = slabBegin; p < slabBegin + sliceStride; ++p )
+        {
+        if ( marker[p] != m_MarkerValue )
+          {
+          next[threadId - 1].push_back( HandOverType(p, marker[p]) );
+          }
+        }
+      }
+    if ( threadId + 1 < numberOfThreads )
+      {
+      for ( OffsetValueType p = slabEnd - sliceStride; p < slabEnd; ++p )
+        {
+        if ( marker[p] != m_MarkerValue )
+          {
+          next[threadId + 1].push_back( HandOverType(p, marker[p]) );
+          }
+        }
+      }
+    }
+  else
+    {
+    // propagate the values handed over by the neighbor slabs
+    for ( ThreadIdType s = 0; s < numberOfThreads; s++ )
+      {
+      std::vector< HandOverType > & handOver = str->HandOver[str->Round % 2][s][threadId];
+      for ( size_t i = 0; i < handOver.size(); i++ )
+        {
+        const InputImagePixelType V = handOver[i].second;
+        for ( unsigned int k = 0; k < 2; k++ )
+          {
+          const std::vector< OffsetValueType > & offsets = ( k == 0 ) ? previousOffsets : laterOffsets;
+          for ( size_t n = 0; n < offsets.size(); n++ )
+            {
+            const OffsetValueType q = handOver[i].first + offsets[n];
+            if ( q < slabBegin || q >= slabEnd )
+              {
+              continue;
+              }
+            const InputImagePixelType VN = marker[q];
+            const InputImagePixelType iN = mask[q];
+            if ( compare(V, VN) && ( iN != VN ) )
+              {
+              marker[q] = compare(iN, V) ? V : iN;
+              fifo.push(q);
+              }
+            }
+          }
+        }
+      handOver.clear();
+      }
+    }
+
+  // now process the fifo - this fill the parts that weren't dealt
+  // with by the raster and anti-raster passes
+  while ( !fifo.empty() )
+    {
+    const OffsetValueType p = fifo.front();
+    fifo.pop();
+    const InputImagePixelType V = marker[p];
+    bool handedOverToPrevious = false;
+    bool handedOverToNext = false;
+    for ( unsigned int k = 0; k < 2; k++ )
+      {
+      const std::vector< OffsetValueType > & offsets = ( k == 0 ) ? previousOffsets : laterOffsets;
+      for ( size_t n = 0; n < offsets.size(); n++ )
+        {
+        const OffsetValueType q = p + offsets[n];
+        if ( q < slabBegin )
+          {
+          if ( !handedOverToPrevious && threadId > 0 )
+            {
+            next[threadId - 1].push_back( HandOverType(p, V) );
+            handedOverToPrevious = true;
+            }
+          continue;
+          }
+        if ( q >= slabEnd )
+          {
+          if ( !handedOverToNext && threadId + 1 < numberOfThreads )
+            {
+            next[threadId + 1].push_back( HandOverType(p, V) );
+            handedOverToNext = true;
+            }
+          continue;
+          }
+        const InputImagePixelType VN = marker[q];
+        const InputImagePixelType iN = mask[q];
+        // candidate for dilation via flooding
+        if ( compare(V, VN) && ( iN != VN ) )
+          {
+          if ( compare(iN, V) )
+            {
+            // not clamped by the mask, propagate the center value
+            marker[q] = V;
+            }
+          else
+            {
+            // apply the clamping
+            marker[q] = iN;
+            }
+          fifo.push(q);
+          }
+        }
+      }
     }
 }
 
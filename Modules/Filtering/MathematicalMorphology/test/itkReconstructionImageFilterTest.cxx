@@ -0,0 +1,160 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkReconstructionByDilationImageFilter.h"
+#include "itkReconstructionByErosionImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+namespace
+{
+typedef itk::Image< short, 3 > ImageType;
+
+template< class TFilter >
+bool
+CompareWithSingleThreaded( const ImageType *marker, const ImageType *mask,
+                           bool fullyConnected, const char *name )
+{
+  // the reconstruction without internal copy is the single threaded
+  // algorithm
+  typename TFilter::Pointer reference = TFilter::New();
+  reference->SetMarkerImage( marker );
+  reference->SetMaskImage( mask );
+  reference->SetFullyConnected( fullyConnected );
+  reference->SetUseInternalCopy( false );
+  reference->Update();
+
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetMarkerImage( marker );
+  filter->SetMaskImage( mask );
+  filter->SetFullyConnected( fullyConnected );
+
+  bool passed = true;
+  const unsigned int numberOfThreads[4] = { 1, 2, 3, 8 };
+  for( unsigned int t = 0; t < 4; t++ )
+    {
+    filter->SetNumberOfThreads( numberOfThreads[t] );
+    filter->Modified();
+    filter->Update();
+
+    itk::ImageRegionConstIterator< ImageType >
+      rit( reference->GetOutput(), reference->GetOutput()->GetBufferedRegion() );
+    itk::ImageRegionConstIterator< ImageType >
+      oit( filter->GetOutput(), filter->GetOutput()->GetBufferedRegion() );
+
+    unsigned int numberOfChanged = 0;
+    unsigned int numberOfDifferences = 0;
+    itk::ImageRegionConstIterator< ImageType >
+      mit( marker, marker->GetBufferedRegion() );
+    for( ; !rit.IsAtEnd(); ++rit, ++oit, ++mit )
+      {
+      numberOfChanged += ( rit.Get() != mit.Get() );
+      numberOfDifferences += ( rit.Get() != oit.Get() );
+      }
+
+    std::cout << name << ( fullyConnected ? ", fully connected" : "" )
+              << " with " << numberOfThreads[t] << " threads: "
+              << numberOfChanged << " reconstructed pixels, "
+              << numberOfDifferences << " differences" << std::endl;
+
+    passed &= ( numberOfDifferences == 0 && numberOfChanged > 0 );
+    }
+  return passed;
+}
+}
+
+int itkReconstructionImageFilterTest( int, char* [] )
+{
+  // A noisy landscape with maxima and basins spanning several slabs
+  ImageType::SizeType size = {{ 37, 29, 23 }};
+  ImageType::RegionType region;
+  region.SetSize( size );
+
+  ImageType::Pointer mask = ImageType::New();
+  mask->SetRegions( region );
+  mask->Allocate();
+
+  ImageType::Pointer dilationMarker = ImageType::New();
+  dilationMarker->SetRegions( region );
+  dilationMarker->Allocate();
+
+  ImageType::Pointer erosionMarker = ImageType::New();
+  erosionMarker->SetRegions( region );
+  erosionMarker->Allocate();
+
+  unsigned int seed = 1234;
+  itk::ImageRegionIteratorWithIndex< ImageType > it( mask, region );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType & index = it.GetIndex();
+    seed = seed * 1103515245 + 12345;
+    const double value = 100.0
+      + 40.0 * vcl_sin( 0.4 * index[0] ) * vcl_cos( 0.3 * index[1] )
+      + 30.0 * vcl_sin( 0.5 * index[2] + 0.2 * index[0] )
+      + static_cast< double >( ( seed >> 16 ) % 20 );
+    it.Set( static_cast< short >( value ) );
+
+    // h-maxima like marker for the dilation
+    dilationMarker->SetPixel( index, it.Get() - 25 );
+
+    // fill hole like marker for the erosion
+    bool border = false;
+    for( unsigned int d = 0; d < 3; d++ )
+      {
+      border |= ( index[d] == 0 ) ||
+        ( index[d] == static_cast< ImageType::IndexValueType >( size[d] ) - 1 );
+      }
+    erosionMarker->SetPixel( index, border ? it.Get() : 300 );
+    }
+
+  typedef itk::ReconstructionByDilationImageFilter< ImageType, ImageType > DilationType;
+  typedef itk::ReconstructionByErosionImageFilter< ImageType, ImageType >  ErosionType;
+
+  bool passed = true;
+  for( unsigned int fullyConnected = 0; fullyConnected < 2; fullyConnected++ )
+    {
+    passed &= CompareWithSingleThreaded< DilationType >
+      ( dilationMarker, mask, fullyConnected != 0, "Dilation" );
+    passed &= CompareWithSingleThreaded< ErosionType >
+      ( erosionMarker, mask, fullyConnected != 0, "Erosion" );
+    }
+
+  // the marker must be below the mask for a dilation
+  DilationType::Pointer invalid = DilationType::New();
+  invalid->SetMarkerImage( erosionMarker );
+  invalid->SetMaskImage( mask );
+  invalid->SetNumberOfThreads( 3 );
+  try
+    {
+    invalid->Update();
+    std::cout << "Missing exception for invalid marker image" << std::endl;
+    passed = false;
+    }
+  catch( itk::ExceptionObject & err )
+    {
+    std::cout << "Expected exception: " << err.GetDescription() << std::endl;
+    }
+
+  if( !passed )
+    {
+    std::cout << "Test failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
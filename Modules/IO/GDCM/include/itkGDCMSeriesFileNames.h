@@ -44,6 +44,12 @@ namespace itk
  *    dicom objects, you may want to try calling ->SetUseSeriesDetails(true)
  *    prior to calling SetDirectory().
  *
+ *  The headers of the files are read when the directory is set, on
+ *    NumberOfReadThreads threads. Only the headers are kept, and with
+ *    ParseSortingTagsOnly on, parsing of each file stops after the
+ *    tags used to group and sort the series. Both must be set before
+ *    SetDirectory() to have an effect.
+ *
  * \ingroup IOFilters
  *
  * \ingroup ITKIOGDCM
@@ -152,6 +158,7 @@ public:
   void AddSeriesRestriction(const std::string & tag)
   {
     m_SerieHelper->AddRestriction(tag);
+    m_SeriesRestrictions.push_back(tag);
   }
 
   /** Parse any sequences in the DICOM file. Defaults to false
@@ -169,6 +176,27 @@ public:
   itkSetMacro(LoadPrivateTags, bool);
   itkGetConstMacro(LoadPrivateTags, bool);
   itkBooleanMacro(LoadPrivateTags);
+
+  /** Set/Get the number of threads used to read the headers of the
+   * files of the directory. The default of one reads them one after
+   * another. The files are added to the series in directory order
+   * whatever the number of threads.
+   */
+  itkSetClampMacro(NumberOfReadThreads, ThreadIdType, 1, ITK_MAX_THREADS);
+  itkGetConstMacro(NumberOfReadThreads, ThreadIdType);
+
+  /** Stop parsing each file after the tags used to group and sort the
+   * series: the Series Instance UID, the image position and
+   * orientation, the tags of SetUseSeriesDetails and those added with
+   * AddSeriesRestriction. This avoids reading the pixel data and the
+   * tags that follow it. Files are then taken as images when they have
+   * Rows and Columns, without checking that the pixel data can be
+   * read, and the headers given by GetSeriesHelper() only hold the
+   * tags that were parsed. Defaults to false.
+   */
+  itkSetMacro(ParseSortingTagsOnly, bool);
+  itkGetConstMacro(ParseSortingTagsOnly, bool);
+  itkBooleanMacro(ParseSortingTagsOnly);
 protected:
   GDCMSeriesFileNames();
   ~GDCMSeriesFileNames();
@@ -194,10 +222,20 @@ private:
   /** Internal structure to keep the list of series UIDs */
   SerieUIDContainer m_SeriesUIDs;
 
+  /** Tags added with AddSeriesRestriction */
+  std::vector< std::string > m_SeriesRestrictions;
+
+  /** Read the headers of the files of the input directory and add them
+   * to m_SerieHelper. */
+  void ReadHeaders(const std::vector< std::string > & fileNames);
+
   bool m_UseSeriesDetails;
   bool m_Recursive;
   bool m_LoadSequences;
   bool m_LoadPrivateTags;
+  bool m_ParseSortingTagsOnly;
+
+  ThreadIdType m_NumberOfReadThreads;
 };
 } //namespace ITK
 
@@ -21,23 +21,122 @@
 #include "itkGDCMSeriesFileNames.h"
 #include "itksys/SystemTools.hxx"
 #include "itkProgressReporter.h"
+#include "itkSimpleFastMutexLock.h"
+#include "gdcmDirectory.h"
+#include "gdcmImageReader.h"
 
 namespace itk
 {
+namespace
+{
+/** gdcm::SerieHelper reads the files of a directory whole, one after
+ * another. This gives access to its protected AddFile, so that headers
+ * read elsewhere can be added to the series. */
+class GDCMSerieHelper:public gdcm::SerieHelper
+{
+public:
+  bool AddHeader(gdcm::FileWithName & header)
+  {
+    return this->AddFile(header);
+  }
+};
+
+/** Internal structure used for passing work to the read threads. */
+struct ReadHeadersThreadStruct
+{
+  const std::vector< std::string > *FileNames;
+  std::vector< gdcm::SmartPointer< gdcm::FileWithName > > Headers;
+  bool ParseSortingTagsOnly;
+  gdcm::Tag LastSortingTag;
+  SimpleFastMutexLock Lock;
+  size_t NextFile;
+};
+
+/** Read the header of an image file, or return a null pointer if it
+ * is not one. */
+gdcm::SmartPointer< gdcm::FileWithName >
+ReadHeader(const std::string & fileName, bool parseSortingTagsOnly,
+           const gdcm::Tag & lastSortingTag)
+{
+  gdcm::SmartPointer< gdcm::FileWithName > header;
+  if ( parseSortingTagsOnly )
+    {
+    gdcm::Reader reader;
+    reader.SetFileName( fileName.c_str() );
+    const std::set< gdcm::Tag > skipTags;
+    if ( !reader.ReadUpToTag(lastSortingTag, skipTags) )
+      {
+      return header;
+      }
+    const gdcm::DataSet & dataSet = reader.GetFile().GetDataSet();
+    if ( !dataSet.FindDataElement( gdcm::Tag(0x0028, 0x0010) )
+         || !dataSet.FindDataElement( gdcm::Tag(0x0028, 0x0011) ) )
+      {
+      return header;
+      }
+    header = new gdcm::FileWithName( reader.GetFile() );
+    }
+  else
+    {
+    // only accept DICOM files containing an image, as
+    // gdcm::SerieHelper does
+    gdcm::ImageReader reader;
+    reader.SetFileName( fileName.c_str() );
+    if ( !reader.Read() )
+      {
+      return header;
+      }
+    header = new gdcm::FileWithName( reader.GetFile() );
+    // the pixel data is not needed to sort the series, and would
+    // otherwise be kept in memory for every file of the directory
+    header->GetDataSet().Remove( gdcm::Tag(0x7fe0, 0x0010) );
+    }
+  header->filename = fileName;
+  return header;
+}
+
+ITK_THREAD_RETURN_TYPE ReadHeadersThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ReadHeadersThreadStruct *str = static_cast< ReadHeadersThreadStruct * >( info->UserData );
+
+  const size_t numberOfFiles = str->FileNames->size();
+  while ( true )
+    {
+    str->Lock.Lock();
+    if ( str->NextFile >= numberOfFiles )
+      {
+      str->Lock.Unlock();
+      break;
+      }
+    const size_t i = str->NextFile++;
+    str->Lock.Unlock();
+
+    str->Headers[i] = ReadHeader( ( *str->FileNames )[i],
+                                  str->ParseSortingTagsOnly,
+                                  str->LastSortingTag );
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+}
+
 GDCMSeriesFileNames::GDCMSeriesFileNames()
 {
-  m_SerieHelper = new gdcm::SerieHelper();
+  m_SerieHelper = new GDCMSerieHelper();
   m_InputDirectory = "";
   m_OutputDirectory = "";
   m_UseSeriesDetails = true;
   m_Recursive = false;
   m_LoadSequences = false;
   m_LoadPrivateTags = false;
+  m_ParseSortingTagsOnly = false;
+  m_NumberOfReadThreads = 1;
 }
 
 GDCMSeriesFileNames::~GDCMSeriesFileNames()
 {
-  delete m_SerieHelper;
+  delete static_cast< GDCMSerieHelper * >( m_SerieHelper );
 }
 
 void GDCMSeriesFileNames::SetInputDirectory(const char *name)
@@ -72,11 +171,72 @@ void GDCMSeriesFileNames::SetInputDirectory(std::string const & name)
   m_SerieHelper->SetUseSeriesDetails(m_UseSeriesDetails);
   m_SerieHelper->SetLoadMode( ( m_LoadSequences ? 0 : gdcm::LD_NOSEQ )
                               | ( m_LoadPrivateTags ? 0 : gdcm::LD_NOSHADOW ) );
-  m_SerieHelper->SetDirectory(name, m_Recursive);
+  gdcm::Directory directory;
+  directory.Load(name, m_Recursive);
+  this->ReadHeaders( directory.GetFilenames() );
   //as a side effect it also execute
   this->Modified();
 }
 
+void GDCMSeriesFileNames::ReadHeaders(const std::vector< std::string > & fileNames)
+{
+  ReadHeadersThreadStruct str;
+  str.FileNames = &fileNames;
+  str.Headers.resize( fileNames.size() );
+  str.ParseSortingTagsOnly = m_ParseSortingTagsOnly;
+  str.NextFile = 0;
+
+  // the last of the tags that CreateUniqueSeriesIdentifier and
+  // OrderFileList look at: Series Instance UID, Image Position and
+  // Orientation (Patient), the series details, and the restrictions
+  str.LastSortingTag = gdcm::Tag(0x0028, 0x0011);
+  for ( std::vector< std::string >::const_iterator it = m_SeriesRestrictions.begin();
+        it != m_SeriesRestrictions.end(); ++it )
+    {
+    gdcm::Tag tag;
+    if ( tag.ReadFromPipeSeparatedString( it->c_str() ) && str.LastSortingTag < tag )
+      {
+      str.LastSortingTag = tag;
+      }
+    }
+
+  ThreadIdType numberOfThreads = m_NumberOfReadThreads;
+  if ( numberOfThreads > fileNames.size() )
+    {
+    numberOfThreads = static_cast< ThreadIdType >( fileNames.size() );
+    }
+  if ( numberOfThreads > 1 )
+    {
+    MultiThreader *threader = this->GetMultiThreader();
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(ReadHeadersThreaderCallback, &str);
+    threader->SingleMethodExecute();
+    }
+  else
+    {
+    for ( size_t i = 0; i < fileNames.size(); ++i )
+      {
+      str.Headers[i] = ReadHeader(fileNames[i], str.ParseSortingTagsOnly,
+                                  str.LastSortingTag);
+      }
+    }
+
+  // add the headers in directory order, so that the series do not
+  // depend on the order in which the threads read the files
+  GDCMSerieHelper *helper = static_cast< GDCMSerieHelper * >( m_SerieHelper );
+  for ( size_t i = 0; i < str.Headers.size(); ++i )
+    {
+    if ( str.Headers[i] )
+      {
+      helper->AddHeader( *str.Headers[i] );
+      }
+    else
+      {
+      itkDebugMacro(<< "Could not read the DICOM image " << fileNames[i]);
+      }
+    }
+}
+
 const SerieUIDContainer & GDCMSeriesFileNames::GetSeriesUIDs()
 {
   m_SeriesUIDs.clear();
@@ -278,6 +438,8 @@ void GDCMSeriesFileNames::PrintSelf(std::ostream & os, Indent indent) const
   os << indent << "InputDirectory: " << m_InputDirectory << std::endl;
   os << indent << "LoadSequences:" << m_LoadSequences << std::endl;
   os << indent << "LoadPrivateTags:" << m_LoadPrivateTags << std::endl;
+  os << indent << "ParseSortingTagsOnly:" << m_ParseSortingTagsOnly << std::endl;
+  os << indent << "NumberOfReadThreads:" << m_NumberOfReadThreads << std::endl;
   if ( m_Recursive )
     {
     os << indent << "Recursive: True" << std::endl;
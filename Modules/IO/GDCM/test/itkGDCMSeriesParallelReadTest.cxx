@@ -0,0 +1,219 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+//
+//  Writes a synthetic DICOM series whose file names are not in slice
+//  order, then sorts and reads it back with one and with several
+//  threads, with and without ParseSortingTagsOnly. The times of each
+//  configuration are reported, so the test doubles as a benchmark when
+//  given a larger number of slices.
+//
+
+#include "itkImageSeriesReader.h"
+#include "itkImageSeriesWriter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkGDCMImageIO.h"
+#include "itkGDCMSeriesFileNames.h"
+#include "itkTimeProbe.h"
+#include "itksys/SystemTools.hxx"
+#include <fstream>
+#include <sstream>
+
+int itkGDCMSeriesParallelReadTest( int argc, char* argv[] )
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0]
+              << " OutputDicomDirectory [numberOfSlices] [numberOfThreads]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+  const unsigned int numberOfSlices = argc > 2 ? atoi(argv[2]) : 40;
+  const unsigned int numberOfThreads = argc > 3 ? atoi(argv[3]) : 4;
+
+  typedef itk::Image<unsigned short,3>                   ImageType;
+  typedef itk::Image<unsigned short,2>                   SliceType;
+  typedef itk::ImageSeriesWriter< ImageType, SliceType > WriterType;
+  typedef itk::ImageSeriesReader< ImageType >            ReaderType;
+  typedef itk::GDCMSeriesFileNames                       SeriesFileNames;
+
+  itksys::SystemTools::RemoveADirectory( directory.c_str() );
+  itksys::SystemTools::MakeDirectory( directory.c_str() );
+
+  //
+  // the volume
+  ImageType::RegionType region;
+  region.SetSize(0, 128);
+  region.SetSize(1, 96);
+  region.SetSize(2, numberOfSlices);
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.75;
+  spacing[1] = 0.75;
+  spacing[2] = 2.5;
+  image->SetSpacing(spacing);
+  ImageType::PointType origin;
+  origin[0] = -40.0;
+  origin[1] = 12.5;
+  origin[2] = 100.0;
+  image->SetOrigin(origin);
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it(image, region);
+  for(; !it.IsAtEnd(); ++it)
+    {
+    const ImageType::IndexType & idx = it.GetIndex();
+    it.Set( static_cast< unsigned short >( idx[0] * 3 + idx[1] * 5 + idx[2] * 1000 ) );
+    }
+
+  //
+  // file names that are sorted neither in the slice order nor in
+  // its reverse
+  std::vector< std::string > fileNames;
+  for(unsigned int i = 0; i < numberOfSlices; i++)
+    {
+    std::ostringstream name;
+    name << directory << "/slice";
+    name.width(6);
+    name.fill('0');
+    name << ( i * 7919 ) % 100003 << ".dcm";
+    fileNames.push_back( name.str() );
+    }
+
+  itk::GDCMImageIO::Pointer writeIO = itk::GDCMImageIO::New();
+  itk::MetaDataDictionary & dict = writeIO->GetMetaDataDictionary();
+  itk::EncapsulateMetaData<std::string>(dict, "0008|0060", "CT");
+  itk::EncapsulateMetaData<std::string>(dict, "0002|0002", "1.2.840.10008.5.1.4.1.1.2");
+
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( image );
+  writer->SetImageIO( writeIO );
+  writer->SetFileNames( fileNames );
+
+  // a file that is not DICOM, which both ways of scanning must skip
+  std::ofstream notes( ( directory + "/notes.txt" ).c_str() );
+  notes << "not a DICOM file" << std::endl;
+  notes.close();
+
+  try
+    {
+    writer->Update();
+    }
+  catch (itk::ExceptionObject &excp)
+    {
+    std::cerr << "Exception thrown while writing the series" << std::endl;
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  int status = EXIT_SUCCESS;
+
+  //
+  // sorting
+  const bool         sortingTagsOnly[] = { false, false, true, true };
+  const unsigned int sortingThreads[] = { 1, numberOfThreads, 1, numberOfThreads };
+  for(unsigned int c = 0; c < 4; c++)
+    {
+    SeriesFileNames::Pointer names = SeriesFileNames::New();
+    names->SetParseSortingTagsOnly( sortingTagsOnly[c] );
+    names->SetNumberOfReadThreads( sortingThreads[c] );
+
+    itk::TimeProbe probe;
+    probe.Start();
+    names->SetInputDirectory( directory );
+    const itk::FilenamesContainer & sorted = names->GetInputFileNames();
+    probe.Stop();
+
+    std::cout << "Sorting " << numberOfSlices << " files on "
+              << sortingThreads[c] << " thread(s)"
+              << ( sortingTagsOnly[c] ? ", parsing the sorting tags only: " : ": " )
+              << probe.GetMean() << " s" << std::endl;
+
+    if( sorted.size() != numberOfSlices )
+      {
+      std::cerr << "Found " << sorted.size() << " files instead of "
+                << numberOfSlices << std::endl;
+      status = EXIT_FAILURE;
+      continue;
+      }
+    for(unsigned int i = 0; i < numberOfSlices; i++)
+      {
+      if( itksys::SystemTools::GetFilenameName( sorted[i] )
+          != itksys::SystemTools::GetFilenameName( fileNames[i] ) )
+        {
+        std::cerr << "File " << i << " is " << sorted[i]
+                  << " instead of " << fileNames[i] << std::endl;
+        status = EXIT_FAILURE;
+        break;
+        }
+      }
+    }
+
+  //
+  // reading; the slices are only read concurrently with the ImageIOs
+  // created by the factory, and one after another with an ImageIO given
+  // to the reader
+  const unsigned int readThreads[] = { 1, numberOfThreads, numberOfThreads };
+  const bool         givenImageIO[] = { true, false, true };
+  for(unsigned int c = 0; c < 3; c++)
+    {
+    ReaderType::Pointer reader = ReaderType::New();
+    if( givenImageIO[c] )
+      {
+      reader->SetImageIO( itk::GDCMImageIO::New() );
+      }
+    reader->SetFileNames( fileNames );
+    reader->SetNumberOfReadThreads( readThreads[c] );
+
+    itk::TimeProbe probe;
+    probe.Start();
+    try
+      {
+      reader->Update();
+      }
+    catch (itk::ExceptionObject &excp)
+      {
+      std::cerr << "Exception thrown while reading the series" << std::endl;
+      std::cerr << excp << std::endl;
+      return EXIT_FAILURE;
+      }
+    probe.Stop();
+
+    std::cout << "Reading " << numberOfSlices << " files on "
+              << readThreads[c] << " thread(s)"
+              << ( givenImageIO[c] ? " with a given ImageIO: " : ": " )
+              << probe.GetMean() << " s" << std::endl;
+
+    itk::ImageRegionConstIterator< ImageType > eit(image, region);
+    itk::ImageRegionConstIterator< ImageType > rit(reader->GetOutput(), region);
+    for(; !eit.IsAtEnd(); ++eit, ++rit)
+      {
+      if( eit.Get() != rit.Get() )
+        {
+        std::cerr << "Pixel " << rit.GetIndex() << " is " << rit.Get()
+                  << " instead of " << eit.Get() << std::endl;
+        status = EXIT_FAILURE;
+        break;
+        }
+      }
+    }
+
+  return status;
+}
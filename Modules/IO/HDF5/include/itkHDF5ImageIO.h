@@ -129,6 +129,27 @@ public:
    * that the IORegions has been set properly. */
   virtual void Write(const void *buffer);
 
+  /** Set/Get the size of the compressed chunks the voxel data is
+   * stored in along dimension i, in pixels. Sizes that are not set or
+   * 0 default to the image size, except for the last dimension which
+   * defaults to 1, so that each chunk is an N-1 dimensional slice.
+   * Cubic chunks are better for reading random 3D regions. The sizes
+   * are clipped to the image size when writing. ReadImageInformation
+   * sets them to the chunk size of the file. */
+  void SetChunkSize(unsigned int i, SizeValueType size);
+  SizeValueType GetChunkSize(unsigned int i) const;
+
+  /** Split the streamed writes on chunk boundaries, so that each
+   * chunk is compressed once. */
+  virtual unsigned int GetActualNumberOfSplitsForWriting(unsigned int numberOfRequestedSplits,
+                                                         const ImageIORegion & pasteRegion,
+                                                         const ImageIORegion & largestPossibleRegion);
+
+  virtual ImageIORegion GetSplitRegionForWriting(unsigned int ithPiece,
+                                                 unsigned int numberOfActualSplits,
+                                                 const ImageIORegion & pasteRegion,
+                                                 const ImageIORegion & largestPossibleRegion);
+
 protected:
   HDF5ImageIO();
   ~HDF5ImageIO();
@@ -186,6 +207,17 @@ private:
                        unsigned long numElements);
   void SetupStreaming(H5::DataSpace *imageSpace,
                       H5::DataSpace *slabSpace);
+
+  /** The chunk size written along dimension i */
+  SizeValueType GetChunkSizeForWriting(unsigned int i) const;
+
+  /** The dimension split when streaming the paste region, and the
+   * range of chunks it covers along that dimension */
+  int GetChunkSplitAxis(const ImageIORegion & pasteRegion,
+                        SizeValueType & firstChunk,
+                        SizeValueType & numberOfChunks) const;
+
+  std::vector< SizeValueType > m_ChunkSize;
   H5::H5File  *m_H5File;
   H5::DataSet *m_VoxelDataSet;
   bool         m_ImageInformationWritten;
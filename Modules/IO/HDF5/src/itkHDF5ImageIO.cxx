@@ -22,6 +22,8 @@
 #include "itksys/SystemTools.hxx"
 #include "itk_H5Cpp.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -52,6 +54,72 @@ HDF5ImageIO
   Superclass::PrintSelf(os, indent);
   // just prints out the pointer value.
   os << indent << "H5File: " << this->m_H5File << std::endl;
+  os << indent << "ChunkSize:";
+  for(unsigned int i = 0; i < this->m_ChunkSize.size(); i++)
+    {
+    os << " " << this->m_ChunkSize[i];
+    }
+  os << std::endl;
+}
+
+void
+HDF5ImageIO
+::SetChunkSize(unsigned int i, SizeValueType size)
+{
+  if(i >= this->m_ChunkSize.size())
+    {
+    this->m_ChunkSize.resize(i + 1, 0);
+    }
+  if(this->m_ChunkSize[i] != size)
+    {
+    this->m_ChunkSize[i] = size;
+    this->Modified();
+    }
+}
+
+SizeValueType
+HDF5ImageIO
+::GetChunkSize(unsigned int i) const
+{
+  return i < this->m_ChunkSize.size() ? this->m_ChunkSize[i] : 0;
+}
+
+SizeValueType
+HDF5ImageIO
+::GetChunkSizeForWriting(unsigned int i) const
+{
+  const SizeValueType dimension = this->m_Dimensions[i];
+  const SizeValueType chunkSize = this->GetChunkSize(i);
+  if(chunkSize > 0)
+    {
+    return std::min(chunkSize,dimension);
+    }
+  // by default, a chunk is the N-1 dimensional slice
+  return i == this->GetNumberOfDimensions() - 1 ? 1 : dimension;
+}
+
+int
+HDF5ImageIO
+::GetChunkSplitAxis(const ImageIORegion & pasteRegion,
+                    SizeValueType & firstChunk,
+                    SizeValueType & numberOfChunks) const
+{
+  // split on the outermost dimension available, as the superclass does
+  int splitAxis = pasteRegion.GetImageDimension() - 1;
+  while(splitAxis >= 0 && pasteRegion.GetSize(splitAxis) == 1)
+    {
+    --splitAxis;
+    }
+  if(splitAxis < 0)
+    {
+    return splitAxis;
+    }
+  const SizeValueType chunkSize = this->GetChunkSizeForWriting(splitAxis);
+  const SizeValueType start = pasteRegion.GetIndex(splitAxis);
+  const SizeValueType end = start + pasteRegion.GetSize(splitAxis);
+  firstChunk = start / chunkSize;
+  numberOfChunks = ( end + chunkSize - 1 ) / chunkSize - firstChunk;
+  return splitAxis;
 }
 
 //
@@ -740,6 +808,18 @@ HDF5ImageIO
       {
       this->SetNumberOfComponents(Dims[nDims - 1]);
       }
+    //
+    // report the chunk size, fastest moving first
+    this->m_ChunkSize.clear();
+    H5::DSetCreatPropList imagePlist = imageSet.getCreatePlist();
+    if(imagePlist.getLayout() == H5D_CHUNKED)
+      {
+      imagePlist.getChunk(nDims,Dims);
+      for(int i = 0, j = numDims - 1; i < numDims; i++, j--)
+        {
+        this->m_ChunkSize.push_back(Dims[j]);
+        }
+      }
     delete [] Dims;
 
     //
@@ -1243,12 +1323,14 @@ HDF5ImageIO
     std::string VoxelDataName(ImageGroup);
     VoxelDataName += "/0";
     VoxelDataName += VoxelData;
-    // set up properties for chunked, compressed writes.
-    // in this case, set the chunk size to be the N-1 dimension
-    // region
+    // set up properties for chunked, compressed writes,
+    // keeping the components of a voxel in the same chunk
     H5::DSetCreatPropList plist;
     plist.setDeflate(5);
-    dims[0] = 1;
+    for(int i(0), j(this->GetNumberOfDimensions()-1); j >= 0; i++, j--)
+      {
+      dims[j] = this->GetChunkSizeForWriting(i);
+      }
     plist.setChunk(numDims,dims);
 
     //
@@ -1287,6 +1369,62 @@ HDF5ImageIO
     }
 }
 
+unsigned int
+HDF5ImageIO
+::GetActualNumberOfSplitsForWriting(unsigned int numberOfRequestedSplits,
+                                    const ImageIORegion & pasteRegion,
+                                    const ImageIORegion & largestPossibleRegion)
+{
+  // let the superclass check the paste region against an existing file
+  StreamingImageIOBase::GetActualNumberOfSplitsForWriting(numberOfRequestedSplits,
+                                                          pasteRegion,
+                                                          largestPossibleRegion);
+  SizeValueType firstChunk, numberOfChunks;
+  if(numberOfRequestedSplits <= 1 ||
+     this->GetChunkSplitAxis(pasteRegion,firstChunk,numberOfChunks) < 0)
+    {
+    return 1;
+    }
+  const SizeValueType chunksPerPiece =
+    ( numberOfChunks + numberOfRequestedSplits - 1 ) / numberOfRequestedSplits;
+  return static_cast<unsigned int>( ( numberOfChunks + chunksPerPiece - 1 ) / chunksPerPiece );
+}
+
+ImageIORegion
+HDF5ImageIO
+::GetSplitRegionForWriting(unsigned int ithPiece,
+                           unsigned int numberOfActualSplits,
+                           const ImageIORegion & pasteRegion,
+                           const ImageIORegion & itkNotUsed(largestPossibleRegion))
+{
+  ImageIORegion splitRegion = pasteRegion;
+  SizeValueType firstChunk, numberOfChunks;
+  const int     splitAxis =
+    this->GetChunkSplitAxis(pasteRegion,firstChunk,numberOfChunks);
+  if(numberOfActualSplits <= 1 || splitAxis < 0)
+    {
+    return splitRegion;
+    }
+  //
+  // each piece covers whole chunks along the split axis, except where
+  // the paste region begins or ends inside a chunk
+  const SizeValueType chunkSize = this->GetChunkSizeForWriting(splitAxis);
+  const SizeValueType chunksPerPiece =
+    ( numberOfChunks + numberOfActualSplits - 1 ) / numberOfActualSplits;
+  const SizeValueType regionStart = pasteRegion.GetIndex(splitAxis);
+  const SizeValueType regionEnd = regionStart + pasteRegion.GetSize(splitAxis);
+  const SizeValueType pieceStart =
+    std::max(regionStart, ( firstChunk + ithPiece * chunksPerPiece ) * chunkSize);
+  const SizeValueType pieceEnd =
+    std::min(regionEnd, ( firstChunk + ( ithPiece + 1 ) * chunksPerPiece ) * chunkSize);
+  splitRegion.SetIndex(splitAxis,pieceStart);
+  splitRegion.SetSize(splitAxis,pieceEnd - pieceStart);
+
+  itkDebugMacro("  Split Piece: " << splitRegion);
+
+  return splitRegion;
+}
+
 //
 // GetHeaderSize -- return 0
 ImageIOBase::SizeType
@@ -16,6 +16,7 @@
  *
  *=========================================================================*/
 #include "itkHDF5ImageIOFactory.h"
+#include "itkHDF5ImageIO.h"
 #include "itkIOTestHelper.h"
 #include "itkPipelineMonitorImageFilter.h"
 #include "itkStreamingImageFilter.h"
@@ -114,6 +115,105 @@ int HDF5ReadWriteTest2(const char *fileName)
   return success;
 }
 
+int HDF5ChunkedReadWriteTest(const char *fileName)
+{
+  typedef itk::Image<float,3> ImageType;
+  ImageType::RegionType imageRegion;
+  ImageType::SizeType size;
+  ImageType::SpacingType spacing;
+  const itk::SizeValueType chunkSize[3] = { 2, 3, 4 };
+  for(unsigned i = 0; i < 3; i++)
+    {
+    size[i] = 5 + i;
+    spacing[i] = 1.0;
+    }
+  imageRegion.SetSize(size);
+  ImageType::Pointer im =
+    itk::IOTestHelper::AllocateImageFromRegionAndSpacing<ImageType>(imageRegion,spacing);
+  vnl_random randgen(12345678);
+  itk::ImageRegionIterator<ImageType> it(im,im->GetLargestPossibleRegion());
+  for(it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    float pix;
+    itk::IOTestHelper::RandomPix(randgen,pix);
+    it.Set(pix);
+    }
+
+  //
+  // the 7 slices are split on the 4 slice chunk boundary
+  itk::HDF5ImageIO::Pointer writeIO = itk::HDF5ImageIO::New();
+  itk::ImageIORegion largest(3);
+  writeIO->SetNumberOfDimensions(3);
+  for(unsigned i = 0; i < 3; i++)
+    {
+    writeIO->SetDimensions(i,size[i]);
+    writeIO->SetChunkSize(i,chunkSize[i]);
+    largest.SetSize(i,size[i]);
+    }
+  const unsigned int numberOfSplits =
+    writeIO->GetActualNumberOfSplitsForWriting(3,largest,largest);
+  if(numberOfSplits != 2 ||
+     writeIO->GetSplitRegionForWriting(0,numberOfSplits,largest,largest).GetSize(2) != 4 ||
+     writeIO->GetSplitRegionForWriting(1,numberOfSplits,largest,largest).GetIndex(2) != 4 ||
+     writeIO->GetSplitRegionForWriting(1,numberOfSplits,largest,largest).GetSize(2) != 3)
+    {
+    std::cout << "Streamed writes are not split on chunk boundaries" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileWriter<ImageType> WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetImageIO(writeIO);
+  writer->SetFileName(fileName);
+  writer->SetInput(im);
+  writer->SetNumberOfStreamDivisions(3);
+
+  typedef itk::ImageFileReader<ImageType> ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  try
+    {
+    writer->Write();
+    // force writer close
+    writer = WriterType::Pointer();
+    writeIO = itk::HDF5ImageIO::Pointer();
+    reader->Update();
+    }
+  catch(itk::ExceptionObject &err)
+    {
+    std::cout << "itkHDF5ImageIOTest" << std::endl
+              << "Exception Object caught: " << std::endl
+              << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  itk::HDF5ImageIO *readIO =
+    dynamic_cast<itk::HDF5ImageIO *>(reader->GetImageIO());
+  for(unsigned i = 0; i < 3; i++)
+    {
+    if(readIO == 0 || readIO->GetChunkSize(i) != chunkSize[i])
+      {
+      std::cout << "Chunk size " << i << " was not written" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  ImageType::Pointer im2 = reader->GetOutput();
+  itk::ImageRegionIterator<ImageType> it2(im2,im2->GetLargestPossibleRegion());
+  for(it.GoToBegin(),it2.GoToBegin(); !it.IsAtEnd() && !it2.IsAtEnd(); ++it,++it2)
+    {
+    if(it.Value() != it2.Value())
+      {
+      std::cout << "Original Pixel (" << it.Value()
+                << ") doesn't match read-in Pixel ("
+                << it2.Value() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  reader = ReaderType::Pointer();
+  itk::IOTestHelper::Remove(fileName);
+  return EXIT_SUCCESS;
+}
+
 int
 itkHDF5ImageIOStreamingReadWriteTest(int ac, char * av [])
 {
@@ -130,5 +230,6 @@ itkHDF5ImageIOStreamingReadWriteTest(int ac, char * av [])
   result += HDF5ReadWriteTest2<unsigned char>("StreamingUCharImage.hdf5");
   result += HDF5ReadWriteTest2<float>("StreamingFloatImage.hdf5");
   result += HDF5ReadWriteTest2<itk::RGBPixel<unsigned char> >("StreamingRGBImage.hdf5");
+  result += HDF5ChunkedReadWriteTest("ChunkedFloatImage.hdf5");
   return result != 0;
 }
@@ -20,6 +20,7 @@
 
 #include "itkObject.h"
 #include "itkNumericTraits.h"
+#include "itkMultiThreader.h"
 
 namespace itk
 {
@@ -56,6 +57,20 @@ public:
                                  int inputNumberOfComponents,
                                  OutputPixelType *outputData, size_t size);
 
+  /** Same as the methods above, but the buffer is split into chunks of
+   * consecutive pixels that are converted on the threads of the given
+   * MultiThreader. Buffers too small to be worth splitting are
+   * converted on the calling thread. */
+  static void Convert(InputPixelType *inputData,
+                      int inputNumberOfComponents,
+                      OutputPixelType *outputData, size_t size,
+                      MultiThreader *threader);
+
+  static void ConvertVectorImage(InputPixelType *inputData,
+                                 int inputNumberOfComponents,
+                                 OutputPixelType *outputData, size_t size,
+                                 MultiThreader *threader);
+
 protected:
   /** Convert to Gray output. */
   /** Input values are cast to output values. */
@@ -146,6 +161,25 @@ private:
   ConvertPixelBuffer();
   ~ConvertPixelBuffer();
 
+  /** The smallest number of pixels converted by a thread. */
+  static const size_t MinimumPixelsPerThread = 65536;
+
+  struct ThreadStruct {
+    InputPixelType *InputData;
+    int InputNumberOfComponents;
+    OutputPixelType *OutputData;
+    size_t Size;
+    bool VectorImage;
+  };
+
+  /** Split the conversion among the threads of the MultiThreader. */
+  static void ThreadedConvert(InputPixelType *inputData,
+                              int inputNumberOfComponents,
+                              OutputPixelType *outputData, size_t size,
+                              bool vectorImage, MultiThreader *threader);
+
+  static ITK_THREAD_RETURN_TYPE ConvertThreaderCallback(void *arg);
+
   /** the most common case, where InputComponentType == unsigned
    *  char, the alpha is in the range 0..255. I presume in the
    *  mythical world of rgba<X> for all integral scalar types X, alpha
@@ -22,6 +22,7 @@
 #include "itkRGBPixel.h"
 
 #include <stddef.h>
+#include <algorithm>
 
 namespace itk
 {
@@ -708,6 +709,108 @@ ConvertPixelBuffer< InputPixelType, OutputPixelType, OutputConvertTraits >
     ++inputData;
     }
 }
+
+template< typename InputPixelType,
+          typename OutputPixelType,
+          class OutputConvertTraits
+          >
+void
+ConvertPixelBuffer< InputPixelType, OutputPixelType, OutputConvertTraits >
+::Convert(InputPixelType *inputData,
+          int inputNumberOfComponents,
+          OutputPixelType *outputData, size_t size,
+          MultiThreader *threader)
+{
+  // an empty conversion throws on the calling thread when the
+  // components can not be converted
+  Convert(inputData, inputNumberOfComponents, outputData, 0);
+  ThreadedConvert(inputData, inputNumberOfComponents, outputData, size, false, threader);
+}
+
+template< typename InputPixelType,
+          typename OutputPixelType,
+          class OutputConvertTraits
+          >
+void
+ConvertPixelBuffer< InputPixelType, OutputPixelType, OutputConvertTraits >
+::ConvertVectorImage(InputPixelType *inputData,
+                     int inputNumberOfComponents,
+                     OutputPixelType *outputData, size_t size,
+                     MultiThreader *threader)
+{
+  ThreadedConvert(inputData, inputNumberOfComponents, outputData, size, true, threader);
+}
+
+template< typename InputPixelType,
+          typename OutputPixelType,
+          class OutputConvertTraits
+          >
+void
+ConvertPixelBuffer< InputPixelType, OutputPixelType, OutputConvertTraits >
+::ThreadedConvert(InputPixelType *inputData,
+                  int inputNumberOfComponents,
+                  OutputPixelType *outputData, size_t size,
+                  bool vectorImage, MultiThreader *threader)
+{
+  if ( !threader || threader->GetNumberOfThreads() < 2 || size < 2 * MinimumPixelsPerThread )
+    {
+    if ( vectorImage )
+      {
+      ConvertVectorImage(inputData, inputNumberOfComponents, outputData, size);
+      }
+    else
+      {
+      Convert(inputData, inputNumberOfComponents, outputData, size);
+      }
+    return;
+    }
+
+  ThreadStruct str;
+  str.InputData = inputData;
+  str.InputNumberOfComponents = inputNumberOfComponents;
+  str.OutputData = outputData;
+  str.Size = size;
+  str.VectorImage = vectorImage;
+
+  const ThreadIdType numberOfThreads = threader->GetNumberOfThreads();
+  threader->SetNumberOfThreads( static_cast< ThreadIdType >(
+                                  std::min( static_cast< size_t >( numberOfThreads ),
+                                            size / MinimumPixelsPerThread ) ) );
+  threader->SetSingleMethod(Self::ConvertThreaderCallback, &str);
+  threader->SingleMethodExecute();
+  threader->SetNumberOfThreads(numberOfThreads);
+}
+
+template< typename InputPixelType,
+          typename OutputPixelType,
+          class OutputConvertTraits
+          >
+ITK_THREAD_RETURN_TYPE
+ConvertPixelBuffer< InputPixelType, OutputPixelType, OutputConvertTraits >
+::ConvertThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  const ThreadStruct *str = static_cast< ThreadStruct * >( info->UserData );
+
+  // each thread converts a range of consecutive pixels
+  const size_t threadId = info->ThreadID;
+  const size_t numberOfThreads = info->NumberOfThreads;
+  const size_t begin = str->Size * threadId / numberOfThreads;
+  const size_t end = str->Size * ( threadId + 1 ) / numberOfThreads;
+
+  InputPixelType *input = str->InputData + begin * str->InputNumberOfComponents;
+  if ( str->VectorImage )
+    {
+    // the output holds as many components per pixel as the input
+    ConvertVectorImage(input, str->InputNumberOfComponents,
+                       str->OutputData + begin * str->InputNumberOfComponents, end - begin);
+    }
+  else
+    {
+    Convert(input, str->InputNumberOfComponents, str->OutputData + begin, end - begin);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
 } // end namespace itk
 
 #endif
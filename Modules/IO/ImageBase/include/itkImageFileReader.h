@@ -77,6 +77,14 @@ public:
  * raw binary format) have no accepted suffix, so you will have to
  * manually create the ImageIO instance of the write type.
  *
+ * When ImageIOInformationCache is enabled, the ImageIO created for a
+ * file that was read before, and whose modification time and length
+ * have not changed, is of the type that read it and gets the image
+ * information read then, so that GenerateOutputInformation neither
+ * probes the factories nor parses the header. The header is then parsed
+ * when the pixels are read. ImageIOs set with SetImageIO() are not
+ * cached.
+ *
  * \sa ImageSeriesReader
  * \sa ImageIOBase
  *
@@ -149,12 +157,51 @@ public:
   itkSetMacro(UseStreaming, bool);
   itkGetConstReferenceMacro(UseStreaming, bool);
   itkBooleanMacro(UseStreaming);
+
+  /** Set/Get whether the output may be mapped from the file instead
+   * of being read into an allocated buffer. Mapping is used when the
+   * ImageIO reports that the pixel data is stored uncompressed and in
+   * the native byte order (see ImageIOBase::CanMemoryMapRead), the
+   * pixel type needs no conversion and the requested region is
+   * contiguous in the file and aligned to the size of a pixel
+   * component. Pages are then only read from disk when
+   * they are first accessed, and writes to the output buffer are not
+   * propagated to the file. The file must not be modified while the
+   * output is in use. Default is off. */
+  itkSetMacro(UseMemoryMapping, bool);
+  itkGetConstReferenceMacro(UseMemoryMapping, bool);
+  itkBooleanMacro(UseMemoryMapping);
+
+  /** Set/Get whether the region of the file that is expected to be
+   * requested next is read in the background while the pipeline
+   * processes the current one. When the output is streamed, the
+   * requested regions are consecutive pieces of the image along one
+   * dimension, so the piece that follows a region that either starts
+   * the image or follows the previous region in that dimension is read
+   * ahead, by a new ImageIO of the type of the one reading the file.
+   * It is then copied to the output if it is the region requested
+   * next, and discarded otherwise. This only helps when the ImageIO can
+   * read regions (see ImageIOBase::CanStreamRead), and must only be
+   * used with ImageIOs whose library may be used from two threads at
+   * once, such as those derived from StreamingImageIOBase. Since the
+   * new ImageIO would not have the settings of an ImageIO given with
+   * SetImageIO(), nothing is read ahead in that case. Default is
+   * off. */
+  itkSetMacro(UsePrefetching, bool);
+  itkGetConstReferenceMacro(UsePrefetching, bool);
+  itkBooleanMacro(UsePrefetching);
+
+  /** Set/Get the largest number of bytes read ahead. Regions larger than
+   * this are not prefetched. Default is 128 MB. */
+  itkSetMacro(PrefetchBufferSize, SizeValueType);
+  itkGetConstMacro(PrefetchBufferSize, SizeValueType);
 protected:
   ImageFileReader();
   ~ImageFileReader();
   void PrintSelf(std::ostream & os, Indent indent) const;
 
-  /** Convert a block of pixels from one type to another. */
+  /** Convert a block of pixels from one type to another, on the
+   * threads of the reader (see ProcessObject::SetNumberOfThreads). */
   void DoConvertBuffer(void *buffer, size_t numberOfPixels);
 
   /** Test whether the given filename exist and it is readable, this
@@ -167,12 +214,50 @@ protected:
   /** Does the real work. */
   virtual void GenerateData();
 
+  /** Set up the output to use a buffer mapped from the file. Returns
+   * false when the current file and requested region can not be
+   * mapped, in which case the output is left untouched. */
+  bool MapOutputBuffer();
+
+  /** Parse the header of the file if the image information was taken
+   * from ImageIOInformationCache, since reading the pixels may need
+   * more than that information. */
+  void ReadPendingImageInformation();
+
+  /** Read m_ActualIORegion into the buffer, by copying it from the
+   * prefetched region when that is the one, and start prefetching the
+   * next region when UsePrefetching is on. */
+  void ReadActualIORegion(void *buffer);
+
+  /** Predict the region that will be requested after m_ActualIORegion.
+   * Returns false when no region is expected. */
+  bool PredictNextIORegion(ImageIORegion & next) const;
+
+  /** Start reading the predicted region in the background. */
+  void StartPrefetch();
+
+  /** Wait for the background read, if any, to finish. Returns true when
+   * it read m_ActualIORegion of the current file. */
+  bool FinishPrefetch();
+
+  /** Function run by the prefetching thread. */
+  static ITK_THREAD_RETURN_TYPE PrefetchThreadCallback(void *arg);
+
   ImageIOBase::Pointer m_ImageIO;
 
   bool m_UserSpecifiedImageIO; // keep track whether the
                                // ImageIO is user specified
 
   bool m_UseStreaming;
+
+  bool m_UseMemoryMapping;
+
+  // whether m_ImageIO holds the cached image information of the file
+  // and has not parsed its header yet
+  bool m_ImageInformationFromCache;
+
+  bool          m_UsePrefetching;
+  SizeValueType m_PrefetchBufferSize;
 private:
   ImageFileReader(const Self &); //purposely not implemented
   void operator=(const Self &);  //purposely not implemented
@@ -182,6 +267,21 @@ private:
   // The region that the ImageIO class will return when we ask to
   // produce the requested region.
   ImageIORegion m_ActualIORegion;
+
+  // The region read before m_ActualIORegion, from which the streaming
+  // sequence is recognized
+  ImageIORegion m_PreviousIORegion;
+
+  // The state of the background read. It is only touched by the
+  // prefetching thread between StartPrefetch() and FinishPrefetch().
+  ImageIOBase::Pointer m_PrefetchImageIO;
+  bool                 m_PrefetchImageIOInformationRead;
+  std::string          m_PrefetchFileName;
+  ImageIORegion        m_PrefetchRegion;
+  std::vector< char >  m_PrefetchBuffer;
+  bool                 m_PrefetchRunning;
+  bool                 m_PrefetchSucceeded;
+  ThreadIdType         m_PrefetchThreadId;
 };
 } //namespace ITK
 
@@ -21,11 +21,14 @@
 
 #include "itkObjectFactory.h"
 #include "itkImageIOFactory.h"
+#include "itkImageIOInformationCache.h"
 #include "itkConvertPixelBuffer.h"
+#include "itkMemoryMappedImportImageContainer.h"
 #include "itkPixelTraits.h"
 #include "itkVectorImage.h"
 
 #include "itksys/SystemTools.hxx"
+#include <algorithm>
 #include <fstream>
 
 namespace itk
@@ -38,12 +41,22 @@ ImageFileReader< TOutputImage, ConvertPixelTraits >
   this->SetFileName("");
   m_UserSpecifiedImageIO = false;
   m_UseStreaming = true;
+  m_UseMemoryMapping = false;
+  m_ImageInformationFromCache = false;
+  m_UsePrefetching = false;
+  m_PrefetchBufferSize = 128 * 1024 * 1024;
+  m_PrefetchImageIOInformationRead = false;
+  m_PrefetchRunning = false;
+  m_PrefetchSucceeded = false;
+  m_PrefetchThreadId = 0;
 }
 
 template< class TOutputImage, class ConvertPixelTraits >
 ImageFileReader< TOutputImage, ConvertPixelTraits >
 ::~ImageFileReader()
-{}
+{
+  this->FinishPrefetch();
+}
 
 template< class TOutputImage, class ConvertPixelTraits >
 void ImageFileReader< TOutputImage, ConvertPixelTraits >
@@ -63,6 +76,10 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
 
   os << indent << "UserSpecifiedImageIO flag: " << m_UserSpecifiedImageIO << "\n";
   os << indent << "m_UseStreaming: " << m_UseStreaming << "\n";
+  os << indent << "m_UseMemoryMapping: " << m_UseMemoryMapping << "\n";
+  os << indent << "m_ImageInformationFromCache: " << m_ImageInformationFromCache << "\n";
+  os << indent << "m_UsePrefetching: " << m_UsePrefetching << "\n";
+  os << indent << "m_PrefetchBufferSize: " << m_PrefetchBufferSize << "\n";
 }
 
 template< class TOutputImage, class ConvertPixelTraits >
@@ -110,10 +127,18 @@ ImageFileReader< TOutputImage, ConvertPixelTraits >
     m_ExceptionMessage = err.GetDescription();
     }
 
+  m_ImageInformationFromCache = false;
 #if !defined(SPECIFIC_IMAGEIO_MODULE_TEST)
   if ( m_UserSpecifiedImageIO == false ) //try creating via factory
     {
-    m_ImageIO = ImageIOFactory::CreateImageIO(this->GetFileName().c_str(), ImageIOFactory::ReadMode);
+    // a file that was read before gets an ImageIO of the type that
+    // read it, which already holds the image information
+    m_ImageIO = ImageIOInformationCache::Find( this->GetFileName() );
+    m_ImageInformationFromCache = m_ImageIO.IsNotNull();
+    if ( !m_ImageInformationFromCache )
+      {
+      m_ImageIO = ImageIOFactory::CreateImageIO(this->GetFileName().c_str(), ImageIOFactory::ReadMode);
+      }
     }
 #endif
 
@@ -149,7 +174,16 @@ ImageFileReader< TOutputImage, ConvertPixelTraits >
   // the image.
   //
   m_ImageIO->SetFileName( this->GetFileName().c_str() );
-  m_ImageIO->ReadImageInformation();
+  if ( !m_ImageInformationFromCache )
+    {
+    m_ImageIO->ReadImageInformation();
+#if !defined(SPECIFIC_IMAGEIO_MODULE_TEST)
+    if ( m_UserSpecifiedImageIO == false )
+      {
+      ImageIOInformationCache::Insert(this->GetFileName(), m_ImageIO);
+      }
+#endif
+    }
 
   SizeType dimSize;
   double   spacing[TOutputImage::ImageDimension];
@@ -162,6 +196,9 @@ ImageFileReader< TOutputImage, ConvertPixelTraits >
 
   if ( numberOfDimensionsIO > TOutputImage::ImageDimension )
     {
+    // the default direction may depend on more than the cached
+    // information
+    this->ReadPendingImageInformation();
     for ( unsigned int k = 0; k < numberOfDimensionsIO; k++ )
       {
       directionIO.push_back( m_ImageIO->GetDefaultDirection(k) );
@@ -289,6 +326,11 @@ ImageFileReader< TOutputImage, ConvertPixelTraits >
 ::EnlargeOutputRequestedRegion(DataObject *output)
 {
   itkDebugMacro (<< "Starting EnlargeOutputRequestedRegion() ");
+
+  // the ImageIO is about to be asked about reading pixels, which may
+  // need more of the header than the cached information
+  this->ReadPendingImageInformation();
+
   typename TOutputImage::Pointer out = dynamic_cast< TOutputImage * >( output );
   typename TOutputImage::RegionType largestRegion = out->GetLargestPossibleRegion();
   ImageRegionType streamableRegion;
@@ -347,6 +389,21 @@ ImageFileReader< TOutputImage, ConvertPixelTraits >
   out->SetRequestedRegion(streamableRegion);
 }
 
+template< class TOutputImage, class ConvertPixelTraits >
+void
+ImageFileReader< TOutputImage, ConvertPixelTraits >
+::ReadPendingImageInformation()
+{
+  if ( m_ImageInformationFromCache )
+    {
+    itkDebugMacro(<< "Reading the header of " << this->GetFileName()
+                  << " whose information was cached");
+    m_ImageIO->SetFileName( this->GetFileName().c_str() );
+    m_ImageIO->ReadImageInformation();
+    m_ImageInformationFromCache = false;
+    }
+}
+
 template< class TOutputImage, class ConvertPixelTraits >
 void ImageFileReader< TOutputImage, ConvertPixelTraits >
 ::GenerateData()
@@ -357,7 +414,14 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
                  << "Allocating the buffer with the EnlargedRequestedRegion \n"
                  << output->GetRequestedRegion() << "\n");
 
-  // allocated the output image to the size of the enlarge requested region
+  // map the pixels of the file into the output when possible, and
+  // otherwise allocate the output image to the size of the enlarged
+  // requested region
+  if ( m_UseMemoryMapping && this->MapOutputBuffer() )
+    {
+    itkDebugMacro(<< "Output buffer mapped from the file.");
+    return;
+    }
   this->AllocateOutputs();
 
   // Test if the file exists and if it can be opened.
@@ -410,7 +474,7 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
                      << m_ImageIO->GetNumberOfComponents() );
 
       loadBuffer = new char[sizeOfActualIORegion];
-      m_ImageIO->Read( static_cast< void * >( loadBuffer ) );
+      this->ReadActualIORegion( static_cast< void * >( loadBuffer ) );
 
       // See note below as to why the buffered region is needed and
       // not actualIOregion
@@ -430,7 +494,7 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
       OutputImagePixelType *outputBuffer = output->GetPixelContainer()->GetBufferPointer();
 
       loadBuffer = new char[sizeOfActualIORegion];
-      m_ImageIO->Read( static_cast< void * >( loadBuffer ) );
+      this->ReadActualIORegion( static_cast< void * >( loadBuffer ) );
 
       // we use std::copy here as it should be optimized to memcpy for
       // plain old data, but still is oop
@@ -444,7 +508,7 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
       itkDebugMacro(<< "No buffer conversion required.");
 
       OutputImagePixelType *outputBuffer = output->GetPixelContainer()->GetBufferPointer();
-      m_ImageIO->Read(outputBuffer);
+      this->ReadActualIORegion(outputBuffer);
       }
     }
   catch ( ... )
@@ -470,6 +534,248 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
     }
 }
 
+template< class TOutputImage, class ConvertPixelTraits >
+void
+ImageFileReader< TOutputImage, ConvertPixelTraits >
+::ReadActualIORegion(void *buffer)
+{
+  if ( this->FinishPrefetch() )
+    {
+    itkDebugMacro(<< "Copying the prefetched region " << m_ActualIORegion);
+    std::copy( m_PrefetchBuffer.begin(), m_PrefetchBuffer.end(), static_cast< char * >( buffer ) );
+    }
+  else
+    {
+    m_ImageIO->Read(buffer);
+    }
+
+  // the ImageIO reading ahead is created by CreateAnother(), which
+  // would lose the settings of an ImageIO given by the user
+  if ( m_UsePrefetching && !m_UserSpecifiedImageIO )
+    {
+    this->StartPrefetch();
+    }
+  m_PreviousIORegion = m_ActualIORegion;
+}
+
+template< class TOutputImage, class ConvertPixelTraits >
+bool
+ImageFileReader< TOutputImage, ConvertPixelTraits >
+::PredictNextIORegion(ImageIORegion & next) const
+{
+  const unsigned int dimension = m_ActualIORegion.GetImageDimension();
+
+  // streaming splits the outermost dimension that the region does not
+  // cover entirely
+  int splitDimension = -1;
+  for ( int i = static_cast< int >( dimension ) - 1; i >= 0 && splitDimension < 0; --i )
+    {
+    const SizeValueType fileSize =
+      static_cast< unsigned int >( i ) < m_ImageIO->GetNumberOfDimensions() ? m_ImageIO->GetDimensions(i) : 1;
+    if ( m_ActualIORegion.GetSize(i) < fileSize )
+      {
+      splitDimension = i;
+      }
+    }
+  if ( splitDimension < 0 )
+    {
+    return false;
+    }
+
+  // the region must start a sequence of pieces, or continue one
+  bool follows = m_PreviousIORegion.GetImageDimension() == dimension;
+  for ( unsigned int i = 0; i < dimension && follows; ++i )
+    {
+    if ( static_cast< int >( i ) == splitDimension )
+      {
+      follows = m_PreviousIORegion.GetIndex(i) + static_cast< IndexValueType >( m_PreviousIORegion.GetSize(i) )
+                == m_ActualIORegion.GetIndex(i);
+      }
+    else
+      {
+      follows = m_PreviousIORegion.GetIndex(i) == m_ActualIORegion.GetIndex(i)
+                && m_PreviousIORegion.GetSize(i) == m_ActualIORegion.GetSize(i);
+      }
+    }
+  if ( !follows && m_ActualIORegion.GetIndex(splitDimension) != 0 )
+    {
+    return false;
+    }
+
+  const SizeValueType  fileSize = m_ImageIO->GetDimensions(splitDimension);
+  const IndexValueType start = m_ActualIORegion.GetIndex(splitDimension)
+                               + static_cast< IndexValueType >( m_ActualIORegion.GetSize(splitDimension) );
+  if ( start >= static_cast< IndexValueType >( fileSize ) )
+    {
+    return false;
+    }
+  next = m_ActualIORegion;
+  next.SetIndex(splitDimension, start);
+  next.SetSize( splitDimension, std::min( m_ActualIORegion.GetSize(splitDimension),
+                                          static_cast< SizeValueType >( fileSize - start ) ) );
+  return true;
+}
+
+template< class TOutputImage, class ConvertPixelTraits >
+void
+ImageFileReader< TOutputImage, ConvertPixelTraits >
+::StartPrefetch()
+{
+  ImageIORegion next;
+  if ( !this->PredictNextIORegion(next) )
+    {
+    return;
+    }
+  const SizeValueType size = next.GetNumberOfPixels()
+                             * m_ImageIO->GetComponentSize() * m_ImageIO->GetNumberOfComponents();
+  if ( size > m_PrefetchBufferSize )
+    {
+    return;
+    }
+
+  // the ImageIO reading ahead is kept as long as the file is the same,
+  // so that it only parses the header once
+  if ( m_PrefetchImageIO.IsNull()
+       || m_PrefetchFileName != this->GetFileName()
+       || strcmp( m_PrefetchImageIO->GetNameOfClass(), m_ImageIO->GetNameOfClass() ) != 0 )
+    {
+    LightObject::Pointer another = m_ImageIO->CreateAnother();
+    m_PrefetchImageIO = dynamic_cast< ImageIOBase * >( another.GetPointer() );
+    if ( m_PrefetchImageIO.IsNull() )
+      {
+      return;
+      }
+    m_PrefetchFileName = this->GetFileName();
+    m_PrefetchImageIOInformationRead = false;
+    }
+
+  itkDebugMacro(<< "Prefetching " << next);
+  m_PrefetchRegion = next;
+  m_PrefetchBuffer.resize(size);
+  m_PrefetchSucceeded = false;
+  m_PrefetchThreadId = this->GetMultiThreader()->SpawnThread(Self::PrefetchThreadCallback, this);
+  m_PrefetchRunning = true;
+}
+
+template< class TOutputImage, class ConvertPixelTraits >
+bool
+ImageFileReader< TOutputImage, ConvertPixelTraits >
+::FinishPrefetch()
+{
+  if ( !m_PrefetchRunning )
+    {
+    return false;
+    }
+  this->GetMultiThreader()->TerminateThread(m_PrefetchThreadId);
+  m_PrefetchRunning = false;
+
+  return m_PrefetchSucceeded
+         && m_PrefetchRegion == m_ActualIORegion
+         && m_PrefetchFileName == this->GetFileName()
+         && strcmp( m_PrefetchImageIO->GetNameOfClass(), m_ImageIO->GetNameOfClass() ) == 0;
+}
+
+template< class TOutputImage, class ConvertPixelTraits >
+ITK_THREAD_RETURN_TYPE
+ImageFileReader< TOutputImage, ConvertPixelTraits >
+::PrefetchThreadCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  Self *reader = static_cast< Self * >( info->UserData );
+
+  // errors are left to the read of the region in GenerateData()
+  try
+    {
+    ImageIOBase *io = reader->m_PrefetchImageIO;
+    if ( !reader->m_PrefetchImageIOInformationRead )
+      {
+      io->SetFileName( reader->m_PrefetchFileName.c_str() );
+      io->ReadImageInformation();
+      io->SetUseStreamedReading(true);
+      reader->m_PrefetchImageIOInformationRead = true;
+      }
+    io->SetIORegion(reader->m_PrefetchRegion);
+    io->Read( &reader->m_PrefetchBuffer[0] );
+    reader->m_PrefetchSucceeded = true;
+    }
+  catch ( ... )
+    {
+    reader->m_PrefetchSucceeded = false;
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TOutputImage, class ConvertPixelTraits >
+bool
+ImageFileReader< TOutputImage, ConvertPixelTraits >
+::MapOutputBuffer()
+{
+  typename TOutputImage::Pointer output = this->GetOutput();
+
+  // the pixels must be usable as they are stored in the file
+  ImageIOBase::IOComponentType ioType =
+    ImageIOBase
+    ::MapPixelType< typename ConvertPixelTraits::ComponentType >::CType;
+  if ( m_ImageIO->GetComponentType() != ioType
+       || m_ImageIO->GetNumberOfComponents() != ConvertPixelTraits::GetNumberOfComponents()
+       || sizeof( OutputImagePixelType ) != m_ImageIO->GetComponentSize() * m_ImageIO->GetNumberOfComponents()
+       || m_ActualIORegion.GetNumberOfPixels() != output->GetRequestedRegion().GetNumberOfPixels() )
+    {
+    return false;
+    }
+
+  std::string            dataFileName;
+  ImageIOBase::SizeType  dataOffset = 0;
+  if ( !m_ImageIO->CanMemoryMapRead(dataFileName, dataOffset) )
+    {
+    return false;
+    }
+
+  // The region must be contiguous in the file: all the dimensions
+  // after the first one that is not read entirely must have a size of
+  // one.
+  const unsigned int ioDimension = m_ImageIO->GetNumberOfDimensions();
+  SizeValueType      pixelOffset = 0;
+  SizeValueType      pixelStride = 1;
+  bool               partial = false;
+  for ( unsigned int i = 0; i < ioDimension; ++i )
+    {
+    const SizeValueType size =
+      i < m_ActualIORegion.GetImageDimension() ? m_ActualIORegion.GetSize(i) : 1;
+    const IndexValueType index =
+      i < m_ActualIORegion.GetImageDimension() ? m_ActualIORegion.GetIndex(i) : 0;
+    if ( partial && size != 1 )
+      {
+      return false;
+      }
+    partial = partial || size != m_ImageIO->GetDimensions(i);
+    pixelOffset += index * pixelStride;
+    pixelStride *= m_ImageIO->GetDimensions(i);
+    }
+
+  // mapped pixels must be aligned like allocated ones
+  const SizeValueType byteOffset =
+    static_cast< SizeValueType >( dataOffset ) + pixelOffset * sizeof( OutputImagePixelType );
+  if ( byteOffset % m_ImageIO->GetComponentSize() != 0 )
+    {
+    return false;
+    }
+
+  typedef typename TOutputImage::PixelContainer PixelContainerType;
+  typedef MemoryMappedImportImageContainer< typename PixelContainerType::ElementIdentifier,
+                                            typename PixelContainerType::Element > MappedContainerType;
+
+  typename MappedContainerType::Pointer container = MappedContainerType::New();
+  if ( !container->MapFile( dataFileName, byteOffset, m_ActualIORegion.GetNumberOfPixels() ) )
+    {
+    return false;
+    }
+
+  output->SetBufferedRegion( output->GetRequestedRegion() );
+  output->SetPixelContainer(container);
+  return true;
+}
+
 template< class TOutputImage, class ConvertPixelTraits >
 void
 ImageFileReader< TOutputImage, ConvertPixelTraits >
@@ -481,6 +787,10 @@ ImageFileReader< TOutputImage, ConvertPixelTraits >
     this->GetOutput()->GetPixelContainer()->GetBufferPointer();
   bool isVectorImage(strcmp(this->GetOutput()->GetNameOfClass(),
                             "VectorImage") == 0);
+
+  // the pixels are converted in chunks on the threads of the reader
+  MultiThreader *threader = this->GetMultiThreader();
+  threader->SetNumberOfThreads( this->GetNumberOfThreads() );
   // TODO:
   // Pass down the PixelType (RGB, VECTOR, etc.) so that any vector to
   // scalar conversion be type specific. i.e. RGB to scalar would use
@@ -508,7 +818,8 @@ ImageFileReader< TOutputImage, ConvertPixelTraits >
         ::ConvertVectorImage(static_cast< type * >( inputData ),        \
                              m_ImageIO->GetNumberOfComponents(),        \
                              outputData,                                \
-                             numberOfPixels);                           \
+                             numberOfPixels,                            \
+                             threader);                                 \
       }                                                                 \
     else                                                                \
       {                                                                 \
@@ -519,7 +830,8 @@ ImageFileReader< TOutputImage, ConvertPixelTraits >
         ::Convert(static_cast< type * >( inputData ),                   \
                   m_ImageIO->GetNumberOfComponents(),                   \
                   outputData,                                           \
-                  numberOfPixels);                                      \
+                  numberOfPixels,                                       \
+                  threader);                                            \
       }                                                                 \
     }
 
@@ -315,6 +315,19 @@ public:
     return false;
   }
 
+  /** Determine if the pixel data of the current file can be mapped
+      into memory instead of being read. This is the case when the
+      data is stored uncompressed, contiguously and in the byte order
+      of this machine. If so, dataFileName is set to the file holding
+      the data and dataOffset to the byte position of its first pixel
+      in that file. Default is false. This is only meaningful after
+      the header of the file has been read. */
+  virtual bool CanMemoryMapRead( std::string & itkNotUsed(dataFileName),
+                                 SizeType & itkNotUsed(dataOffset) )
+  {
+    return false;
+  }
+
   /** Read the spacing and dimensions of the image.
    * Assumes SetFileName has been called with a valid file name. */
   virtual void ReadImageInformation() = 0;
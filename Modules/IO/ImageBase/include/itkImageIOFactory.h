@@ -48,6 +48,9 @@ public:
   typedef enum { ReadMode, WriteMode } FileModeType;
 
   /** Create the appropriate ImageIO depending on the particulars of the file.
+   * The ImageIOs whose supported extensions match the file name are
+   * asked first whether they can read or write it, and then the others,
+   * each in the order the factories were registered.
     */
   static ImageIOBasePointer CreateImageIO(const char *path, FileModeType mode);
 
@@ -0,0 +1,103 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkImageIOInformationCache_h
+#define __itkImageIOInformationCache_h
+
+#include "itkObject.h"
+#include "itkImageIOBase.h"
+
+namespace itk
+{
+/** \class ImageIOInformationCache
+ * \brief Process-wide cache of the ImageIO type and image information
+ * of the files read by ImageFileReader.
+ *
+ * When the cache is enabled, ImageFileReader::GenerateOutputInformation
+ * looks up the file name in the cache before asking ImageIOFactory for
+ * an ImageIO. On a hit, the ImageIO is created from the type that read
+ * the file before, and it is given the dimensions, spacing, origin,
+ * direction, pixel type and meta data found then, so that neither the
+ * registered factories are probed nor the header is parsed. The header
+ * is only parsed again if the reader goes on to read pixels.
+ *
+ * An entry is used only while the modification time and the length of
+ * the file are those it was stored with. Since modification times have
+ * a resolution of a second, a file that is rewritten with the same
+ * length within the second it was cached in is not detected; such
+ * files should be removed from the cache with Remove(). Only the file
+ * that was given to the reader is checked, not the data files that a
+ * header may refer to.
+ *
+ * The cache is disabled by default. The least recently used entries are
+ * dropped when it holds more than MaximumNumberOfEntries files. All the
+ * methods may be called from several threads.
+ *
+ * \sa ImageFileReader
+ * \sa ImageIOFactory
+ * \ingroup ITKIOImageBase
+ */
+class ITK_EXPORT ImageIOInformationCache:public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImageIOInformationCache    Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageIOInformationCache, Object);
+
+  /** Enable or disable the cache. Disabling it also empties it. */
+  static void SetEnabled(bool enabled);
+  static bool GetEnabled();
+  static void EnabledOn() { SetEnabled(true); }
+  static void EnabledOff() { SetEnabled(false); }
+
+  /** Set/Get the number of files the cache holds at most. Default is
+   * 1024. */
+  static void SetMaximumNumberOfEntries(SizeValueType number);
+  static SizeValueType GetMaximumNumberOfEntries();
+
+  /** Number of files currently in the cache. */
+  static SizeValueType GetNumberOfEntries();
+
+  /** Return a new ImageIO of the type that read the given file, with
+   * the image information read then, or a null pointer if the cache is
+   * disabled, the file is not in it or has changed since. */
+  static ImageIOBase::Pointer Find(const std::string & fileName);
+
+  /** Store the type and the image information of an ImageIO that has
+   * just read the information of the given file. Does nothing when the
+   * cache is disabled. */
+  static void Insert(const std::string & fileName, const ImageIOBase *imageIO);
+
+  /** Remove one file, or all of them, from the cache. */
+  static void Remove(const std::string & fileName);
+  static void Clear();
+
+protected:
+  ImageIOInformationCache();
+  ~ImageIOInformationCache();
+private:
+  ImageIOInformationCache(const Self &); //purposely not implemented
+  void operator=(const Self &);          //purposely not implemented
+};
+} // end namespace itk
+
+#endif
@@ -0,0 +1,71 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkImageIOTaskQueue_h
+#define __itkImageIOTaskQueue_h
+
+#include "itkObject.h"
+#include "itkMultiThreader.h"
+
+namespace itk
+{
+/** \class ImageIOTaskQueue
+ * \brief Runs independent tasks of an ImageIO on the threads of a
+ * MultiThreader.
+ *
+ * The tasks are handed out one at a time from a shared counter, so that
+ * tasks of varying cost, such as the (de)compression of the chunks of a
+ * compressed file, keep all the threads busy. Execute() returns when all
+ * the tasks are done. It is the common implementation of the parallel
+ * hooks that ImageIOs hand to their third party libraries, e.g. the
+ * MET_ParallelForFunctionType of MetaIO and the nrrdParallelFor of NrrdIO.
+ *
+ * \sa MultiThreader
+ * \ingroup ITKIOImageBase
+ */
+class ITK_EXPORT ImageIOTaskQueue:public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImageIOTaskQueue           Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageIOTaskQueue, Object);
+
+  /** A task, called with the task data and the index of the task. */
+  typedef void ( *TaskFunctionType )(void *taskData, unsigned int taskId);
+
+  /** Call task(taskData, i) exactly once for every i in
+   * [0, numberOfTasks) on the threads of the given threader. */
+  static void Execute(MultiThreader *threader, TaskFunctionType task,
+                      void *taskData, unsigned int numberOfTasks);
+
+protected:
+  ImageIOTaskQueue();
+  ~ImageIOTaskQueue();
+private:
+  ImageIOTaskQueue(const Self &); //purposely not implemented
+  void operator=(const Self &);   //purposely not implemented
+
+  static ITK_THREAD_RETURN_TYPE ExecuteThreaderCallback(void *arg);
+};
+} // end namespace itk
+
+#endif
@@ -23,6 +23,7 @@
 #include <string>
 #include "itkMetaDataDictionary.h"
 #include "itkImageFileReader.h"
+#include "itkSimpleFastMutexLock.h"
 
 namespace itk
 {
@@ -34,6 +35,16 @@ namespace itk
  * the files, but the image data must have the same Size for all
  * dimensions.
  *
+ * By default the files are read one after another. Setting
+ * NumberOfReadThreads above one reads and decodes the slices
+ * concurrently. Each slice is still decoded directly into its part of
+ * the output buffer when the read region matches the slice, and the
+ * MetaDataDictionaryArray keeps the order of the file names
+ * regardless of which thread read a file. Each thread reads with
+ * ImageIOs created by the factory, so the slices are read one after
+ * another when an ImageIO has been set with SetImageIO(), whose
+ * settings another instance would not have.
+ *
  * \sa GDCMSeriesFileNames
  * \sa NumericSeriesFileNames
  * \ingroup IOFilters
@@ -153,9 +164,16 @@ public:
   itkSetMacro(UseStreaming, bool);
   itkGetConstReferenceMacro(UseStreaming, bool);
   itkBooleanMacro(UseStreaming);
+
+  /** Set/Get the number of threads used to read the slices of the
+   * series. The default of one reads the files sequentially, as does
+   * any number when an ImageIO has been set. */
+  itkSetClampMacro(NumberOfReadThreads, ThreadIdType, 1, ITK_MAX_THREADS);
+  itkGetConstMacro(NumberOfReadThreads, ThreadIdType);
 protected:
   ImageSeriesReader():m_ImageIO(0), m_ReverseOrder(false),
-    m_UseStreaming(true), m_MetaDataDictionaryArrayUpdate(true) {}
+    m_UseStreaming(true), m_MetaDataDictionaryArrayUpdate(true),
+    m_NumberOfReadThreads(1) {}
   ~ImageSeriesReader();
   void PrintSelf(std::ostream & os, Indent indent) const;
 
@@ -191,11 +209,42 @@ private:
 
   int ComputeMovingDimensionIndex(ReaderType *reader);
 
+  /** Read the slice of file position i into the output buffer, or
+   * only its header when the slice is outside the requested
+   * region. Returns a copy of the meta-data dictionary when
+   * copyDictionary is true, and NULL otherwise. */
+  DictionaryRawPointer ReadSlice(int i, ImageIOBase *imageIO, bool copyDictionary);
+
+  /** Read the given slices with NumberOfReadThreads threads, storing
+   * the dictionaries by file position. */
+  void ThreadedReadSlices(const std::vector< int > & slices,
+                          bool copyDictionaries,
+                          std::vector< DictionaryRawPointer > & dictionaries);
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ReadSlicesThreaderCallback(void *arg);
+
+  /** Internal structure used for passing work to the read threads. */
+  struct ReadThreadStruct
+  {
+    Self *Reader;
+    const std::vector< int > *Slices;
+    std::vector< DictionaryRawPointer > *Dictionaries;
+    bool CopyDictionaries;
+    SimpleFastMutexLock Lock;
+    size_t NextSlice;
+    size_t CompletedSlices;
+    bool Stop;
+    std::vector< std::string > Errors;
+  };
+
   /** Modified time of the MetaDataDictionaryArray */
   TimeStamp m_MetaDataDictionaryArrayMTime;
 
   /** Indicated if the MMDA should be updated */
   bool m_MetaDataDictionaryArrayUpdate;
+
+  ThreadIdType m_NumberOfReadThreads;
 };
 } //namespace ITK
 
@@ -54,6 +54,7 @@ void ImageSeriesReader< TOutputImage >
 
   os << indent << "ReverseOrder: " << m_ReverseOrder << std::endl;
   os << indent << "UseStreaming: " << m_UseStreaming << std::endl;
+  os << indent << "NumberOfReadThreads: " << m_NumberOfReadThreads << std::endl;
 
   if ( m_ImageIO )
     {
@@ -283,33 +284,11 @@ void ImageSeriesReader< TOutputImage >
   TOutputImage *output = this->GetOutput();
 
   ImageRegionType requestedRegion = output->GetRequestedRegion();
-  ImageRegionType largestRegion = output->GetLargestPossibleRegion();
-  ImageRegionType sliceRegionToRequest = output->GetRequestedRegion();
-
-  // Each file must have the same size.
-  SizeType validSize = largestRegion.GetSize();
-
-  // If more than one file is being read, then the input dimension
-  // will be less than the output dimension.  In this case, set
-  // the last dimension that is other than 1 of validSize to 1.  However, if the
-  // input and output have the same number of dimensions, this should
-  // not be done because it will lower the dimension of the output image.
-  if ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage )
-    {
-    validSize[this->m_NumberOfDimensionsInImage] = 1;
-    sliceRegionToRequest.SetSize(this->m_NumberOfDimensionsInImage, 1);
-    sliceRegionToRequest.SetIndex(this->m_NumberOfDimensionsInImage, 0);
-    }
 
   // Allocate the output buffer
   output->SetBufferedRegion(requestedRegion);
   output->Allocate();
 
-  // progress reported on a per slice basis
-  ProgressReporter progress(this, 0,
-                            requestedRegion.GetSize(TOutputImage::ImageDimension-1),
-                            100);
-
   // We utilize the modified time of the output information to
   // know when the meta array needs to be updated, when the output
   // information is updated so should the meta array.
@@ -319,147 +298,325 @@ void ImageSeriesReader< TOutputImage >
     this->m_OutputInformationMTime > this->m_MetaDataDictionaryArrayMTime
     && m_MetaDataDictionaryArrayUpdate;
 
-  typename  TOutputImage::InternalPixelType *outputBuffer = output->GetBufferPointer();
-  IndexType                           sliceStartIndex = requestedRegion.GetIndex();
-  const int                           numberOfFiles = static_cast< int >( m_FileNames.size() );
+  IndexType sliceStartIndex = requestedRegion.GetIndex();
+  const int numberOfFiles = static_cast< int >( m_FileNames.size() );
 
+  // collect the slices we need to read, either for their pixels or
+  // for their meta data
+  std::vector< int > slices;
   for ( int i = 0; i != numberOfFiles; ++i )
     {
     if ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage )
       {
       sliceStartIndex[this->m_NumberOfDimensionsInImage] = i;
       }
-
-    const bool insideRequestedRegion = requestedRegion.IsInside(sliceStartIndex);
-    const int  iFileName = ( m_ReverseOrder ? numberOfFiles - i - 1 : i );
-
-    // check if we need this slice
-    if ( !insideRequestedRegion && !needToUpdateMetaDataDictionaryArray )
+    if ( requestedRegion.IsInside(sliceStartIndex) || needToUpdateMetaDataDictionaryArray )
       {
-      continue;
+      slices.push_back(i);
       }
+    }
 
-    // configure reader
-    typename ReaderType::Pointer reader = ReaderType::New();
-    reader->SetFileName( m_FileNames[iFileName].c_str() );
+  // each thread needs an ImageIO of its own, and CreateAnother() would
+  // lose the settings of the one given by the user, so the slices are
+  // only read concurrently with the ImageIOs created by the factory
+  if ( m_NumberOfReadThreads > 1 && slices.size() > 1 && !m_ImageIO )
+    {
+    std::vector< DictionaryRawPointer > dictionaries( numberOfFiles, static_cast< DictionaryRawPointer >( 0 ) );
+    this->ThreadedReadSlices(slices, needToUpdateMetaDataDictionaryArray, dictionaries);
 
-    TOutputImage * readerOutput = reader->GetOutput();
+    // the dictionaries are kept in the order of the file names,
+    // independently of the order the threads completed them
+    for ( int i = 0; i != numberOfFiles; ++i )
+      {
+      if ( dictionaries[i] )
+        {
+        m_MetaDataDictionaryArray.push_back(dictionaries[i]);
+        }
+      }
+    }
+  else
+    {
+    // progress reported on a per slice basis
+    ProgressReporter progress(this, 0, slices.size(), 100);
 
-    if ( m_ImageIO )
+    for ( size_t s = 0; s < slices.size(); ++s )
       {
-      reader->SetImageIO(m_ImageIO);
+      DictionaryRawPointer newDictionary =
+        this->ReadSlice(slices[s], m_ImageIO, needToUpdateMetaDataDictionaryArray);
+      if ( newDictionary )
+        {
+        m_MetaDataDictionaryArray.push_back(newDictionary);
+        }
+      progress.CompletedPixel();
       }
-    reader->SetUseStreaming(m_UseStreaming);
-    readerOutput->SetRequestedRegion(sliceRegionToRequest);
+    }
+
+  // update the time if we modified the meta array
+  if ( needToUpdateMetaDataDictionaryArray )
+    {
+    m_MetaDataDictionaryArrayMTime.Modified();
+    }
+}
+
+template< class TOutputImage >
+typename ImageSeriesReader< TOutputImage >::DictionaryRawPointer
+ImageSeriesReader< TOutputImage >
+::ReadSlice(int i, ImageIOBase *imageIO, bool copyDictionary)
+{
+  TOutputImage *output = this->GetOutput();
+
+  const ImageRegionType & requestedRegion = output->GetRequestedRegion();
+  const ImageRegionType & largestRegion = output->GetLargestPossibleRegion();
+  ImageRegionType         sliceRegionToRequest = requestedRegion;
+
+  // Each file must have the same size.
+  SizeType validSize = largestRegion.GetSize();
+
+  // If more than one file is being read, then the input dimension
+  // will be less than the output dimension.  In this case, set
+  // the last dimension that is other than 1 of validSize to 1.  However, if the
+  // input and output have the same number of dimensions, this should
+  // not be done because it will lower the dimension of the output image.
+  if ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage )
+    {
+    validSize[this->m_NumberOfDimensionsInImage] = 1;
+    sliceRegionToRequest.SetSize(this->m_NumberOfDimensionsInImage, 1);
+    sliceRegionToRequest.SetIndex(this->m_NumberOfDimensionsInImage, 0);
+    }
+
+  typename  TOutputImage::InternalPixelType *outputBuffer = output->GetBufferPointer();
+  IndexType                           sliceStartIndex = requestedRegion.GetIndex();
+  const int                           numberOfFiles = static_cast< int >( m_FileNames.size() );
+
+  if ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage )
+    {
+    sliceStartIndex[this->m_NumberOfDimensionsInImage] = i;
+    }
+
+  const bool insideRequestedRegion = requestedRegion.IsInside(sliceStartIndex);
+  const int  iFileName = ( m_ReverseOrder ? numberOfFiles - i - 1 : i );
 
-    // update the data or info
-    if ( !insideRequestedRegion )
+  // configure reader
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( m_FileNames[iFileName].c_str() );
+
+  TOutputImage * readerOutput = reader->GetOutput();
+
+  if ( imageIO )
+    {
+    reader->SetImageIO(imageIO);
+    }
+  reader->SetUseStreaming(m_UseStreaming);
+  readerOutput->SetRequestedRegion(sliceRegionToRequest);
+
+  // update the data or info
+  if ( !insideRequestedRegion )
+    {
+    reader->UpdateOutputInformation();
+    }
+  else
+    {
+    // read the meta data information
+    readerOutput->UpdateOutputInformation();
+
+    // propagate the requested region to determin what the region
+    // will actually be read
+    readerOutput->PropagateRequestedRegion();
+
+    // check that the size of each slice is the same
+    if ( readerOutput->GetLargestPossibleRegion().GetSize() != validSize )
       {
-      reader->UpdateOutputInformation();
+      itkExceptionMacro( << "Size mismatch! The size of  "
+                         << m_FileNames[iFileName].c_str()
+                         << " is "
+                         << readerOutput->GetLargestPossibleRegion().GetSize()
+                         << " and does not match the required size "
+                         << validSize
+                         << " from file "
+                         << m_FileNames[m_ReverseOrder ? m_FileNames.size() - 1 : 0].c_str() );
       }
-    else
+
+    // get the size of the region to be read
+    SizeType readSize = readerOutput->GetRequestedRegion().GetSize();
+
+    if( readSize == sliceRegionToRequest.GetSize() )
       {
-      // read the meta data information
-      readerOutput->UpdateOutputInformation();
+      // if the buffer of the ImageReader is going to match that of
+      // ourselves, then set the ImageReader's buffer to a section
+      // of ours
+
+      const size_t  numberOfPixelsInSlice = sliceRegionToRequest.GetNumberOfPixels();
+
+      typedef typename TOutputImage::AccessorFunctorType AccessorFunctorType;
+      const size_t      numberOfInternalComponentsPerPixel =  AccessorFunctorType::GetVectorLength( output );
+
+
+      const ptrdiff_t   sliceOffset = ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage ) ?
+        ( i - requestedRegion.GetIndex(this->m_NumberOfDimensionsInImage)) : 0;
 
-      // propagate the requested region to determin what the region
-      // will actually be read
-      readerOutput->PropagateRequestedRegion();
+      const ptrdiff_t  numberOfPixelComponentsUpToSlice =  numberOfPixelsInSlice * numberOfInternalComponentsPerPixel * sliceOffset;
+      const bool       bufferDelete = false;
 
-      // check that the size of each slice is the same
-      if ( readerOutput->GetLargestPossibleRegion().GetSize() != validSize )
+      typename  TOutputImage::InternalPixelType * outputSliceBuffer = outputBuffer + numberOfPixelComponentsUpToSlice;
+
+      if ( strcmp(output->GetNameOfClass(), "VectorImage") == 0 )
         {
-        itkExceptionMacro( << "Size mismatch! The size of  "
-                           << m_FileNames[iFileName].c_str()
-                           << " is "
-                           << readerOutput->GetLargestPossibleRegion().GetSize()
-                           << " and does not match the required size "
-                           << validSize
-                           << " from file "
-                           << m_FileNames[m_ReverseOrder ? m_FileNames.size() - 1 : 0].c_str() );
+        // if the input image type is a vector image then the number
+        // of components needs to be set for the size
+        readerOutput->GetPixelContainer()->SetImportPointer( outputSliceBuffer,
+                                                             numberOfPixelsInSlice*numberOfInternalComponentsPerPixel,
+                                                             bufferDelete );
         }
+      else
+        {
+        // otherwise the actual number of pixels needs to be passed
+        readerOutput->GetPixelContainer()->SetImportPointer( outputSliceBuffer,
+                                                             numberOfPixelsInSlice,
+                                                             bufferDelete );
+        }
+      readerOutput->UpdateOutputData();
+      }
+    else
+      {
+      // the read region isn't going to match exactly what we need
+      // to update to buffer created by the reader, then copy
+
+      reader->Update();
 
-      // get the size of the region to be read
-      SizeType readSize = readerOutput->GetRequestedRegion().GetSize();
+      // output of buffer copy
+      ImageRegionType outRegion = requestedRegion;
+      outRegion.SetIndex( sliceStartIndex );
 
-      if( readSize == sliceRegionToRequest.GetSize() )
+      // set the moving dimension to a size of 1
+      if ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage )
         {
-        // if the buffer of the ImageReader is going to match that of
-        // ourselves, then set the ImageReader's buffer to a section
-        // of ours
+        outRegion.SetSize(this->m_NumberOfDimensionsInImage, 1);
+        }
 
-        const size_t  numberOfPixelsInSlice = sliceRegionToRequest.GetNumberOfPixels();
+      ImageAlgorithm::Copy( readerOutput, output, sliceRegionToRequest, outRegion );
 
-        typedef typename TOutputImage::AccessorFunctorType AccessorFunctorType;
-        const size_t      numberOfInternalComponentsPerPixel =  AccessorFunctorType::GetVectorLength( output );
+      }
+    } // end !insidedRequestedRegion
 
+  // Deep copy the MetaDataDictionary
+  if ( reader->GetImageIO() && copyDictionary )
+    {
+    DictionaryRawPointer newDictionary = new DictionaryType;
+    *newDictionary = reader->GetImageIO()->GetMetaDataDictionary();
+    return newDictionary;
+    }
+  return 0;
+}
 
-        const ptrdiff_t   sliceOffset = ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage ) ?
-          ( i - requestedRegion.GetIndex(this->m_NumberOfDimensionsInImage)) : 0;
+template< class TOutputImage >
+void ImageSeriesReader< TOutputImage >
+::ThreadedReadSlices(const std::vector< int > & slices,
+                     bool copyDictionaries,
+                     std::vector< DictionaryRawPointer > & dictionaries)
+{
+  ThreadIdType numberOfThreads = m_NumberOfReadThreads;
+  if ( numberOfThreads > slices.size() )
+    {
+    numberOfThreads = static_cast< ThreadIdType >( slices.size() );
+    }
 
-        const ptrdiff_t  numberOfPixelComponentsUpToSlice =  numberOfPixelsInSlice * numberOfInternalComponentsPerPixel * sliceOffset;
-        const bool       bufferDelete = false;
+  ReadThreadStruct str;
+  str.Reader = this;
+  str.Slices = &slices;
+  str.Dictionaries = &dictionaries;
+  str.CopyDictionaries = copyDictionaries;
+  str.NextSlice = 0;
+  str.CompletedSlices = 0;
+  str.Stop = false;
 
-        typename  TOutputImage::InternalPixelType * outputSliceBuffer = outputBuffer + numberOfPixelComponentsUpToSlice;
+  this->UpdateProgress(0.0f);
 
-        if ( strcmp(output->GetNameOfClass(), "VectorImage") == 0 )
-          {
-          // if the input image type is a vector image then the number
-          // of components needs to be set for the size
-          readerOutput->GetPixelContainer()->SetImportPointer( outputSliceBuffer,
-                                                               numberOfPixelsInSlice*numberOfInternalComponentsPerPixel,
-                                                               bufferDelete );
-          }
-        else
-          {
-          // otherwise the actual number of pixels needs to be passed
-          readerOutput->GetPixelContainer()->SetImportPointer( outputSliceBuffer,
-                                                               numberOfPixelsInSlice,
-                                                               bufferDelete );
-          }
-        readerOutput->UpdateOutputData();
-        }
-      else
-        {
-        // the read region isn't going to match exactly what we need
-        // to update to buffer created by the reader, then copy
+  MultiThreader *threader = this->GetMultiThreader();
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(Self::ReadSlicesThreaderCallback, &str);
+  threader->SingleMethodExecute();
 
-        reader->Update();
+  if ( !str.Errors.empty() || this->GetAbortGenerateData() )
+    {
+    for ( size_t i = 0; i < dictionaries.size(); ++i )
+      {
+      delete dictionaries[i];
+      dictionaries[i] = 0;
+      }
+    }
 
-        // output of buffer copy
-        ImageRegionType outRegion = requestedRegion;
-        outRegion.SetIndex( sliceStartIndex );
+  if ( !str.Errors.empty() )
+    {
+    itkExceptionMacro(<< "Reading the series failed: " << str.Errors[0]);
+    }
 
-        // set the moving dimension to a size of 1
-        if ( TOutputImage::ImageDimension != this->m_NumberOfDimensionsInImage )
-          {
-          outRegion.SetSize(this->m_NumberOfDimensionsInImage, 1);
-          }
+  if ( this->GetAbortGenerateData() )
+    {
+    std::string    msg;
+    ProcessAborted e(__FILE__, __LINE__);
+    msg += "Object " + std::string( this->GetNameOfClass() ) + ": AbortGenerateDataOn";
+    e.SetDescription(msg);
+    throw e;
+    }
 
-        ImageAlgorithm::Copy( readerOutput, output, sliceRegionToRequest, outRegion );
+  this->UpdateProgress(1.0f);
+}
 
-        }
+template< class TOutputImage >
+ITK_THREAD_RETURN_TYPE
+ImageSeriesReader< TOutputImage >
+::ReadSlicesThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  const ThreadIdType threadId = info->ThreadID;
+  ReadThreadStruct * str = static_cast< ReadThreadStruct * >( info->UserData );
 
-      // report progress for read slices
-      progress.CompletedPixel();
+  const size_t numberOfSlices = str->Slices->size();
 
-     } // end !insidedRequestedRegion
+  // the slices are handed out one at a time, since the time to read
+  // a file can vary a lot within a series
+  while ( true )
+    {
+    str->Lock.Lock();
+    if ( str->Stop || str->NextSlice >= numberOfSlices )
+      {
+      str->Lock.Unlock();
+      break;
+      }
+    const int i = ( *str->Slices )[str->NextSlice++];
+    str->Lock.Unlock();
 
-    // Deep copy the MetaDataDictionary into the array
-    if ( reader->GetImageIO() &&  needToUpdateMetaDataDictionaryArray )
+    try
+      {
+      ( *str->Dictionaries )[i] =
+        str->Reader->ReadSlice(i, 0, str->CopyDictionaries);
+      }
+    catch ( ExceptionObject & e )
       {
-      DictionaryRawPointer newDictionary = new DictionaryType;
-      *newDictionary = reader->GetImageIO()->GetMetaDataDictionary();
-      m_MetaDataDictionaryArray.push_back(newDictionary);
+      str->Lock.Lock();
+      str->Errors.push_back( e.GetDescription() );
+      str->Stop = true;
+      str->Lock.Unlock();
+      break;
       }
 
-    } // end per slice loop
+    str->Lock.Lock();
+    const size_t completed = ++str->CompletedSlices;
+    if ( str->Reader->GetAbortGenerateData() )
+      {
+      str->Stop = true;
+      }
+    str->Lock.Unlock();
 
-  // update the time if we modified the meta array
-  if ( needToUpdateMetaDataDictionaryArray )
-    {
-    m_MetaDataDictionaryArrayMTime.Modified();
+    // only thread 0 should update the progress of the filter
+    if ( threadId == 0 )
+      {
+      str->Reader->UpdateProgress( static_cast< float >( completed ) / numberOfSlices );
+      }
     }
+
+  return ITK_THREAD_RETURN_VALUE;
 }
 
 template< class TOutputImage >
@@ -0,0 +1,82 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMemoryMappedFileRegion_h
+#define __itkMemoryMappedFileRegion_h
+
+#include "itkMacro.h"
+#include "itkIntTypes.h"
+#include <string>
+
+namespace itk
+{
+/** \class MemoryMappedFileRegion
+ * \brief A read-only view of a range of bytes of a file, mapped into
+ * memory.
+ *
+ * The range is mapped copy-on-write: the pages are read from the file
+ * when they are first accessed, and writing to them modifies a
+ * private copy only. The file must not be truncated while it is
+ * mapped.
+ *
+ * \ingroup IOFilters
+ * \ingroup ITKIOImageBase
+ */
+class ITK_EXPORT MemoryMappedFileRegion
+{
+public:
+  MemoryMappedFileRegion();
+  ~MemoryMappedFileRegion();
+
+  /** Map numberOfBytes bytes of the file starting at byte offset.
+   * Returns false, leaving nothing mapped, when the file can not be
+   * opened or is too short, or the system does not support mapping
+   * it. */
+  bool Map(const std::string & fileName, SizeValueType offset, SizeValueType numberOfBytes);
+
+  /** Release the mapping. */
+  void Unmap();
+
+  /** Exchange the mappings of two objects. */
+  void Swap(MemoryMappedFileRegion & other);
+
+  /** Pointer to the first mapped byte, or NULL when nothing is mapped. */
+  void * GetPointer() const
+  {
+    return m_Pointer;
+  }
+
+  SizeValueType GetNumberOfBytes() const
+  {
+    return m_NumberOfBytes;
+  }
+
+private:
+  MemoryMappedFileRegion(const MemoryMappedFileRegion &); //purposely not implemented
+  void operator=(const MemoryMappedFileRegion &);         //purposely not implemented
+
+  /** Start and length of the mapping, which begins at a page boundary
+   * at or before the requested offset. */
+  void *        m_MappedAddress;
+  SizeValueType m_MappedLength;
+
+  void *        m_Pointer;
+  SizeValueType m_NumberOfBytes;
+};
+} // end namespace itk
+
+#endif // __itkMemoryMappedFileRegion_h
@@ -0,0 +1,99 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMemoryMappedImportImageContainer_h
+#define __itkMemoryMappedImportImageContainer_h
+
+#include "itkImportImageContainer.h"
+#include "itkMemoryMappedFileRegion.h"
+
+namespace itk
+{
+/** \class MemoryMappedImportImageContainer
+ * \brief An ImportImageContainer whose elements are mapped from a file.
+ *
+ * MapFile() points the container at a range of a file mapped into
+ * memory, so that the pixels are read from disk only when they are
+ * first accessed. The mapping is copy-on-write: filters may modify
+ * the buffer without changing the file. Reserving more elements than
+ * are mapped moves the data to an ordinary allocated buffer, as
+ * for any ImportImageContainer.
+ *
+ * ImageFileReader uses this container when UseMemoryMapping is on.
+ *
+ * \sa ImageFileReader::SetUseMemoryMapping
+ * \ingroup ImageObjects
+ * \ingroup ITKIOImageBase
+ */
+template< typename TElementIdentifier, typename TElement >
+class ITK_EXPORT MemoryMappedImportImageContainer:
+  public ImportImageContainer< TElementIdentifier, TElement >
+{
+public:
+  /** Standard class typedefs. */
+  typedef MemoryMappedImportImageContainer                     Self;
+  typedef ImportImageContainer< TElementIdentifier, TElement > Superclass;
+  typedef SmartPointer< Self >                                 Pointer;
+  typedef SmartPointer< const Self >                           ConstPointer;
+
+  /** Save the template parameters. */
+  typedef typename Superclass::ElementIdentifier ElementIdentifier;
+  typedef typename Superclass::Element           Element;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Standard part of every itk Object. */
+  itkTypeMacro(MemoryMappedImportImageContainer, ImportImageContainer);
+
+  /** Map numberOfElements elements of fileName, the first of which is
+   * at byte offset, and make them the content of the container. The
+   * offset must be a multiple of the size of an element component.
+   * Returns false, leaving the container unchanged, when the range can
+   * not be mapped. */
+  bool MapFile(const std::string & fileName, SizeValueType offset,
+               ElementIdentifier numberOfElements);
+
+  /** Whether the elements currently come from a mapped file. */
+  bool IsMapped() const
+  {
+    return m_MappedFile.GetPointer() != 0;
+  }
+
+protected:
+  MemoryMappedImportImageContainer() {}
+  virtual ~MemoryMappedImportImageContainer();
+
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+  /** Release the mapping along with any memory managed by the
+   * superclass. */
+  virtual void DeallocateManagedMemory();
+
+private:
+  MemoryMappedImportImageContainer(const Self &); //purposely not implemented
+  void operator=(const Self &);                   //purposely not implemented
+
+  MemoryMappedFileRegion m_MappedFile;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkMemoryMappedImportImageContainer.hxx"
+#endif
+
+#endif
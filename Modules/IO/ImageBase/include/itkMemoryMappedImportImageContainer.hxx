@@ -0,0 +1,72 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMemoryMappedImportImageContainer_hxx
+#define __itkMemoryMappedImportImageContainer_hxx
+
+#include "itkMemoryMappedImportImageContainer.h"
+
+namespace itk
+{
+template< typename TElementIdentifier, typename TElement >
+MemoryMappedImportImageContainer< TElementIdentifier, TElement >
+::~MemoryMappedImportImageContainer()
+{
+  // the superclass destructor can not call our override
+  this->DeallocateManagedMemory();
+}
+
+template< typename TElementIdentifier, typename TElement >
+bool
+MemoryMappedImportImageContainer< TElementIdentifier, TElement >
+::MapFile(const std::string & fileName, SizeValueType offset,
+          ElementIdentifier numberOfElements)
+{
+  MemoryMappedFileRegion mappedFile;
+  if ( !mappedFile.Map( fileName, offset, static_cast< SizeValueType >( numberOfElements ) * sizeof( TElement ) ) )
+    {
+    return false;
+    }
+
+  // SetImportPointer releases the current content, including a
+  // previous mapping, before the new one is taken over
+  this->SetImportPointer(static_cast< TElement * >( mappedFile.GetPointer() ), numberOfElements, false);
+  m_MappedFile.Swap(mappedFile);
+  return true;
+}
+
+template< typename TElementIdentifier, typename TElement >
+void
+MemoryMappedImportImageContainer< TElementIdentifier, TElement >
+::DeallocateManagedMemory()
+{
+  Superclass::DeallocateManagedMemory();
+  m_MappedFile.Unmap();
+}
+
+template< typename TElementIdentifier, typename TElement >
+void
+MemoryMappedImportImageContainer< TElementIdentifier, TElement >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Mapped bytes: " << m_MappedFile.GetNumberOfBytes() << std::endl;
+}
+} // end namespace itk
+
+#endif
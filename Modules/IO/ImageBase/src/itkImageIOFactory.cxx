@@ -21,10 +21,39 @@
 
 namespace itk
 {
+namespace
+{
+// Whether the file name ends with one of the extensions the ImageIO
+// declares for the given mode
+bool HasSupportedExtension(const ImageIOBase *io, const std::string & fileName,
+                           ImageIOFactory::FileModeType mode)
+{
+  const ImageIOBase::ArrayOfExtensionsType & extensions =
+    mode == ImageIOFactory::ReadMode ? io->GetSupportedReadExtensions() : io->GetSupportedWriteExtensions();
+  for ( ImageIOBase::ArrayOfExtensionsType::const_iterator e = extensions.begin();
+        e != extensions.end(); ++e )
+    {
+    if ( fileName.size() > e->size()
+         && fileName.compare(fileName.size() - e->size(), e->size(), *e) == 0 )
+      {
+      return true;
+      }
+    }
+  return false;
+}
+}
+
 ImageIOBase::Pointer
 ImageIOFactory::CreateImageIO(const char *path, FileModeType mode)
 {
+  // The ImageIOs that declare the extension of the file are asked
+  // first, in the order they were registered, so that the files
+  // opened by the others to check their headers are only opened when
+  // the extension is unknown or misleading.
+  const std::string fileName = path ? path : "";
+
   std::list< ImageIOBase::Pointer > possibleImageIO;
+  std::list< ImageIOBase::Pointer > otherImageIO;
   std::list< LightObject::Pointer > allobjects =
     ObjectFactoryBase::CreateAllInstance("itkImageIOBase");
   for ( std::list< LightObject::Pointer >::iterator i = allobjects.begin();
@@ -33,7 +62,14 @@ ImageIOFactory::CreateImageIO(const char *path, FileModeType mode)
     ImageIOBase *io = dynamic_cast< ImageIOBase * >( i->GetPointer() );
     if ( io )
       {
-      possibleImageIO.push_back(io);
+      if ( HasSupportedExtension(io, fileName, mode) )
+        {
+        possibleImageIO.push_back(io);
+        }
+      else
+        {
+        otherImageIO.push_back(io);
+        }
       }
     else
       {
@@ -42,6 +78,8 @@ ImageIOFactory::CreateImageIO(const char *path, FileModeType mode)
                 << std::endl;
       }
     }
+  possibleImageIO.splice(possibleImageIO.end(), otherImageIO);
+
   for ( std::list< ImageIOBase::Pointer >::iterator k = possibleImageIO.begin();
         k != possibleImageIO.end(); ++k )
     {
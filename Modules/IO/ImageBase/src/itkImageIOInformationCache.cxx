@@ -0,0 +1,239 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageIOInformationCache.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itksys/SystemTools.hxx"
+
+#include <list>
+#include <map>
+
+namespace itk
+{
+namespace
+{
+typedef std::list< std::string > UseListType;
+
+struct InformationCacheEntry
+{
+  // An ImageIO of the type that read the file, holding the image
+  // information only. It is never modified once in the cache, so
+  // that it can be copied from without holding the lock.
+  ImageIOBase::Pointer  m_ImageIO;
+  long                  m_ModifiedTime;
+  unsigned long         m_FileLength;
+  UseListType::iterator m_Use;
+};
+
+typedef std::map< std::string, InformationCacheEntry > EntryMapType;
+
+SimpleFastMutexLock informationCacheLock;
+bool                informationCacheEnabled = false;
+SizeValueType       informationCacheMaximumNumberOfEntries = 1024;
+EntryMapType        informationCacheEntries;
+// The file names from the most to the least recently used
+UseListType informationCacheUses;
+
+ImageIOBase::Pointer CreateImageIOOfSameType(const ImageIOBase *imageIO)
+{
+  LightObject::Pointer another = imageIO->CreateAnother();
+  return dynamic_cast< ImageIOBase * >( another.GetPointer() );
+}
+
+void CopyImageInformation(const ImageIOBase *source, ImageIOBase *destination)
+{
+  const unsigned int numberOfDimensions = source->GetNumberOfDimensions();
+
+  destination->SetNumberOfDimensions(numberOfDimensions);
+  for ( unsigned int i = 0; i < numberOfDimensions; i++ )
+    {
+    destination->SetDimensions( i, source->GetDimensions(i) );
+    destination->SetSpacing( i, source->GetSpacing(i) );
+    destination->SetOrigin( i, source->GetOrigin(i) );
+    std::vector< double > axis = source->GetDirection(i);
+    destination->SetDirection(i, axis);
+    }
+  destination->SetPixelType( source->GetPixelType() );
+  destination->SetComponentType( source->GetComponentType() );
+  destination->SetNumberOfComponents( source->GetNumberOfComponents() );
+  destination->SetByteOrder( source->GetByteOrder() );
+  destination->SetFileType( source->GetFileType() );
+  destination->SetMetaDataDictionary( source->GetMetaDataDictionary() );
+}
+
+// Must be called with the lock held
+void RemoveInformationCacheEntry(EntryMapType::iterator entry)
+{
+  informationCacheUses.erase(entry->second.m_Use);
+  informationCacheEntries.erase(entry);
+}
+
+// Must be called with the lock held
+void TrimInformationCache()
+{
+  while ( informationCacheEntries.size() > informationCacheMaximumNumberOfEntries )
+    {
+    RemoveInformationCacheEntry( informationCacheEntries.find( informationCacheUses.back() ) );
+    }
+}
+}
+
+ImageIOInformationCache::ImageIOInformationCache()
+{}
+
+ImageIOInformationCache::~ImageIOInformationCache()
+{}
+
+void
+ImageIOInformationCache::SetEnabled(bool enabled)
+{
+  informationCacheLock.Lock();
+  informationCacheEnabled = enabled;
+  if ( !enabled )
+    {
+    informationCacheEntries.clear();
+    informationCacheUses.clear();
+    }
+  informationCacheLock.Unlock();
+}
+
+bool
+ImageIOInformationCache::GetEnabled()
+{
+  informationCacheLock.Lock();
+  const bool enabled = informationCacheEnabled;
+  informationCacheLock.Unlock();
+  return enabled;
+}
+
+void
+ImageIOInformationCache::SetMaximumNumberOfEntries(SizeValueType number)
+{
+  informationCacheLock.Lock();
+  informationCacheMaximumNumberOfEntries = number;
+  TrimInformationCache();
+  informationCacheLock.Unlock();
+}
+
+SizeValueType
+ImageIOInformationCache::GetMaximumNumberOfEntries()
+{
+  informationCacheLock.Lock();
+  const SizeValueType number = informationCacheMaximumNumberOfEntries;
+  informationCacheLock.Unlock();
+  return number;
+}
+
+SizeValueType
+ImageIOInformationCache::GetNumberOfEntries()
+{
+  informationCacheLock.Lock();
+  const SizeValueType number = informationCacheEntries.size();
+  informationCacheLock.Unlock();
+  return number;
+}
+
+ImageIOBase::Pointer
+ImageIOInformationCache::Find(const std::string & fileName)
+{
+  informationCacheLock.Lock();
+  if ( !informationCacheEnabled )
+    {
+    informationCacheLock.Unlock();
+    return 0;
+    }
+
+  EntryMapType::iterator entry = informationCacheEntries.find(fileName);
+  if ( entry == informationCacheEntries.end() )
+    {
+    informationCacheLock.Unlock();
+    return 0;
+    }
+
+  if ( !itksys::SystemTools::FileExists( fileName.c_str() )
+       || itksys::SystemTools::ModifiedTime( fileName.c_str() ) != entry->second.m_ModifiedTime
+       || itksys::SystemTools::FileLength( fileName.c_str() ) != entry->second.m_FileLength )
+    {
+    RemoveInformationCacheEntry(entry);
+    informationCacheLock.Unlock();
+    return 0;
+    }
+
+  informationCacheUses.splice(informationCacheUses.begin(), informationCacheUses, entry->second.m_Use);
+  ImageIOBase::Pointer cached = entry->second.m_ImageIO;
+  informationCacheLock.Unlock();
+
+  ImageIOBase::Pointer imageIO = CreateImageIOOfSameType(cached);
+  if ( imageIO.IsNotNull() )
+    {
+    CopyImageInformation(cached, imageIO);
+    }
+  return imageIO;
+}
+
+void
+ImageIOInformationCache::Insert(const std::string & fileName, const ImageIOBase *imageIO)
+{
+  if ( !GetEnabled() || !imageIO )
+    {
+    return;
+    }
+
+  InformationCacheEntry newEntry;
+  newEntry.m_ImageIO = CreateImageIOOfSameType(imageIO);
+  if ( newEntry.m_ImageIO.IsNull() )
+    {
+    return;
+    }
+  CopyImageInformation(imageIO, newEntry.m_ImageIO);
+  newEntry.m_ModifiedTime = itksys::SystemTools::ModifiedTime( fileName.c_str() );
+  newEntry.m_FileLength = itksys::SystemTools::FileLength( fileName.c_str() );
+
+  informationCacheLock.Lock();
+  EntryMapType::iterator entry = informationCacheEntries.find(fileName);
+  if ( entry != informationCacheEntries.end() )
+    {
+    RemoveInformationCacheEntry(entry);
+    }
+  informationCacheUses.push_front(fileName);
+  newEntry.m_Use = informationCacheUses.begin();
+  informationCacheEntries[fileName] = newEntry;
+  TrimInformationCache();
+  informationCacheLock.Unlock();
+}
+
+void
+ImageIOInformationCache::Remove(const std::string & fileName)
+{
+  informationCacheLock.Lock();
+  EntryMapType::iterator entry = informationCacheEntries.find(fileName);
+  if ( entry != informationCacheEntries.end() )
+    {
+    RemoveInformationCacheEntry(entry);
+    }
+  informationCacheLock.Unlock();
+}
+
+void
+ImageIOInformationCache::Clear()
+{
+  informationCacheLock.Lock();
+  informationCacheEntries.clear();
+  informationCacheUses.clear();
+  informationCacheLock.Unlock();
+}
+} // end namespace itk
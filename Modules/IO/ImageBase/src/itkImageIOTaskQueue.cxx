@@ -0,0 +1,79 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageIOTaskQueue.h"
+#include "itkSimpleFastMutexLock.h"
+
+namespace itk
+{
+namespace
+{
+// Tasks still to be run
+struct ImageIOTaskQueueThreadStruct {
+  ImageIOTaskQueue::TaskFunctionType Task;
+  void *                             TaskData;
+  unsigned int                       NumberOfTasks;
+  unsigned int                       NextTask;
+  SimpleFastMutexLock                Lock;
+};
+}
+
+ImageIOTaskQueue::ImageIOTaskQueue()
+{}
+
+ImageIOTaskQueue::~ImageIOTaskQueue()
+{}
+
+void
+ImageIOTaskQueue::Execute(MultiThreader *threader, TaskFunctionType task,
+                          void *taskData, unsigned int numberOfTasks)
+{
+  ImageIOTaskQueueThreadStruct str;
+  str.Task = task;
+  str.TaskData = taskData;
+  str.NumberOfTasks = numberOfTasks;
+  str.NextTask = 0;
+
+  threader->SetSingleMethod(Self::ExecuteThreaderCallback, &str);
+  threader->SingleMethodExecute();
+}
+
+ITK_THREAD_RETURN_TYPE
+ImageIOTaskQueue::ExecuteThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ImageIOTaskQueueThreadStruct *str =
+    static_cast< ImageIOTaskQueueThreadStruct * >( info->UserData );
+
+  // the tasks are handed out one at a time since their cost may vary,
+  // e.g. with the compressibility of the data
+  for (;; )
+    {
+    str->Lock.Lock();
+    const unsigned int task = str->NextTask++;
+    str->Lock.Unlock();
+    if ( task >= str->NumberOfTasks )
+      {
+      break;
+      }
+    str->Task(str->TaskData, task);
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+} // end namespace itk
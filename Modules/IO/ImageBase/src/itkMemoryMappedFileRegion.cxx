@@ -0,0 +1,151 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkMemoryMappedFileRegion.h"
+#include "itkInternationalizationIOHelpers.h"
+#include <algorithm>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace itk
+{
+MemoryMappedFileRegion::MemoryMappedFileRegion():
+  m_MappedAddress(0),
+  m_MappedLength(0),
+  m_Pointer(0),
+  m_NumberOfBytes(0)
+{}
+
+MemoryMappedFileRegion::~MemoryMappedFileRegion()
+{
+  this->Unmap();
+}
+
+bool
+MemoryMappedFileRegion
+::Map(const std::string & fileName, SizeValueType offset, SizeValueType numberOfBytes)
+{
+  this->Unmap();
+
+  if ( numberOfBytes == 0 )
+    {
+    return false;
+    }
+
+  const int fd = i18n::I18nOpenForReading(fileName);
+  if ( fd < 0 )
+    {
+    return false;
+    }
+
+#if defined( _WIN32 )
+  HANDLE file = reinterpret_cast< HANDLE >( _get_osfhandle(fd) );
+  LARGE_INTEGER fileSize;
+  if ( file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)
+       || static_cast< SizeValueType >( fileSize.QuadPart ) < offset + numberOfBytes )
+    {
+    _close(fd);
+    return false;
+    }
+
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  const SizeValueType alignedOffset = offset - offset % systemInfo.dwAllocationGranularity;
+  const SizeValueType length = numberOfBytes + ( offset - alignedOffset );
+
+  // the mapping object keeps the file open until the view is unmapped
+  HANDLE mapping = CreateFileMapping(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  _close(fd);
+  if ( mapping == NULL )
+    {
+    return false;
+    }
+  void *address = MapViewOfFile( mapping, FILE_MAP_COPY,
+                                 static_cast< DWORD >( static_cast< unsigned long long >( alignedOffset ) >> 32 ),
+                                 static_cast< DWORD >( alignedOffset & 0xFFFFFFFFUL ),
+                                 static_cast< SIZE_T >( length ) );
+  CloseHandle(mapping);
+  if ( address == NULL )
+    {
+    return false;
+    }
+#else
+  struct stat fileStat;
+  if ( fstat(fd, &fileStat) != 0
+       || static_cast< SizeValueType >( fileStat.st_size ) < offset + numberOfBytes )
+    {
+    close(fd);
+    return false;
+    }
+
+  const SizeValueType pageSize = static_cast< SizeValueType >( sysconf(_SC_PAGESIZE) );
+  const SizeValueType alignedOffset = offset - offset % pageSize;
+  const SizeValueType length = numberOfBytes + ( offset - alignedOffset );
+
+  // the mapping keeps a reference to the file, so the descriptor can
+  // be closed right away
+  void *address = mmap( 0, static_cast< size_t >( length ), PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                        fd, static_cast< off_t >( alignedOffset ) );
+  close(fd);
+  if ( address == MAP_FAILED )
+    {
+    return false;
+    }
+#endif
+
+  m_MappedAddress = address;
+  m_MappedLength = length;
+  m_Pointer = static_cast< char * >( address ) + ( offset - alignedOffset );
+  m_NumberOfBytes = numberOfBytes;
+  return true;
+}
+
+void
+MemoryMappedFileRegion
+::Unmap()
+{
+  if ( m_MappedAddress )
+    {
+#if defined( _WIN32 )
+    UnmapViewOfFile(m_MappedAddress);
+#else
+    munmap( m_MappedAddress, static_cast< size_t >( m_MappedLength ) );
+#endif
+    }
+  m_MappedAddress = 0;
+  m_MappedLength = 0;
+  m_Pointer = 0;
+  m_NumberOfBytes = 0;
+}
+
+void
+MemoryMappedFileRegion
+::Swap(MemoryMappedFileRegion & other)
+{
+  std::swap(m_MappedAddress, other.m_MappedAddress);
+  std::swap(m_MappedLength, other.m_MappedLength);
+  std::swap(m_Pointer, other.m_Pointer);
+  std::swap(m_NumberOfBytes, other.m_NumberOfBytes);
+}
+} // end namespace itk
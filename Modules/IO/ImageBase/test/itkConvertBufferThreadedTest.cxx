@@ -0,0 +1,174 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTimeProbe.h"
+
+//
+//  Checks that converting buffers in chunks on several threads gives
+//  the same pixels as converting them on one thread, for scalar, color
+//  and vector image conversions, and when ImageFileReader converts a
+//  file to the pixel type of its output. The times are reported.
+//
+
+namespace
+{
+template< class TInput, class TOutput >
+bool TestThreadedConversion(const char *description, int inputNumberOfComponents,
+                            size_t size, itk::MultiThreader *threader, bool vectorImage)
+{
+  typedef itk::DefaultConvertPixelTraits< TOutput >                    TraitsType;
+  typedef itk::ConvertPixelBuffer< TInput, TOutput, TraitsType >         ConverterType;
+
+  const size_t outputLength = vectorImage ? size * inputNumberOfComponents : size;
+
+  std::vector< TInput > input( size * inputNumberOfComponents );
+  for ( size_t i = 0; i < input.size(); i++ )
+    {
+    input[i] = static_cast< TInput >( ( i * 7919 ) % 251 );
+    }
+  std::vector< TOutput > expected(outputLength);
+  std::vector< TOutput > output(outputLength);
+
+  itk::TimeProbe serialProbe;
+  itk::TimeProbe threadedProbe;
+  if ( vectorImage )
+    {
+    serialProbe.Start();
+    ConverterType::ConvertVectorImage(&input[0], inputNumberOfComponents, &expected[0], size);
+    serialProbe.Stop();
+    threadedProbe.Start();
+    ConverterType::ConvertVectorImage(&input[0], inputNumberOfComponents, &output[0], size, threader);
+    threadedProbe.Stop();
+    }
+  else
+    {
+    serialProbe.Start();
+    ConverterType::Convert(&input[0], inputNumberOfComponents, &expected[0], size);
+    serialProbe.Stop();
+    threadedProbe.Start();
+    ConverterType::Convert(&input[0], inputNumberOfComponents, &output[0], size, threader);
+    threadedProbe.Stop();
+    }
+
+  std::cout << "Converting " << size << " pixels " << description
+            << ": " << serialProbe.GetMean() << " s on one thread, "
+            << threadedProbe.GetMean() << " s on " << threader->GetNumberOfThreads()
+            << std::endl;
+
+  for ( size_t i = 0; i < outputLength; i++ )
+    {
+    if ( !( output[i] == expected[i] ) )
+      {
+      std::cerr << "Converting " << description << ", pixel " << i << " is "
+                << output[i] << " instead of " << expected[i] << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkConvertBufferThreadedTest(int argc, char *argv[])
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory [numberOfThreads]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string        directory = argv[1];
+  const itk::ThreadIdType  numberOfThreads = argc > 2 ? atoi(argv[2]) : 4;
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads(numberOfThreads);
+
+  // sizes that do not split evenly, and one too small to be split
+  const size_t size = 1000003;
+  int          status = EXIT_SUCCESS;
+
+  if ( !TestThreadedConversion< short, float >("from short to float", 1, size, threader, false)
+       || !TestThreadedConversion< short, float >("from short to float, small", 1, 1000, threader, false)
+       || !TestThreadedConversion< unsigned char, float >("from RGB to gray", 3, size, threader, false)
+       || !TestThreadedConversion< unsigned short, itk::RGBAPixel< unsigned char > >
+         ("from 5 components to RGBA", 5, size, threader, false)
+       || !TestThreadedConversion< int, double >("into a vector image", 3, size, threader, true) )
+    {
+    status = EXIT_FAILURE;
+    }
+
+  // the threads of the reader are used to convert the file's pixels
+  typedef itk::Image< short, 3 > ShortImageType;
+  typedef itk::Image< float, 3 > FloatImageType;
+
+  ShortImageType::RegionType region;
+  region.SetSize(0, 128);
+  region.SetSize(1, 96);
+  region.SetSize(2, 33);
+  ShortImageType::Pointer image = ShortImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< ShortImageType > it(image, region);
+  for (; !it.IsAtEnd(); ++it )
+    {
+    const ShortImageType::IndexType & idx = it.GetIndex();
+    it.Set( static_cast< short >( idx[0] - idx[1] * 3 + idx[2] * 700 ) );
+    }
+
+  const std::string fileName = directory + "/itkConvertBufferThreadedTest.mha";
+  try
+    {
+    typedef itk::ImageFileWriter< ShortImageType > WriterType;
+    WriterType::Pointer writer = WriterType::New();
+    writer->SetInput(image);
+    writer->SetFileName(fileName);
+    writer->Update();
+
+    typedef itk::ImageFileReader< FloatImageType > ReaderType;
+    ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileName(fileName);
+    reader->SetNumberOfThreads(numberOfThreads);
+    reader->Update();
+
+    itk::ImageRegionConstIterator< ShortImageType > eit(image, region);
+    itk::ImageRegionConstIterator< FloatImageType > rit(reader->GetOutput(), region);
+    for (; !eit.IsAtEnd(); ++eit, ++rit )
+      {
+      if ( rit.Get() != static_cast< float >( eit.Get() ) )
+        {
+        std::cerr << "Pixel " << rit.GetIndex() << " read as float is " << rit.Get()
+                  << " instead of " << eit.Get() << std::endl;
+        status = EXIT_FAILURE;
+        break;
+        }
+      }
+    }
+  catch ( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    status = EXIT_FAILURE;
+    }
+
+  if ( status == EXIT_SUCCESS )
+    {
+    std::cout << "Test PASSED !" << std::endl;
+    }
+  return status;
+}
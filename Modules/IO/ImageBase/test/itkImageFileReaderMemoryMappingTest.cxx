@@ -0,0 +1,203 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionIterator.h"
+#include "itkStreamingImageFilter.h"
+#include "itkMemoryMappedImportImageContainer.h"
+#include "itkVector.h"
+
+namespace
+{
+
+template< class TImage >
+typename TImage::Pointer MakeMappingTestImage()
+{
+  typename TImage::RegionType region;
+  typename TImage::SizeType   size;
+  size[0] = 21;
+  size[1] = 18;
+  size[2] = 15;
+  region.SetSize(size);
+
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(region);
+  image->Allocate();
+
+  typedef typename itk::NumericTraits< typename TImage::PixelType >::ValueType ValueType;
+  const unsigned int numberOfComponents =
+    itk::NumericTraits< typename TImage::PixelType >::GetLength( image->GetPixel( region.GetIndex() ) );
+
+  itk::ImageRegionIterator< TImage > it(image, region);
+  unsigned int value = 0;
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    typename TImage::PixelType pixel = it.Get();
+    for ( unsigned int c = 0; c < numberOfComponents; ++c )
+      {
+      itk::DefaultConvertPixelTraits< typename TImage::PixelType >
+        ::SetNthComponent( c, pixel, static_cast< ValueType >( ( value++ * 7 ) % 251 ) );
+      }
+    it.Set(pixel);
+    }
+  return image;
+}
+
+template< class TImage >
+bool SameImages(const TImage *a, const TImage *b, const typename TImage::RegionType & region)
+{
+  itk::ImageRegionConstIterator< TImage > aIt(a, region);
+  itk::ImageRegionConstIterator< TImage > bIt(b, region);
+  for ( ; !aIt.IsAtEnd(); ++aIt, ++bIt )
+    {
+    if ( aIt.Get() != bIt.Get() )
+      {
+      std::cerr << "Pixels differ at " << aIt.GetIndex() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< class TImage >
+bool IsMapped(const TImage *image)
+{
+  typedef typename TImage::PixelContainer PixelContainerType;
+  typedef itk::MemoryMappedImportImageContainer< typename PixelContainerType::ElementIdentifier,
+                                                 typename PixelContainerType::Element > MappedContainerType;
+  const MappedContainerType *container =
+    dynamic_cast< const MappedContainerType * >( image->GetPixelContainer() );
+  return container && container->IsMapped();
+}
+
+template< class TImage >
+int TestMemoryMapping(const std::string & fileName, bool compress, bool expectMapped)
+{
+  typedef itk::ImageFileReader< TImage > ReaderType;
+  typedef itk::ImageFileWriter< TImage > WriterType;
+
+  std::cout << "Testing " << fileName << ( compress ? " compressed" : "" ) << std::endl;
+
+  typename TImage::Pointer image = MakeMappingTestImage< TImage >();
+
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(image);
+  writer->SetFileName(fileName);
+  writer->SetUseCompression(compress);
+  writer->Update();
+
+  // the whole image
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  reader->UseMemoryMappingOn();
+  reader->Update();
+
+  const typename TImage::RegionType largestRegion = image->GetLargestPossibleRegion();
+  if ( !SameImages< TImage >(image, reader->GetOutput(), largestRegion) )
+    {
+    return EXIT_FAILURE;
+    }
+  if ( IsMapped< TImage >( reader->GetOutput() ) != expectMapped )
+    {
+    std::cerr << "The output is " << ( expectMapped ? "not " : "" ) << "mapped" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // writing to a mapped output must not change the file
+  typename TImage::IndexType index = largestRegion.GetIndex();
+  typename TImage::PixelType saved = reader->GetOutput()->GetPixel(index);
+  typename TImage::IndexType last = index;
+  last[0] += largestRegion.GetSize(0) - 1;
+  typename TImage::PixelType changed = image->GetPixel(last);
+  reader->GetOutput()->SetPixel(index, changed);
+
+  typename ReaderType::Pointer plainReader = ReaderType::New();
+  plainReader->SetFileName(fileName);
+  plainReader->Update();
+  if ( plainReader->GetOutput()->GetPixel(index) != saved )
+    {
+    std::cerr << "Writing to the mapped buffer changed the file" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // streamed in slabs, and for a region of a single slab
+  typename ReaderType::Pointer streamedReader = ReaderType::New();
+  streamedReader->SetFileName(fileName);
+  streamedReader->UseMemoryMappingOn();
+
+  typedef itk::StreamingImageFilter< TImage, TImage > StreamerType;
+  typename StreamerType::Pointer streamer = StreamerType::New();
+  streamer->SetInput( streamedReader->GetOutput() );
+  streamer->SetNumberOfStreamDivisions(4);
+  streamer->Update();
+  if ( !SameImages< TImage >(image, streamer->GetOutput(), largestRegion) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  typename TImage::RegionType slab = largestRegion;
+  slab.SetIndex(2, 5);
+  slab.SetSize(2, 3);
+  streamedReader->GetOutput()->SetRequestedRegion(slab);
+  streamedReader->Update();
+  if ( !SameImages< TImage >(image, streamedReader->GetOutput(), slab) )
+    {
+    return EXIT_FAILURE;
+    }
+  if ( IsMapped< TImage >( streamedReader->GetOutput() ) != expectMapped )
+    {
+    std::cerr << "The slab is " << ( expectMapped ? "not " : "" ) << "mapped" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+}
+
+int itkImageFileReaderMemoryMappingTest(int argc, char* argv[])
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+
+  typedef itk::Image< float, 3 >                        FloatImageType;
+  typedef itk::Image< unsigned char, 3 >                UCharImageType;
+  typedef itk::Image< itk::Vector< short, 3 >, 3 >      VectorImageType;
+
+  int status = EXIT_SUCCESS;
+
+  // pixels stored after a header are only mapped when the header
+  // length keeps them aligned, which is always the case for bytes
+  status |= TestMemoryMapping< UCharImageType >(directory + "/MemoryMapping.mha", false, true);
+  status |= TestMemoryMapping< FloatImageType >(directory + "/MemoryMapping.mhd", false, true);
+  status |= TestMemoryMapping< VectorImageType >(directory + "/MemoryMappingVector.mhd", false, true);
+  status |= TestMemoryMapping< UCharImageType >(directory + "/MemoryMapping.nrrd", false, true);
+  status |= TestMemoryMapping< FloatImageType >(directory + "/MemoryMapping.nhdr", false, true);
+  status |= TestMemoryMapping< UCharImageType >(directory + "/MemoryMapping.vtk", false, true);
+
+  // compressed data is read as usual
+  status |= TestMemoryMapping< FloatImageType >(directory + "/MemoryMappingCompressed.mha", true, false);
+  status |= TestMemoryMapping< FloatImageType >(directory + "/MemoryMappingCompressed.nrrd", true, false);
+
+  return status;
+}
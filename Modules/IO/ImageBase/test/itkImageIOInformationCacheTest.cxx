@@ -0,0 +1,268 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageIOFactory.h"
+#include "itkImageIOInformationCache.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTimeProbe.h"
+
+//
+//  Reads the information of the same files repeatedly with and without
+//  ImageIOInformationCache, and checks that the cached information and
+//  the pixels read after it are those of the files, also after a file
+//  was rewritten. The times of the repeated reads are reported.
+//
+
+namespace
+{
+typedef itk::Image< short, 3 >              CacheImageType;
+typedef itk::ImageFileReader< CacheImageType > CacheReaderType;
+
+CacheImageType::Pointer MakeCacheImage(unsigned int size, short offset)
+{
+  CacheImageType::RegionType region;
+  region.SetSize(0, size);
+  region.SetSize(1, size + 1);
+  region.SetSize(2, 3);
+  CacheImageType::Pointer image = CacheImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+  CacheImageType::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 0.75;
+  spacing[2] = 2.0;
+  image->SetSpacing(spacing);
+  CacheImageType::PointType origin;
+  origin[0] = -10.0;
+  origin[1] = 4.0;
+  origin[2] = offset;
+  image->SetOrigin(origin);
+
+  itk::ImageRegionIteratorWithIndex< CacheImageType > it(image, region);
+  for (; !it.IsAtEnd(); ++it )
+    {
+    const CacheImageType::IndexType & idx = it.GetIndex();
+    it.Set( static_cast< short >( offset + idx[0] + idx[1] * 7 + idx[2] * 100 ) );
+    }
+  return image;
+}
+
+void WriteCacheImage(const CacheImageType *image, const std::string & fileName)
+{
+  typedef itk::ImageFileWriter< CacheImageType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(image);
+  writer->SetFileName(fileName);
+  writer->Update();
+}
+
+bool SameInformation(const CacheImageType *expected, const CacheReaderType *reader)
+{
+  const CacheImageType *image = reader->GetOutput();
+  if ( image->GetLargestPossibleRegion() != expected->GetLargestPossibleRegion()
+       || image->GetSpacing() != expected->GetSpacing()
+       || image->GetOrigin() != expected->GetOrigin()
+       || image->GetDirection() != expected->GetDirection() )
+    {
+    std::cerr << "The information of " << reader->GetFileName()
+              << " is " << image->GetLargestPossibleRegion()
+              << image->GetSpacing() << " " << image->GetOrigin()
+              << " instead of " << expected->GetLargestPossibleRegion()
+              << expected->GetSpacing() << " " << expected->GetOrigin() << std::endl;
+    return false;
+    }
+  return true;
+}
+
+bool SamePixels(const CacheImageType *expected, const CacheImageType *image)
+{
+  if ( image->GetBufferedRegion() != expected->GetLargestPossibleRegion() )
+    {
+    std::cerr << "Read " << image->GetBufferedRegion() << std::endl;
+    return false;
+    }
+  itk::ImageRegionConstIterator< CacheImageType > eit( expected, expected->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< CacheImageType > it( image, expected->GetLargestPossibleRegion() );
+  for (; !eit.IsAtEnd(); ++eit, ++it )
+    {
+    if ( eit.Get() != it.Get() )
+      {
+      std::cerr << "Pixel " << it.GetIndex() << " is " << it.Get()
+                << " instead of " << eit.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+// Read the information of the files the given number of times, and
+// check it on the last round
+bool ReadInformation(const std::vector< std::string > & fileNames,
+                     const std::vector< CacheImageType::Pointer > & images,
+                     unsigned int repeats, const char *description)
+{
+  itk::TimeProbe probe;
+  bool           same = true;
+  for ( unsigned int r = 0; r < repeats; r++ )
+    {
+    for ( unsigned int f = 0; f < fileNames.size(); f++ )
+      {
+      CacheReaderType::Pointer reader = CacheReaderType::New();
+      reader->SetFileName(fileNames[f]);
+      probe.Start();
+      reader->UpdateOutputInformation();
+      probe.Stop();
+      if ( r + 1 == repeats )
+        {
+        same = SameInformation(images[f], reader) && same;
+        }
+      }
+    }
+  std::cout << "Reading the information of " << fileNames.size() << " files "
+            << repeats << " times " << description << ": "
+            << probe.GetTotal() << " s" << std::endl;
+  return same;
+}
+}
+
+int itkImageIOInformationCacheTest(int argc, char *argv[])
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory [repeats]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string  directory = argv[1];
+  const unsigned int repeats = argc > 2 ? atoi(argv[2]) : 50;
+
+  std::vector< std::string > fileNames;
+  fileNames.push_back(directory + "/itkImageIOInformationCacheTest.mha");
+  fileNames.push_back(directory + "/itkImageIOInformationCacheTest.nrrd");
+  fileNames.push_back(directory + "/itkImageIOInformationCacheTest.nii");
+
+  std::vector< CacheImageType::Pointer > images;
+  for ( unsigned int f = 0; f < fileNames.size(); f++ )
+    {
+    images.push_back( MakeCacheImage(10 + f, static_cast< short >( f * 1000 ) ) );
+    WriteCacheImage(images[f], fileNames[f]);
+    }
+
+  int status = EXIT_SUCCESS;
+  try
+    {
+    // the extension decides which ImageIO is asked first
+    const char *expectedIO[] = { "MetaImageIO", "NrrdImageIO", "NiftiImageIO" };
+    for ( unsigned int f = 0; f < fileNames.size(); f++ )
+      {
+      itk::ImageIOBase::Pointer io =
+        itk::ImageIOFactory::CreateImageIO(fileNames[f].c_str(), itk::ImageIOFactory::ReadMode);
+      if ( io.IsNull() || expectedIO[f] != std::string( io->GetNameOfClass() ) )
+        {
+        std::cerr << "The ImageIO created for " << fileNames[f] << " is "
+                  << ( io.IsNull() ? "null" : io->GetNameOfClass() )
+                  << " instead of " << expectedIO[f] << std::endl;
+        status = EXIT_FAILURE;
+        }
+      }
+
+    if ( !ReadInformation(fileNames, images, repeats, "without the cache") )
+      {
+      status = EXIT_FAILURE;
+      }
+    if ( itk::ImageIOInformationCache::GetNumberOfEntries() != 0 )
+      {
+      std::cerr << "The disabled cache holds "
+                << itk::ImageIOInformationCache::GetNumberOfEntries() << " files" << std::endl;
+      status = EXIT_FAILURE;
+      }
+
+    itk::ImageIOInformationCache::EnabledOn();
+    if ( !ReadInformation(fileNames, images, repeats, "with the cache") )
+      {
+      status = EXIT_FAILURE;
+      }
+    if ( itk::ImageIOInformationCache::GetNumberOfEntries() != fileNames.size() )
+      {
+      std::cerr << "The cache holds " << itk::ImageIOInformationCache::GetNumberOfEntries()
+                << " files instead of " << fileNames.size() << std::endl;
+      status = EXIT_FAILURE;
+      }
+
+    // the cached ImageIOs must still read the pixels
+    for ( unsigned int f = 0; f < fileNames.size(); f++ )
+      {
+      itk::ImageIOBase::Pointer cached = itk::ImageIOInformationCache::Find(fileNames[f]);
+      if ( cached.IsNull() || expectedIO[f] != std::string( cached->GetNameOfClass() ) )
+        {
+        std::cerr << fileNames[f] << " was not found in the cache" << std::endl;
+        status = EXIT_FAILURE;
+        }
+
+      CacheReaderType::Pointer reader = CacheReaderType::New();
+      reader->SetFileName(fileNames[f]);
+      reader->Update();
+      if ( !SamePixels( images[f], reader->GetOutput() ) )
+        {
+        std::cerr << "Reading " << fileNames[f] << " with the cache failed" << std::endl;
+        status = EXIT_FAILURE;
+        }
+      }
+
+    // a rewritten file of another size is read again
+    CacheImageType::Pointer larger = MakeCacheImage(17, 5000);
+    WriteCacheImage(larger, fileNames[0]);
+    CacheReaderType::Pointer rewrittenReader = CacheReaderType::New();
+    rewrittenReader->SetFileName(fileNames[0]);
+    rewrittenReader->Update();
+    if ( !SameInformation(larger, rewrittenReader) || !SamePixels( larger, rewrittenReader->GetOutput() ) )
+      {
+      std::cerr << "The rewritten file was read from the cache" << std::endl;
+      status = EXIT_FAILURE;
+      }
+
+    // the least recently used files are dropped first
+    itk::ImageIOInformationCache::SetMaximumNumberOfEntries(2);
+    if ( itk::ImageIOInformationCache::GetNumberOfEntries() != 2
+         || itk::ImageIOInformationCache::Find(fileNames[1]).IsNotNull() )
+      {
+      std::cerr << "The cache did not drop its least recently used file" << std::endl;
+      status = EXIT_FAILURE;
+      }
+
+    itk::ImageIOInformationCache::EnabledOff();
+    if ( itk::ImageIOInformationCache::Find(fileNames[0]).IsNotNull() )
+      {
+      std::cerr << "The disabled cache found " << fileNames[0] << std::endl;
+      status = EXIT_FAILURE;
+      }
+    }
+  catch ( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    status = EXIT_FAILURE;
+    }
+
+  if ( status == EXIT_SUCCESS )
+    {
+    std::cout << "Test PASSED !" << std::endl;
+    }
+  return status;
+}
@@ -0,0 +1,173 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageSeriesReader.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkMetaDataObject.h"
+
+namespace
+{
+
+typedef itk::Image< short, 3 >             ParallelImageType;
+typedef itk::ImageSeriesReader< ParallelImageType > ParallelReaderType;
+
+bool CompareSeriesReaders( ParallelReaderType *expected, ParallelReaderType *actual )
+{
+  ParallelImageType * expectedImage = expected->GetOutput();
+  ParallelImageType * actualImage = actual->GetOutput();
+
+  if ( expectedImage->GetBufferedRegion() != actualImage->GetBufferedRegion() )
+    {
+    std::cerr << "Buffered regions differ: " << expectedImage->GetBufferedRegion()
+              << actualImage->GetBufferedRegion() << std::endl;
+    return false;
+    }
+
+  itk::ImageRegionConstIterator< ParallelImageType > eIt( expectedImage, expectedImage->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< ParallelImageType > aIt( actualImage, actualImage->GetBufferedRegion() );
+  for ( ; !eIt.IsAtEnd(); ++eIt, ++aIt )
+    {
+    if ( eIt.Get() != aIt.Get() )
+      {
+      std::cerr << "Pixel mismatch at " << eIt.GetIndex() << ": "
+                << eIt.Get() << " != " << aIt.Get() << std::endl;
+      return false;
+      }
+    }
+
+  const ParallelReaderType::DictionaryArrayType & expectedArray = *expected->GetMetaDataDictionaryArray();
+  const ParallelReaderType::DictionaryArrayType & actualArray = *actual->GetMetaDataDictionaryArray();
+  if ( expectedArray.size() != actualArray.size() )
+    {
+    std::cerr << "Dictionary array sizes differ: " << expectedArray.size()
+              << " != " << actualArray.size() << std::endl;
+    return false;
+    }
+  for ( size_t i = 0; i < expectedArray.size(); ++i )
+    {
+    std::vector< std::string > expectedKeys = expectedArray[i]->GetKeys();
+    if ( expectedKeys != actualArray[i]->GetKeys() )
+      {
+      std::cerr << "Dictionary " << i << " has different keys" << std::endl;
+      return false;
+      }
+    for ( size_t k = 0; k < expectedKeys.size(); ++k )
+      {
+      std::string expectedValue;
+      std::string actualValue;
+      if ( itk::ExposeMetaData< std::string >( *expectedArray[i], expectedKeys[k], expectedValue )
+           && itk::ExposeMetaData< std::string >( *actualArray[i], expectedKeys[k], actualValue )
+           && expectedValue != actualValue )
+        {
+        std::cerr << "Dictionary " << i << " differs at " << expectedKeys[k] << ": "
+                  << expectedValue << " != " << actualValue << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+}
+
+int itkImageSeriesReaderParallelTest( int ac, char* av[] )
+{
+  if ( ac < 3 )
+    {
+    std::cerr << "usage: itkIOTests itkImageSeriesReaderParallelTest inputFileName(s)" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // repeat the series so that each thread gets several files
+  ParallelReaderType::FileNamesContainer fnames;
+  for ( int r = 0; r < 4; ++r )
+    {
+    for ( int i = 1; i < ac; ++i )
+      {
+      fnames.push_back( av[i] );
+      }
+    }
+
+  for ( int reverse = 0; reverse < 2; ++reverse )
+    {
+    for ( int partial = 0; partial < 2; ++partial )
+      {
+      ParallelReaderType::Pointer sequential = ParallelReaderType::New();
+      sequential->SetFileNames( fnames );
+      sequential->SetReverseOrder( reverse != 0 );
+
+      ParallelReaderType::Pointer parallel = ParallelReaderType::New();
+      parallel->SetFileNames( fnames );
+      parallel->SetReverseOrder( reverse != 0 );
+      parallel->SetNumberOfReadThreads( 4 );
+      if ( partial )
+        {
+        // with a user ImageIO, the slices are read one after another
+        sequential->SetImageIO( itk::ImageIOFactory::CreateImageIO( av[1], itk::ImageIOFactory::ReadMode ) );
+        parallel->SetImageIO( itk::ImageIOFactory::CreateImageIO( av[1], itk::ImageIOFactory::ReadMode ) );
+        }
+
+      std::cout << "Comparing sequential and parallel reads, reverse " << reverse
+                << ", partial " << partial << std::endl;
+      try
+        {
+        sequential->UpdateOutputInformation();
+        parallel->UpdateOutputInformation();
+        if ( partial )
+          {
+          // only read every other slice of the middle of the volume
+          ParallelImageType::RegionType region = sequential->GetOutput()->GetLargestPossibleRegion();
+          region.SetIndex( 2, 3 );
+          region.SetSize( 2, fnames.size() - 5 );
+          sequential->GetOutput()->SetRequestedRegion( region );
+          parallel->GetOutput()->SetRequestedRegion( region );
+          }
+        sequential->Update();
+        parallel->Update();
+        }
+      catch ( itk::ExceptionObject & ex )
+        {
+        std::cerr << ex << std::endl;
+        return EXIT_FAILURE;
+        }
+
+      if ( !CompareSeriesReaders( sequential, parallel ) )
+        {
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  std::cout << "Checking that a missing file is reported" << std::endl;
+  fnames.push_back( "this_file_does_not_exist.dcm" );
+  ParallelReaderType::Pointer failing = ParallelReaderType::New();
+  failing->SetFileNames( fnames );
+  failing->SetNumberOfReadThreads( 3 );
+  try
+    {
+    failing->Update();
+    std::cerr << "Expected an exception for a missing file" << std::endl;
+    return EXIT_FAILURE;
+    }
+  catch ( itk::ExceptionObject & ex )
+    {
+    std::cout << "Caught expected exception: " << ex.GetDescription() << std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -21,6 +21,7 @@
 
 #include <fstream>
 #include "itkImageIOBase.h"
+#include "itkMultiThreader.h"
 #include "metaObject.h"
 #include "metaImage.h"
 
@@ -115,17 +116,24 @@ public:
                            const ImageIORegion & largestPossibleRegion);
 
   /** Determine if the ImageIO can stream reading from this
-   *  file. Only time cannot stream read/write is if compression is used.
+   *  file. Compressed files can only be stream read when they were
+   *  written in chunks, see SetCompressionChunkSize().
    *  CanRead must be called prior to this function. */
   virtual bool CanStreamRead()
   {
-    if ( m_MetaImage.CompressedData() )
+    if ( m_MetaImage.CompressedData() && m_MetaImage.CompressedDataChunkSize() <= 0 )
       {
       return false;
       }
     return true;
   }
 
+  /** Determine if the pixel data can be mapped into memory. This is
+   *  the case for uncompressed binary data stored in the byte order
+   *  of this machine, either after the header or in a single
+   *  external data file. */
+  virtual bool CanMemoryMapRead(std::string & dataFileName, SizeType & dataOffset);
+
   /** Determine if the ImageIO can stream writing to this
    *  file. Only time cannot stream read/write is if compression is used.
    *  Assumes file passes a CanRead call and its pixels are of the same
@@ -145,6 +153,20 @@ public:
    * \warning this is only used when streaming is on. */
   itkSetMacro(SubSamplingFactor, unsigned int);
   itkGetConstMacro(SubSamplingFactor, unsigned int);
+
+  /** Number of uncompressed bytes in each of the independently
+   *  deflated chunks written when UseCompression is on. The chunks are
+   *  compressed and decompressed on several threads, and allow
+   *  streamed reading of compressed files. They still form a single
+   *  zlib stream, so readers unaware of them read the file as before.
+   *  Must not exceed NumericTraits< int >::max(). Default is 0, which
+   *  writes one compressed stream as before. */
+  itkSetMacro(CompressionChunkSize, unsigned int);
+  itkGetConstMacro(CompressionChunkSize, unsigned int);
+
+  /** Get the multithreader used to compress and decompress the chunks. */
+  itkGetObjectMacro(MultiThreader, MultiThreader);
+
 protected:
   MetaImageIO();
   ~MetaImageIO();
@@ -158,6 +180,10 @@ private:
   void operator=(const Self &); //purposely not implemented
 
   unsigned int m_SubSamplingFactor;
+
+  unsigned int m_CompressionChunkSize;
+
+  MultiThreader::Pointer m_MultiThreader;
 };
 } // end namespace itk
 
@@ -20,14 +20,50 @@
 #include "itkSpatialOrientationAdapter.h"
 #include "itkMetaDataObject.h"
 #include "itkIOCommon.h"
+#include "itkByteSwapper.h"
+#include "itkImageIOTaskQueue.h"
 #include "itksys/SystemTools.hxx"
 
 namespace itk
 {
+namespace
+{
+// A MetaIO task with the data it is called with
+struct MetaImageIOTask {
+  MET_TaskFunctionType Task;
+  void *               TaskData;
+};
+
+void MetaImageIORunTask(void *taskData, unsigned int taskId)
+{
+  MetaImageIOTask *task = static_cast< MetaImageIOTask * >( taskData );
+  task->Task( task->TaskData, static_cast< int >( taskId ) );
+}
+
+// MET_ParallelForFunctionType running the tasks with a MultiThreader
+void MetaImageIOParallelFor(MET_TaskFunctionType task, void *taskData,
+                            int numberOfTasks, void *clientData)
+{
+  if ( numberOfTasks <= 0 )
+    {
+    return;
+    }
+  MetaImageIOTask metaTask;
+  metaTask.Task = task;
+  metaTask.TaskData = taskData;
+  ImageIOTaskQueue::Execute(static_cast< MultiThreader * >( clientData ),
+                            MetaImageIORunTask, &metaTask,
+                            static_cast< unsigned int >( numberOfTasks ) );
+}
+} // end anonymous namespace
+
 MetaImageIO::MetaImageIO()
 {
   m_FileType = Binary;
   m_SubSamplingFactor = 1;
+  m_CompressionChunkSize = 0;
+  m_MultiThreader = MultiThreader::New();
+  m_MetaImage.ParallelForFunction( MetaImageIOParallelFor, m_MultiThreader.GetPointer() );
   if ( MET_SystemByteOrderMSB() )
     {
     m_ByteOrder = BigEndian;
@@ -52,6 +88,8 @@ void MetaImageIO::PrintSelf(std::ostream & os, Indent indent) const
   Superclass::PrintSelf(os, indent);
   m_MetaImage.PrintInfo();
   os << indent << "SubSamplingFactor: " << m_SubSamplingFactor << "\n";
+  os << indent << "CompressionChunkSize: " << m_CompressionChunkSize << "\n";
+  os << indent << "MultiThreader: " << m_MultiThreader.GetPointer() << "\n";
 }
 
 void MetaImageIO::SetDataFileName(const char *filename)
@@ -487,6 +525,87 @@ void MetaImageIO::Read(void *buffer)
     }
 }
 
+bool MetaImageIO::CanMemoryMapRead(std::string & dataFileName, SizeType & dataOffset)
+{
+  if ( !m_MetaImage.BinaryData() || m_MetaImage.CompressedData() || m_SubSamplingFactor != 1 )
+    {
+    return false;
+    }
+  if ( this->GetComponentSize() > 1
+       && m_MetaImage.BinaryDataByteOrderMSB() != ByteSwapper< int >::SystemIsBigEndian() )
+    {
+    return false;
+    }
+
+  const std::string elementDataFile = m_MetaImage.ElementDataFileName();
+  const bool        local = elementDataFile == "LOCAL" || elementDataFile == "Local"
+                            || elementDataFile == "local";
+  if ( !local
+       && ( elementDataFile.compare(0, 4, "LIST") == 0
+            || elementDataFile.find('%') != std::string::npos ) )
+    {
+    // the slices are spread over several files
+    return false;
+    }
+
+  if ( local )
+    {
+    dataFileName = m_FileName;
+    }
+  else if ( itksys::SystemTools::FileIsFullPath( elementDataFile.c_str() ) )
+    {
+    dataFileName = elementDataFile;
+    }
+  else
+    {
+    const std::string path = itksys::SystemTools::GetFilenamePath(m_FileName);
+    dataFileName = path.empty() ? elementDataFile : path + "/" + elementDataFile;
+    }
+  if ( !itksys::SystemTools::FileExists( dataFileName.c_str(), true ) )
+    {
+    return false;
+    }
+
+  // the offset follows the rules of MetaImage::M_ReadElements
+  const int headerSize = m_MetaImage.HeaderSize();
+  if ( headerSize > 0 )
+    {
+    dataOffset = headerSize;
+    }
+  else if ( headerSize == -1 )
+    {
+    const SizeType fileSize =
+      static_cast< SizeType >( itksys::SystemTools::FileLength( dataFileName.c_str() ) );
+    dataOffset = fileSize - static_cast< SizeType >( this->GetImageSizeInBytes() );
+    }
+  else if ( !local )
+    {
+    dataOffset = 0;
+    }
+  else
+    {
+    // the data starts right after the line of the ElementDataFile
+    // field, which ends the header
+    std::ifstream file( m_FileName.c_str(), std::ios::in | std::ios::binary );
+    std::string   line;
+    bool          found = false;
+    while ( !found && std::getline(file, line) )
+      {
+      const std::string::size_type separator = line.find('=');
+      found = separator != std::string::npos
+              && line.compare(0, 15, "ElementDataFile") == 0
+              && line.find_first_not_of(" \t", 15) == separator;
+      }
+    if ( !found )
+      {
+      return false;
+      }
+    dataOffset = static_cast< SizeType >( file.tellg() );
+    }
+
+  return dataOffset >= 0;
+}
+
 MetaImage * MetaImageIO::GetMetaImagePointer(void)
 {
   return &m_MetaImage;
@@ -1030,6 +1149,13 @@ MetaImageIO
   free(transformMatrix);
 
   m_MetaImage.CompressedData(m_UseCompression);
+  // MetaIO stores the chunk size as an int
+  if ( m_CompressionChunkSize > static_cast< unsigned int >( NumericTraits< int >::max() ) )
+    {
+    itkExceptionMacro( "CompressionChunkSize " << m_CompressionChunkSize
+                       << " is larger than " << NumericTraits< int >::max() );
+    }
+  m_MetaImage.CompressedDataChunkSize( static_cast< int >( m_CompressionChunkSize ) );
 
   // this is a check to see if we are actually streaming
   // we initialize with m_IORegion to match dimensions
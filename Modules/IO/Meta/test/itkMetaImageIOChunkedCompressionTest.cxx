@@ -0,0 +1,285 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <fstream>
+#include <sstream>
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkStreamingImageFilter.h"
+#include "itkMetaImageIO.h"
+
+
+#define SPECIFIC_IMAGEIO_MODULE_TEST
+
+namespace
+{
+typedef short                            ChunkedPixelType;
+typedef itk::Image< ChunkedPixelType, 3 > ChunkedImageType;
+
+bool SameImages(const ChunkedImageType *expected, const ChunkedImageType *image,
+                const ChunkedImageType::RegionType & region)
+{
+  if ( !image->GetBufferedRegion().IsInside(region) )
+    {
+    std::cerr << "Buffered region " << image->GetBufferedRegion()
+              << " does not contain " << region << std::endl;
+    return false;
+    }
+  itk::ImageRegionConstIterator< ChunkedImageType > eit(expected, region);
+  itk::ImageRegionConstIterator< ChunkedImageType > it(image, region);
+  for (; !eit.IsAtEnd(); ++eit, ++it )
+    {
+    if ( eit.Get() != it.Get() )
+      {
+      std::cerr << "Pixel " << it.GetIndex() << " is " << it.Get()
+                << " instead of " << eit.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+std::string ReadFileContents(const std::string & fileName)
+{
+  std::ifstream     file(fileName.c_str(), std::ios::in | std::ios::binary);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+int ReadAndCompare(const std::string & fileName, const ChunkedImageType *expected,
+                   bool expectStreamable)
+{
+  typedef itk::ImageFileReader< ChunkedImageType > ReaderType;
+  int status = EXIT_SUCCESS;
+
+  // whole image
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  reader->Update();
+  if ( !SameImages( expected, reader->GetOutput(), expected->GetLargestPossibleRegion() ) )
+    {
+    std::cerr << "Reading " << fileName << " failed" << std::endl;
+    status = EXIT_FAILURE;
+    }
+
+  itk::ImageIOBase *io = reader->GetImageIO();
+  if ( io->CanStreamRead() != expectStreamable )
+    {
+    std::cerr << "CanStreamRead() is " << io->CanStreamRead() << " for "
+              << fileName << std::endl;
+    status = EXIT_FAILURE;
+    }
+
+  // streamed in slabs that do not match the chunks
+  typedef itk::StreamingImageFilter< ChunkedImageType, ChunkedImageType > StreamerType;
+  ReaderType::Pointer   streamedReader = ReaderType::New();
+  streamedReader->SetFileName(fileName);
+  StreamerType::Pointer streamer = StreamerType::New();
+  streamer->SetInput( streamedReader->GetOutput() );
+  streamer->SetNumberOfStreamDivisions(7);
+  streamer->Update();
+  if ( !SameImages( expected, streamer->GetOutput(), expected->GetLargestPossibleRegion() ) )
+    {
+    std::cerr << "Streamed reading of " << fileName << " failed" << std::endl;
+    status = EXIT_FAILURE;
+    }
+
+  // requested region in the middle of the image
+  ChunkedImageType::RegionType region;
+  region.SetIndex(0, 5);
+  region.SetIndex(1, 7);
+  region.SetIndex(2, 11);
+  region.SetSize(0, 20);
+  region.SetSize(1, 30);
+  region.SetSize(2, 13);
+  ReaderType::Pointer regionReader = ReaderType::New();
+  regionReader->SetFileName(fileName);
+  regionReader->GetOutput()->SetRequestedRegion(region);
+  regionReader->Update();
+  if ( !SameImages(expected, regionReader->GetOutput(), region) )
+    {
+    std::cerr << "Reading region " << region << " of " << fileName << " failed" << std::endl;
+    status = EXIT_FAILURE;
+    }
+  if ( expectStreamable && regionReader->GetOutput()->GetBufferedRegion() != region )
+    {
+    std::cerr << "Region of " << fileName << " was not stream read" << std::endl;
+    status = EXIT_FAILURE;
+    }
+
+  return status;
+}
+
+int WriteChunked(const std::string & fileName, const ChunkedImageType *image,
+                 unsigned int chunkSize)
+{
+  itk::MetaImageIO::Pointer io = itk::MetaImageIO::New();
+  io->SetCompressionChunkSize(chunkSize);
+  io->GetMultiThreader()->SetNumberOfThreads(4);
+
+  typedef itk::ImageFileWriter< ChunkedImageType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetImageIO(io);
+  writer->SetInput(image);
+  writer->SetFileName(fileName);
+  writer->UseCompressionOn();
+  writer->Update();
+
+  const bool chunked = ReadFileContents(fileName).find("CompressedDataChunkSize") != std::string::npos;
+  if ( chunked != ( chunkSize > 0 ) )
+    {
+    std::cerr << "Chunk size is " << ( chunked ? "" : "not " )
+              << "written in " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+}
+
+int itkMetaImageIOChunkedCompressionTest(int ac, char* av[])
+{
+  if ( ac < 2 )
+    {
+    std::cerr << "Usage: " << av[0] << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string outputDirectory(av[1]);
+
+  // compressible but not constant data
+  ChunkedImageType::Pointer  image = ChunkedImageType::New();
+  ChunkedImageType::SizeType size;
+  size[0] = 45;
+  size[1] = 50;
+  size[2] = 40;
+  image->SetRegions(size);
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< ChunkedImageType > it( image, image->GetLargestPossibleRegion() );
+  for (; !it.IsAtEnd(); ++it )
+    {
+    const ChunkedImageType::IndexType & index = it.GetIndex();
+    it.Set( static_cast< ChunkedPixelType >( ( index[0] * index[1] + 7 * index[2] ) % 1000 - 500 ) );
+    }
+
+  int status = EXIT_SUCCESS;
+  try
+    {
+    // chunks of 10000 bytes span parts of several lines and slices
+    const std::string chunkedName = outputDirectory + "/ChunkedCompression.mha";
+    if ( WriteChunked(chunkedName, image, 10000) != EXIT_SUCCESS
+         || ReadAndCompare(chunkedName, image, true) != EXIT_SUCCESS )
+      {
+      status = EXIT_FAILURE;
+      }
+
+    const std::string externalName = outputDirectory + "/ChunkedCompression.mhd";
+    if ( WriteChunked(externalName, image, 10000) != EXIT_SUCCESS
+         || ReadAndCompare(externalName, image, true) != EXIT_SUCCESS )
+      {
+      status = EXIT_FAILURE;
+      }
+
+    // chunks shorter than a line of the image
+    const std::string smallChunksName = outputDirectory + "/ChunkedCompressionSmall.mha";
+    if ( WriteChunked(smallChunksName, image, 64) != EXIT_SUCCESS
+         || ReadAndCompare(smallChunksName, image, true) != EXIT_SUCCESS )
+      {
+      status = EXIT_FAILURE;
+      }
+
+    // a single chunk
+    const std::string singleChunkName = outputDirectory + "/ChunkedCompressionSingle.mha";
+    if ( WriteChunked(singleChunkName, image, 1000000) != EXIT_SUCCESS
+         || ReadAndCompare(singleChunkName, image, true) != EXIT_SUCCESS )
+      {
+      status = EXIT_FAILURE;
+      }
+
+    // chunking disabled: one compressed stream, not stream readable
+    const std::string streamName = outputDirectory + "/ChunkedCompressionOff.mha";
+    if ( WriteChunked(streamName, image, 0) != EXIT_SUCCESS
+         || ReadAndCompare(streamName, image, false) != EXIT_SUCCESS )
+      {
+      status = EXIT_FAILURE;
+      }
+
+    // chunking is off by default
+    const std::string defaultName = outputDirectory + "/ChunkedCompressionDefault.mha";
+    typedef itk::ImageFileWriter< ChunkedImageType > WriterType;
+    WriterType::Pointer defaultWriter = WriterType::New();
+    defaultWriter->SetImageIO( itk::MetaImageIO::New() );
+    defaultWriter->SetInput(image);
+    defaultWriter->SetFileName(defaultName);
+    defaultWriter->UseCompressionOn();
+    defaultWriter->Update();
+    if ( ReadFileContents(defaultName) != ReadFileContents(streamName) )
+      {
+      std::cerr << defaultName << " differs from " << streamName << std::endl;
+      status = EXIT_FAILURE;
+      }
+
+    // chunk sizes MetaIO cannot store are refused
+    bool caught = false;
+    try
+      {
+      WriteChunked(outputDirectory + "/ChunkedCompressionTooLarge.mha", image,
+                   static_cast< unsigned int >( itk::NumericTraits< int >::max() ) + 1u);
+      }
+    catch ( itk::ExceptionObject & e )
+      {
+      std::cout << "Caught expected exception: " << e.GetDescription() << std::endl;
+      caught = true;
+      }
+    if ( !caught )
+      {
+      std::cerr << "A chunk size larger than the largest int was accepted" << std::endl;
+      status = EXIT_FAILURE;
+      }
+
+    // a reader ignoring the chunk size inflates the chunks as one stream
+    std::string       contents = ReadFileContents(chunkedName);
+    const std::string key = "CompressedDataChunkSize = 10000\n";
+    const std::string::size_type keyPos = contents.find(key);
+    if ( keyPos == std::string::npos )
+      {
+      std::cerr << "No chunk size in " << chunkedName << std::endl;
+      status = EXIT_FAILURE;
+      }
+    else
+      {
+      contents.erase(keyPos, key.size());
+      const std::string unchunkedName = outputDirectory + "/ChunkedCompressionIgnored.mha";
+      std::ofstream     unchunked(unchunkedName.c_str(), std::ios::out | std::ios::binary);
+      unchunked.write( contents.data(), contents.size() );
+      unchunked.close();
+      if ( ReadAndCompare(unchunkedName, image, false) != EXIT_SUCCESS )
+        {
+        status = EXIT_FAILURE;
+        }
+      }
+    }
+  catch ( itk::ExceptionObject & e )
+    {
+    std::cerr << e << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return status;
+}
@@ -0,0 +1,296 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkStreamingImageFilter.h"
+#include "itkMetaImageIO.h"
+#include "itkVersion.h"
+#include "itkTimeProbe.h"
+
+//
+//  Streams a MetaImage from a reader that prefetches the next piece,
+//  through StreamingImageFilter and through a streaming ImageFileWriter,
+//  and checks that the pieces read ahead are those used, and that a
+//  reader given an ImageIO with non-default settings reads nothing ahead.
+//
+
+namespace
+{
+typedef itk::Image< short, 3 >                 PrefetchImageType;
+typedef itk::ImageFileReader< PrefetchImageType > PrefetchReaderType;
+
+// A MetaImageIO that counts the regions it reads
+class CountingMetaImageIO:public itk::MetaImageIO
+{
+public:
+  typedef CountingMetaImageIO            Self;
+  typedef itk::MetaImageIO               Superclass;
+  typedef itk::SmartPointer< Self >      Pointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(CountingMetaImageIO, MetaImageIO);
+
+  virtual void Read(void *buffer)
+  {
+    ++m_NumberOfReads;
+    Superclass::Read(buffer);
+  }
+
+  unsigned int m_NumberOfReads;
+
+protected:
+  CountingMetaImageIO():m_NumberOfReads(0) {}
+};
+
+// Creates CountingMetaImageIOs for the readers that are not given an
+// ImageIO, since only those prefetch
+class CountingMetaImageIOFactory:public itk::ObjectFactoryBase
+{
+public:
+  typedef CountingMetaImageIOFactory     Self;
+  typedef itk::ObjectFactoryBase         Superclass;
+  typedef itk::SmartPointer< Self >      Pointer;
+
+  itkFactorylessNewMacro(Self);
+  itkTypeMacro(CountingMetaImageIOFactory, ObjectFactoryBase);
+
+  virtual const char * GetITKSourceVersion() const { return ITK_SOURCE_VERSION; }
+  virtual const char * GetDescription() const { return "Counting Meta ImageIO Factory"; }
+
+protected:
+  CountingMetaImageIOFactory()
+  {
+    this->RegisterOverride( "itkImageIOBase", "CountingMetaImageIO", "Counting Meta Image IO",
+                            1, itk::CreateObjectFunction< CountingMetaImageIO >::New() );
+  }
+};
+
+bool SameImages(const PrefetchImageType *expected, const PrefetchImageType *image)
+{
+  const PrefetchImageType::RegionType & region = expected->GetLargestPossibleRegion();
+  if ( image->GetBufferedRegion() != region )
+    {
+    std::cerr << "Read " << image->GetBufferedRegion() << std::endl;
+    return false;
+    }
+  itk::ImageRegionConstIterator< PrefetchImageType > eit(expected, region);
+  itk::ImageRegionConstIterator< PrefetchImageType > it(image, region);
+  for (; !eit.IsAtEnd(); ++eit, ++it )
+    {
+    if ( eit.Get() != it.Get() )
+      {
+      std::cerr << "Pixel " << it.GetIndex() << " is " << it.Get()
+                << " instead of " << eit.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+PrefetchReaderType::Pointer MakeReader(const std::string & fileName, bool prefetching,
+                                       itk::SizeValueType prefetchBufferSize)
+{
+  PrefetchReaderType::Pointer reader = PrefetchReaderType::New();
+  reader->SetFileName(fileName);
+  reader->SetUsePrefetching(prefetching);
+  reader->SetPrefetchBufferSize(prefetchBufferSize);
+  return reader;
+}
+
+bool CheckNumberOfReads(PrefetchReaderType *reader, unsigned int expected)
+{
+  const CountingMetaImageIO *io = dynamic_cast< const CountingMetaImageIO * >( reader->GetImageIO() );
+  if ( !io )
+    {
+    std::cerr << "The reader did not read with a CountingMetaImageIO" << std::endl;
+    return false;
+    }
+  const unsigned int numberOfReads = io->m_NumberOfReads;
+  if ( numberOfReads != expected )
+    {
+    std::cerr << "The reader read " << numberOfReads << " regions itself instead of "
+              << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+}
+
+int itkMetaImagePrefetchingReadTest(int argc, char *argv[])
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+  const std::string fileName = directory + "/itkMetaImagePrefetchingReadTest.mha";
+  const std::string copyFileName = directory + "/itkMetaImagePrefetchingReadTestCopy.mha";
+
+  PrefetchImageType::RegionType region;
+  region.SetSize(0, 96);
+  region.SetSize(1, 80);
+  region.SetSize(2, 48);
+  PrefetchImageType::Pointer image = PrefetchImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< PrefetchImageType > it(image, region);
+  for (; !it.IsAtEnd(); ++it )
+    {
+    const PrefetchImageType::IndexType & idx = it.GetIndex();
+    it.Set( static_cast< short >( idx[0] + idx[1] * 3 + idx[2] * 300 ) );
+    }
+
+  typedef itk::ImageFileWriter< PrefetchImageType >            WriterType;
+  typedef itk::StreamingImageFilter< PrefetchImageType, PrefetchImageType > StreamerType;
+
+  itk::ObjectFactoryBase::RegisterFactory( CountingMetaImageIOFactory::New(),
+                                           itk::ObjectFactoryBase::INSERT_AT_FRONT );
+
+  const unsigned int numberOfDivisions = 8;
+  int                status = EXIT_SUCCESS;
+  try
+    {
+    WriterType::Pointer writer = WriterType::New();
+    writer->SetImageIO( itk::MetaImageIO::New() );
+    writer->SetInput(image);
+    writer->SetFileName(fileName);
+    writer->Update();
+
+    // with prefetching the reader's own ImageIO only reads the first
+    // piece, and without it, or with a buffer too small for a piece,
+    // it reads them all
+    const bool               prefetching[] = { false, true, true };
+    const itk::SizeValueType bufferSizes[] = { 1024 * 1024, 1024 * 1024, 1024 };
+    const unsigned int       expectedReads[] = { numberOfDivisions, 1, numberOfDivisions };
+    for ( unsigned int c = 0; c < 3; c++ )
+      {
+      PrefetchReaderType::Pointer reader = MakeReader(fileName, prefetching[c], bufferSizes[c]);
+      StreamerType::Pointer       streamer = StreamerType::New();
+      streamer->SetInput( reader->GetOutput() );
+      streamer->SetNumberOfStreamDivisions(numberOfDivisions);
+
+      itk::TimeProbe probe;
+      probe.Start();
+      streamer->Update();
+      probe.Stop();
+      std::cout << "Streaming " << numberOfDivisions << " pieces"
+                << ( prefetching[c] ? " with" : " without" ) << " prefetching into a buffer of "
+                << bufferSizes[c] << " bytes: " << probe.GetMean() << " s" << std::endl;
+
+      if ( !SameImages( image, streamer->GetOutput() ) || !CheckNumberOfReads(reader, expectedReads[c]) )
+        {
+        status = EXIT_FAILURE;
+        }
+      }
+
+    // a streaming writer pulls the pieces in the same order
+    PrefetchReaderType::Pointer reader = MakeReader(fileName, true, 1024 * 1024);
+    WriterType::Pointer         copyWriter = WriterType::New();
+    copyWriter->SetImageIO( itk::MetaImageIO::New() );
+    copyWriter->SetInput( reader->GetOutput() );
+    copyWriter->SetFileName(copyFileName);
+    copyWriter->SetNumberOfStreamDivisions(numberOfDivisions);
+    copyWriter->Update();
+    if ( !CheckNumberOfReads(reader, 1) )
+      {
+      status = EXIT_FAILURE;
+      }
+
+    PrefetchReaderType::Pointer copyReader = PrefetchReaderType::New();
+    copyReader->SetImageIO( itk::MetaImageIO::New() );
+    copyReader->SetFileName(copyFileName);
+    copyReader->Update();
+    if ( !SameImages( image, copyReader->GetOutput() ) )
+      {
+      std::cerr << "The copy written from the prefetching reader differs" << std::endl;
+      status = EXIT_FAILURE;
+      }
+
+    // a region that does not start a sequence of pieces is read alone
+    PrefetchReaderType::Pointer regionReader = MakeReader(fileName, true, 1024 * 1024);
+    regionReader->UpdateOutputInformation();
+    PrefetchImageType::RegionType subRegion = region;
+    subRegion.SetIndex(2, 10);
+    subRegion.SetSize(2, 5);
+    regionReader->GetOutput()->SetRequestedRegion(subRegion);
+    regionReader->Update();
+    if ( !CheckNumberOfReads(regionReader, 1) )
+      {
+      status = EXIT_FAILURE;
+      }
+    itk::ImageRegionConstIterator< PrefetchImageType > eit(image, subRegion);
+    itk::ImageRegionConstIterator< PrefetchImageType > rit(regionReader->GetOutput(), subRegion);
+    for (; !eit.IsAtEnd(); ++eit, ++rit )
+      {
+      if ( eit.Get() != rit.Get() )
+        {
+        std::cerr << "Pixel " << rit.GetIndex() << " of the region is " << rit.Get()
+                  << " instead of " << eit.Get() << std::endl;
+        status = EXIT_FAILURE;
+        break;
+        }
+      }
+
+    // an ImageIO given by the user keeps its settings for every piece,
+    // since the reader does not create another one to read ahead
+    const unsigned int subSamplingFactor = 2;
+    PrefetchImageType::Pointer expected;
+    for ( unsigned int c = 0; c < 2; c++ )
+      {
+      CountingMetaImageIO::Pointer subSamplingIO = CountingMetaImageIO::New();
+      subSamplingIO->SetSubSamplingFactor(subSamplingFactor);
+      PrefetchReaderType::Pointer subSamplingReader = MakeReader(fileName, c == 1, 1024 * 1024);
+      subSamplingReader->SetImageIO(subSamplingIO);
+      StreamerType::Pointer streamer = StreamerType::New();
+      streamer->SetInput( subSamplingReader->GetOutput() );
+      streamer->SetNumberOfStreamDivisions(numberOfDivisions);
+      streamer->Update();
+      if ( c == 0 )
+        {
+        expected = streamer->GetOutput();
+        expected->DisconnectPipeline();
+        }
+      else if ( !SameImages( expected, streamer->GetOutput() )
+                || !CheckNumberOfReads(subSamplingReader, numberOfDivisions) )
+        {
+        std::cerr << "The subsampling ImageIO given to the prefetching reader was not used" << std::endl;
+        status = EXIT_FAILURE;
+        }
+      }
+    if ( expected->GetLargestPossibleRegion().GetSize(0) != region.GetSize(0) / subSamplingFactor )
+      {
+      std::cerr << "The image was not subsampled" << std::endl;
+      status = EXIT_FAILURE;
+      }
+    }
+  catch ( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    status = EXIT_FAILURE;
+    }
+
+  if ( status == EXIT_SUCCESS )
+    {
+    std::cout << "Test PASSED !" << std::endl;
+    }
+  return status;
+}
@@ -100,6 +100,17 @@ public:
     */
   itkSetMacro(LegacyAnalyze75Mode, bool);
   itkGetConstMacro(LegacyAnalyze75Mode, bool);
+
+  /** Index the access points of .nii.gz and .img.gz files on their
+   * first region read, and restart inflation from the closest one on
+   * later region reads instead of from the start of the file. The
+   * first read inflates the whole file once to build the index, which
+   * is then kept in memory for as long as the file is not modified.
+   * Worth turning on when many subregions, such as single volumes of
+   * a long 4D series, are read from the same file. Off by default. */
+  itkSetMacro(UseCompressedDataIndex, bool);
+  itkGetConstMacro(UseCompressedDataIndex, bool);
+  itkBooleanMacro(UseCompressedDataIndex);
 protected:
   NiftiImageIO();
   ~NiftiImageIO();
@@ -117,6 +128,10 @@ private:
 
   void  SetImageIOMetadataFromNIfTI();
 
+  /** Read a region, in nifti dimension order, of the data of
+   * m_NiftiImage into data, swapped to the native byte order. */
+  void  ReadNiftiData(const int origin[7], const int size[7], void *data);
+
   nifti_image *m_NiftiImage;
 
   double m_RescaleSlope;
@@ -126,6 +141,8 @@ private:
 
   bool m_LegacyAnalyze75Mode;
 
+  bool m_UseCompressedDataIndex;
+
   NiftiImageIO(const Self &);   //purposely not implemented
   void operator=(const Self &); //purposely not implemented
 };
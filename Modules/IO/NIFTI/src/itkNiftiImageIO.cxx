@@ -19,6 +19,13 @@
 #include "itkIOCommon.h"
 #include "itkMetaDataObject.h"
 #include "itkSpatialOrientationAdapter.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itksys/SystemTools.hxx"
+#include "itk_zlib.h"
+#include "vnl/vnl_math.h"
+#include <algorithm>
+#include <fstream>
+#include <map>
 
 namespace itk
 {
@@ -352,7 +359,8 @@ NiftiImageIO::NiftiImageIO():
   m_RescaleSlope(1.0),
   m_RescaleIntercept(0.0),
   m_OnDiskComponentType(UNKNOWNCOMPONENTTYPE),
-  m_LegacyAnalyze75Mode(true)
+  m_LegacyAnalyze75Mode(true),
+  m_UseCompressedDataIndex(false)
 {
   this->SetNumberOfDimensions(3);
   nifti_set_debug_level(0); // suppress error messages
@@ -383,6 +391,7 @@ NiftiImageIO
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "LegacyAnalyze75Mode: " << this->m_LegacyAnalyze75Mode << std::endl;
+  os << indent << "UseCompressedDataIndex: " << this->m_UseCompressedDataIndex << std::endl;
 }
 
 bool
@@ -417,6 +426,505 @@ void RescaleFunction(TBuffer *buffer,
     }
 }
 
+namespace
+{
+/** \class NiftiGzipIndex
+ * Points of a gzip stream at which inflation can be restarted, so that
+ * a region deep in a .nii.gz file is reached without inflating all of
+ * the data in front of it. After zlib's examples/zran.c. */
+class NiftiGzipIndex:public LightObject
+{
+public:
+  typedef NiftiGzipIndex       Self;
+  typedef LightObject          Superclass;
+  typedef SmartPointer< Self > Pointer;
+
+  itkFactorylessNewMacro(Self);
+
+  /** Size of the inflate dictionary kept with each access point. */
+  static const unsigned int WindowSize = 32768;
+
+  /** Size of the reads from the compressed file. */
+  static const unsigned int ChunkSize = 16384;
+
+  struct AccessPoint {
+    /** offset in the uncompressed data */
+    OffsetValueType Out;
+    /** offset of the first full byte of the block in the file */
+    OffsetValueType In;
+    /** bits of the byte before In that belong to the block */
+    int Bits;
+  };
+
+  /** Inflate the whole file, keeping an access point about every span
+   * uncompressed bytes. Returns false if it is not a readable gzip
+   * file. */
+  bool Build(const std::string & fileName, OffsetValueType span)
+  {
+    std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+    if ( !file )
+      {
+      return false;
+      }
+
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.avail_in = 0;
+    stream.next_in = Z_NULL;
+    // 47: detect a gzip or zlib header
+    if ( inflateInit2(&stream, 47) != Z_OK )
+      {
+      return false;
+      }
+
+    unsigned char   input[ChunkSize];
+    unsigned char   window[WindowSize];
+    OffsetValueType totalIn = 0;
+    OffsetValueType totalOut = 0;
+    OffsetValueType last = 0;
+    int             ret = Z_OK;
+    stream.avail_out = 0;
+    do
+      {
+      file.read(reinterpret_cast< char * >( input ), ChunkSize);
+      stream.avail_in = static_cast< uInt >( file.gcount() );
+      if ( stream.avail_in == 0 )
+        {
+        ret = Z_DATA_ERROR;
+        break;
+        }
+      stream.next_in = input;
+      do
+        {
+        if ( stream.avail_out == 0 )
+          {
+          stream.avail_out = WindowSize;
+          stream.next_out = window;
+          }
+        totalIn += stream.avail_in;
+        totalOut += stream.avail_out;
+        // stop at the end of each deflate block
+        ret = inflate(&stream, Z_BLOCK);
+        totalIn -= stream.avail_in;
+        totalOut -= stream.avail_out;
+        if ( ret == Z_NEED_DICT || ret == Z_MEM_ERROR || ret == Z_DATA_ERROR )
+          {
+          ret = Z_DATA_ERROR;
+          break;
+          }
+        if ( ret == Z_STREAM_END )
+          {
+          break;
+          }
+        // at the end of a block that is not the last one
+        if ( ( stream.data_type & 128 ) && !( stream.data_type & 64 )
+             && ( totalOut == 0 || totalOut - last > span ) )
+          {
+          this->AddPoint(stream.data_type & 7, totalIn, totalOut,
+                         stream.avail_out, window);
+          last = totalOut;
+          }
+        }
+      while ( stream.avail_in != 0 );
+      }
+    while ( ret != Z_STREAM_END && ret != Z_DATA_ERROR );
+
+    inflateEnd(&stream);
+    m_Length = totalOut;
+    return ret == Z_STREAM_END && !m_Points.empty();
+  }
+
+  /** Length of the uncompressed data. */
+  OffsetValueType GetLength() const
+  {
+    return m_Length;
+  }
+
+  /** The last access point at or before an uncompressed offset. */
+  unsigned int FindPoint(OffsetValueType offset) const
+  {
+    unsigned int i = 0;
+    while ( i + 1 < m_Points.size() && m_Points[i + 1].Out <= offset )
+      {
+      ++i;
+      }
+    return i;
+  }
+
+  const AccessPoint & GetPoint(unsigned int i) const
+  {
+    return m_Points[i];
+  }
+
+  const unsigned char * GetWindow(unsigned int i) const
+  {
+    return &m_Windows[static_cast< size_t >( i ) * WindowSize];
+  }
+
+  /** File state the index was built from. */
+  long          m_ModifiedTime;
+  unsigned long m_FileLength;
+
+protected:
+  NiftiGzipIndex():m_ModifiedTime(0), m_FileLength(0), m_Length(0) {}
+  ~NiftiGzipIndex() {}
+
+private:
+  void AddPoint(int bits, OffsetValueType in, OffsetValueType out,
+                unsigned int left, const unsigned char *window)
+  {
+    AccessPoint point;
+    point.Bits = bits;
+    point.In = in;
+    point.Out = out;
+    m_Points.push_back(point);
+
+    // the circular window, oldest byte first
+    const size_t start = m_Windows.size();
+    m_Windows.resize(start + WindowSize);
+    unsigned char *copy = &m_Windows[start];
+    if ( left )
+      {
+      memcpy(copy, window + WindowSize - left, left);
+      }
+    if ( left < WindowSize )
+      {
+      memcpy(copy + left, window, WindowSize - left);
+      }
+  }
+
+  std::vector< AccessPoint >   m_Points;
+  std::vector< unsigned char > m_Windows;
+  OffsetValueType              m_Length;
+
+  NiftiGzipIndex(const Self &);  //purposely not implemented
+  void operator=(const Self &);  //purposely not implemented
+};
+
+/** Indices of the .nii.gz files read with UseCompressedDataIndex on,
+ * kept for as long as the file is not modified. */
+class NiftiGzipIndexCache
+{
+public:
+  static NiftiGzipIndex::Pointer GetIndex(const std::string & fileName)
+  {
+    const long          modifiedTime = itksys::SystemTools::ModifiedTime( fileName.c_str() );
+    const unsigned long fileLength = itksys::SystemTools::FileLength( fileName.c_str() );
+
+    m_Lock.Lock();
+    IndexMapType::iterator it = m_Indices.find(fileName);
+    if ( it != m_Indices.end()
+         && it->second->m_ModifiedTime == modifiedTime
+         && it->second->m_FileLength == fileLength )
+      {
+      NiftiGzipIndex::Pointer index = it->second;
+      m_Lock.Unlock();
+      return index;
+      }
+    m_Lock.Unlock();
+
+    // build outside of the lock, other files stay readable meanwhile
+    NiftiGzipIndex::Pointer index = NiftiGzipIndex::New();
+    if ( !index->Build(fileName, SpanSize) )
+      {
+      return NULL;
+      }
+    index->m_ModifiedTime = modifiedTime;
+    index->m_FileLength = fileLength;
+
+    m_Lock.Lock();
+    if ( m_Indices.size() >= MaximumNumberOfIndices
+         && m_Indices.find(fileName) == m_Indices.end() )
+      {
+      m_Indices.erase( m_Indices.begin() );
+      }
+    m_Indices[fileName] = index;
+    m_Lock.Unlock();
+    return index;
+  }
+
+private:
+  /** Uncompressed bytes between two access points. */
+  static const OffsetValueType SpanSize = 1048576;
+
+  static const unsigned int MaximumNumberOfIndices = 8;
+
+  typedef std::map< std::string, NiftiGzipIndex::Pointer > IndexMapType;
+
+  static IndexMapType        m_Indices;
+  static SimpleFastMutexLock m_Lock;
+};
+
+NiftiGzipIndexCache::IndexMapType NiftiGzipIndexCache::m_Indices;
+SimpleFastMutexLock               NiftiGzipIndexCache::m_Lock;
+
+/** Reads byte ranges of the uncompressed data of a gzip file, restarting
+ * at the closest access point of an index when that is shorter than
+ * inflating on from the current position. */
+class NiftiGzipIndexReader
+{
+public:
+  NiftiGzipIndexReader(const NiftiGzipIndex *index, const std::string & fileName):
+    m_Index(index),
+    m_File(fileName.c_str(), std::ios::in | std::ios::binary),
+    m_Active(false),
+    m_Position(0),
+    m_Discard(NiftiGzipIndex::WindowSize)
+  {}
+
+  ~NiftiGzipIndexReader()
+  {
+    if ( m_Active )
+      {
+      inflateEnd(&m_Stream);
+      }
+  }
+
+  bool Read(OffsetValueType offset, char *out, size_t length)
+  {
+    const unsigned int point = m_Index->FindPoint(offset);
+    if ( !m_Active || offset < m_Position
+         || m_Index->GetPoint(point).Out > m_Position )
+      {
+      if ( !this->Restart(point) )
+        {
+        return false;
+        }
+      }
+    return this->Inflate(0, static_cast< size_t >( offset - m_Position ) )
+           && this->Inflate(out, length);
+  }
+
+private:
+  bool Restart(unsigned int i)
+  {
+    if ( m_Active )
+      {
+      inflateEnd(&m_Stream);
+      m_Active = false;
+      }
+    const NiftiGzipIndex::AccessPoint & point = m_Index->GetPoint(i);
+
+    m_Stream.zalloc = Z_NULL;
+    m_Stream.zfree = Z_NULL;
+    m_Stream.opaque = Z_NULL;
+    m_Stream.avail_in = 0;
+    m_Stream.next_in = Z_NULL;
+    // raw inflate from the middle of the deflate stream
+    if ( inflateInit2(&m_Stream, -15) != Z_OK )
+      {
+      return false;
+      }
+    m_Active = true;
+
+    m_File.clear();
+    m_File.seekg(point.In - ( point.Bits ? 1 : 0 ), std::ios::beg);
+    if ( point.Bits )
+      {
+      const int c = m_File.get();
+      if ( c == EOF )
+        {
+        return false;
+        }
+      inflatePrime(&m_Stream, point.Bits, c >> ( 8 - point.Bits ));
+      }
+    if ( !m_File )
+      {
+      return false;
+      }
+    inflateSetDictionary(&m_Stream, m_Index->GetWindow(i), NiftiGzipIndex::WindowSize);
+    m_Position = point.Out;
+    return true;
+  }
+
+  /** Inflate length bytes into out, or drop them if out is null. */
+  bool Inflate(char *out, size_t length)
+  {
+    while ( length > 0 )
+      {
+      const uInt chunk = static_cast< uInt >( std::min(length, m_Discard.size()) );
+      m_Stream.next_out = out ? reinterpret_cast< Bytef * >( out ) : &m_Discard[0];
+      m_Stream.avail_out = chunk;
+      while ( m_Stream.avail_out > 0 )
+        {
+        if ( m_Stream.avail_in == 0 )
+          {
+          m_File.read(reinterpret_cast< char * >( m_Input ), NiftiGzipIndex::ChunkSize);
+          m_Stream.avail_in = static_cast< uInt >( m_File.gcount() );
+          if ( m_Stream.avail_in == 0 )
+            {
+            return false;
+            }
+          m_Stream.next_in = m_Input;
+          }
+        const int ret = inflate(&m_Stream, Z_NO_FLUSH);
+        if ( ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR
+             || ( ret == Z_STREAM_END && m_Stream.avail_out > 0 ) )
+          {
+          return false;
+          }
+        }
+      if ( out )
+        {
+        out += chunk;
+        }
+      length -= chunk;
+      m_Position += chunk;
+      }
+    return true;
+  }
+
+  const NiftiGzipIndex *        m_Index;
+  std::ifstream                 m_File;
+  z_stream                      m_Stream;
+  bool                          m_Active;
+  OffsetValueType               m_Position;
+  unsigned char                 m_Input[NiftiGzipIndex::ChunkSize];
+  std::vector< unsigned char >  m_Discard;
+};
+
+/** Reads byte ranges of the data of a nifti file through znzlib. */
+class NiftiZnzReader
+{
+public:
+  NiftiZnzReader(const char *fileName, int useCompression):
+    m_File( znzopen(fileName, "rb", useCompression) ),
+    m_Position(-1)
+  {}
+
+  ~NiftiZnzReader()
+  {
+    if ( !znz_isnull(m_File) )
+      {
+      znzclose(m_File);
+      }
+  }
+
+  bool IsOpen() const
+  {
+    return !znz_isnull(m_File);
+  }
+
+  bool Read(OffsetValueType offset, char *out, size_t length)
+  {
+    if ( offset != m_Position
+         && znzseek(m_File, static_cast< long >( offset ), SEEK_SET) < 0 )
+      {
+      return false;
+      }
+    if ( znzread(out, 1, length, m_File) != length )
+      {
+      m_Position = -1;
+      return false;
+      }
+    m_Position = offset + length;
+    return true;
+  }
+
+private:
+  znzFile         m_File;
+  OffsetValueType m_Position;
+};
+
+/** Read the rows of a region of nifti data, merging the rows of
+ * dimensions that are read whole into single reads. Offsets are in
+ * bytes from the start of the file. */
+template< class TReader >
+bool ReadNiftiRows(TReader & reader, OffsetValueType dataOffset,
+                     const OffsetValueType extent[7], size_t pixelSize,
+                     const int origin[7], const int size[7], char *out)
+{
+  OffsetValueType stride[7];
+  stride[0] = pixelSize;
+  for ( unsigned int i = 1; i < 7; i++ )
+    {
+    stride[i] = stride[i - 1] * extent[i - 1];
+    }
+
+  // the first dimension that is not part of a contiguous run
+  unsigned int outer = 1;
+  size_t       runLength = size[0];
+  while ( outer < 7 && origin[outer - 1] == 0 && size[outer - 1] == extent[outer - 1] )
+    {
+    runLength *= size[outer];
+    ++outer;
+    }
+  const size_t runBytes = runLength * pixelSize;
+
+  int index[7];
+  for ( unsigned int i = 0; i < 7; i++ )
+    {
+    index[i] = origin[i];
+    }
+  for (;; )
+    {
+    OffsetValueType offset = dataOffset;
+    for ( unsigned int i = 0; i < 7; i++ )
+      {
+      offset += index[i] * stride[i];
+      }
+    if ( !reader.Read(offset, out, runBytes) )
+      {
+      return false;
+      }
+    out += runBytes;
+
+    unsigned int d = outer;
+    for (; d < 7; d++ )
+      {
+      if ( ++index[d] < origin[d] + size[d] )
+        {
+        break;
+        }
+      index[d] = origin[d];
+      }
+    if ( d >= 7 )
+      {
+      return true;
+      }
+    }
+}
+
+/** What nifti_read_buffer does after reading: swap to the native byte
+ * order and set invalid floating point values to zero. */
+template< class TFloat >
+void ZeroNonFiniteValues(void *data, size_t bytes)
+{
+  TFloat *values = static_cast< TFloat * >( data );
+  const size_t count = bytes / sizeof( TFloat );
+  for ( size_t i = 0; i < count; i++ )
+    {
+    if ( !vnl_math_isfinite(values[i]) )
+      {
+      values[i] = 0;
+      }
+    }
+}
+
+void FinishNiftiRead(const nifti_image *nim, void *data, size_t bytes)
+{
+  if ( nim->swapsize > 1 && nim->byteorder != nifti_short_order() )
+    {
+    nifti_swap_Nbytes(bytes / nim->swapsize, nim->swapsize, data);
+    }
+  switch ( nim->datatype )
+    {
+    case NIFTI_TYPE_FLOAT32:
+    case NIFTI_TYPE_COMPLEX64:
+      ZeroNonFiniteValues< float >(data, bytes);
+      break;
+    case NIFTI_TYPE_FLOAT64:
+    case NIFTI_TYPE_COMPLEX128:
+      ZeroNonFiniteValues< double >(data, bytes);
+      break;
+    default:
+      break;
+    }
+}
+}
+
 template< typename PixelType >
 void
 CastCopy(float *to, void *from, size_t pixelcount)
@@ -429,15 +937,82 @@ CastCopy(float *to, void *from, size_t pixelcount)
     }
 }
 
-void NiftiImageIO::Read(void *buffer)
+void
+NiftiImageIO
+::ReadNiftiData(const int origin[7], const int size[7], void *data)
 {
-  void *data = 0;
+  const nifti_image *nim = this->m_NiftiImage;
+
+  OffsetValueType extent[7];
+  size_t          regionBytes = nim->nbyper;
+  for ( unsigned int i = 0; i < 7; i++ )
+    {
+    extent[i] = ( static_cast< int >( i ) < nim->ndim && nim->dim[i + 1] > 0 ) ? nim->dim[i + 1] : 1;
+    if ( origin[i] < 0 || size[i] < 1 || origin[i] + size[i] > extent[i] )
+      {
+      itkExceptionMacro( << "Requested region does not fit in the image in file: "
+                         << this->GetFileName() );
+      }
+    regionBytes *= size[i];
+    }
+
+  const bool compressed = nifti_is_gzfile(nim->iname) != 0;
 
+  OffsetValueType dataOffset = nim->iname_offset;
+  if ( dataOffset < 0 )
+    {
+    // a negative offset means the data is at the end of the file
+    if ( compressed )
+      {
+      itkExceptionMacro( << "Negative data offset in compressed file: " << nim->iname );
+      }
+    const OffsetValueType fileSize = nifti_get_filesize(nim->iname);
+    const OffsetValueType dataSize = static_cast< OffsetValueType >( nifti_get_volsize(nim) );
+    dataOffset = fileSize > dataSize ? fileSize - dataSize : 0;
+    }
+
+  bool regionRead = false;
+  if ( compressed && this->m_UseCompressedDataIndex )
+    {
+    NiftiGzipIndex::Pointer index = NiftiGzipIndexCache::GetIndex(nim->iname);
+    const OffsetValueType   dataEnd = dataOffset + static_cast< OffsetValueType >( nifti_get_volsize(nim) );
+    // fall back on znzlib for files the index does not cover
+    if ( index.IsNotNull() && index->GetLength() >= dataEnd )
+      {
+      NiftiGzipIndexReader reader(index, nim->iname);
+      if ( !ReadNiftiRows(reader, dataOffset, extent, nim->nbyper,
+                          origin, size, static_cast< char * >( data ) ) )
+        {
+        itkExceptionMacro( << "Failed to read the requested region of file: " << nim->iname );
+        }
+      regionRead = true;
+      }
+    }
+
+  if ( !regionRead )
+    {
+    NiftiZnzReader reader(nim->iname, compressed);
+    if ( !reader.IsOpen() )
+      {
+      itkExceptionMacro( << "Cannot open data file: " << nim->iname );
+      }
+    if ( !ReadNiftiRows(reader, dataOffset, extent, nim->nbyper,
+                        origin, size, static_cast< char * >( data ) ) )
+      {
+      itkExceptionMacro( << "Failed to read the requested region of file: " << nim->iname );
+      }
+    }
+
+  FinishNiftiRead(nim, data, regionBytes);
+}
+
+void NiftiImageIO::Read(void *buffer)
+{
   ImageIORegion            regionToRead = this->GetIORegion();
   ImageIORegion::SizeType  size = regionToRead.GetSize();
   ImageIORegion::IndexType start = regionToRead.GetIndex();
 
-  int          numElts = 1;
+  size_t       numElts = 1;
   int          _origin[7];
   int          _size[7];
   unsigned int i;
@@ -456,15 +1031,24 @@ void NiftiImageIO::Read(void *buffer)
 
   unsigned int numComponents = this->GetNumberOfComponents();
   //
+  // if single or complex, nifti layout == itk layout
+  const bool sameLayout = numComponents == 1
+                          || this->GetPixelType() == COMPLEX
+                          || this->GetPixelType() == RGB
+                          || this->GetPixelType() == RGBA;
+  //
   // special case for images of vector pixels
-  if ( numComponents > 1 && this->GetPixelType() != COMPLEX )
+  if ( !sameLayout )
     {
     // nifti always sticks vec size in dim 4, so have to shove
     // other dims out of the way
     _size[6] = _size[5];
     _size[5] = _size[4];
+    _origin[6] = _origin[5];
+    _origin[5] = _origin[4];
     // sizes = x y z t vecsize
     _size[4] = numComponents;
+    _origin[4] = 0;
     }
   // Free memory if any was occupied already (incase of re-using the IO filter).
   if ( this->m_NiftiImage != NULL )
@@ -481,133 +1065,105 @@ void NiftiImageIO::Read(void *buffer)
     }
 
   //
-  // decide whether to read whole region or subregion, by stepping
-  // thru dims and comparing them to requested sizes
-  for ( i = 0; i < this->GetNumberOfDimensions(); i++ )
-    {
-    if ( this->m_NiftiImage->dim[i + 1] != _size[i] )
+  // if we're going to have to rescale pixels, and the on-disk
+  // pixel type is different than the pixel type reported to
+  // ImageFileReader, we have to up-promote the data to float
+  // before doing the rescale.
+  const bool mustCast = this->MustRescale()
+                        && this->m_ComponentType != this->m_OnDiskComponentType;
+
+  //
+  // read straight into the output buffer when nothing else is to be
+  // done with the data, or else into a buffer of the region size.
+  // Malloc instead of new to be consistent with allocation used in
+  // niftilib
+  void *data = buffer;
+  if ( mustCast || !sameLayout )
+    {
+    size_t regionBytes = this->m_NiftiImage->nbyper;
+    for ( i = 0; i < 7; i++ )
       {
-      break;
+      regionBytes *= _size[i];
       }
-    }
-  // if all dimensions match requested size, just read in
-  // all data as a block
-  if ( i == this->GetNumberOfDimensions() )
-    {
-    if ( nifti_image_load(this->m_NiftiImage) == -1 )
+    data = malloc(regionBytes);
+    if ( data == NULL )
       {
-      itkExceptionMacro( << "nifti_image_load failed for file: "
-                         << this->GetFileName() );
+      itkExceptionMacro( << "Failed to allocate " << regionBytes
+                         << " bytes to read file: " << this->GetFileName() );
       }
-    data = this->m_NiftiImage->data;
     }
-  else
+  try
     {
-    // read in a subregion
-    if ( nifti_read_subregion_image(this->m_NiftiImage,
-                                    _origin,
-                                    _size,
-                                    &data) == -1 || this->m_NiftiImage == NULL )
+    this->ReadNiftiData(_origin, _size, data);
+    }
+  catch ( ... )
+    {
+    if ( data != buffer )
       {
-      itkExceptionMacro( << "nifti_read_subregion_image failed for file: "
-                         << this->GetFileName() );
+      free(data);
       }
+    throw;
     }
-  unsigned int pixelSize = this->m_NiftiImage->nbyper;
-  //
-  // if we're going to have to rescale pixels, and the on-disk
-  // pixel type is different than the pixel type reported to
-  // ImageFileReader, we have to up-promote the data to float
-  // before doing the rescale.
-  //
-  if ( this->MustRescale()
-       && this->m_ComponentType != this->m_OnDiskComponentType )
-    {
-    pixelSize =
-      static_cast< unsigned int >( this->GetNumberOfComponents() )
-      * static_cast< unsigned int >( sizeof( float ) );
-
-    // Deal with correct management of 64bits platforms
-    const size_t imageSizeInComponents =
-      static_cast< size_t >( this->GetImageSizeInComponents() );
 
-    //
-    // allocate new buffer for floats. Malloc instead of new to
-    // be consistent with allocation used in niftilib
-    float *_data =
-      static_cast< float * >
-      ( malloc( imageSizeInComponents * sizeof( float ) ) );
+  size_t componentSize = this->m_NiftiImage->nbyper;
+  const size_t regionComponents = numElts * numComponents;
+  if ( mustCast )
+    {
+    componentSize = sizeof( float );
+    float *_data = sameLayout ? static_cast< float * >( buffer )
+                   : static_cast< float * >( malloc( regionComponents * sizeof( float ) ) );
+    if ( _data == NULL )
+      {
+      free(data);
+      itkExceptionMacro( << "Failed to allocate memory to read file: " << this->GetFileName() );
+      }
     switch ( this->m_OnDiskComponentType )
       {
       case CHAR:
-        CastCopy< char >(_data, data, imageSizeInComponents);
+        CastCopy< char >(_data, data, regionComponents);
         break;
       case UCHAR:
-        CastCopy< unsigned char >(_data, data, imageSizeInComponents);
+        CastCopy< unsigned char >(_data, data, regionComponents);
         break;
       case SHORT:
-        CastCopy< short >(_data, data, imageSizeInComponents);
+        CastCopy< short >(_data, data, regionComponents);
         break;
       case USHORT:
-        CastCopy< unsigned short >(_data, data, imageSizeInComponents);
+        CastCopy< unsigned short >(_data, data, regionComponents);
         break;
       case INT:
-        CastCopy< int >(_data, data, imageSizeInComponents);
+        CastCopy< int >(_data, data, regionComponents);
         break;
       case UINT:
-        CastCopy< unsigned int >(_data, data, imageSizeInComponents);
+        CastCopy< unsigned int >(_data, data, regionComponents);
         break;
       case LONG:
-        CastCopy< long >(_data, data, imageSizeInComponents);
+        CastCopy< long >(_data, data, regionComponents);
         break;
       case ULONG:
-        CastCopy< unsigned long >(_data, data, imageSizeInComponents);
-        break;
-      case FLOAT:
-        itkExceptionMacro(<< "FLOAT pixels do not need Casting to float");
+        CastCopy< unsigned long >(_data, data, regionComponents);
         break;
-      case DOUBLE:
-        itkExceptionMacro(<< "DOUBLE pixels do not need Casting to float");
-        break;
-      case UNKNOWNCOMPONENTTYPE:
-        itkExceptionMacro(<< "Bad OnDiskComponentType UNKNOWNCOMPONENTTYPE");
-      }
-    //
-    // we're replacing the data pointer, so if it was allocated
-    // in nifti_read_subregion_image, free the old data here
-    if ( data != this->m_NiftiImage->data )
-      {
-      free(data);
+      default:
+        free(data);
+        if ( _data != buffer )
+          {
+          free(_data);
+          }
+        itkExceptionMacro(<< "Bad OnDiskComponentType for casting to float: "
+                          << this->m_OnDiskComponentType);
       }
+    free(data);
     data = _data;
     }
-  //
-  // if single or complex, nifti layout == itk layout
-  if ( numComponents == 1
-       || this->GetPixelType() == COMPLEX
-       || this->GetPixelType() == RGB
-       || this->GetPixelType() == RGBA )
-    {
-    const size_t NumBytes = numElts * pixelSize;
-    memcpy(buffer, data, NumBytes);
-    //
-    // if read_subregion was called it allocates a buffer that needs to be
-    // freed.
-    if ( data != this->m_NiftiImage->data )
-      {
-      free(data);
-      }
-    }
-  else
+
+  if ( !sameLayout )
     {
     // otherwise nifti is x y z t vec l m 0, itk is
     // vec x y z t l m o
-    const char *       niftibuf = (const char *)data;
-    char *             itkbuf = (char *)buffer;
-    const unsigned int rowdist = this->m_NiftiImage->dim[1];
-    const unsigned int slicedist = rowdist * this->m_NiftiImage->dim[2];
-    const unsigned int volumedist = slicedist * this->m_NiftiImage->dim[3];
-    const unsigned int seriesdist = volumedist * this->m_NiftiImage->dim[4];
+    const char * niftibuf = (const char *)data;
+    char *       itkbuf = (char *)buffer;
+    const size_t seriesdist = static_cast< size_t >( _size[0] ) * _size[1] * _size[2] * _size[3];
+    const size_t outerdist = static_cast< size_t >( _size[5] ) * _size[6];
     //
     // as per ITK bug 0007485
     // NIfTI is lower triangular, ITK is upper triangular.
@@ -626,35 +1182,24 @@ void NiftiImageIO::Read(void *buffer)
         vecOrder[i] = i;
         }
       }
-    for ( int t = 0; t < this->m_NiftiImage->dim[4]; t++ )
+    for ( size_t l = 0; l < outerdist; l++ )
       {
-      for ( int z = 0; z < this->m_NiftiImage->dim[3]; z++ )
+      for ( unsigned int c = 0; c < numComponents; c++ )
         {
-        for ( int y = 0; y < this->m_NiftiImage->dim[2]; y++ )
+        const char *from = niftibuf + ( l * numComponents + c ) * seriesdist * componentSize;
+        char *      to = itkbuf + ( l * seriesdist * numComponents + vecOrder[c] ) * componentSize;
+        for ( size_t p = 0; p < seriesdist; p++ )
           {
-          for ( int x = 0; x < this->m_NiftiImage->dim[1]; x++ )
-            {
-            for ( unsigned int c = 0; c < numComponents; c++ )
-              {
-              const unsigned int nifti_index =
-                ( c * seriesdist + volumedist * t + slicedist * z + rowdist * y + x ) * pixelSize;
-              const unsigned int itk_index =
-                ( ( volumedist * t + slicedist * z + rowdist * y + x ) * numComponents + vecOrder[c] ) * pixelSize;
-              memcpy(itkbuf + itk_index, niftibuf + nifti_index, pixelSize);
-              }
-            }
+          memcpy(to, from, componentSize);
+          from += componentSize;
+          to += numComponents * componentSize;
           }
         }
       }
     delete[] vecOrder;
     dumpdata(data);
     dumpdata(buffer);
-    // if read_subregion was called it allocates a buffer that needs to be
-    // freed.
-    if ( data != this->m_NiftiImage->data )
-      {
-      free(data);
-      }
+    free(data);
     }
 
   // If the scl_slope field is nonzero, then rescale each voxel value in the
@@ -0,0 +1,189 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkNiftiImageIOTest.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+// Region reads of compressed 4D and vector images, with and without
+// the index of the compressed data
+namespace
+{
+template< class TImage >
+bool ReadRegion(const std::string & fileName, const TImage *expected,
+                const typename TImage::RegionType & region, bool useIndex)
+{
+  typedef itk::ImageFileReader< TImage > ReaderType;
+  itk::NiftiImageIO::Pointer io = itk::NiftiImageIO::New();
+  io->SetUseCompressedDataIndex(useIndex);
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetImageIO(io);
+  reader->SetFileName(fileName);
+  reader->UpdateOutputInformation();
+  reader->GetOutput()->SetRequestedRegion(region);
+  reader->Update();
+
+  const TImage *image = reader->GetOutput();
+  if ( image->GetBufferedRegion() != region )
+    {
+    std::cerr << "Read " << image->GetBufferedRegion()
+              << " instead of " << region << std::endl;
+    return false;
+    }
+  itk::ImageRegionConstIterator< TImage > eit(expected, region);
+  itk::ImageRegionConstIterator< TImage > it(image, region);
+  for (; !eit.IsAtEnd(); ++eit, ++it )
+    {
+    if ( eit.Get() != it.Get() )
+      {
+      std::cerr << "Pixel " << it.GetIndex() << " of " << region
+                << ( useIndex ? " read with" : " read without" )
+                << " the index is " << it.Get()
+                << " instead of " << eit.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< class TImage >
+typename TImage::RegionType MakeRegion(const itk::IndexValueType *index,
+                                       const itk::SizeValueType *size)
+{
+  typename TImage::RegionType region;
+  for ( unsigned int i = 0; i < TImage::ImageDimension; i++ )
+    {
+    region.SetIndex(i, index[i]);
+    region.SetSize(i, size[i]);
+    }
+  return region;
+}
+}
+
+int itkNiftiImageIOTest12(int ac, char *av[])
+{
+  if ( ac < 2 )
+    {
+    std::cerr << "Usage: " << av[0] << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  itksys::SystemTools::ChangeDirectory(av[1]);
+
+  //
+  // a series of 40 volumes, several MB uncompressed so that the index
+  // has more than one access point
+  typedef itk::Image< short, 4 > SeriesType;
+  SeriesType::RegionType seriesRegion;
+  seriesRegion.SetSize(0, 64);
+  seriesRegion.SetSize(1, 48);
+  seriesRegion.SetSize(2, 20);
+  seriesRegion.SetSize(3, 40);
+  SeriesType::SpacingType seriesSpacing;
+  seriesSpacing.Fill(1.0);
+  SeriesType::Pointer series =
+    itk::IOTestHelper::AllocateImageFromRegionAndSpacing< SeriesType >(seriesRegion, seriesSpacing);
+
+  vnl_random randgen(12345678);
+  itk::ImageRegionIteratorWithIndex< SeriesType > sit(series, seriesRegion);
+  for (; !sit.IsAtEnd(); ++sit )
+    {
+    const SeriesType::IndexType & idx = sit.GetIndex();
+    sit.Set( static_cast< short >( idx[0] + idx[1] * 3 + idx[2] * 5 + idx[3] * 7
+                                   + randgen.lrand32(0, 15) ) );
+    }
+
+  const std::string seriesFileName("itkNiftiImageIOTest12Series.nii.gz");
+  itk::IOTestHelper::WriteImage< SeriesType, itk::NiftiImageIO >(series, seriesFileName);
+
+  const itk::IndexValueType seriesIndices[][4] =
+    { { 0, 0, 0, 37 },    // one of the last volumes
+      { 0, 0, 0, 3 },     // an earlier one, read after a later one
+      { 5, 7, 2, 10 },    // a box over several volumes
+      { 0, 20, 19, 39 },  // a single row at the very end
+      { 0, 0, 0, 0 } };   // everything
+  const itk::SizeValueType seriesSizes[][4] =
+    { { 64, 48, 20, 1 },
+      { 64, 48, 20, 1 },
+      { 30, 11, 9, 25 },
+      { 64, 1, 1, 1 },
+      { 64, 48, 20, 40 } };
+
+  //
+  // a 3D image of 3 component vectors, whose components nifti stores
+  // apart from each other
+  typedef itk::VectorImage< float, 3 > VectorImageType;
+  VectorImageType::RegionType vectorRegion;
+  vectorRegion.SetSize(0, 17);
+  vectorRegion.SetSize(1, 13);
+  vectorRegion.SetSize(2, 11);
+  VectorImageType::Pointer vectorImage = VectorImageType::New();
+  vectorImage->SetRegions(vectorRegion);
+  vectorImage->SetNumberOfComponentsPerPixel(3);
+  vectorImage->Allocate();
+  itk::ImageRegionIteratorWithIndex< VectorImageType > vit(vectorImage, vectorRegion);
+  for (; !vit.IsAtEnd(); ++vit )
+    {
+    const VectorImageType::IndexType & idx = vit.GetIndex();
+    VectorImageType::PixelType pixel(3);
+    for ( unsigned int c = 0; c < 3; c++ )
+      {
+      pixel[c] = idx[0] + idx[1] * 100.0f + idx[2] * 10000.0f + c * 0.25f;
+      }
+    vit.Set(pixel);
+    }
+
+  const std::string vectorFileName("itkNiftiImageIOTest12Vector.nii.gz");
+  itk::IOTestHelper::WriteImage< VectorImageType, itk::NiftiImageIO >(vectorImage, vectorFileName);
+
+  const itk::IndexValueType vectorIndex[3] = { 3, 4, 5 };
+  const itk::SizeValueType  vectorSize[3] = { 9, 6, 4 };
+
+  int status = EXIT_SUCCESS;
+  try
+    {
+    for ( unsigned int useIndex = 0; useIndex < 2; useIndex++ )
+      {
+      for ( unsigned int r = 0; r < sizeof( seriesSizes ) / sizeof( seriesSizes[0] ); r++ )
+        {
+        if ( !ReadRegion< SeriesType >(seriesFileName, series,
+                                       MakeRegion< SeriesType >(seriesIndices[r], seriesSizes[r]),
+                                       useIndex != 0) )
+          {
+          status = EXIT_FAILURE;
+          }
+        }
+      if ( !ReadRegion< VectorImageType >(vectorFileName, vectorImage,
+                                          MakeRegion< VectorImageType >(vectorIndex, vectorSize),
+                                          useIndex != 0) )
+        {
+        status = EXIT_FAILURE;
+        }
+      }
+    }
+  catch ( itk::ExceptionObject & err )
+    {
+    std::cerr << "itkNiftiImageIOTest12" << std::endl
+              << "Exception Object caught: " << std::endl
+              << err << std::endl;
+    status = EXIT_FAILURE;
+    }
+
+  itk::IOTestHelper::Remove( seriesFileName.c_str() );
+  itk::IOTestHelper::Remove( vectorFileName.c_str() );
+  return status;
+}
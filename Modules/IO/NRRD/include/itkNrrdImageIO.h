@@ -20,6 +20,7 @@
 
 
 #include "itkImageIOBase.h"
+#include "itkMultiThreader.h"
 #include <fstream>
 #include "NrrdIO.h"
 
@@ -65,6 +66,12 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   virtual void Read(void *buffer);
 
+  /** Determine if the pixel data can be mapped into memory. This is
+   * the case for raw encoded data in the byte order of this machine,
+   * stored after the header or in a single detached data file, and
+   * with any non-scalar axis being the fastest one. */
+  virtual bool CanMemoryMapRead(std::string & dataFileName, SizeType & dataOffset);
+
   /** Determine the file type. Returns true if this ImageIO can write the
    * file specified. */
   virtual bool CanWriteFile(const char *);
@@ -76,6 +83,19 @@ public:
    * that the IORegions has been set properly. */
   virtual void Write(const void *buffer);
 
+  /** Number of uncompressed bytes in each of the gzip members written
+   * when UseCompression is on. The members are compressed on several
+   * threads, and files made of them are also decompressed on several
+   * threads. Any gzip reader reads them as one stream. Must not exceed
+   * NumericTraits< int >::max(). Default is 0, which writes a single
+   * member as before. */
+  itkSetMacro(CompressionChunkSize, unsigned int);
+  itkGetConstMacro(CompressionChunkSize, unsigned int);
+
+  /** Get the multithreader used to compress and decompress the
+   * members. */
+  itkGetObjectMacro(MultiThreader, MultiThreader);
+
 protected:
   NrrdImageIO();
   ~NrrdImageIO();
@@ -90,6 +110,16 @@ protected:
 private:
   NrrdImageIO(const Self &);    //purposely not implemented
   void operator=(const Self &); //purposely not implemented
+
+  /** Location of raw pixel data found by ReadImageInformation. The
+   * file name is empty when the data can not be mapped. */
+  std::string m_RawDataFileName;
+  bool        m_RawDataIsAttached;
+  long int    m_RawDataByteSkip;
+
+  unsigned int m_CompressionChunkSize;
+
+  MultiThreader::Pointer m_MultiThreader;
 };
 } // end namespace itk
 
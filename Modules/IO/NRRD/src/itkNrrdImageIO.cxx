@@ -20,13 +20,32 @@
 #include "itkMetaDataObject.h"
 #include "itkIOCommon.h"
 #include "itkFloatingPointExceptions.h"
+#include "itkByteSwapper.h"
+#include "itkImageIOTaskQueue.h"
+#include "itksys/SystemTools.hxx"
+#include <fstream>
 
 namespace itk
 {
 #define KEY_PREFIX "NRRD_"
 
-NrrdImageIO::NrrdImageIO()
+namespace
 {
+// nrrdParallelFor running the tasks with a MultiThreader
+void NrrdImageIOParallelFor(nrrdTask task, void *taskData,
+                            unsigned int numberOfTasks, void *clientData)
+{
+  ImageIOTaskQueue::Execute(static_cast< MultiThreader * >( clientData ),
+                            task, taskData, numberOfTasks);
+}
+} // end anonymous namespace
+
+NrrdImageIO::NrrdImageIO():
+  m_RawDataIsAttached(false),
+  m_RawDataByteSkip(0),
+  m_CompressionChunkSize(0)
+{
+  m_MultiThreader = MultiThreader::New();
   this->SetNumberOfDimensions(3);
   this->AddSupportedWriteExtension(".nrrd");
   this->AddSupportedReadExtension(".nrrd");
@@ -53,6 +72,8 @@ bool NrrdImageIO::SupportsDimension(unsigned long dim)
 void NrrdImageIO::PrintSelf(std::ostream & os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "CompressionChunkSize: " << m_CompressionChunkSize << "\n";
+  os << indent << "MultiThreader: " << m_MultiThreader.GetPointer() << "\n";
 }
 
 ImageIOBase::IOComponentType
@@ -236,6 +257,8 @@ void NrrdImageIO::ReadImageInformation()
   Nrrd *       nrrd = nrrdNew();
   NrrdIoState *nio = nrrdIoStateNew();
 
+  m_RawDataFileName = "";
+
   // nrrd causes exceptions on purpose, so mask them
   bool saveFPEState(FloatingPointExceptions::GetExceptionAction());
   FloatingPointExceptions::Disable();
@@ -673,6 +696,31 @@ void NrrdImageIO::ReadImageInformation()
                                                                 msrFrame);
     }
 
+  // remember where raw pixel data is stored, for CanMemoryMapRead
+  if ( nio->encoding == nrrdEncodingRaw
+       && 0 == nio->lineSkip
+       && !nio->dataFNFormat
+       && nio->dataFNArr->len <= 1
+       && ( 0 == rangeAxisNum || 0 == rangeAxisIdx[0] )
+       && ImageIOBase::SYMMETRICSECONDRANKTENSOR != this->GetPixelType() )
+    {
+    m_RawDataIsAttached = 0 == nio->dataFNArr->len;
+    m_RawDataByteSkip = nio->byteSkip;
+    if ( m_RawDataIsAttached )
+      {
+      m_RawDataFileName = this->GetFileName();
+      }
+    else
+      {
+      // detached data files are relative to the header
+      m_RawDataFileName = nio->dataFN[0];
+      if ( !itksys::SystemTools::FileIsFullPath( m_RawDataFileName.c_str() ) && airStrlen(nio->path) )
+        {
+        m_RawDataFileName = std::string(nio->path) + "/" + m_RawDataFileName;
+        }
+      }
+    }
+
   nrrd = nrrdNix(nrrd);
   nio = nrrdIoStateNix(nio);
 }
@@ -723,14 +771,21 @@ void NrrdImageIO::Read(void *buffer)
   bool saveFPEState(FloatingPointExceptions::GetExceptionAction());
   FloatingPointExceptions::Disable();
 
+  // chunked gzip data is decompressed on several threads
+  NrrdIoState *nio = nrrdIoStateNew();
+  nio->parallelFor = NrrdImageIOParallelFor;
+  nio->parallelForData = m_MultiThreader.GetPointer();
+
   // Read in the nrrd.  Yes, this means that the header is being read
   // twice: once by NrrdImageIO::ReadImageInformation, and once here
-  if ( nrrdLoad(nrrd, this->GetFileName(), NULL) != 0 )
+  if ( nrrdLoad(nrrd, this->GetFileName(), nio) != 0 )
     {
+    nio = nrrdIoStateNix(nio);
     char *err =  biffGetDone(NRRD); // would be nice to free(err)
     itkExceptionMacro("Read: Error reading "
                       << this->GetFileName() << ":\n" << err);
     }
+  nio = nrrdIoStateNix(nio);
 
   // restore state
   FloatingPointExceptions::SetEnabled(saveFPEState);
@@ -811,6 +866,63 @@ void NrrdImageIO::Read(void *buffer)
     }
 }
 
+bool NrrdImageIO::CanMemoryMapRead(std::string & dataFileName, SizeType & dataOffset)
+{
+  if ( m_RawDataFileName.empty()
+       || !itksys::SystemTools::FileExists( m_RawDataFileName.c_str(), true ) )
+    {
+    return false;
+    }
+  if ( this->GetComponentSize() > 1
+       && ( this->GetByteOrder() == ImageIOBase::OrderNotApplicable
+            || ( this->GetByteOrder() == ImageIOBase::BigEndian ) != ByteSwapper< int >::SystemIsBigEndian() ) )
+    {
+    return false;
+    }
+
+  // the byte skip is applied after the header for attached data; a
+  // skip of -1 places the data at the end of the file
+  SizeType start = 0;
+  if ( m_RawDataByteSkip == -1 )
+    {
+    const SizeType fileSize =
+      static_cast< SizeType >( itksys::SystemTools::FileLength( m_RawDataFileName.c_str() ) );
+    start = fileSize - static_cast< SizeType >( this->GetImageSizeInBytes() );
+    }
+  else if ( m_RawDataByteSkip < 0 )
+    {
+    return false;
+    }
+  else
+    {
+    if ( m_RawDataIsAttached )
+      {
+      // the header ends with the first empty line
+      std::ifstream file( m_RawDataFileName.c_str(), std::ios::in | std::ios::binary );
+      std::string   line;
+      bool          found = false;
+      while ( !found && std::getline(file, line) )
+        {
+        found = line.empty() || line == "\r";
+        }
+      if ( !found )
+        {
+        return false;
+        }
+      start = static_cast< SizeType >( file.tellg() );
+      }
+    start += m_RawDataByteSkip;
+    }
+
+  if ( start < 0 )
+    {
+    return false;
+    }
+  dataFileName = m_RawDataFileName;
+  dataOffset = start;
+  return true;
+}
+
 bool NrrdImageIO::CanWriteFile(const char *name)
 {
   std::string filename = name;
@@ -1060,6 +1172,17 @@ void NrrdImageIO::Write(const void *buffer)
     {
     // this is necessarily gzip-compressed *raw* data
     nio->encoding = nrrdEncodingGzip;
+    // NrrdIO stores the chunk size as an int
+    if ( m_CompressionChunkSize > static_cast< unsigned int >( NumericTraits< int >::max() ) )
+      {
+      nrrdNix(nrrd);
+      nrrdIoStateNix(nio);
+      itkExceptionMacro( "CompressionChunkSize " << m_CompressionChunkSize
+                         << " is larger than " << NumericTraits< int >::max() );
+      }
+    nio->zlibChunkSize = static_cast< int >( m_CompressionChunkSize );
+    nio->parallelFor = NrrdImageIOParallelFor;
+    nio->parallelForData = m_MultiThreader.GetPointer();
     }
   else
     {
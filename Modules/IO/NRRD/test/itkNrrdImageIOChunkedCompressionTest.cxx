@@ -0,0 +1,251 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <fstream>
+#include <sstream>
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkNrrdImageIO.h"
+#include "itk_zlib.h"
+
+//
+//  Writes gzip compressed NRRD files in chunks on several threads,
+//  reads them back, and checks that a plain gzip reader reads the
+//  chunked data as one stream.
+//
+
+namespace
+{
+typedef short                             ChunkedPixelType;
+typedef itk::Image< ChunkedPixelType, 3 > ChunkedImageType;
+
+bool SameImages(const ChunkedImageType *expected, const ChunkedImageType *image)
+{
+  const ChunkedImageType::RegionType & region = expected->GetLargestPossibleRegion();
+  if ( image->GetBufferedRegion() != region )
+    {
+    std::cerr << "Read " << image->GetBufferedRegion() << std::endl;
+    return false;
+    }
+  itk::ImageRegionConstIterator< ChunkedImageType > eit(expected, region);
+  itk::ImageRegionConstIterator< ChunkedImageType > it(image, region);
+  for (; !eit.IsAtEnd(); ++eit, ++it )
+    {
+    if ( eit.Get() != it.Get() )
+      {
+      std::cerr << "Pixel " << it.GetIndex() << " is " << it.Get()
+                << " instead of " << eit.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+std::string ReadFileContents(const std::string & fileName)
+{
+  std::ifstream     file(fileName.c_str(), std::ios::in | std::ios::binary);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+// Number of gzip members carrying the chunk size
+unsigned int CountChunks(const std::string & fileName)
+{
+  const std::string contents = ReadFileContents(fileName);
+  const char        header[] = { '\x1f', '\x8b', '\x08', '\x04' };
+  const std::string memberHeader(header, 4);
+  unsigned int      count = 0;
+
+  for ( std::string::size_type pos = contents.find(memberHeader);
+        pos != std::string::npos;
+        pos = contents.find(memberHeader, pos + 1) )
+    {
+    if ( contents.compare(pos + 12, 2, "NC") == 0 )
+      {
+      ++count;
+      }
+    }
+  return count;
+}
+
+void WriteImage(const std::string & fileName, const ChunkedImageType *image,
+                itk::NrrdImageIO *io)
+{
+  typedef itk::ImageFileWriter< ChunkedImageType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetImageIO(io);
+  writer->SetInput(image);
+  writer->SetFileName(fileName);
+  writer->UseCompressionOn();
+  writer->Update();
+}
+
+int WriteAndRead(const std::string & fileName, const ChunkedImageType *image,
+                 unsigned int chunkSize, const std::string & dataFileName,
+                 unsigned int expectedChunks)
+{
+  itk::NrrdImageIO::Pointer io = itk::NrrdImageIO::New();
+  io->SetCompressionChunkSize(chunkSize);
+  io->GetMultiThreader()->SetNumberOfThreads(4);
+  WriteImage(fileName, image, io);
+
+  int                status = EXIT_SUCCESS;
+  const unsigned int chunks = CountChunks(dataFileName);
+  if ( chunks != expectedChunks )
+    {
+    std::cerr << dataFileName << " holds " << chunks << " chunks instead of "
+              << expectedChunks << std::endl;
+    status = EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< ChunkedImageType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  itk::NrrdImageIO::Pointer readIO = itk::NrrdImageIO::New();
+  readIO->GetMultiThreader()->SetNumberOfThreads(4);
+  reader->SetImageIO(readIO);
+  reader->SetFileName(fileName);
+  reader->Update();
+  if ( !SameImages( image, reader->GetOutput() ) )
+    {
+    std::cerr << "Reading " << fileName << " failed" << std::endl;
+    status = EXIT_FAILURE;
+    }
+  return status;
+}
+}
+
+int itkNrrdImageIOChunkedCompressionTest(int ac, char* av[])
+{
+  if ( ac < 2 )
+    {
+    std::cerr << "Usage: " << av[0] << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string outputDirectory(av[1]);
+
+  // compressible but not constant data
+  ChunkedImageType::Pointer  image = ChunkedImageType::New();
+  ChunkedImageType::SizeType size;
+  size[0] = 45;
+  size[1] = 50;
+  size[2] = 40;
+  image->SetRegions(size);
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< ChunkedImageType > it( image, image->GetLargestPossibleRegion() );
+  for (; !it.IsAtEnd(); ++it )
+    {
+    const ChunkedImageType::IndexType & index = it.GetIndex();
+    it.Set( static_cast< ChunkedPixelType >( ( index[0] * index[1] + 7 * index[2] ) % 1000 - 500 ) );
+    }
+  const unsigned int imageBytes = 45 * 50 * 40 * sizeof( ChunkedPixelType );
+
+  int status = EXIT_SUCCESS;
+  try
+    {
+    // chunks of 10000 bytes, the last one shorter
+    const std::string chunkedName = outputDirectory + "/NrrdChunkedCompression.nrrd";
+    if ( WriteAndRead(chunkedName, image, 10000, chunkedName,
+                      ( imageBytes + 9999 ) / 10000) != EXIT_SUCCESS )
+      {
+      status = EXIT_FAILURE;
+      }
+
+    // a single chunk
+    const std::string singleChunkName = outputDirectory + "/NrrdChunkedCompressionSingle.nrrd";
+    if ( WriteAndRead(singleChunkName, image, 1000000, singleChunkName, 1) != EXIT_SUCCESS )
+      {
+      status = EXIT_FAILURE;
+      }
+
+    // chunking disabled: one gzip member, as written by default
+    const std::string streamName = outputDirectory + "/NrrdChunkedCompressionOff.nrrd";
+    if ( WriteAndRead(streamName, image, 0, streamName, 0) != EXIT_SUCCESS )
+      {
+      status = EXIT_FAILURE;
+      }
+    const std::string defaultName = outputDirectory + "/NrrdChunkedCompressionDefault.nrrd";
+    WriteImage( defaultName, image, itk::NrrdImageIO::New() );
+    if ( ReadFileContents(defaultName) != ReadFileContents(streamName) )
+      {
+      std::cerr << defaultName << " differs from " << streamName << std::endl;
+      status = EXIT_FAILURE;
+      }
+
+    // a detached data file is plain gzip data, that zlib reads as one
+    // stream
+    const std::string detachedName = outputDirectory + "/NrrdChunkedCompression.nhdr";
+    const std::string detachedDataName = outputDirectory + "/NrrdChunkedCompression.raw.gz";
+    if ( WriteAndRead(detachedName, image, 4096, detachedDataName,
+                      ( imageBytes + 4095 ) / 4096) != EXIT_SUCCESS )
+      {
+      status = EXIT_FAILURE;
+      }
+    gzFile gzData = gzopen(detachedDataName.c_str(), "rb");
+    if ( !gzData )
+      {
+      std::cerr << "Cannot open " << detachedDataName << std::endl;
+      status = EXIT_FAILURE;
+      }
+    else
+      {
+      std::vector< ChunkedPixelType > data(imageBytes / sizeof( ChunkedPixelType ) + 1);
+      const int                       read = gzread(gzData, &data[0], imageBytes + 1);
+      gzclose(gzData);
+      if ( read != static_cast< int >( imageBytes )
+           || memcmp( &data[0], image->GetBufferPointer(), imageBytes ) != 0 )
+        {
+        std::cerr << "zlib read " << read << " bytes of " << detachedDataName
+                  << " instead of the " << imageBytes << " bytes of the image" << std::endl;
+        status = EXIT_FAILURE;
+        }
+      }
+
+    // chunk sizes NrrdIO cannot store are refused
+    bool caught = false;
+    try
+      {
+      itk::NrrdImageIO::Pointer io = itk::NrrdImageIO::New();
+      io->SetCompressionChunkSize( static_cast< unsigned int >( itk::NumericTraits< int >::max() ) + 1u );
+      WriteImage(outputDirectory + "/NrrdChunkedCompressionTooLarge.nrrd", image, io);
+      }
+    catch ( itk::ExceptionObject & e )
+      {
+      std::cout << "Caught expected exception: " << e.GetDescription() << std::endl;
+      caught = true;
+      }
+    if ( !caught )
+      {
+      std::cerr << "A chunk size larger than the largest int was accepted" << std::endl;
+      status = EXIT_FAILURE;
+      }
+    }
+  catch ( itk::ExceptionObject & e )
+    {
+    std::cerr << e << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if ( status == EXIT_SUCCESS )
+    {
+    std::cout << "Test PASSED !" << std::endl;
+    }
+  return status;
+}
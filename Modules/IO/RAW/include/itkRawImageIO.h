@@ -106,6 +106,10 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   virtual void Read(void *buffer);
 
+  /** Binary data in the byte order of this machine can be mapped
+   * into memory; it starts after the header. */
+  virtual bool CanMemoryMapRead(std::string & dataFileName, SizeType & dataOffset);
+
   /** Set/Get the Data mask. */
   itkGetConstReferenceMacro(ImageMask, unsigned short);
   void SetImageMask(unsigned long val)
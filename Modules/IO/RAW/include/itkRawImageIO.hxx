@@ -162,6 +162,26 @@ void RawImageIO< TPixel, VImageDimension >
   m_ManualHeaderSize = true;
 }
 
+template< class TPixel, unsigned int VImageDimension >
+bool RawImageIO< TPixel, VImageDimension >
+::CanMemoryMapRead(std::string & dataFileName, SizeType & dataOffset)
+{
+  if ( m_FileType != Binary || m_FileDimensionality != this->GetNumberOfDimensions() )
+    {
+    return false;
+    }
+  if ( this->GetComponentSize() > 1
+       && ( ( m_ByteOrder == LittleEndian && ByteSwapper< int >::SystemIsBigEndian() )
+            || ( m_ByteOrder == BigEndian && ByteSwapper< int >::SystemIsLittleEndian() ) ) )
+    {
+    return false;
+    }
+
+  dataFileName = m_FileName;
+  dataOffset = static_cast< SizeType >( this->GetHeaderSize() );
+  return true;
+}
+
 template< class TPixel, unsigned int VImageDimension >
 void RawImageIO< TPixel, VImageDimension >
 ::Read(void *buffer)
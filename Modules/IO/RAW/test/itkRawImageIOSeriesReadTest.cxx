@@ -0,0 +1,126 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <fstream>
+#include <sstream>
+#include "itkRawImageIO.h"
+#include "itkImageSeriesReader.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkByteSwapper.h"
+
+//
+//  Reads a series of raw files, which have a header and big endian
+//  pixels, with a RawImageIO configured for them, on one and on several
+//  read threads. The settings of the RawImageIO, which can not be found
+//  in the files, must be used for every slice.
+//
+
+int itkRawImageIOSeriesReadTest(int argc, char *argv[])
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+
+  typedef unsigned short                       PixelType;
+  typedef itk::Image< PixelType, 3 >           ImageType;
+  typedef itk::ImageSeriesReader< ImageType >  ReaderType;
+  typedef itk::RawImageIO< PixelType, 2 >      IOType;
+
+  const unsigned int width = 17;
+  const unsigned int height = 11;
+  const unsigned int numberOfSlices = 12;
+  const unsigned int headerSize = 64;
+
+  ReaderType::FileNamesContainer fileNames;
+  for ( unsigned int z = 0; z < numberOfSlices; z++ )
+    {
+    std::ostringstream name;
+    name << directory << "/itkRawImageIOSeriesReadTest" << z << ".raw";
+    fileNames.push_back( name.str() );
+
+    std::ofstream file(name.str().c_str(), std::ios::out | std::ios::binary);
+    const std::string header(headerSize, 'h');
+    file.write( header.c_str(), headerSize );
+    for ( unsigned int i = 0; i < width * height; i++ )
+      {
+      PixelType value = static_cast< PixelType >( z * 1000 + i );
+      itk::ByteSwapper< PixelType >::SwapFromSystemToBigEndian(&value);
+      file.write( reinterpret_cast< const char * >( &value ), sizeof( PixelType ) );
+      }
+    }
+
+  int                status = EXIT_SUCCESS;
+  const unsigned int readThreads[] = { 1, 4 };
+  for ( unsigned int c = 0; c < 2; c++ )
+    {
+    IOType::Pointer io = IOType::New();
+    io->SetFileTypeToBinary();
+    io->SetByteOrderToBigEndian();
+    io->SetHeaderSize(headerSize);
+    io->SetDimensions(0, width);
+    io->SetDimensions(1, height);
+
+    ReaderType::Pointer reader = ReaderType::New();
+    reader->SetImageIO(io);
+    reader->SetFileNames(fileNames);
+    reader->SetNumberOfReadThreads(readThreads[c]);
+    try
+      {
+      reader->Update();
+      }
+    catch ( itk::ExceptionObject & excp )
+      {
+      std::cerr << "Exception while reading the series on " << readThreads[c]
+                << " thread(s)" << std::endl;
+      std::cerr << excp << std::endl;
+      status = EXIT_FAILURE;
+      continue;
+      }
+
+    const ImageType::RegionType region = reader->GetOutput()->GetLargestPossibleRegion();
+    if ( region.GetSize(0) != width || region.GetSize(1) != height
+         || region.GetSize(2) != numberOfSlices )
+      {
+      std::cerr << "Read " << region << " on " << readThreads[c] << " thread(s)" << std::endl;
+      status = EXIT_FAILURE;
+      continue;
+      }
+    itk::ImageRegionConstIteratorWithIndex< ImageType > it(reader->GetOutput(), region);
+    for (; !it.IsAtEnd(); ++it )
+      {
+      const ImageType::IndexType & idx = it.GetIndex();
+      const PixelType expected = static_cast< PixelType >( idx[2] * 1000 + idx[1] * width + idx[0] );
+      if ( it.Get() != expected )
+        {
+        std::cerr << "Pixel " << idx << " read on " << readThreads[c] << " thread(s) is "
+                  << it.Get() << " instead of " << expected << std::endl;
+        status = EXIT_FAILURE;
+        break;
+        }
+      }
+    }
+
+  if ( status == EXIT_SUCCESS )
+    {
+    std::cout << "Test PASSED !" << std::endl;
+    }
+  return status;
+}
@@ -19,18 +19,29 @@
 #define __itkTIFFImageIO_h
 
 #include "itkImageIOBase.h"
+#include "itkMultiThreader.h"
 #include <fstream>
 
 namespace itk
 {
 //BTX
 class TIFFReaderInternal;
+class TIFFWriterInternal;
 //ETX
 
 /** \class TIFFImageIO
  *
  * \brief ImageIO object for reading and writing TIFF images
  *
+ * Uncompressed, PackBits and LZW encoded grayscale and RGB images
+ * stored top-left first can be read by region: only the strips or
+ * tiles, and pages, intersecting the requested region are decoded, on
+ * several threads. Such files can be streamed by ImageFileReader.
+ *
+ * When TileWidth and TileHeight are set, the image is written in tiles
+ * and can be written in pieces by ImageFileWriter, one band of tiles
+ * or set of pages at a time.
+ *
  * \ingroup IOFilters
  *
  * \ingroup ITKIOTIFF
@@ -71,6 +82,22 @@ public:
   /** Reads 3D data from tiled tiff. */
   virtual void ReadTiles(void *buffer);
 
+  /** Reads the IORegion by decoding only the strips or tiles of the
+   * pages that intersect it. */
+  virtual void ReadRegion(void *buffer);
+
+  /** Returns true when the file last passed to ReadImageInformation
+   * can be read by region. */
+  virtual bool CanStreamRead()
+  {
+    return m_CanStreamRead;
+  }
+
+  /** Returns the requested region when streamed reading is on and the
+   * file can be read by region, and the whole image otherwise. */
+  virtual ImageIORegion
+  GenerateStreamableReadRegionFromRequestedRegion(const ImageIORegion & requested) const;
+
   /*-------- This part of the interfaces deals with writing data. ----- */
 
   /** Determine the file type. Returns true if this ImageIO can read the
@@ -82,9 +109,39 @@ public:
   virtual void WriteImageInformation();
 
   /** Writes the data to disk from the memory buffer provided. Make sure
-   * that the IORegion has been set properly. */
+   * that the IORegion has been set properly. When writing tiles, the
+   * IORegions must be the pieces returned by GetSplitRegionForWriting,
+   * written in order. */
   virtual void Write(const void *buffer);
 
+  /** Returns true when tiles are written. */
+  virtual bool CanStreamWrite()
+  {
+    return m_TileWidth > 0 && m_TileHeight > 0;
+  }
+
+  /** When writing tiles, split the image into bands of whole tile rows
+   * of a page, or into sets of whole pages. Pasting is not supported. */
+  virtual unsigned int GetActualNumberOfSplitsForWriting(unsigned int numberOfRequestedSplits,
+                                                         const ImageIORegion & pasteRegion,
+                                                         const ImageIORegion & largestPossibleRegion);
+
+  virtual ImageIORegion GetSplitRegionForWriting(unsigned int ithPiece,
+                                                 unsigned int numberOfActualSplits,
+                                                 const ImageIORegion & pasteRegion,
+                                                 const ImageIORegion & largestPossibleRegion);
+
+  /** Size of the tiles written, in pixels. Both must be multiples of
+   * 16. When either is 0, the image is written in strips. Default is
+   * 0. */
+  itkSetMacro(TileWidth, unsigned int);
+  itkGetConstMacro(TileWidth, unsigned int);
+  itkSetMacro(TileHeight, unsigned int);
+  itkGetConstMacro(TileHeight, unsigned int);
+
+  /** Get the multithreader used to decode the strips and tiles. */
+  itkGetObjectMacro(MultiThreader, MultiThreader);
+
   enum { NOFORMAT, RGB_, GRAYSCALE, PALETTE_RGB, PALETTE_GRAYSCALE, OTHER };
 
   //BTX
@@ -131,6 +188,11 @@ protected:
 
   void InternalWrite(const void *buffer);
 
+  /** Record the directory of each page when the strips and tiles of
+   * all of them can be copied as they are into the output. Returns
+   * false when the file can only be read whole. */
+  bool InitializePageDirectoryOffsets();
+
   void InitializeColors();
 
   void ReadGenericImage(void *out,
@@ -157,6 +219,8 @@ protected:
 
   TIFFReaderInternal *m_InternalImage;
 
+  TIFFWriterInternal *m_InternalWriter;
+
   int m_Compression;
 private:
   TIFFImageIO(const Self &);    //purposely not implemented
@@ -167,6 +231,14 @@ private:
   unsigned short *m_ColorBlue;
   int             m_TotalColors;
   unsigned int    m_ImageFormat;
+
+  bool                    m_CanStreamRead;
+  std::vector< uint64_t > m_PageDirectoryOffsets;
+
+  unsigned int m_TileWidth;
+  unsigned int m_TileHeight;
+
+  MultiThreader::Pointer m_MultiThreader;
 };
 } // end namespace itk
 
@@ -17,9 +17,13 @@
  *=========================================================================*/
 
 #include "itkTIFFImageIO.h"
+#include "itkMath.h"
+#include "itkSimpleFastMutexLock.h"
 #include "itksys/SystemTools.hxx"
 
 #include <sys/stat.h>
+#include <algorithm>
+#include <cstring>
 
 #include "itk_tiff.h"
 
@@ -268,6 +272,150 @@ int TIFFReaderInternal::CanRead()
            && ( this->m_BitsPerSample == 8 || this->m_BitsPerSample == 16 ) );
 }
 
+/** The TIFF being written while its tiles are written in pieces */
+class TIFFWriterInternal
+{
+public:
+  TIFFWriterInternal():m_Image(NULL), m_NextPage(0), m_NextRow(0) {}
+
+  void Clean()
+  {
+    if ( this->m_Image )
+      {
+      TIFFClose(this->m_Image);
+      }
+    this->m_Image = NULL;
+    this->m_NextPage = 0;
+    this->m_NextRow = 0;
+  }
+
+  TIFF *       m_Image;
+  unsigned int m_NextPage;
+  unsigned int m_NextRow;
+};
+
+namespace
+{
+// A strip or tile of a page to decode into the IORegion
+struct TIFFImageIOChunk {
+  uint64       DirectoryOffset;
+  unsigned int Page;
+  uint32       Index;
+  bool         Tiled;
+  uint32       X;
+  uint32       Y;
+  uint32       Width;
+  uint32       Height;
+};
+
+struct TIFFImageIORegionThreadStruct {
+  std::string                       FileName;
+  const std::vector< TIFFImageIOChunk > *Chunks;
+  const ImageIORegion *             Region;
+  unsigned char *                   Buffer;
+  size_t                            PixelSize;
+  SimpleFastMutexLock               Lock;
+  size_t                            NextChunk;
+  std::string                       Error;
+};
+
+ITK_THREAD_RETURN_TYPE TIFFImageIORegionThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  TIFFImageIORegionThreadStruct *str =
+    static_cast< TIFFImageIORegionThreadStruct * >( info->UserData );
+
+  const ImageIORegion & region = *str->Region;
+  const uint32 x0 = region.GetIndex(0);
+  const uint32 y0 = region.GetIndex(1);
+  const uint32 x1 = x0 + region.GetSize(0);
+  const uint32 y1 = y0 + region.GetSize(1);
+  const unsigned int z0 = region.GetImageDimension() > 2 ? region.GetIndex(2) : 0;
+
+  // libtiff handles cannot be shared between threads, so each thread
+  // opens its own once it gets a chunk
+  TIFF *                       tif = NULL;
+  uint64                       directoryOffset = 0;
+  std::vector< unsigned char > chunkBuffer;
+
+  for (;; )
+    {
+    str->Lock.Lock();
+    if ( !str->Error.empty() || str->NextChunk >= str->Chunks->size() )
+      {
+      str->Lock.Unlock();
+      break;
+      }
+    const TIFFImageIOChunk & chunk = ( *str->Chunks )[str->NextChunk++];
+    str->Lock.Unlock();
+
+    std::string error;
+    if ( !tif )
+      {
+      tif = TIFFOpen(str->FileName.c_str(), "r");
+      if ( !tif )
+        {
+        error = "Cannot open file " + str->FileName;
+        }
+      }
+    if ( tif && directoryOffset != chunk.DirectoryOffset )
+      {
+      if ( TIFFSetSubDirectory(tif, chunk.DirectoryOffset) )
+        {
+        directoryOffset = chunk.DirectoryOffset;
+        }
+      else
+        {
+        error = "Cannot read the directory of a page";
+        }
+      }
+    if ( error.empty() )
+      {
+      const tmsize_t chunkSize = chunk.Tiled ? TIFFTileSize(tif) : TIFFStripSize(tif);
+      chunkBuffer.resize(chunkSize);
+      const tmsize_t bytesRead = chunk.Tiled
+                                 ? TIFFReadEncodedTile(tif, chunk.Index, &chunkBuffer[0], chunkSize)
+                                 : TIFFReadEncodedStrip(tif, chunk.Index, &chunkBuffer[0], chunkSize);
+      if ( bytesRead < 0 )
+        {
+        error = chunk.Tiled ? "Cannot read a tile" : "Cannot read a strip";
+        }
+      }
+    if ( !error.empty() )
+      {
+      str->Lock.Lock();
+      str->Error = error;
+      str->Lock.Unlock();
+      break;
+      }
+
+    // copy the part of the chunk inside the region
+    const uint32 cx0 = std::max(x0, chunk.X);
+    const uint32 cx1 = std::min(x1, chunk.X + chunk.Width);
+    const uint32 cy0 = std::max(y0, chunk.Y);
+    const uint32 cy1 = std::min(y1, chunk.Y + chunk.Height);
+    const size_t lineSize = ( cx1 - cx0 ) * str->PixelSize;
+    for ( uint32 y = cy0; y < cy1; ++y )
+      {
+      const unsigned char *source = &chunkBuffer[0]
+                                    + ( ( y - chunk.Y ) * static_cast< size_t >( chunk.Width )
+                                        + ( cx0 - chunk.X ) ) * str->PixelSize;
+      unsigned char *destination = str->Buffer
+                                   + ( ( ( chunk.Page - z0 ) * static_cast< size_t >( y1 - y0 ) + ( y - y0 ) )
+                                       * ( x1 - x0 ) + ( cx0 - x0 ) ) * str->PixelSize;
+      memcpy(destination, source, lineSize);
+      }
+    }
+
+  if ( tif )
+    {
+    TIFFClose(tif);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+} // end anonymous namespace
+
 bool TIFFImageIO::CanReadFile(const char *file)
 {
   // First check the extension
@@ -1281,6 +1429,175 @@ void TIFFImageIO::ReadVolume(void *buffer)
     }
 }
 
+/** Read the IORegion from the strips or tiles intersecting it */
+void TIFFImageIO::ReadRegion(void *buffer)
+{
+  const ImageIORegion & region = this->GetIORegion();
+  const uint32          x0 = region.GetIndex(0);
+  const uint32          y0 = region.GetIndex(1);
+  const uint32          x1 = x0 + region.GetSize(0);
+  const uint32          y1 = y0 + region.GetSize(1);
+  unsigned int          z0 = 0;
+  unsigned int          z1 = 1;
+
+  if ( region.GetImageDimension() > 2 )
+    {
+    z0 = region.GetIndex(2);
+    z1 = z0 + region.GetSize(2);
+    }
+  if ( x1 > m_InternalImage->m_Width || y1 > m_InternalImage->m_Height
+       || z1 > m_PageDirectoryOffsets.size() )
+    {
+    itkExceptionMacro(<< "The region " << region << " is outside of the image");
+    }
+
+  // List the strips or tiles to decode, page after page
+  TIFF *                          tif = m_InternalImage->m_Image;
+  std::vector< TIFFImageIOChunk > chunks;
+  for ( unsigned int page = z0; page < z1; ++page )
+    {
+    if ( !TIFFSetSubDirectory(tif, m_PageDirectoryOffsets[page]) )
+      {
+      itkExceptionMacro(<< "Cannot read the directory of page " << page);
+      }
+
+    TIFFImageIOChunk chunk;
+    chunk.DirectoryOffset = m_PageDirectoryOffsets[page];
+    chunk.Page = page;
+    chunk.Tiled = TIFFIsTiled(tif) != 0;
+    if ( chunk.Tiled )
+      {
+      TIFFGetField(tif, TIFFTAG_TILEWIDTH, &chunk.Width);
+      TIFFGetField(tif, TIFFTAG_TILELENGTH, &chunk.Height);
+      }
+    else
+      {
+      chunk.Width = m_InternalImage->m_Width;
+      TIFFGetFieldDefaulted(tif, TIFFTAG_ROWSPERSTRIP, &chunk.Height);
+      chunk.Height = std::min(chunk.Height, m_InternalImage->m_Height);
+      }
+    if ( chunk.Width == 0 || chunk.Height == 0 )
+      {
+      itkExceptionMacro(<< "Invalid strip or tile size in page " << page);
+      }
+
+    for ( uint32 y = y0 - y0 % chunk.Height; y < y1; y += chunk.Height )
+      {
+      for ( uint32 x = x0 - x0 % chunk.Width; x < x1; x += chunk.Width )
+        {
+        chunk.X = x;
+        chunk.Y = y;
+        chunk.Index = chunk.Tiled ? TIFFComputeTile(tif, x, y, 0, 0) : TIFFComputeStrip(tif, y, 0);
+        chunks.push_back(chunk);
+        }
+      }
+    }
+
+  TIFFImageIORegionThreadStruct str;
+  str.FileName = m_FileName;
+  str.Chunks = &chunks;
+  str.Region = &region;
+  str.Buffer = static_cast< unsigned char * >( buffer );
+  str.PixelSize = this->GetComponentSize() * this->GetNumberOfComponents();
+  str.NextChunk = 0;
+
+  m_MultiThreader->SetSingleMethod(TIFFImageIORegionThreaderCallback, &str);
+  m_MultiThreader->SingleMethodExecute();
+
+  if ( !str.Error.empty() )
+    {
+    itkExceptionMacro(<< "Error while reading " << m_FileName << ": " << str.Error);
+    }
+}
+
+bool TIFFImageIO::InitializePageDirectoryOffsets()
+{
+  m_PageDirectoryOffsets.clear();
+
+  // The samples are copied as they are, so only the layouts that
+  // ReadGenericImage and ReadVolume would copy unchanged qualify
+  TIFFReaderInternal *ri = m_InternalImage;
+  if ( !ri->CanRead() || ri->m_NumberOfTiles > 0
+       || ri->m_Orientation != ORIENTATION_TOPLEFT
+       || !( ( ri->m_SamplesPerPixel == 1 && ri->m_Photometrics == PHOTOMETRIC_MINISBLACK )
+             || ( ri->m_SamplesPerPixel == 3 && ri->m_Photometrics == PHOTOMETRIC_RGB ) ) )
+    {
+    return false;
+    }
+
+  const size_t numberOfPages = m_NumberOfDimensions > 2 ? m_Dimensions[2] : 1;
+  TIFF *       tif = ri->m_Image;
+  bool         canRead = true;
+
+  for ( unsigned int dir = 0;
+        canRead && m_PageDirectoryOffsets.size() < numberOfPages
+        && dir < TIFFNumberOfDirectories(tif); ++dir )
+    {
+    if ( !TIFFSetDirectory(tif, static_cast< tdir_t >( dir ) ) )
+      {
+      canRead = false;
+      break;
+      }
+
+    int32 subfiletype = 0;
+    if ( TIFFGetField(tif, TIFFTAG_SUBFILETYPE, &subfiletype)
+         && ( subfiletype & FILETYPE_REDUCEDIMAGE || subfiletype & FILETYPE_MASK ) )
+      {
+      continue;
+      }
+
+    uint32         width = 0;
+    uint32         height = 0;
+    unsigned short samplesPerPixel, bitsPerSample, compression, planarConfig;
+    unsigned short orientation, photometric = 0;
+    short          sampleFormat;
+    TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width);
+    TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height);
+    TIFFGetField(tif, TIFFTAG_PHOTOMETRIC, &photometric);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &samplesPerPixel);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_BITSPERSAMPLE, &bitsPerSample);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_COMPRESSION, &compression);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_PLANARCONFIG, &planarConfig);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_ORIENTATION, &orientation);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLEFORMAT, &sampleFormat);
+
+    canRead = width == ri->m_Width && height == ri->m_Height
+              && samplesPerPixel == ri->m_SamplesPerPixel
+              && bitsPerSample == ri->m_BitsPerSample
+              && photometric == ri->m_Photometrics
+              && planarConfig == PLANARCONFIG_CONTIG
+              && orientation == ORIENTATION_TOPLEFT
+              && sampleFormat == ri->m_SampleFormat
+              && ( compression == COMPRESSION_NONE
+                   || compression == COMPRESSION_PACKBITS
+                   || compression == COMPRESSION_LZW );
+    if ( canRead )
+      {
+      m_PageDirectoryOffsets.push_back( TIFFCurrentDirOffset(tif) );
+      }
+    }
+
+  // Set the directory back to the first image for the other readers
+  TIFFSetDirectory(tif, 0);
+
+  if ( !canRead || m_PageDirectoryOffsets.size() != numberOfPages )
+    {
+    m_PageDirectoryOffsets.clear();
+    return false;
+    }
+  return true;
+}
+
+ImageIORegion
+TIFFImageIO::GenerateStreamableReadRegionFromRequestedRegion(const ImageIORegion & requested) const
+{
+  if ( m_UseStreamedReading && m_CanStreamRead )
+    {
+    return requested;
+    }
+  return Superclass::GenerateStreamableReadRegionFromRequestedRegion(requested);
+}
+
 void TIFFImageIO::Read(void *buffer)
 {
 
@@ -1300,6 +1617,13 @@ void TIFFImageIO::Read(void *buffer)
     return;
     }
 
+  if ( m_CanStreamRead )
+    {
+    this->ReadRegion(buffer);
+    m_InternalImage->Clean();
+    return;
+    }
+
   // The IO region should be of dimensions 3 otherwise we read only the first
   // page
   if ( m_InternalImage->m_NumberOfPages > 0 && this->GetIORegion().GetImageDimension() > 2 )
@@ -1402,6 +1726,12 @@ TIFFImageIO::TIFFImageIO()
 
   m_Compression = TIFFImageIO::PackBits;
 
+  m_InternalWriter = new TIFFWriterInternal;
+  m_CanStreamRead = false;
+  m_TileWidth = 0;
+  m_TileHeight = 0;
+  m_MultiThreader = MultiThreader::New();
+
   this->AddSupportedWriteExtension(".tif");
   this->AddSupportedWriteExtension(".TIF");
   this->AddSupportedWriteExtension(".tiff");
@@ -1417,12 +1747,17 @@ TIFFImageIO::~TIFFImageIO()
 {
   m_InternalImage->Clean();
   delete m_InternalImage;
+  m_InternalWriter->Clean();
+  delete m_InternalWriter;
 }
 
 void TIFFImageIO::PrintSelf(std::ostream & os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "Compression: " << m_Compression << "\n";
+  os << indent << "TileWidth: " << m_TileWidth << "\n";
+  os << indent << "TileHeight: " << m_TileHeight << "\n";
+  os << indent << "MultiThreader: " << m_MultiThreader.GetPointer() << "\n";
 }
 
 void TIFFImageIO::InitializeColors()
@@ -1562,6 +1897,8 @@ void TIFFImageIO::ReadImageInformation()
     m_Origin[2] = 0.0;
     }
 
+  m_CanStreamRead = this->InitializePageDirectoryOffsets();
+
   return;
 }
 
@@ -1661,6 +1998,38 @@ void TIFFImageIO::InternalWrite(const void *buffer)
 
   int predictor;
 
+  // The rows and pages written by this call. Tiles can be written in
+  // several calls, one piece from GetSplitRegionForWriting at a time.
+  const bool   tiled = this->CanStreamWrite();
+  unsigned int firstRow = 0;
+  unsigned int lastRow = height;
+  unsigned int firstPage = 0;
+  unsigned int lastPage = pages;
+
+  if ( tiled )
+    {
+    if ( m_TileWidth % 16 != 0 || m_TileHeight % 16 != 0 )
+      {
+      itkExceptionMacro(<< "TIFF tile width and height must be multiples of 16, not "
+                        << m_TileWidth << " and " << m_TileHeight);
+      }
+    firstRow = m_IORegion.GetIndex(1);
+    lastRow = firstRow + m_IORegion.GetSize(1);
+    if ( m_NumberOfDimensions == 3 )
+      {
+      firstPage = m_IORegion.GetIndex(2);
+      lastPage = firstPage + m_IORegion.GetSize(2);
+      }
+    if ( m_IORegion.GetIndex(0) != 0 || m_IORegion.GetSize(0) != width
+         || firstRow % m_TileHeight != 0
+         || ( lastRow % m_TileHeight != 0 && lastRow != height )
+         || ( lastPage - firstPage > 1 && ( firstRow != 0 || lastRow != height ) ) )
+      {
+      itkExceptionMacro(<< "TIFF tiles can only be written in bands of whole tile rows of a page"
+                        << " or in whole pages, not in the region " << m_IORegion);
+      }
+    }
+
   const char *mode = "w";
 
   // If the size of the image if greater then 2GB then use big tiff
@@ -1676,127 +2045,158 @@ void TIFFImageIO::InternalWrite(const void *buffer)
     }
 
 
-  TIFF *tif = TIFFOpen(m_FileName.c_str(), mode );
-  if ( !tif )
-    {
-    itkExceptionMacro( "Error while trying to open file for writing: "
-                       << this->GetFileName()
-                       << std::endl
-                       << "Reason: "
-                       << itksys::SystemTools::GetLastSystemError() );
-    }
+  TIFF *tif = m_InternalWriter->m_Image;
 
-  if ( this->GetComponentType() == SHORT
-       || this->GetComponentType() == CHAR )
+  if ( firstPage == 0 && firstRow == 0 )
     {
-    TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_INT);
-    }
+    m_InternalWriter->Clean();
 
-  uint32 w = width;
-  uint32 h = height;
+    tif = TIFFOpen(m_FileName.c_str(), mode );
+    if ( !tif )
+      {
+      itkExceptionMacro( "Error while trying to open file for writing: "
+                         << this->GetFileName()
+                         << std::endl
+                         << "Reason: "
+                         << itksys::SystemTools::GetLastSystemError() );
+      }
+    m_InternalWriter->m_Image = tif;
 
-  if ( m_NumberOfDimensions == 3 )
-    {
-    TIFFCreateDirectory(tif);
-    }
-  for ( page = 0; page < pages; page++ )
-    {
-    TIFFSetDirectory(tif, page);
-    TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, w);
-    TIFFSetField(tif, TIFFTAG_IMAGELENGTH, h);
-    TIFFSetField(tif, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
-    TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, scomponents);
-    TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, bps); // Fix for stype
-    TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
     if ( this->GetComponentType() == SHORT
          || this->GetComponentType() == CHAR )
       {
       TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_INT);
       }
-    TIFFSetField(tif, TIFFTAG_SOFTWARE, "InsightToolkit");
 
-    if ( scomponents > 3 )
+    if ( m_NumberOfDimensions == 3 )
       {
-      // if number of scalar components is greater than 3, that means we assume
-      // there is alpha.
-      uint16  extra_samples = scomponents - 3;
-      uint16 *sample_info = new uint16[scomponents - 3];
-      sample_info[0] = EXTRASAMPLE_ASSOCALPHA;
-      int cc;
-      for ( cc = 1; cc < scomponents - 3; cc++ )
-        {
-        sample_info[cc] = EXTRASAMPLE_UNSPECIFIED;
-        }
-      TIFFSetField(tif, TIFFTAG_EXTRASAMPLES, extra_samples,
-                   sample_info);
-      delete[] sample_info;
+      TIFFCreateDirectory(tif);
       }
+    }
+  else if ( !tif || firstPage != m_InternalWriter->m_NextPage
+            || firstRow != m_InternalWriter->m_NextRow )
+    {
+    itkExceptionMacro(<< "The tiles of " << m_FileName
+                      << " must be written in order, starting from the first page");
+    }
 
-    int compression;
+  uint32 w = width;
+  uint32 h = height;
 
-    if ( m_UseCompression )
+  for ( page = firstPage; page < lastPage; page++ )
+    {
+    const unsigned int pageFirstRow = ( page == firstPage ) ? firstRow : 0;
+    const unsigned int pageLastRow = ( page == lastPage - 1 ) ? lastRow : height;
+
+    // The fields of a page are set before its first row is written
+    if ( pageFirstRow == 0 )
       {
-      switch ( m_Compression )
+      TIFFSetDirectory(tif, page);
+      TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, w);
+      TIFFSetField(tif, TIFFTAG_IMAGELENGTH, h);
+      TIFFSetField(tif, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
+      TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, scomponents);
+      TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, bps); // Fix for stype
+      TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+      if ( this->GetComponentType() == SHORT
+           || this->GetComponentType() == CHAR )
         {
-        case TIFFImageIO::PackBits:
-          compression = COMPRESSION_PACKBITS; break;
-        case TIFFImageIO::JPEG:
-          compression = COMPRESSION_JPEG; break;
-        case TIFFImageIO::Deflate:
-          compression = COMPRESSION_DEFLATE; break;
-        case TIFFImageIO::LZW:
-          compression = COMPRESSION_LZW; break;
-        default:
-          compression = COMPRESSION_NONE;
+        TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_INT);
+        }
+      TIFFSetField(tif, TIFFTAG_SOFTWARE, "InsightToolkit");
+
+      if ( scomponents > 3 )
+        {
+        // if number of scalar components is greater than 3, that means we assume
+        // there is alpha.
+        uint16  extra_samples = scomponents - 3;
+        uint16 *sample_info = new uint16[scomponents - 3];
+        sample_info[0] = EXTRASAMPLE_ASSOCALPHA;
+        int cc;
+        for ( cc = 1; cc < scomponents - 3; cc++ )
+          {
+          sample_info[cc] = EXTRASAMPLE_UNSPECIFIED;
+          }
+        TIFFSetField(tif, TIFFTAG_EXTRASAMPLES, extra_samples,
+                     sample_info);
+        delete[] sample_info;
         }
-      }
-    else
-      {
-      compression = COMPRESSION_NONE;
-      }
 
-    TIFFSetField(tif, TIFFTAG_COMPRESSION, compression); // Fix for compression
+      int compression;
 
-    uint16 photometric = ( scomponents == 1 ) ? PHOTOMETRIC_MINISBLACK : PHOTOMETRIC_RGB;
+      if ( m_UseCompression )
+        {
+        switch ( m_Compression )
+          {
+          case TIFFImageIO::PackBits:
+            compression = COMPRESSION_PACKBITS; break;
+          case TIFFImageIO::JPEG:
+            compression = COMPRESSION_JPEG; break;
+          case TIFFImageIO::Deflate:
+            compression = COMPRESSION_DEFLATE; break;
+          case TIFFImageIO::LZW:
+            compression = COMPRESSION_LZW; break;
+          default:
+            compression = COMPRESSION_NONE;
+          }
+        }
+      else
+        {
+        compression = COMPRESSION_NONE;
+        }
 
-    if ( compression == COMPRESSION_JPEG )
-      {
-      TIFFSetField(tif, TIFFTAG_JPEGQUALITY, 75); // Parameter
-      TIFFSetField(tif, TIFFTAG_JPEGCOLORMODE, JPEGCOLORMODE_RGB);
-      photometric = PHOTOMETRIC_YCBCR;
-      }
-    else if ( compression == COMPRESSION_LZW )
-      {
-      predictor = 2;
-      TIFFSetField(tif, TIFFTAG_PREDICTOR, predictor);
-      itkDebugMacro(<< "LZW compression is patented outside US so it is disabled");
-      }
-    else if ( compression == COMPRESSION_DEFLATE )
-      {
-      predictor = 2;
-      TIFFSetField(tif, TIFFTAG_PREDICTOR, predictor);
-      }
+      TIFFSetField(tif, TIFFTAG_COMPRESSION, compression); // Fix for compression
 
-    TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, photometric); // Fix for scomponents
+      uint16 photometric = ( scomponents == 1 ) ? PHOTOMETRIC_MINISBLACK : PHOTOMETRIC_RGB;
 
-    TIFFSetField( tif,
-                  TIFFTAG_ROWSPERSTRIP,
-                  TIFFDefaultStripSize(tif, rowsperstrip) );
+      if ( compression == COMPRESSION_JPEG )
+        {
+        TIFFSetField(tif, TIFFTAG_JPEGQUALITY, 75); // Parameter
+        TIFFSetField(tif, TIFFTAG_JPEGCOLORMODE, JPEGCOLORMODE_RGB);
+        photometric = PHOTOMETRIC_YCBCR;
+        }
+      else if ( compression == COMPRESSION_LZW )
+        {
+        predictor = 2;
+        TIFFSetField(tif, TIFFTAG_PREDICTOR, predictor);
+        itkDebugMacro(<< "LZW compression is patented outside US so it is disabled");
+        }
+      else if ( compression == COMPRESSION_DEFLATE )
+        {
+        predictor = 2;
+        TIFFSetField(tif, TIFFTAG_PREDICTOR, predictor);
+        }
 
-    if ( resolution_x > 0 && resolution_y > 0 )
-     {
-     TIFFSetField(tif, TIFFTAG_XRESOLUTION, resolution_x);
-     TIFFSetField(tif, TIFFTAG_YRESOLUTION, resolution_y);
-     TIFFSetField(tif, TIFFTAG_RESOLUTIONUNIT, RESUNIT_INCH);
-     }
+      TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, photometric); // Fix for scomponents
 
-    if ( m_NumberOfDimensions == 3 )
-      {
-      // We are writing single page of the multipage file
-      TIFFSetField(tif, TIFFTAG_SUBFILETYPE, FILETYPE_PAGE);
-      // Set the page number
-      TIFFSetField(tif, TIFFTAG_PAGENUMBER, page, pages);
+      if ( tiled )
+        {
+        TIFFSetField(tif, TIFFTAG_TILEWIDTH, m_TileWidth);
+        TIFFSetField(tif, TIFFTAG_TILELENGTH, m_TileHeight);
+        }
+      else
+        {
+        TIFFSetField( tif,
+                      TIFFTAG_ROWSPERSTRIP,
+                      TIFFDefaultStripSize(tif, rowsperstrip) );
+        }
+
+      if ( resolution_x > 0 && resolution_y > 0 )
+       {
+       TIFFSetField(tif, TIFFTAG_XRESOLUTION, resolution_x);
+       TIFFSetField(tif, TIFFTAG_YRESOLUTION, resolution_y);
+       TIFFSetField(tif, TIFFTAG_RESOLUTIONUNIT, RESUNIT_INCH);
+       }
+
+      if ( m_NumberOfDimensions == 3 )
+        {
+        // We are writing single page of the multipage file
+        TIFFSetField(tif, TIFFTAG_SUBFILETYPE, FILETYPE_PAGE);
+        // Set the page number
+        TIFFSetField(tif, TIFFTAG_PAGENUMBER, page, pages);
+        }
       }
+
     int rowLength; // in bytes
 
     switch ( this->GetComponentType() )
@@ -1821,24 +2221,155 @@ void TIFFImageIO::InternalWrite(const void *buffer)
     rowLength *= this->GetNumberOfComponents();
     rowLength *= width;
 
-    int row = 0;
-    for ( unsigned int idx2 = 0; idx2 < height; idx2++ )
+    if ( tiled )
       {
-      if ( TIFFWriteScanline(tif, const_cast< char * >( outPtr ), row, 0) < 0 )
+      // Gather each tile from the rows of the buffer, padding the tiles
+      // on the right and bottom edges with zeros
+      const size_t        pixelLength = rowLength / width;
+      const size_t        tileRowLength = m_TileWidth * pixelLength;
+      std::vector< char > tile(tileRowLength * m_TileHeight);
+
+      for ( unsigned int y = pageFirstRow; y < pageLastRow; y += m_TileHeight )
         {
-        itkExceptionMacro(<< "TIFFImageIO: error out of disk space");
-        break;
+        const unsigned int tileRows = std::min(m_TileHeight, height - y);
+        for ( unsigned int x = 0; x < width; x += m_TileWidth )
+          {
+          const size_t copyLength = std::min(m_TileWidth, width - x) * pixelLength;
+          std::fill(tile.begin(), tile.end(), 0);
+          for ( unsigned int r = 0; r < tileRows; ++r )
+            {
+            memcpy(&tile[r * tileRowLength],
+                   outPtr + ( y - pageFirstRow + r ) * static_cast< size_t >( rowLength ) + x * pixelLength,
+                   copyLength);
+            }
+          if ( TIFFWriteEncodedTile(tif, TIFFComputeTile(tif, x, y, 0, 0),
+                                    &tile[0], tile.size() ) < 0 )
+            {
+            itkExceptionMacro(<< "TIFFImageIO: error out of disk space");
+            }
+          }
+        }
+      outPtr += ( pageLastRow - pageFirstRow ) * static_cast< size_t >( rowLength );
+      }
+    else
+      {
+      int row = 0;
+      for ( unsigned int idx2 = 0; idx2 < height; idx2++ )
+        {
+        if ( TIFFWriteScanline(tif, const_cast< char * >( outPtr ), row, 0) < 0 )
+          {
+          itkExceptionMacro(<< "TIFFImageIO: error out of disk space");
+          break;
+          }
+        outPtr += rowLength;
+        row++;
         }
-      outPtr += rowLength;
-      row++;
       }
 
-    if ( m_NumberOfDimensions == 3 )
+    if ( m_NumberOfDimensions == 3 && pageLastRow == height )
       {
       TIFFWriteDirectory(tif);
       }
     }
-  TIFFClose(tif);
+
+  if ( lastPage == pages && lastRow == height )
+    {
+    m_InternalWriter->Clean();
+    }
+  else if ( lastRow == height )
+    {
+    m_InternalWriter->m_NextPage = lastPage;
+    m_InternalWriter->m_NextRow = 0;
+    }
+  else
+    {
+    m_InternalWriter->m_NextPage = firstPage;
+    m_InternalWriter->m_NextRow = lastRow;
+    }
+}
+
+unsigned int
+TIFFImageIO::GetActualNumberOfSplitsForWriting(unsigned int numberOfRequestedSplits,
+                                               const ImageIORegion & pasteRegion,
+                                               const ImageIORegion & largestPossibleRegion)
+{
+  if ( !this->CanStreamWrite() )
+    {
+    return Superclass::GetActualNumberOfSplitsForWriting(numberOfRequestedSplits,
+                                                         pasteRegion, largestPossibleRegion);
+    }
+  if ( pasteRegion != largestPossibleRegion )
+    {
+    itkExceptionMacro( "Pasting is not supported! Can't write:" << this->GetFileName() );
+    }
+
+  const unsigned int pages = largestPossibleRegion.GetImageDimension() > 2
+                             ? largestPossibleRegion.GetSize(2) : 1;
+  const unsigned int tileRows = Math::Ceil< unsigned int >(
+    largestPossibleRegion.GetSize(1) / static_cast< double >( m_TileHeight ) );
+
+  if ( numberOfRequestedSplits <= pages )
+    {
+    // sets of whole pages
+    const unsigned int pagesPerPiece = Math::Ceil< unsigned int >(
+      pages / static_cast< double >( std::max(numberOfRequestedSplits, 1u) ) );
+    return Math::Ceil< unsigned int >( pages / static_cast< double >( pagesPerPiece ) );
+    }
+
+  // bands of tile rows in each page
+  const unsigned int bandsPerPage = std::min( tileRows, Math::Ceil< unsigned int >(
+                                                numberOfRequestedSplits / static_cast< double >( pages ) ) );
+  const unsigned int tileRowsPerBand = Math::Ceil< unsigned int >( tileRows / static_cast< double >( bandsPerPage ) );
+  return pages * Math::Ceil< unsigned int >( tileRows / static_cast< double >( tileRowsPerBand ) );
+}
+
+ImageIORegion
+TIFFImageIO::GetSplitRegionForWriting(unsigned int ithPiece,
+                                      unsigned int numberOfActualSplits,
+                                      const ImageIORegion & pasteRegion,
+                                      const ImageIORegion & largestPossibleRegion)
+{
+  if ( !this->CanStreamWrite() )
+    {
+    return Superclass::GetSplitRegionForWriting(ithPiece, numberOfActualSplits,
+                                                pasteRegion, largestPossibleRegion);
+    }
+
+  ImageIORegion      splitRegion = largestPossibleRegion;
+  const unsigned int height = largestPossibleRegion.GetSize(1);
+  const unsigned int pages = largestPossibleRegion.GetImageDimension() > 2
+                             ? largestPossibleRegion.GetSize(2) : 1;
+
+  if ( numberOfActualSplits <= pages )
+    {
+    const unsigned int pagesPerPiece = Math::Ceil< unsigned int >(
+      pages / static_cast< double >( numberOfActualSplits ) );
+    const unsigned int firstPage = ithPiece * pagesPerPiece;
+    if ( pages > 1 )
+      {
+      splitRegion.SetIndex(2, firstPage);
+      splitRegion.SetSize( 2, std::min(pagesPerPiece, pages - firstPage) );
+      }
+    }
+  else
+    {
+    const unsigned int bandsPerPage = numberOfActualSplits / pages;
+    const unsigned int tileRows = Math::Ceil< unsigned int >( height / static_cast< double >( m_TileHeight ) );
+    const unsigned int rowsPerBand = m_TileHeight
+                                     * Math::Ceil< unsigned int >( tileRows / static_cast< double >( bandsPerPage ) );
+    const unsigned int firstRow = ( ithPiece % bandsPerPage ) * rowsPerBand;
+    splitRegion.SetIndex(1, firstRow);
+    splitRegion.SetSize( 1, std::min(rowsPerBand, height - firstRow) );
+    if ( largestPossibleRegion.GetImageDimension() > 2 )
+      {
+      splitRegion.SetIndex(2, ithPiece / bandsPerPage);
+      splitRegion.SetSize(2, 1);
+      }
+    }
+
+  itkDebugMacro("  Split Piece: " << splitRegion);
+
+  return splitRegion;
 }
 
 bool TIFFImageIO::CanFindTIFFTag(unsigned int t)
@@ -0,0 +1,244 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkStreamingImageFilter.h"
+#include "itkRGBPixel.h"
+#include "itkTIFFImageIO.h"
+#include "itk_tiff.h"
+
+namespace
+{
+template< class TImage >
+bool SameImages(const TImage *expected, const TImage *image,
+                const typename TImage::RegionType & region)
+{
+  if ( !image->GetBufferedRegion().IsInside(region) )
+    {
+    std::cerr << "Buffered region " << image->GetBufferedRegion()
+              << " does not contain " << region << std::endl;
+    return false;
+    }
+  itk::ImageRegionConstIterator< TImage > eit(expected, region);
+  itk::ImageRegionConstIterator< TImage > it(image, region);
+  for (; !eit.IsAtEnd(); ++eit, ++it )
+    {
+    if ( eit.Get() != it.Get() )
+      {
+      std::cerr << "Pixel " << it.GetIndex() << " is " << it.Get()
+                << " instead of " << eit.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< class TPixel >
+void SetTestPixel(TPixel & pixel, unsigned int value)
+{
+  pixel = static_cast< TPixel >( value );
+}
+
+template< class TComponent >
+void SetTestPixel(itk::RGBPixel< TComponent > & pixel, unsigned int value)
+{
+  pixel[0] = static_cast< TComponent >( value );
+  pixel[1] = static_cast< TComponent >( value * 3 );
+  pixel[2] = static_cast< TComponent >( value * 7 );
+}
+
+// Write an image with the given tile size and number of stream
+// divisions, and check that full, streamed and region reads return it
+template< class TImage >
+int TestTIFFStreaming(const std::string & fileName,
+                      const typename TImage::SizeType & size,
+                      unsigned int tileWidth, unsigned int tileHeight,
+                      unsigned int numberOfWriteDivisions)
+{
+  std::cout << "Testing " << fileName << std::endl;
+
+  typename TImage::RegionType region;
+  region.SetSize(size);
+
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(region);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< TImage > it(image, region);
+  for (; !it.IsAtEnd(); ++it )
+    {
+    unsigned int value = 0;
+    for ( unsigned int i = 0; i < TImage::ImageDimension; ++i )
+      {
+      value = value * 31 + it.GetIndex()[i];
+      }
+    typename TImage::PixelType pixel;
+    SetTestPixel(pixel, value);
+    it.Set(pixel);
+    }
+
+  typedef itk::ImageFileWriter< TImage > WriterType;
+  typedef itk::ImageFileReader< TImage > ReaderType;
+
+  // The image is first written in strips, and then streamed from that
+  // file to the tested one, so that the writer gets it piece by piece
+  const std::string sourceFileName = fileName + ".source.tif";
+  typename WriterType::Pointer sourceWriter = WriterType::New();
+  sourceWriter->SetFileName(sourceFileName);
+  sourceWriter->SetInput(image);
+  sourceWriter->Update();
+
+  typename ReaderType::Pointer sourceReader = ReaderType::New();
+  sourceReader->SetFileName(sourceFileName);
+  sourceReader->UseStreamingOn();
+
+  itk::TIFFImageIO::Pointer writeIO = itk::TIFFImageIO::New();
+  writeIO->SetTileWidth(tileWidth);
+  writeIO->SetTileHeight(tileHeight);
+
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetImageIO(writeIO);
+  writer->SetFileName(fileName);
+  writer->SetInput( sourceReader->GetOutput() );
+  writer->SetNumberOfStreamDivisions(numberOfWriteDivisions);
+  writer->Update();
+
+  TIFF *tif = TIFFOpen(fileName.c_str(), "r");
+  if ( !tif )
+    {
+    std::cerr << "Cannot open " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  const bool tiled = TIFFIsTiled(tif) != 0;
+  TIFFClose(tif);
+  if ( tiled != ( tileWidth > 0 ) )
+    {
+    std::cerr << "The file is " << ( tiled ? "" : "not " ) << "tiled" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // full read
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  reader->Update();
+  if ( !reader->GetImageIO()->CanStreamRead() )
+    {
+    std::cerr << "TIFFImageIO cannot stream read " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  if ( reader->GetOutput()->GetLargestPossibleRegion() != region
+       || !SameImages< TImage >(image, reader->GetOutput(), region) )
+    {
+    std::cerr << "Full read failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // streamed read
+  typename ReaderType::Pointer streamReader = ReaderType::New();
+  streamReader->SetFileName(fileName);
+  streamReader->UseStreamingOn();
+  typedef itk::StreamingImageFilter< TImage, TImage > StreamerType;
+  typename StreamerType::Pointer streamer = StreamerType::New();
+  streamer->SetInput( streamReader->GetOutput() );
+  streamer->SetNumberOfStreamDivisions(7);
+  streamer->Update();
+  if ( !SameImages< TImage >(image, streamer->GetOutput(), region) )
+    {
+    std::cerr << "Streamed read failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // region read, which must not read more than the region
+  typename TImage::RegionType subRegion;
+  for ( unsigned int i = 0; i < TImage::ImageDimension; ++i )
+    {
+    subRegion.SetIndex(i, size[i] / 3);
+    subRegion.SetSize(i, size[i] / 2 > 0 ? size[i] / 2 : 1);
+    }
+  typename ReaderType::Pointer regionReader = ReaderType::New();
+  regionReader->SetFileName(fileName);
+  regionReader->UseStreamingOn();
+  regionReader->UpdateOutputInformation();
+  regionReader->GetOutput()->SetRequestedRegion(subRegion);
+  regionReader->Update();
+  if ( regionReader->GetOutput()->GetBufferedRegion() != subRegion
+       || !SameImages< TImage >(image, regionReader->GetOutput(), subRegion) )
+    {
+    std::cerr << "Region read of " << subRegion << " failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+}
+
+int itkTIFFImageIOStreamingTest( int argc, char* argv[] )
+{
+  if( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+
+  typedef itk::Image< unsigned char, 3 >                 VolumeType;
+  typedef itk::Image< unsigned short, 3 >                ShortVolumeType;
+  typedef itk::Image< itk::RGBPixel< unsigned char >, 2 > RGBImageType;
+
+  VolumeType::SizeType volumeSize;
+  volumeSize[0] = 150;
+  volumeSize[1] = 130;
+  volumeSize[2] = 5;
+
+  RGBImageType::SizeType rgbSize;
+  rgbSize[0] = 201;
+  rgbSize[1] = 97;
+
+  int status = EXIT_SUCCESS;
+  try
+    {
+    // bands of tile rows
+    status |= TestTIFFStreaming< VolumeType >(directory + "/itkTIFFImageIOStreamingTest1.tif",
+                                              volumeSize, 32, 48, 12);
+    // sets of pages
+    status |= TestTIFFStreaming< ShortVolumeType >(directory + "/itkTIFFImageIOStreamingTest2.tif",
+                                                   volumeSize, 64, 16, 3);
+    // strips
+    status |= TestTIFFStreaming< ShortVolumeType >(directory + "/itkTIFFImageIOStreamingTest3.tif",
+                                                   volumeSize, 0, 0, 1);
+    // a single page in bands
+    status |= TestTIFFStreaming< RGBImageType >(directory + "/itkTIFFImageIOStreamingTest4.tif",
+                                                rgbSize, 48, 32, 3);
+    }
+  catch ( itk::ExceptionObject & excp )
+    {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if ( status != EXIT_SUCCESS )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test PASSED !" << std::endl;
+  return EXIT_SUCCESS;
+}
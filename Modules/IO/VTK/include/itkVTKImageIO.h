@@ -71,6 +71,12 @@ public:
   // overidden to return true only when supported
   virtual bool CanStreamRead(void);
 
+  // see super class for documentation
+  //
+  // overidden to return true for binary data that needs no byte
+  // swapping, which is stored big endian
+  virtual bool CanMemoryMapRead(std::string & dataFileName, SizeType & dataOffset);
+
 
   /*-------- This part of the interface deals with reading data. ------ */
 
@@ -86,6 +86,19 @@ bool VTKImageIO::CanStreamRead(void)
   return canStreamRead;
 }
 
+bool VTKImageIO::CanMemoryMapRead(std::string & dataFileName, SizeType & dataOffset)
+{
+  if ( !this->CanStreamRead()
+       || ( this->GetComponentSize() > 1 && !ByteSwapper< int >::SystemIsBigEndian() ) )
+    {
+    return false;
+    }
+
+  dataFileName = m_FileName;
+  dataOffset = this->GetDataPosition();
+  return true;
+}
+
 bool VTKImageIO::CanStreamWrite(void)
 {
   bool canStreamWrite = true;
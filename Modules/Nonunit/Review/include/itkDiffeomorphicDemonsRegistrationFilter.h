@@ -23,6 +23,7 @@
 
 #include "itkMultiplyImageFilter.h"
 #include "itkExponentialDisplacementFieldImageFilter.h"
+#include "itkComposeDisplacementFieldsImageFilter.h"
 
 namespace itk
 {
@@ -191,28 +192,20 @@ private:
   typedef ExponentialDisplacementFieldImageFilter<
     DisplacementFieldType, DisplacementFieldType >        FieldExponentiatorType;
 
-  typedef WarpVectorImageFilter<
-    DisplacementFieldType,
-    DisplacementFieldType, DisplacementFieldType >        VectorWarperType;
+  typedef ComposeDisplacementFieldsImageFilter<
+    DisplacementFieldType, DisplacementFieldType >        ComposerType;
 
   typedef VectorLinearInterpolateNearestNeighborExtrapolateImageFunction<
-    DisplacementFieldType, double >                      FieldInterpolatorType;
-
-  typedef AddImageFilter<
-    DisplacementFieldType,
-    DisplacementFieldType, DisplacementFieldType >        AdderType;
+    DisplacementFieldType, typename ComposerType::RealType > FieldInterpolatorType;
 
   typedef typename MultiplyByConstantType::Pointer   MultiplyByConstantPointer;
   typedef typename FieldExponentiatorType::Pointer   FieldExponentiatorPointer;
-  typedef typename VectorWarperType::Pointer         VectorWarperPointer;
+  typedef typename ComposerType::Pointer             ComposerPointer;
   typedef typename FieldInterpolatorType::Pointer    FieldInterpolatorPointer;
-  typedef typename FieldInterpolatorType::OutputType FieldInterpolatorOutputType;
-  typedef typename AdderType::Pointer                AdderPointer;
 
   MultiplyByConstantPointer m_Multiplier;
   FieldExponentiatorPointer m_Exponentiator;
-  VectorWarperPointer       m_Warper;
-  AdderPointer              m_Adder;
+  ComposerPointer           m_Composer;
   bool                      m_UseFirstOrderExp;
 };
 } // end namespace itk
@@ -42,13 +42,10 @@ DiffeomorphicDemonsRegistrationFilter< TFixedImage, TMovingImage, TDisplacementF
 
   m_Exponentiator = FieldExponentiatorType::New();
 
-  m_Warper = VectorWarperType::New();
+  m_Composer = ComposerType::New();
   FieldInterpolatorPointer VectorInterpolator =
     FieldInterpolatorType::New();
-  m_Warper->SetInterpolator(VectorInterpolator);
-
-  m_Adder = AdderType::New();
-  m_Adder->InPlaceOn();
+  m_Composer->SetInterpolator(VectorInterpolator);
 }
 
 /**
@@ -274,17 +271,7 @@ DiffeomorphicDemonsRegistrationFilter< TFixedImage, TMovingImage, TDisplacementF
     // use s <- s o (Id +u)
 
     // skip exponential and compose the vector fields
-    m_Warper->SetOutputOrigin( this->GetUpdateBuffer()->GetOrigin() );
-    m_Warper->SetOutputSpacing( this->GetUpdateBuffer()->GetSpacing() );
-    m_Warper->SetOutputDirection( this->GetUpdateBuffer()->GetDirection() );
-    m_Warper->SetInput( this->GetOutput() );
-    m_Warper->SetDisplacementField( this->GetUpdateBuffer() );
-
-    m_Adder->SetInput1( m_Warper->GetOutput() );
-    m_Adder->SetInput2( this->GetUpdateBuffer() );
-
-    m_Adder->GetOutput()->SetRequestedRegion(
-      this->GetOutput()->GetRequestedRegion() );
+    m_Composer->SetWarpingField( this->GetUpdateBuffer() );
     }
   else
     {
@@ -321,26 +308,24 @@ DiffeomorphicDemonsRegistrationFilter< TFixedImage, TMovingImage, TDisplacementF
     m_Exponentiator->Update();
 
     // compose the vector fields
-    m_Warper->SetOutputOrigin( this->GetUpdateBuffer()->GetOrigin() );
-    m_Warper->SetOutputSpacing( this->GetUpdateBuffer()->GetSpacing() );
-    m_Warper->SetOutputDirection( this->GetUpdateBuffer()->GetDirection() );
-    m_Warper->SetInput( this->GetOutput() );
-    m_Warper->SetDisplacementField( m_Exponentiator->GetOutput() );
-
-    m_Warper->Update();
-
-    m_Adder->SetInput1( m_Warper->GetOutput() );
-    m_Adder->SetInput2( m_Exponentiator->GetOutput() );
-
-    m_Adder->GetOutput()->SetRequestedRegion(
-      this->GetOutput()->GetRequestedRegion() );
+    m_Composer->SetWarpingField( m_Exponentiator->GetOutput() );
     }
 
+  m_Composer->SetDisplacementField( this->GetOutput() );
+  m_Composer->GetOutput()->SetRequestedRegion(
+    this->GetOutput()->GetRequestedRegion() );
+
   // Triggers update
-  m_Adder->Update();
+  m_Composer->Update();
+
+  // The composer reads the current field, so its output must
+  // not reuse that buffer at the next update.
+  DisplacementFieldPointer composedField = m_Composer->GetOutput();
+  composedField->DisconnectPipeline();
 
   // Region passing stuff
-  this->GraftOutput( m_Adder->GetOutput() );
+  this->GraftOutput( composedField );
+  this->GetOutput()->Modified();
 
   DemonsRegistrationFunctionType *drfp = this->DownCastDifferenceFunctionType();
 
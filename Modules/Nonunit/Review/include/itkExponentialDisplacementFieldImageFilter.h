@@ -20,9 +20,8 @@
 
 #include "itkDivideImageFilter.h"
 #include "itkCastImageFilter.h"
-#include "itkWarpVectorImageFilter.h"
+#include "itkComposeDisplacementFieldsImageFilter.h"
 #include "itkVectorLinearInterpolateNearestNeighborExtrapolateImageFunction.h"
-#include "itkAddImageFilter.h"
 
 namespace itk
 {
@@ -47,6 +46,11 @@ namespace itk
  *      exp(\Phi) = exp( \frac{\Phi}{2^N} )^{2^N}
  *    \f]
  *
+ * Each squaring step composes the current field with itself using
+ * ComposeDisplacementFieldsImageFilter, which works directly in the
+ * index space of the field with linear interpolation and nearest
+ * neighbor extrapolation.
+ *
  *
  * This filter expects both the input and output images to be of pixel type
  * Vector.
@@ -151,22 +155,16 @@ protected:
   typedef CastImageFilter<
     InputImageType, OutputImageType >                   CasterType;
 
-  typedef WarpVectorImageFilter<
-    OutputImageType,
-    OutputImageType, OutputImageType >                  VectorWarperType;
+  typedef ComposeDisplacementFieldsImageFilter<
+    OutputImageType, OutputImageType >                  ComposerType;
 
   typedef VectorLinearInterpolateNearestNeighborExtrapolateImageFunction<
-    OutputImageType, double >                            FieldInterpolatorType;
-
-  typedef AddImageFilter<
-    OutputImageType, OutputImageType, OutputImageType > AdderType;
+    OutputImageType, typename ComposerType::RealType >  FieldInterpolatorType;
 
   typedef typename DivideByConstantType::Pointer     DivideByConstantPointer;
   typedef typename CasterType::Pointer               CasterPointer;
-  typedef typename VectorWarperType::Pointer         VectorWarperPointer;
+  typedef typename ComposerType::Pointer             ComposerPointer;
   typedef typename FieldInterpolatorType::Pointer    FieldInterpolatorPointer;
-  typedef typename FieldInterpolatorType::OutputType FieldInterpolatorOutputType;
-  typedef typename AdderType::Pointer                AdderPointer;
 private:
   ExponentialDisplacementFieldImageFilter(const Self &); //purposely not
                                                         // implemented
@@ -180,8 +178,7 @@ private:
 
   DivideByConstantPointer m_Divider;
   CasterPointer           m_Caster;
-  VectorWarperPointer     m_Warper;
-  AdderPointer            m_Adder;
+  ComposerPointer         m_Composer;
 };
 } // end namespace itk
 
@@ -36,14 +36,11 @@ ExponentialDisplacementFieldImageFilter< TInputImage, TOutputImage >
   m_ComputeInverse = false;
   m_Divider = DivideByConstantType::New();
   m_Caster = CasterType::New();
-  m_Warper = VectorWarperType::New();
+  m_Composer = ComposerType::New();
 
   FieldInterpolatorPointer VectorInterpolator =
     FieldInterpolatorType::New();
-  m_Warper->SetInterpolator(VectorInterpolator);
-
-  m_Adder = AdderType::New();
-  m_Adder->InPlaceOn();
+  m_Composer->SetInterpolator(VectorInterpolator);
 }
 
 /**
@@ -185,38 +182,26 @@ ExponentialDisplacementFieldImageFilter< TInputImage, TOutputImage >
 
   progress.CompletedPixel();
 
-  // Do the iterative composition of the vector field
-  m_Warper->SetOutputOrigin( inputPtr->GetOrigin() );
-  m_Warper->SetOutputSpacing( inputPtr->GetSpacing() );
-  m_Warper->SetOutputDirection( inputPtr->GetDirection() );
-
+  // Do the iterative composition of the vector field with itself
   for ( unsigned int i = 0; i < numiter; i++ )
     {
-    m_Warper->SetInput( this->GetOutput() );
-    m_Warper->SetDisplacementField( this->GetOutput() );
+    m_Composer->SetDisplacementField( this->GetOutput() );
+    m_Composer->SetWarpingField( this->GetOutput() );
 
-    m_Warper->GetOutput()->SetRequestedRegion(
+    m_Composer->GetOutput()->SetRequestedRegion(
       this->GetOutput()->GetRequestedRegion() );
 
-    m_Warper->Update();
-
-    OutputImagePointer warpedIm = m_Warper->GetOutput();
-    warpedIm->DisconnectPipeline();
-
-    // Remember we chose to use an inplace adder
-    m_Adder->SetInput1( this->GetOutput() );
-
-    m_Adder->SetInput2(warpedIm);
-    m_Adder->GetOutput()->SetRequestedRegion(
-      this->GetOutput()->GetRequestedRegion() );
+    m_Composer->Update();
 
-    m_Adder->Update();
+    // The composer reads the current field, so its output must
+    // not reuse that buffer in the next iteration.
+    OutputImagePointer composedIm = m_Composer->GetOutput();
+    composedIm->DisconnectPipeline();
 
     // Region passing stuff
-    this->GraftOutput( m_Adder->GetOutput() );
+    this->GraftOutput(composedIm);
 
-    // Make a call to modified. This seems only necessary for
-    // a non-inplace adder but it doesn't hurt anyhow.
+    // Make sure the composer executes again with the new field.
     this->GetOutput()->Modified();
 
     progress.CompletedPixel();
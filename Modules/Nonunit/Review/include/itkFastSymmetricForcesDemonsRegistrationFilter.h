@@ -23,6 +23,7 @@
 
 #include "itkMultiplyImageFilter.h"
 #include "itkExponentialDisplacementFieldImageFilter.h"
+#include "itkAddImageFilter.h"
 
 namespace itk
 {
@@ -19,6 +19,8 @@
 #define __itkMorphologicalWatershedFromMarkersImageFilter_h
 
 #include "itkImageToImageFilter.h"
+#include <map>
+#include <vector>
 
 namespace itk
 {
@@ -63,6 +65,25 @@ namespace itk
  * Chapter 9.2 of Pierre Soille's book "Morphological Image Analysis:
  * Principles and Applications", Second Edition, Springer, 2003.
  *
+ * The hierarchical queue is an array of buckets indexed by the pixel value
+ * when the input image is of an integral type with less than 65536
+ * different values in the image, and a map of queues otherwise.
+ *
+ * By default the image is flooded on a single thread. With
+ * ParallelFlooding on, the image is split along its last dimension in one
+ * block per thread, and each block is flooded from its own markers. The
+ * blocks then exchange the levels reached on their boundaries, and flood
+ * again from the boundary pixels that a lower path from a neighbor block
+ * reaches, until no boundary changes. Every pixel gets the label of a
+ * marker it is connected to by a path of lowest maximal value, as in the
+ * single threaded flooding, but where several markers reach a pixel at
+ * the same level, as on plateaus, the label it gets depends on the order
+ * the blocks were flooded in, and so on the number of threads. The
+ * watershed lines are then placed between the regions, on the pixel of
+ * each pair of neighbors of different labels that was reached last, so
+ * they may also move with the number of threads and differ from the ones
+ * of the single threaded flooding.
+ *
  * This code was contributed in the Insight Journal paper:
  * "The watershed transform in ITK - discussion and new developments"
  * by Beare R., Lehmann G.
@@ -156,6 +177,16 @@ public:
   itkSetMacro(MarkWatershedLine, bool);
   itkGetConstReferenceMacro(MarkWatershedLine, bool);
   itkBooleanMacro(MarkWatershedLine);
+
+  /**
+   * Set/Get whether the image is flooded in blocks on the threads of the
+   * filter. Default is false. The position of the watershed lines, and the
+   * labels on plateaus reached by several markers, then depend on the
+   * number of threads; see the class documentation.
+   */
+  itkSetMacro(ParallelFlooding, bool);
+  itkGetConstReferenceMacro(ParallelFlooding, bool);
+  itkBooleanMacro(ParallelFlooding);
 protected:
   MorphologicalWatershedFromMarkersImageFilter();
   ~MorphologicalWatershedFromMarkersImageFilter() {}
@@ -171,7 +202,7 @@ protected:
    * \sa ProcessObject::EnlargeOutputRequestedRegion() */
   void EnlargeOutputRequestedRegion( DataObject *itkNotUsed(output) );
 
-  /** The filter is single threaded. */
+  /** The filter is single threaded, unless ParallelFlooding is on. */
   void GenerateData();
 
 private:
@@ -182,6 +213,143 @@ private:
   bool m_FullyConnected;
 
   bool m_MarkWatershedLine;
+
+  bool m_ParallelFlooding;
+
+  typedef typename InputImageType::OffsetValueType OffsetValueType;
+
+  /** A pixel in the hierarchical queue: its offset in the padded status
+   * buffer and its offset in the input and output buffers. */
+  typedef std::pair< OffsetValueType, OffsetValueType > QueueElementType;
+  typedef std::vector< QueueElementType >               QueueLevelType;
+
+  /** FAH (in french: File d'Attente Hierarchique).  The levels are dense
+   * buckets indexed by the pixel value for the images with a small range
+   * of integral values, and a map of levels otherwise.  A level is moved
+   * out of the queue when it is processed; the pixels pushed at this level
+   * or below must then be appended to it by the caller. */
+  class HierarchicalQueue
+    {
+  public:
+    HierarchicalQueue() : m_Dense(false), m_Minimum(), m_Current(0) {}
+
+    void Initialize(bool dense, const InputImagePixelType & minimum,
+                    const InputImagePixelType & maximum)
+    {
+      m_Dense = dense;
+      m_Minimum = minimum;
+      m_Current = 0;
+      m_Map.clear();
+      m_Buckets.clear();
+      if ( m_Dense )
+        {
+        m_Buckets.resize( static_cast< size_t >( maximum - minimum ) + 1 );
+        }
+    }
+
+    void Push(const InputImagePixelType & value, const QueueElementType & element)
+    {
+      if ( m_Dense )
+        {
+        m_Buckets[static_cast< size_t >( value - m_Minimum )].push_back(element);
+        }
+      else
+        {
+        m_Map[value].push_back(element);
+        }
+    }
+
+    /** Move the lowest level to the given one. Return false if the queue
+     * is empty. */
+    bool PopLevel(InputImagePixelType & value, QueueLevelType & level)
+    {
+      QueueLevelType().swap(level);
+      if ( m_Dense )
+        {
+        while ( m_Current < m_Buckets.size() && m_Buckets[m_Current].empty() )
+          {
+          ++m_Current;
+          }
+        if ( m_Current == m_Buckets.size() )
+          {
+          return false;
+          }
+        value = static_cast< InputImagePixelType >( m_Minimum + m_Current );
+        level.swap(m_Buckets[m_Current]);
+        return true;
+        }
+      if ( m_Map.empty() )
+        {
+        return false;
+        }
+      value = m_Map.begin()->first;
+      level.swap(m_Map.begin()->second);
+      m_Map.erase( m_Map.begin() );
+      return true;
+    }
+
+  private:
+    bool                                            m_Dense;
+    InputImagePixelType                             m_Minimum;
+    size_t                                          m_Current;
+    std::vector< QueueLevelType >                   m_Buckets;
+    std::map< InputImagePixelType, QueueLevelType > m_Map;
+    };
+
+  /** A boundary pixel of a block reached by a lower path from a neighbor
+   * block. */
+  struct FloodingSeed
+  {
+    QueueElementType    Element;
+    InputImagePixelType Level;
+    LabelImagePixelType Label;
+  };
+
+  /** The steps run by all the threads in turn when ParallelFlooding is on. */
+  enum FloodingStageType {
+    FloodBlocks,
+    CollectBoundarySeeds,
+    FloodBoundarySeeds,
+    FindWatershedLines,
+    MarkWatershedLines
+  };
+
+  /** Internal structure used for passing the image and the blocks to the
+   * flooding threads. */
+  struct FloodingThreadStruct
+  {
+    Self *                                    Filter;
+    FloodingStageType                         Stage;
+    const InputImagePixelType *               Input;
+    const LabelImagePixelType *               Marker;
+    LabelImagePixelType *                     Output;
+    const unsigned char *                     Status;
+    unsigned char *                           State;
+    InputImagePixelType *                     Level;
+    const std::vector< OffsetValueType > *    StatusNeighbors;
+    const std::vector< OffsetValueType > *    Neighbors;
+    const std::vector< OffsetValueType > *    StatusLines;
+    SizeValueType                             LineLength;
+    SizeValueType                             LinesPerSlice;
+    std::vector< SizeValueType >              BlockLines;
+    std::vector< std::vector< FloodingSeed > > Seeds;
+    bool                                      Dense;
+    InputImagePixelType                       Minimum;
+    InputImagePixelType                       Maximum;
+  };
+
+  /** Flood the image in blocks on several threads. */
+  void FloodInBlocks(FloodingThreadStruct & str);
+
+  /** Run the current stage of the flooding on one block. */
+  void ThreadedFloodBlock(FloodingThreadStruct & str, ThreadIdType block);
+
+  /** Flood a block from the pixels in the queue, without leaving it. */
+  void FloodBlockFromQueue(FloodingThreadStruct & str, ThreadIdType block,
+                           HierarchicalQueue & fah);
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE FloodingThreaderCallback(void *arg);
 }; // end of class
 } // end namespace itk
 
@@ -48,6 +48,7 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
   this->SetNumberOfRequiredInputs(2);
   m_FullyConnected = false;
   m_MarkWatershedLine = true;
+  m_ParallelFlooding = false;
 }
 
 template< class TInputImage, class TLabelImage >
@@ -95,8 +96,8 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
   // The 2 algorithms are very similar and so are integrated in the same filter.
 
   //---------------------------------------------------------------------------
-  // declare the vars common to the 2 algorithms: constants, iterators,
-  // hierarchical queue, progress reporter, and status image
+  // declare the vars common to the 2 algorithms: constants, neighbor offsets,
+  // hierarchical queue, progress reporter, and status buffer
   // also allocate output images and verify preconditions
   //---------------------------------------------------------------------------
 
@@ -107,6 +108,11 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
   static const LabelImagePixelType wsLabel =
     NumericTraits< LabelImagePixelType >::Zero;
 
+  // the states of the pixels in the status buffer
+  static const unsigned char NotProcessed = 0;
+  static const unsigned char Processed = 1;
+  static const unsigned char Outside = 2;
+
   this->AllocateOutputs();
 
   LabelImageConstPointer markerImage = this->GetMarkerImage();
@@ -125,40 +131,146 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
     itkExceptionMacro(<< "Marker and input must have the same size.");
     }
 
-  // FAH (in french: File d'Attente Hierarchique)
-  typedef std::queue< IndexType >                    QueueType;
-  typedef std::map< InputImagePixelType, QueueType > MapType;
-  MapType fah;
-
-  // the radius which will be used for all the shaped iterators
-  Size< ImageDimension > radius;
-  radius.Fill(1);
-
-  // iterator for the marker image
-  typedef ConstShapedNeighborhoodIterator< LabelImageType > MarkerIteratorType;
-  typename MarkerIteratorType::ConstIterator nmIt;
-  MarkerIteratorType
-  markerIt( radius, markerImage, markerImage->GetRequestedRegion() );
-  // add a boundary constant to avoid adding pixels on the border in the fah
-  ConstantBoundaryCondition< LabelImageType > lcbc;
-  lcbc.SetConstant( NumericTraits< LabelImagePixelType >::max() );
-  markerIt.OverrideBoundaryCondition(&lcbc);
-  setConnectivity(&markerIt, m_FullyConnected);
-
-  // iterator for the input image
-  typedef ConstShapedNeighborhoodIterator< InputImageType > InputIteratorType;
-  InputIteratorType
-  inputIt( radius, inputImage, inputImage->GetRequestedRegion() );
-  typename InputIteratorType::ConstIterator niIt;
-  setConnectivity(&inputIt, m_FullyConnected);
-
-  // iterator for the output image
-  typedef ShapedNeighborhoodIterator< LabelImageType > OutputIteratorType;
-  typedef typename OutputIteratorType::OffsetType      OffsetType;
-  typename OutputIteratorType::Iterator noIt;
-  OutputIteratorType
-  outputIt( radius, outputImage, outputImage->GetRequestedRegion() );
-  setConnectivity(&outputIt, m_FullyConnected);
+  const LabelImagePixelType *marker = markerImage->GetBufferPointer();
+  const InputImagePixelType *input = inputImage->GetBufferPointer();
+  LabelImagePixelType *      output = outputImage->GetBufferPointer();
+
+  const typename LabelImageType::SizeType size = outputImage->GetBufferedRegion().GetSize();
+  const OffsetValueType *offsetTable = outputImage->GetOffsetTable();
+  const SizeValueType    numberOfPixels = outputImage->GetBufferedRegion().GetNumberOfPixels();
+
+  // the status buffer is padded by one pixel on each side, so the neighbors
+  // outside of the image can be recognized without any bound check
+  OffsetValueType statusOffsetTable[ImageDimension + 1];
+  statusOffsetTable[0] = 1;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    statusOffsetTable[d + 1] = statusOffsetTable[d] * static_cast< OffsetValueType >( size[d] + 2 );
+    }
+
+  // the offsets of the neighbors, in the same order as in the shaped
+  // neighborhood iterators, in the status buffer and in the images
+  std::vector< OffsetValueType > statusNeighbors;
+  std::vector< OffsetValueType > neighbors;
+  SizeValueType                  neighborhoodSize = 1;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    neighborhoodSize *= 3;
+    }
+  for ( SizeValueType n = 0; n < neighborhoodSize; n++ )
+    {
+    OffsetValueType statusOffset = 0;
+    OffsetValueType offset = 0;
+    unsigned int    numberOfMoves = 0;
+    SizeValueType   position = n;
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      const OffsetValueType move = static_cast< OffsetValueType >( position % 3 ) - 1;
+      position /= 3;
+      statusOffset += move * statusOffsetTable[d];
+      offset += move * offsetTable[d];
+      numberOfMoves += ( move != 0 );
+      }
+    if ( numberOfMoves == 0 || ( !m_FullyConnected && numberOfMoves > 1 ) )
+      {
+      continue;
+      }
+    statusNeighbors.push_back(statusOffset);
+    neighbors.push_back(offset);
+    }
+  const size_t numberOfNeighbors = neighbors.size();
+
+  // the first pixel of each line, in the status buffer and in the images
+  const SizeValueType numberOfLines = numberOfPixels / size[0];
+  std::vector< OffsetValueType > statusLines(numberOfLines);
+  IndexType index;
+  index.Fill(0);
+  for ( SizeValueType l = 0; l < numberOfLines; l++ )
+    {
+    OffsetValueType statusOffset = 0;
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      statusOffset += ( index[d] + 1 ) * statusOffsetTable[d];
+      }
+    statusLines[l] = statusOffset;
+    for ( unsigned int d = 1; d < ImageDimension; d++ )
+      {
+      if ( ++index[d] < static_cast< OffsetValueType >( size[d] ) )
+        {
+        break;
+        }
+      index[d] = 0;
+      }
+    }
+
+  std::vector< unsigned char > status(statusOffsetTable[ImageDimension], Outside);
+  for ( SizeValueType l = 0; l < numberOfLines; l++ )
+    {
+    std::fill(status.begin() + statusLines[l], status.begin() + statusLines[l] + size[0], NotProcessed);
+    }
+
+  // the levels are stored in an array of buckets when the range of the
+  // input image is small enough
+  HierarchicalQueue fah;
+  bool              dense = false;
+  InputImagePixelType minimum = NumericTraits< InputImagePixelType >::Zero;
+  InputImagePixelType maximum = NumericTraits< InputImagePixelType >::Zero;
+  if ( NumericTraits< InputImagePixelType >::is_integer && numberOfPixels > 0 )
+    {
+    minimum = *std::min_element(input, input + numberOfPixels);
+    maximum = *std::max_element(input, input + numberOfPixels);
+    dense = ( static_cast< double >( maximum ) - static_cast< double >( minimum ) < 65536.0 );
+    }
+
+  if ( m_ParallelFlooding )
+    {
+    if ( numberOfPixels == 0 )
+      {
+      return;
+      }
+
+    // the blocks are made of whole slices along the last dimension
+    const SizeValueType numberOfSlices = ImageDimension > 1 ? size[ImageDimension - 1] : 1;
+    SizeValueType       numberOfBlocks = this->GetNumberOfThreads();
+    if ( numberOfBlocks > numberOfSlices )
+      {
+      numberOfBlocks = numberOfSlices;
+      }
+
+    std::vector< unsigned char >       state(numberOfPixels);
+    std::vector< InputImagePixelType > level(numberOfPixels);
+
+    FloodingThreadStruct str;
+    str.Filter = this;
+    str.Stage = FloodBlocks;
+    str.Input = input;
+    str.Marker = marker;
+    str.Output = output;
+    str.Status = &status[0];
+    str.State = &state[0];
+    str.Level = &level[0];
+    str.StatusNeighbors = &statusNeighbors;
+    str.Neighbors = &neighbors;
+    str.StatusLines = &statusLines;
+    str.LineLength = size[0];
+    str.LinesPerSlice = numberOfLines / numberOfSlices;
+    str.BlockLines.resize(numberOfBlocks + 1);
+    for ( SizeValueType b = 0; b <= numberOfBlocks; b++ )
+      {
+      str.BlockLines[b] = ( b * numberOfSlices / numberOfBlocks ) * str.LinesPerSlice;
+      }
+    str.Dense = dense;
+    str.Minimum = minimum;
+    str.Maximum = maximum;
+
+    this->FloodInBlocks(str);
+    return;
+    }
+
+  fah.Initialize(dense, minimum, maximum);
+
+  InputImagePixelType currentValue;
+  QueueLevelType      currentQueue;
 
   //---------------------------------------------------------------------------
   // Meyer's algorithm
@@ -170,126 +282,74 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
     //  - copy markers pixels to output image
     //  - init FAH with indexes of background pixels with marker pixel(s) in
     //    their neighborhood
-
-    ConstantBoundaryCondition< LabelImageType > lcbc2;
-    // outside pixel are watershed so they won't be use to find real watershed
-    // pixels
-    lcbc2.SetConstant(wsLabel);
-    outputIt.OverrideBoundaryCondition(&lcbc2);
-
-    // create a temporary image to store the state of each pixel (processed or
-    // not)
-    typedef Image< bool, ImageDimension > StatusImageType;
-    typename StatusImageType::Pointer statusImage = StatusImageType::New();
-    statusImage->SetRegions( markerImage->GetLargestPossibleRegion() );
-    statusImage->Allocate();
-
-    // iterator for the status image
-    typedef ShapedNeighborhoodIterator< StatusImageType > StatusIteratorType;
-    typename StatusIteratorType::Iterator nsIt;
-    StatusIteratorType
-                                                 statusIt( radius, statusImage, outputImage->GetRequestedRegion() );
-    ConstantBoundaryCondition< StatusImageType > bcbc;
-    bcbc.SetConstant(true);    // outside pixel are already processed
-    statusIt.OverrideBoundaryCondition(&bcbc);
-    setConnectivity(&statusIt, m_FullyConnected);
-
-    // the status image must be initialized before the first stage. In the
-    // first stage, the set to true are the neighbors of the marker (and the
-    // marker) so it's difficult (impossible ?) to init the status image at
-    // the same time
-    // the overhead should be small
-    statusImage->FillBuffer(false);
-
-    for ( markerIt.GoToBegin(), statusIt.GoToBegin(), outputIt.GoToBegin(), inputIt.GoToBegin();
-          !markerIt.IsAtEnd();
-          ++markerIt, ++outputIt )
+    for ( SizeValueType l = 0; l < numberOfLines; l++ )
       {
-      LabelImagePixelType markerPixel = markerIt.GetCenterPixel();
-      if ( markerPixel != bgLabel )
+      const OffsetValueType lineOffset = static_cast< OffsetValueType >( l * size[0] );
+      for ( OffsetValueType x = 0; x < static_cast< OffsetValueType >( size[0] ); x++ )
         {
-        IndexType idx = markerIt.GetIndex();
-
-        // move the iterators to the right place
-        OffsetType shift = idx - statusIt.GetIndex();
-        statusIt += shift;
-        inputIt += shift;
-
-        // this pixel belongs to a marker
-        // mark it as already processed
-        statusIt.SetCenterPixel(true);
-        // copy it to the output image
-        outputIt.SetCenterPixel(markerPixel);
-        // and increase progress because this pixel will not be used in the
-        // flooding stage.
-        progress.CompletedPixel();
-
-        // search the background pixels in the neighborhood
-        for ( nmIt = markerIt.Begin(), nsIt = statusIt.Begin(), niIt = inputIt.Begin();
-              nmIt != markerIt.End();
-              nmIt++, nsIt++, niIt++ )
+        const OffsetValueType offset = lineOffset + x;
+        const OffsetValueType statusOffset = statusLines[l] + x;
+        const LabelImagePixelType markerPixel = marker[offset];
+        if ( markerPixel != bgLabel )
           {
-          if ( !nsIt.Get() && nmIt.Get() == bgLabel )
+          // this pixel belongs to a marker
+          // mark it as already processed
+          status[statusOffset] = Processed;
+          // copy it to the output image
+          output[offset] = markerPixel;
+          // and increase progress because this pixel will not be used in the
+          // flooding stage.
+          progress.CompletedPixel();
+
+          // search the background pixels in the neighborhood
+          for ( size_t n = 0; n < numberOfNeighbors; n++ )
             {
-            // this neighbor is a background pixel and is not already
-            // processed; add its index to fah
-            fah[niIt.Get()].push( markerIt.GetIndex()
-                                  + nmIt.GetNeighborhoodOffset() );
-            // mark it as already in the fah to avoid adding it several times
-            nsIt.Set(true);
+            const OffsetValueType statusNeighbor = statusOffset + statusNeighbors[n];
+            const OffsetValueType neighbor = offset + neighbors[n];
+            if ( status[statusNeighbor] == NotProcessed && marker[neighbor] == bgLabel )
+              {
+              // this neighbor is a background pixel and is not already
+              // processed; add its index to fah
+              fah.Push( input[neighbor], QueueElementType(statusNeighbor, neighbor) );
+              // mark it as already in the fah to avoid adding it several times
+              status[statusNeighbor] = Processed;
+              }
             }
           }
+        else
+          {
+          // Some pixels may be never processed so, by default, non marked pixels
+          // must be marked as watershed
+          output[offset] = wsLabel;
+          }
+        // one more pixel done in the init stage
+        progress.CompletedPixel();
         }
-      else
-        {
-        // Some pixels may be never processed so, by default, non marked pixels
-        // must be marked as watershed
-        outputIt.SetCenterPixel(wsLabel);
-        }
-      // one more pixel done in the init stage
-      progress.CompletedPixel();
       }
-    // fill the borders of the status image with "true"
-    //FillSides<StatusImageType>(statusImage, true);
-    // Now disable the boundary checks
-    //outputIt.NeedToUseBoundaryConditionOff();
-    //statusIt.NeedToUseBoundaryConditionOff();
-    //inputIt.NeedToUseBoundaryConditionOff();
     // end of init stage
 
-    // flooding
-    // init all the iterators
-    outputIt.GoToBegin();
-    statusIt.GoToBegin();
-    inputIt.GoToBegin();
-
     // and start flooding
-    while ( !fah.empty() )
+    while ( fah.PopLevel(currentValue, currentQueue) )
       {
-      // store the current vars
-      InputImagePixelType currentValue = fah.begin()->first;
-      QueueType           currentQueue = fah.begin()->second;
-      // and remove them from the fah
-      fah.erase( fah.begin() );
-
-      while ( !currentQueue.empty() )
+      // the pixels pushed at the current level are appended to the level
+      for ( size_t i = 0; i < currentQueue.size(); i++ )
         {
-        IndexType idx = currentQueue.front();
-        currentQueue.pop();
-
-        // move the iterators to the right place
-        OffsetType shift = idx - outputIt.GetIndex();
-        outputIt += shift;
-        statusIt += shift;
-        inputIt += shift;
+        const OffsetValueType statusOffset = currentQueue[i].first;
+        const OffsetValueType offset = currentQueue[i].second;
 
         // iterate over the neighbors. If there is only one marker value, give
         // that value to the pixel, else keep it as is (watershed line)
         LabelImagePixelType marker = wsLabel;
         bool                collision = false;
-        for ( noIt = outputIt.Begin(); noIt != outputIt.End(); noIt++ )
+        for ( size_t n = 0; n < numberOfNeighbors; n++ )
           {
-          LabelImagePixelType o = noIt.Get();
+          // outside pixel are watershed so they won't be use to find real
+          // watershed pixels
+          if ( status[statusOffset + statusNeighbors[n]] == Outside )
+            {
+            continue;
+            }
+          const LabelImagePixelType o = output[offset + neighbors[n]];
           if ( o != wsLabel )
             {
             if ( marker != wsLabel && o != marker )
@@ -304,28 +364,26 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
         if ( !collision )
           {
           // set the marker value
-          outputIt.SetCenterPixel(marker);
+          output[offset] = marker;
           // and propagate to the neighbors
-          for ( niIt = inputIt.Begin(), nsIt = statusIt.Begin();
-                niIt != inputIt.End();
-                niIt++, nsIt++ )
+          for ( size_t n = 0; n < numberOfNeighbors; n++ )
             {
-            if ( !nsIt.Get() )
+            const OffsetValueType statusNeighbor = statusOffset + statusNeighbors[n];
+            if ( status[statusNeighbor] == NotProcessed )
               {
               // the pixel is not yet processed. add it to the fah
-              InputImagePixelType GrayVal = niIt.Get();
+              const OffsetValueType     neighbor = offset + neighbors[n];
+              const InputImagePixelType GrayVal = input[neighbor];
               if ( GrayVal <= currentValue )
                 {
-                currentQueue.push( inputIt.GetIndex()
-                                   + niIt.GetNeighborhoodOffset() );
+                currentQueue.push_back( QueueElementType(statusNeighbor, neighbor) );
                 }
               else
                 {
-                fah[GrayVal].push( inputIt.GetIndex()
-                                   + niIt.GetNeighborhoodOffset() );
+                fah.Push( GrayVal, QueueElementType(statusNeighbor, neighbor) );
                 }
               // mark it as already in the fah
-              nsIt.Set(true);
+              status[statusNeighbor] = Processed;
               }
             }
           }
@@ -344,103 +402,80 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
     //  - copy markers pixels to output image
     //  - init FAH with indexes of pixels with background pixel in their
     //    neighborhood
-
-    ConstantBoundaryCondition< LabelImageType > lcbc2;
-    // outside pixel are watershed so they won't be use to find real watershed
-    // pixels
-    lcbc2.SetConstant( NumericTraits< LabelImagePixelType >::max() );
-    outputIt.OverrideBoundaryCondition(&lcbc2);
-
-    for ( markerIt.GoToBegin(), outputIt.GoToBegin(), inputIt.GoToBegin();
-          !markerIt.IsAtEnd();
-          ++markerIt, ++outputIt )
+    for ( SizeValueType l = 0; l < numberOfLines; l++ )
       {
-      LabelImagePixelType markerPixel = markerIt.GetCenterPixel();
-      if ( markerPixel != bgLabel )
+      const OffsetValueType lineOffset = static_cast< OffsetValueType >( l * size[0] );
+      for ( OffsetValueType x = 0; x < static_cast< OffsetValueType >( size[0] ); x++ )
         {
-        IndexType  idx = markerIt.GetIndex();
-        OffsetType shift = idx - inputIt.GetIndex();
-        inputIt += shift;
-
-        // this pixels belongs to a marker
-        // copy it to the output image
-        outputIt.SetCenterPixel(markerPixel);
-        // search if it has background pixel in its neighborhood
-        bool haveBgNeighbor = false;
-        for ( nmIt = markerIt.Begin(); nmIt != markerIt.End(); nmIt++ )
+        const OffsetValueType offset = lineOffset + x;
+        const OffsetValueType statusOffset = statusLines[l] + x;
+        const LabelImagePixelType markerPixel = marker[offset];
+        if ( markerPixel != bgLabel )
           {
-          if ( nmIt.Get() == bgLabel )
+          // this pixels belongs to a marker
+          // copy it to the output image
+          output[offset] = markerPixel;
+          // search if it has background pixel in its neighborhood
+          bool haveBgNeighbor = false;
+          for ( size_t n = 0; n < numberOfNeighbors; n++ )
+            {
+            if ( status[statusOffset + statusNeighbors[n]] != Outside
+                 && marker[offset + neighbors[n]] == bgLabel )
+              {
+              haveBgNeighbor = true;
+              break;
+              }
+            }
+          if ( haveBgNeighbor )
             {
-            haveBgNeighbor = true;
-            break;
+            // there is a background pixel in the neighborhood; add to fah
+            fah.Push( input[offset], QueueElementType(statusOffset, offset) );
+            }
+          else
+            {
+            // increase progress because this pixel will not be used in the
+            // flooding stage.
+            progress.CompletedPixel();
             }
-          }
-        if ( haveBgNeighbor )
-          {
-          // there is a background pixel in the neighborhood; add to fah
-          fah[inputIt.GetCenterPixel()].push( markerIt.GetIndex() );
           }
         else
           {
-          // increase progress because this pixel will not be used in the
-          // flooding stage.
-          progress.CompletedPixel();
+          output[offset] = wsLabel;
           }
+        progress.CompletedPixel();
         }
-      else
-        {
-        outputIt.SetCenterPixel(wsLabel);
-        }
-      progress.CompletedPixel();
       }
     // end of init stage
 
-    // flooding
-    // init all the iterators
-    outputIt.GoToBegin();
-    inputIt.GoToBegin();
-
     // and start flooding
-    while ( !fah.empty() )
+    while ( fah.PopLevel(currentValue, currentQueue) )
       {
-      // store the current vars
-      InputImagePixelType currentValue = fah.begin()->first;
-      QueueType           currentQueue = fah.begin()->second;
-      // and remove them from the fah
-      fah.erase( fah.begin() );
-
-      while ( !currentQueue.empty() )
+      // the pixels pushed at the current level are appended to the level
+      for ( size_t i = 0; i < currentQueue.size(); i++ )
         {
-        IndexType idx = currentQueue.front();
-        currentQueue.pop();
+        const OffsetValueType statusOffset = currentQueue[i].first;
+        const OffsetValueType offset = currentQueue[i].second;
 
-        // move the iterators to the right place
-        OffsetType shift = idx - outputIt.GetIndex();
-        outputIt += shift;
-        inputIt += shift;
-
-        LabelImagePixelType currentMarker = outputIt.GetCenterPixel();
+        LabelImagePixelType currentMarker = output[offset];
         // get the current value of the pixel
         // iterate over neighbors to propagate the marker
-        for ( noIt = outputIt.Begin(), niIt = inputIt.Begin();
-              noIt != outputIt.End();
-              noIt++, niIt++ )
+        for ( size_t n = 0; n < numberOfNeighbors; n++ )
           {
-          if ( noIt.Get() == wsLabel )
+          const OffsetValueType statusNeighbor = statusOffset + statusNeighbors[n];
+          const OffsetValueType neighbor = offset + neighbors[n];
+          if ( status[statusNeighbor] != Outside && output[neighbor] == wsLabel )
             {
             // the pixel is not yet processed. It can be labeled with the
             // current label
-            noIt.Set(currentMarker);
-            InputImagePixelType GrayVal = niIt.Get();
+            output[neighbor] = currentMarker;
+            InputImagePixelType GrayVal = input[neighbor];
             if ( GrayVal <= currentValue )
               {
-              currentQueue.push( inputIt.GetIndex()
-                                 + noIt.GetNeighborhoodOffset() );
+              currentQueue.push_back( QueueElementType(statusNeighbor, neighbor) );
               }
             else
               {
-              fah[GrayVal].push( inputIt.GetIndex()
-                                 + noIt.GetNeighborhoodOffset() );
+              fah.Push( GrayVal, QueueElementType(statusNeighbor, neighbor) );
               }
             progress.CompletedPixel();
             }
@@ -450,6 +485,343 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
     }
 }
 
+template< class TInputImage, class TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::FloodInBlocks(FloodingThreadStruct & str)
+{
+  const SizeValueType numberOfBlocks = str.BlockLines.size() - 1;
+
+  MultiThreader *threader = this->GetMultiThreader();
+  threader->SetNumberOfThreads( static_cast< ThreadIdType >( numberOfBlocks ) );
+  threader->SetSingleMethod(Self::FloodingThreaderCallback, &str);
+
+  // each block is flooded from its own markers
+  str.Stage = FloodBlocks;
+  threader->SingleMethodExecute();
+  this->UpdateProgress(0.5f);
+
+  // the blocks are flooded again from the pixels of their boundaries that
+  // are reached by a lower path from a neighbor block, until there is none
+  str.Seeds.resize(numberOfBlocks);
+  for (;; )
+    {
+    str.Stage = CollectBoundarySeeds;
+    threader->SingleMethodExecute();
+
+    SizeValueType numberOfSeeds = 0;
+    for ( SizeValueType b = 0; b < numberOfBlocks; b++ )
+      {
+      numberOfSeeds += str.Seeds[b].size();
+      }
+    if ( numberOfSeeds == 0 )
+      {
+      break;
+      }
+
+    str.Stage = FloodBoundarySeeds;
+    threader->SingleMethodExecute();
+    }
+  this->UpdateProgress(0.9f);
+
+  // the lines are found before any is marked, since marking a pixel
+  // changes the labels its neighbors see
+  if ( m_MarkWatershedLine )
+    {
+    str.Stage = FindWatershedLines;
+    threader->SingleMethodExecute();
+    str.Stage = MarkWatershedLines;
+    threader->SingleMethodExecute();
+    }
+}
+
+template< class TInputImage, class TLabelImage >
+ITK_THREAD_RETURN_TYPE
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::FloodingThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info =
+    static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  FloodingThreadStruct *str = static_cast< FloodingThreadStruct * >( info->UserData );
+
+  const SizeValueType numberOfBlocks = str->BlockLines.size() - 1;
+  for ( SizeValueType block = info->ThreadID; block < numberOfBlocks; block += info->NumberOfThreads )
+    {
+    str->Filter->ThreadedFloodBlock( *str, static_cast< ThreadIdType >( block ) );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TInputImage, class TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::ThreadedFloodBlock(FloodingThreadStruct & str, ThreadIdType block)
+{
+  static const LabelImagePixelType bgLabel =
+    NumericTraits< LabelImagePixelType >::Zero;
+  static const LabelImagePixelType wsLabel =
+    NumericTraits< LabelImagePixelType >::Zero;
+
+  // the states of the pixels in the status buffer, which is only read
+  // here, and in the state buffer, which has no padding
+  static const unsigned char NotProcessed = 0;
+  static const unsigned char Processed = 1;
+  static const unsigned char Outside = 2;
+  static const unsigned char Marker = 3;
+  static const unsigned char WatershedLine = 4;
+
+  const InputImagePixelType *            input = str.Input;
+  const LabelImagePixelType *            marker = str.Marker;
+  LabelImagePixelType *                  output = str.Output;
+  const unsigned char *                  status = str.Status;
+  unsigned char *                        state = str.State;
+  InputImagePixelType *                  level = str.Level;
+  const std::vector< OffsetValueType > & statusNeighbors = *str.StatusNeighbors;
+  const std::vector< OffsetValueType > & neighbors = *str.Neighbors;
+  const std::vector< OffsetValueType > & statusLines = *str.StatusLines;
+  const size_t                           numberOfNeighbors = neighbors.size();
+
+  const SizeValueType   numberOfBlocks = str.BlockLines.size() - 1;
+  const SizeValueType   firstLine = str.BlockLines[block];
+  const SizeValueType   endLine = str.BlockLines[block + 1];
+  const OffsetValueType lineLength = static_cast< OffsetValueType >( str.LineLength );
+  const OffsetValueType begin = static_cast< OffsetValueType >( firstLine ) * lineLength;
+  const OffsetValueType end = static_cast< OffsetValueType >( endLine ) * lineLength;
+
+  switch ( str.Stage )
+    {
+    case FloodBlocks:
+      {
+      // as in Beucher's algorithm, the marker pixels with background
+      // pixels in their neighborhood start the flooding
+      HierarchicalQueue fah;
+      fah.Initialize(str.Dense, str.Minimum, str.Maximum);
+      for ( SizeValueType l = firstLine; l < endLine; l++ )
+        {
+        const OffsetValueType lineOffset = static_cast< OffsetValueType >( l ) * lineLength;
+        for ( OffsetValueType x = 0; x < lineLength; x++ )
+          {
+          const OffsetValueType     offset = lineOffset + x;
+          const OffsetValueType     statusOffset = statusLines[l] + x;
+          const LabelImagePixelType markerPixel = marker[offset];
+          if ( markerPixel == bgLabel )
+            {
+            output[offset] = wsLabel;
+            state[offset] = NotProcessed;
+            continue;
+            }
+          output[offset] = markerPixel;
+          state[offset] = Marker;
+          level[offset] = input[offset];
+          for ( size_t n = 0; n < numberOfNeighbors; n++ )
+            {
+            if ( status[statusOffset + statusNeighbors[n]] != Outside
+                 && marker[offset + neighbors[n]] == bgLabel )
+              {
+              fah.Push( input[offset], QueueElementType(statusOffset, offset) );
+              break;
+              }
+            }
+          }
+        }
+      this->FloodBlockFromQueue(str, block, fah);
+      break;
+      }
+    case CollectBoundarySeeds:
+      {
+      // only the first and the last slices of a block have neighbors in
+      // the other blocks
+      std::vector< FloodingSeed > & seeds = str.Seeds[block];
+      seeds.clear();
+      for ( SizeValueType l = firstLine; l < endLine; l++ )
+        {
+        const bool firstSlice = ( block > 0 && l < firstLine + str.LinesPerSlice );
+        const bool lastSlice = ( block + 1 < numberOfBlocks && l + str.LinesPerSlice >= endLine );
+        if ( !firstSlice && !lastSlice )
+          {
+          continue;
+          }
+        const OffsetValueType lineOffset = static_cast< OffsetValueType >( l ) * lineLength;
+        for ( OffsetValueType x = 0; x < lineLength; x++ )
+          {
+          const OffsetValueType offset = lineOffset + x;
+          const OffsetValueType statusOffset = statusLines[l] + x;
+          if ( state[offset] == Marker )
+            {
+            continue;
+            }
+          // the lowest path from the neighbor blocks, if it is lower than
+          // the one the pixel was reached by
+          bool         found = false;
+          FloodingSeed seed;
+          for ( size_t n = 0; n < numberOfNeighbors; n++ )
+            {
+            const OffsetValueType neighbor = offset + neighbors[n];
+            if ( status[statusOffset + statusNeighbors[n]] == Outside
+                 || ( neighbor >= begin && neighbor < end )
+                 || state[neighbor] == NotProcessed )
+              {
+              continue;
+              }
+            const InputImagePixelType candidate = std::max(level[neighbor], input[offset]);
+            if ( ( state[offset] == NotProcessed || candidate < level[offset] )
+                 && ( !found || candidate < seed.Level ) )
+              {
+              found = true;
+              seed.Element = QueueElementType(statusOffset, offset);
+              seed.Level = candidate;
+              seed.Label = output[neighbor];
+              }
+            }
+          if ( found )
+            {
+            seeds.push_back(seed);
+            }
+          }
+        }
+      break;
+      }
+    case FloodBoundarySeeds:
+      {
+      HierarchicalQueue fah;
+      fah.Initialize(str.Dense, str.Minimum, str.Maximum);
+      const std::vector< FloodingSeed > & seeds = str.Seeds[block];
+      for ( size_t i = 0; i < seeds.size(); i++ )
+        {
+        const OffsetValueType offset = seeds[i].Element.second;
+        state[offset] = Processed;
+        level[offset] = seeds[i].Level;
+        output[offset] = seeds[i].Label;
+        fah.Push(seeds[i].Level, seeds[i].Element);
+        }
+      this->FloodBlockFromQueue(str, block, fah);
+      break;
+      }
+    case FindWatershedLines:
+      {
+      // of two neighbors with different labels, the one reached last, or
+      // at the same level the one with the larger offset, is on the line
+      for ( SizeValueType l = firstLine; l < endLine; l++ )
+        {
+        const OffsetValueType lineOffset = static_cast< OffsetValueType >( l ) * lineLength;
+        for ( OffsetValueType x = 0; x < lineLength; x++ )
+          {
+          const OffsetValueType offset = lineOffset + x;
+          const OffsetValueType statusOffset = statusLines[l] + x;
+          if ( state[offset] != Processed )
+            {
+            continue;
+            }
+          for ( size_t n = 0; n < numberOfNeighbors; n++ )
+            {
+            const OffsetValueType neighbor = offset + neighbors[n];
+            if ( status[statusOffset + statusNeighbors[n]] == Outside )
+              {
+              continue;
+              }
+            const LabelImagePixelType o = output[neighbor];
+            if ( o == wsLabel || o == output[offset] )
+              {
+              continue;
+              }
+            if ( marker[neighbor] != bgLabel
+                 || level[neighbor] < level[offset]
+                 || ( !( level[offset] < level[neighbor] ) && neighbor < offset ) )
+              {
+              state[offset] = WatershedLine;
+              break;
+              }
+            }
+          }
+        }
+      break;
+      }
+    case MarkWatershedLines:
+      {
+      for ( OffsetValueType offset = begin; offset < end; offset++ )
+        {
+        if ( state[offset] == WatershedLine )
+          {
+          output[offset] = wsLabel;
+          }
+        }
+      break;
+      }
+    }
+}
+
+template< class TInputImage, class TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::FloodBlockFromQueue(FloodingThreadStruct & str, ThreadIdType block, HierarchicalQueue & fah)
+{
+  static const unsigned char NotProcessed = 0;
+  static const unsigned char Processed = 1;
+  static const unsigned char Outside = 2;
+  static const unsigned char Marker = 3;
+
+  const InputImagePixelType *            input = str.Input;
+  LabelImagePixelType *                  output = str.Output;
+  const unsigned char *                  status = str.Status;
+  unsigned char *                        state = str.State;
+  InputImagePixelType *                  level = str.Level;
+  const std::vector< OffsetValueType > & statusNeighbors = *str.StatusNeighbors;
+  const std::vector< OffsetValueType > & neighbors = *str.Neighbors;
+  const size_t                           numberOfNeighbors = neighbors.size();
+
+  const OffsetValueType lineLength = static_cast< OffsetValueType >( str.LineLength );
+  const OffsetValueType begin = static_cast< OffsetValueType >( str.BlockLines[block] ) * lineLength;
+  const OffsetValueType end = static_cast< OffsetValueType >( str.BlockLines[block + 1] ) * lineLength;
+
+  InputImagePixelType currentValue;
+  QueueLevelType      currentQueue;
+  while ( fah.PopLevel(currentValue, currentQueue) )
+    {
+    // the pixels pushed at the current level are appended to the level
+    for ( size_t i = 0; i < currentQueue.size(); i++ )
+      {
+      const OffsetValueType statusOffset = currentQueue[i].first;
+      const OffsetValueType offset = currentQueue[i].second;
+
+      // a pixel reached again by a lower path was flooded from there
+      if ( level[offset] < currentValue )
+        {
+        continue;
+        }
+
+      const LabelImagePixelType currentMarker = output[offset];
+      for ( size_t n = 0; n < numberOfNeighbors; n++ )
+        {
+        const OffsetValueType statusNeighbor = statusOffset + statusNeighbors[n];
+        const OffsetValueType neighbor = offset + neighbors[n];
+        if ( status[statusNeighbor] == Outside
+             || neighbor < begin || neighbor >= end
+             || state[neighbor] == Marker )
+          {
+          continue;
+          }
+        const InputImagePixelType GrayVal = input[neighbor];
+        const InputImagePixelType neighborLevel = GrayVal <= currentValue ? currentValue : GrayVal;
+        if ( state[neighbor] == NotProcessed || neighborLevel < level[neighbor] )
+          {
+          state[neighbor] = Processed;
+          level[neighbor] = neighborLevel;
+          output[neighbor] = currentMarker;
+          if ( GrayVal <= currentValue )
+            {
+            currentQueue.push_back( QueueElementType(statusNeighbor, neighbor) );
+            }
+          else
+            {
+            fah.Push( GrayVal, QueueElementType(statusNeighbor, neighbor) );
+            }
+          }
+        }
+      }
+    }
+}
+
 template< class TInputImage, class TLabelImage >
 void
 MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
@@ -459,6 +831,7 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
 
   os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
   os << indent << "MarkWatershedLine: "  << m_MarkWatershedLine << std::endl;
+  os << indent << "ParallelFlooding: "  << m_ParallelFlooding << std::endl;
 }
 } // end namespace itk
 #endif
@@ -105,6 +105,15 @@ public:
   itkGetConstReferenceMacro(MarkWatershedLine, bool);
   itkBooleanMacro(MarkWatershedLine);
 
+  /**
+   * Set/Get whether the image is flooded in blocks on the threads of the
+   * filter. Default is false.
+   * \sa MorphologicalWatershedFromMarkersImageFilter::SetParallelFlooding
+   */
+  itkSetMacro(ParallelFlooding, bool);
+  itkGetConstReferenceMacro(ParallelFlooding, bool);
+  itkBooleanMacro(ParallelFlooding);
+
   /**
    */
   itkSetMacro(Level, InputImagePixelType);
@@ -134,6 +143,8 @@ private:
 
   bool m_MarkWatershedLine;
 
+  bool m_ParallelFlooding;
+
   InputImagePixelType m_Level;
 }; // end of class
 } // end namespace itk
@@ -42,6 +42,7 @@ MorphologicalWatershedImageFilter< TInputImage, TOutputImage >
 {
   m_FullyConnected = false;
   m_MarkWatershedLine = true;
+  m_ParallelFlooding = false;
   m_Level = NumericTraits< InputImagePixelType >::Zero;
 }
 
@@ -110,6 +111,8 @@ MorphologicalWatershedImageFilter< TInputImage, TOutputImage >
   wshed->SetMarkerImage( label->GetOutput() );
   wshed->SetFullyConnected(m_FullyConnected);
   wshed->SetMarkWatershedLine(m_MarkWatershedLine);
+  wshed->SetParallelFlooding(m_ParallelFlooding);
+  wshed->SetNumberOfThreads( this->GetNumberOfThreads() );
 
   if ( m_Level != NumericTraits< InputImagePixelType >::Zero )
     {
@@ -157,6 +160,7 @@ MorphologicalWatershedImageFilter< TInputImage, TOutputImage >
 
   os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
   os << indent << "MarkWatershedLine: "  << m_MarkWatershedLine << std::endl;
+  os << indent << "ParallelFlooding: "  << m_ParallelFlooding << std::endl;
   os << indent << "Level: "
      << static_cast< typename NumericTraits< InputImagePixelType >::PrintType >( m_Level )
      << std::endl;
@@ -0,0 +1,366 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include <queue>
+
+// Compare the watershed of an image of an integral type, which uses the
+// dense hierarchical queue, with the one of the same image with a real
+// type, which uses the map based queue, and with the expected watershed
+// of two basins separated by a ridge. The flooding in blocks on several
+// threads must give the same ridge watershed, the same labels as the
+// single threaded flooding on one thread, and on more threads labels
+// that are still reached by a path of lowest maximal value.
+
+namespace
+{
+const unsigned int Dimension = 2;
+
+typedef itk::Image< short, Dimension >         ShortImageType;
+typedef itk::Image< float, Dimension >         FloatImageType;
+typedef itk::Image< unsigned char, Dimension > LabelImageType;
+
+template< class TInputImage >
+typename LabelImageType::Pointer
+Watershed( const TInputImage *input, const LabelImageType *markers,
+           bool fullyConnected, bool markWatershedLine,
+           bool parallelFlooding = false, itk::ThreadIdType numberOfThreads = 1 )
+{
+  typedef itk::MorphologicalWatershedFromMarkersImageFilter< TInputImage, LabelImageType >
+    FilterType;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( input );
+  filter->SetMarkerImage( markers );
+  filter->SetFullyConnected( fullyConnected );
+  filter->SetMarkWatershedLine( markWatershedLine );
+  filter->SetParallelFlooding( parallelFlooding );
+  if( parallelFlooding )
+    {
+    filter->SetNumberOfThreads( numberOfThreads );
+    }
+  filter->Update();
+
+  LabelImageType::Pointer output = filter->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+typedef std::pair< short, LabelImageType::IndexType > CostElementType;
+
+struct CostElementGreater
+{
+  bool operator()( const CostElementType & a, const CostElementType & b ) const
+  {
+    return a.first > b.first;
+  }
+};
+
+// The lowest maximal value of the paths from the markers of the given
+// label to each pixel, which do not cross the markers of other labels.
+ShortImageType::Pointer
+LabelCost( const ShortImageType *input, const LabelImageType *markers,
+           unsigned char label, bool fullyConnected )
+{
+  const ShortImageType::RegionType region = input->GetLargestPossibleRegion();
+  ShortImageType::Pointer cost = ShortImageType::New();
+  cost->SetRegions( region );
+  cost->Allocate();
+  cost->FillBuffer( itk::NumericTraits< short >::max() );
+
+  std::priority_queue< CostElementType, std::vector< CostElementType >, CostElementGreater > queue;
+  itk::ImageRegionConstIteratorWithIndex< LabelImageType > mit( markers, region );
+  for( ; !mit.IsAtEnd(); ++mit )
+    {
+    if( mit.Get() == label )
+      {
+      cost->SetPixel( mit.GetIndex(), input->GetPixel( mit.GetIndex() ) );
+      queue.push( CostElementType( input->GetPixel( mit.GetIndex() ), mit.GetIndex() ) );
+      }
+    }
+
+  while( !queue.empty() )
+    {
+    const CostElementType top = queue.top();
+    queue.pop();
+    if( top.first > cost->GetPixel( top.second ) )
+      {
+      continue;
+      }
+    for( int dy = -1; dy <= 1; dy++ )
+      {
+      for( int dx = -1; dx <= 1; dx++ )
+        {
+        if( ( dx == 0 && dy == 0 ) || ( !fullyConnected && dx != 0 && dy != 0 ) )
+          {
+          continue;
+          }
+        LabelImageType::IndexType neighbor = top.second;
+        neighbor[0] += dx;
+        neighbor[1] += dy;
+        if( !region.IsInside( neighbor ) || markers->GetPixel( neighbor ) != 0 )
+          {
+          continue;
+          }
+        const short neighborCost = std::max( top.first, input->GetPixel( neighbor ) );
+        if( neighborCost < cost->GetPixel( neighbor ) )
+          {
+          cost->SetPixel( neighbor, neighborCost );
+          queue.push( CostElementType( neighborCost, neighbor ) );
+          }
+        }
+      }
+    }
+  return cost;
+}
+
+// Count the labeled pixels that are not reached at the lowest level by
+// the markers of their label, and, with watershed lines, those next to a
+// pixel of another label.
+unsigned int
+CountFloodingErrors( const ShortImageType *input, const LabelImageType *markers,
+                     const LabelImageType *output, bool fullyConnected,
+                     bool markWatershedLine, unsigned char numberOfLabels )
+{
+  std::vector< ShortImageType::Pointer > costs( numberOfLabels + 1 );
+  for( unsigned char label = 1; label <= numberOfLabels; label++ )
+    {
+    costs[label] = LabelCost( input, markers, label, fullyConnected );
+    }
+
+  const ShortImageType::RegionType region = input->GetLargestPossibleRegion();
+  unsigned int numberOfErrors = 0;
+  itk::ImageRegionConstIteratorWithIndex< LabelImageType > oit( output, region );
+  for( ; !oit.IsAtEnd(); ++oit )
+    {
+    const LabelImageType::IndexType & index = oit.GetIndex();
+    const unsigned char label = oit.Get();
+    if( label == 0 || markers->GetPixel( index ) != 0 )
+      {
+      continue;
+      }
+    short lowest = itk::NumericTraits< short >::max();
+    for( unsigned char l = 1; l <= numberOfLabels; l++ )
+      {
+      lowest = std::min( lowest, costs[l]->GetPixel( index ) );
+      }
+    if( costs[label]->GetPixel( index ) != lowest )
+      {
+      numberOfErrors++;
+      }
+    if( !markWatershedLine )
+      {
+      continue;
+      }
+    for( int dy = -1; dy <= 1; dy++ )
+      {
+      for( int dx = -1; dx <= 1; dx++ )
+        {
+        if( ( dx == 0 && dy == 0 ) || ( !fullyConnected && dx != 0 && dy != 0 ) )
+          {
+          continue;
+          }
+        LabelImageType::IndexType neighbor = index;
+        neighbor[0] += dx;
+        neighbor[1] += dy;
+        if( region.IsInside( neighbor ) && output->GetPixel( neighbor ) != 0
+            && output->GetPixel( neighbor ) != label )
+          {
+          numberOfErrors++;
+          }
+        }
+      }
+    }
+  return numberOfErrors;
+}
+}
+
+int itkMorphologicalWatershedFromMarkersImageFilterTest2( int, char* [] )
+{
+  ShortImageType::SizeType size = {{ 41, 23 }};
+  ShortImageType::RegionType region;
+  region.SetSize( size );
+
+  ShortImageType::Pointer ridge = ShortImageType::New();
+  ridge->SetRegions( region );
+  ridge->Allocate();
+
+  ShortImageType::Pointer noise = ShortImageType::New();
+  noise->SetRegions( region );
+  noise->Allocate();
+
+  FloatImageType::Pointer floatRidge = FloatImageType::New();
+  floatRidge->SetRegions( region );
+  floatRidge->Allocate();
+
+  FloatImageType::Pointer floatNoise = FloatImageType::New();
+  floatNoise->SetRegions( region );
+  floatNoise->Allocate();
+
+  LabelImageType::Pointer markers = LabelImageType::New();
+  markers->SetRegions( region );
+  markers->Allocate();
+  markers->FillBuffer( 0 );
+
+  unsigned int seed = 4321;
+  itk::ImageRegionIteratorWithIndex< ShortImageType > it( ridge, region );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    const ShortImageType::IndexType & index = it.GetIndex();
+
+    // a ridge along the middle column
+    const short value = static_cast< short >( 1000 - 10 * vnl_math_abs( index[0] - 20 ) );
+    it.Set( value );
+    floatRidge->SetPixel( index, value );
+
+    seed = seed * 1103515245 + 12345;
+    const short noiseValue = static_cast< short >( ( seed >> 16 ) % 50 - 25 );
+    noise->SetPixel( index, noiseValue );
+    floatNoise->SetPixel( index, noiseValue );
+
+    if( ( seed >> 8 ) % 37 == 0 )
+      {
+      markers->SetPixel( index, 1 + ( seed >> 20 ) % 5 );
+      }
+    }
+
+  bool passed = true;
+
+  // two markers on each side of the ridge
+  LabelImageType::Pointer ridgeMarkers = LabelImageType::New();
+  ridgeMarkers->SetRegions( region );
+  ridgeMarkers->Allocate();
+  ridgeMarkers->FillBuffer( 0 );
+  LabelImageType::IndexType markerIndex = {{ 0, 11 }};
+  ridgeMarkers->SetPixel( markerIndex, 1 );
+  markerIndex[0] = 40;
+  ridgeMarkers->SetPixel( markerIndex, 2 );
+
+  for( unsigned int fullyConnected = 0; fullyConnected < 2; fullyConnected++ )
+    {
+    for( unsigned int line = 0; line < 2; line++ )
+      {
+      LabelImageType::Pointer shortOutput =
+        Watershed( ridge.GetPointer(), ridgeMarkers, fullyConnected, line );
+      LabelImageType::Pointer floatOutput =
+        Watershed( floatRidge.GetPointer(), ridgeMarkers, fullyConnected, line );
+
+      unsigned int numberOfErrors = 0;
+      itk::ImageRegionIteratorWithIndex< LabelImageType > oit( shortOutput, region );
+      for( ; !oit.IsAtEnd(); ++oit )
+        {
+        const LabelImageType::IndexType & index = oit.GetIndex();
+        if( oit.Get() != floatOutput->GetPixel( index ) )
+          {
+          numberOfErrors++;
+          }
+        else if( index[0] < 20 && oit.Get() != 1 )
+          {
+          numberOfErrors++;
+          }
+        else if( index[0] > 20 && oit.Get() != 2 )
+          {
+          numberOfErrors++;
+          }
+        else if( index[0] == 20 && ( line ? oit.Get() != 0 : oit.Get() == 0 ) )
+          {
+          numberOfErrors++;
+          }
+        }
+      std::cout << "Ridge, FullyConnected: " << fullyConnected
+                << ", MarkWatershedLine: " << line
+                << ", errors: " << numberOfErrors << std::endl;
+      passed &= ( numberOfErrors == 0 );
+
+      // random markers on a noisy image
+      shortOutput = Watershed( noise.GetPointer(), markers, fullyConnected, line );
+      floatOutput = Watershed( floatNoise.GetPointer(), markers, fullyConnected, line );
+
+      numberOfErrors = 0;
+      itk::ImageRegionConstIterator< LabelImageType > sit( shortOutput, region );
+      itk::ImageRegionConstIterator< LabelImageType > fit( floatOutput, region );
+      for( ; !sit.IsAtEnd(); ++sit, ++fit )
+        {
+        numberOfErrors += ( sit.Get() != fit.Get() );
+        }
+      std::cout << "Noise, FullyConnected: " << fullyConnected
+                << ", MarkWatershedLine: " << line
+                << ", differences: " << numberOfErrors << std::endl;
+      passed &= ( numberOfErrors == 0 );
+      }
+    }
+
+  // the flooding in blocks; on one thread, the labels must be those of
+  // the single threaded flooding
+  for( unsigned int fullyConnected = 0; fullyConnected < 2; fullyConnected++ )
+    {
+    LabelImageType::Pointer sequentialOutput =
+      Watershed( noise.GetPointer(), markers, fullyConnected, false );
+    LabelImageType::Pointer parallelOutput =
+      Watershed( noise.GetPointer(), markers, fullyConnected, false, true, 1 );
+    unsigned int numberOfErrors = 0;
+    itk::ImageRegionConstIterator< LabelImageType > sit( sequentialOutput, region );
+    itk::ImageRegionConstIterator< LabelImageType > pit( parallelOutput, region );
+    for( ; !sit.IsAtEnd(); ++sit, ++pit )
+      {
+      numberOfErrors += ( sit.Get() != pit.Get() );
+      }
+    std::cout << "Parallel flooding on one thread, FullyConnected: " << fullyConnected
+              << ", differences: " << numberOfErrors << std::endl;
+    passed &= ( numberOfErrors == 0 );
+
+    for( itk::ThreadIdType threads = 1; threads <= 5; threads++ )
+      {
+      for( unsigned int line = 0; line < 2; line++ )
+        {
+        LabelImageType::Pointer ridgeOutput =
+          Watershed( ridge.GetPointer(), ridgeMarkers, fullyConnected, line, true, threads );
+        numberOfErrors = 0;
+        itk::ImageRegionConstIteratorWithIndex< LabelImageType > rit( ridgeOutput, region );
+        for( ; !rit.IsAtEnd(); ++rit )
+          {
+          const LabelImageType::IndexType & index = rit.GetIndex();
+          if( ( index[0] < 20 && rit.Get() != 1 )
+              || ( index[0] > 20 && rit.Get() != 2 )
+              || ( index[0] == 20 && ( line ? rit.Get() != 0 : rit.Get() == 0 ) ) )
+            {
+            numberOfErrors++;
+            }
+          }
+
+        parallelOutput = Watershed( noise.GetPointer(), markers, fullyConnected, line, true, threads );
+        const unsigned int numberOfFloodingErrors =
+          CountFloodingErrors( noise, markers, parallelOutput, fullyConnected, line, 5 );
+        std::cout << "Parallel flooding on " << threads << " threads, FullyConnected: "
+                  << fullyConnected << ", MarkWatershedLine: " << line
+                  << ", ridge errors: " << numberOfErrors
+                  << ", noise errors: " << numberOfFloodingErrors << std::endl;
+        passed &= ( numberOfErrors == 0 && numberOfFloodingErrors == 0 );
+        }
+      }
+    }
+
+  if( !passed )
+    {
+    std::cout << "Test failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
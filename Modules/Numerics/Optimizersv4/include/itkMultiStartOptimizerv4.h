@@ -19,6 +19,8 @@
 #define __itkMultiStartOptimizerv4_h
 #include "itkObjectToObjectOptimizerBase.h"
 #include "itkGradientDescentOptimizerv4.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleFastMutexLock.h"
 
 namespace itk
 {
@@ -33,6 +35,27 @@ namespace itk
  *   focus modifying the parameter sample space.  This is why we place the burden on the user to provide
  *   the parameter samples over which to optimize.
  *
+ *   When \c UseConcurrentEvaluation is on and no local optimizer is set, the
+ *   start points are evaluated concurrently on \c NumberOfThreads workers.
+ *   Each worker evaluates its own clone of the metric (see
+ *   ImageToImageMetricv4::InternalClone), restricted to a single thread, and
+ *   picks the next unevaluated start from a shared counter.  This avoids the
+ *   per-evaluation threading overhead of the metric when the search
+ *   evaluates many starts on small images, e.g. rotation searches for rigid
+ *   initialization.  The best value is tracked across workers; ties are
+ *   resolved in favor of the lower start index so the result matches the
+ *   sequential search.  If the metric cannot be cloned, the sequential
+ *   search is used.
+ *
+ *   With \c UseEarlyTermination on, the search stops as soon as a start
+ *   reaches a metric value at or below \c EarlyTerminationValue.  In both
+ *   the sequential and the concurrent search, the metric values list then
+ *   holds only the values of the starts that were evaluated, in start
+ *   order; starts that were skipped or failed to evaluate are left out.
+ *   Starts already being evaluated by other workers when the concurrent
+ *   search stops are completed, so it may hold a few more values than the
+ *   sequential search.
+ *
  * \ingroup ITKOptimizersv4
  */
 
@@ -125,7 +148,8 @@ public:
   /** Set the list of parameters over which to search */
   void SetParametersList(ParametersListType & p);
 
-  /** Get the list of metric values that we produced after the multi-start search.  */
+  /** Get the list of metric values that we produced after the multi-start search.
+   * It holds the values of the evaluated start points only, in start order. */
   const MetricValuesListType & GetMetricValuesList() const;
 
   /** Return the parameters from the best visited position */
@@ -137,6 +161,24 @@ public:
 
   inline ParameterListSizeType GetBestParametersIndex( ) { return this->m_BestParametersIndex; }
 
+  /** Set/Get whether the start points are evaluated concurrently, each worker
+   * thread using its own single-threaded clone of the metric. Only used when
+   * no local optimizer is set. Default is off. */
+  itkSetMacro( UseConcurrentEvaluation, bool );
+  itkGetConstMacro( UseConcurrentEvaluation, bool );
+  itkBooleanMacro( UseConcurrentEvaluation );
+
+  /** Set/Get whether the search stops once a start point reaches a metric
+   * value at or below \c EarlyTerminationValue. Default is off. */
+  itkSetMacro( UseEarlyTermination, bool );
+  itkGetConstMacro( UseEarlyTermination, bool );
+  itkBooleanMacro( UseEarlyTermination );
+
+  /** Set/Get the metric value that is considered good enough to stop the
+   * search when \c UseEarlyTermination is on. */
+  itkSetMacro( EarlyTerminationValue, MeasureType );
+  itkGetConstMacro( EarlyTerminationValue, MeasureType );
+
 protected:
 
   /** Default constructor */
@@ -157,11 +199,42 @@ protected:
   MeasureType                   m_MaximumMetricValue;
   ParameterListSizeType         m_BestParametersIndex;
   OptimizerPointer              m_LocalOptimizer;
+  bool                          m_UseConcurrentEvaluation;
+  bool                          m_UseEarlyTermination;
+  MeasureType                   m_EarlyTerminationValue;
+
+  /** Evaluate the start points concurrently. Returns false, without
+   * evaluating anything, if the metric could not be cloned for the
+   * worker threads. */
+  bool ConcurrentEvaluation();
+
+  /** Evaluate start points with the metric clone of the given worker until
+   * none are left or the search is stopped. */
+  void ThreadedEvaluateStarts( ThreadIdType threadId );
+
+  /** Static function used as a "callback" by the MultiThreader. */
+  static ITK_THREAD_RETURN_TYPE ConcurrentEvaluationThreaderCallback( void *arg );
 
 private:
   MultiStartOptimizerv4( const Self & ); //purposely not implemented
   void operator=( const Self& ); //purposely not implemented
 
+  typedef std::vector< MetricTypePointer > MetricListType;
+
+  /** One metric clone per worker during concurrent evaluation. */
+  MetricListType                m_ConcurrentMetrics;
+
+  /** Index of the next start point to be evaluated by a worker. */
+  ParameterListSizeType         m_NextStartIndex;
+
+  /** Whether each start point was evaluated without failing by a worker. */
+  std::vector< bool >           m_ConcurrentValidStarts;
+
+  /** Number of start points that failed to evaluate in a worker. */
+  SizeValueType                 m_NumberOfFailedStarts;
+
+  /** Guards the shared start counter and best value tracker. */
+  SimpleFastMutexLock           m_ConcurrentEvaluationLock;
 };
 
 } // end namespace itk
@@ -19,6 +19,7 @@
 #define __itkObjectToObjectMetric_h
 
 #include "itkSingleValuedCostFunctionv4.h"
+#include "itkIntTypes.h"
 
 namespace itk
 {
@@ -144,6 +145,12 @@ public:
   virtual void UpdateTransformParameters( DerivativeType & derivative,
                                           ParametersValueType factor = NumericTraits<ParametersValueType>::One) = 0;
 
+  /** Set the maximum number of threads used by the metric's own threaded
+   * evaluation. The default implementation does nothing; metrics that thread
+   * their evaluation override it. Used e.g. by MultiStartOptimizerv4 to keep
+   * concurrently evaluated metric clones single-threaded. */
+  virtual void SetMaximumNumberOfThreads( const ThreadIdType ) {}
+
 protected:
   ObjectToObjectMetric();
   virtual ~ObjectToObjectMetric();
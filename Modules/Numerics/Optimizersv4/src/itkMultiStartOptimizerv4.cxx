@@ -34,6 +34,11 @@ MultiStartOptimizerv4
   this->m_MaximumMetricValue=NumericTraits<MeasureType>::max();
   this->m_MinimumMetricValue = this->m_MaximumMetricValue;
   m_LocalOptimizer = NULL;
+  this->m_UseConcurrentEvaluation = false;
+  this->m_UseEarlyTermination = false;
+  this->m_EarlyTerminationValue = NumericTraits<MeasureType>::NonpositiveMin();
+  this->m_NextStartIndex = static_cast<ParameterListSizeType>(0);
+  this->m_NumberOfFailedStarts = 0;
 }
 
 //-------------------------------------------------------------------
@@ -51,6 +56,9 @@ MultiStartOptimizerv4
   os << indent << "Current iteration: " << this->m_CurrentIteration << std::endl;
   os << indent << "Stop condition:"<< this->m_StopCondition << std::endl;
   os << indent << "Stop condition description: " << this->m_StopConditionDescription.str()  << std::endl;
+  os << indent << "Use concurrent evaluation: " << this->m_UseConcurrentEvaluation << std::endl;
+  os << indent << "Use early termination: " << this->m_UseEarlyTermination << std::endl;
+  os << indent << "Early termination value: " << this->m_EarlyTerminationValue << std::endl;
 }
 
 //-------------------------------------------------------------------
@@ -165,6 +173,20 @@ MultiStartOptimizerv4
   this->InvokeEvent( StartEvent() );
 
   this->m_Stop = false;
+
+  if( this->m_UseConcurrentEvaluation )
+    {
+    if( this->m_LocalOptimizer )
+      {
+      itkWarningMacro("Concurrent evaluation is not available with a local optimizer. "
+                      "Evaluating the start points sequentially.");
+      }
+    else if( this->ConcurrentEvaluation() )
+      {
+      return;
+      }
+    }
+
   while( ! this->m_Stop )
     {
     /* Compute metric value */
@@ -193,6 +215,15 @@ MultiStartOptimizerv4
       this->m_MinimumMetricValue=this->m_Value;
       this->m_BestParametersIndex = this->m_CurrentIteration;
       }
+    if ( this->m_UseEarlyTermination && this->m_Value <= this->m_EarlyTerminationValue )
+      {
+      this->m_StopConditionDescription << "Metric value " << this->m_Value
+                                 << " reached the early termination value ("
+                                 << this->m_EarlyTerminationValue << ").";
+      this->m_StopCondition = CONVERGENCE_CHECKER_PASSED;
+      this->StopOptimization();
+      break;
+      }
     /* Check if optimization has been stopped externally.
      * (Presumably this could happen from a multi-threaded client app?) */
     if ( this->m_Stop )
@@ -217,4 +248,179 @@ MultiStartOptimizerv4
     } //while (!m_Stop)
 }
 
+//-------------------------------------------------------------------
+bool
+MultiStartOptimizerv4
+::ConcurrentEvaluation()
+{
+  ThreadIdType numberOfWorkers = this->m_NumberOfThreads;
+  if( static_cast<SizeValueType>( numberOfWorkers ) > this->m_NumberOfIterations )
+    {
+    numberOfWorkers = static_cast<ThreadIdType>( this->m_NumberOfIterations );
+    }
+
+  /* Each worker gets its own single-threaded metric, so that the transform
+   * parameters of one start are not overwritten by another worker. */
+  this->m_ConcurrentMetrics.clear();
+  for( ThreadIdType i = 0; i < numberOfWorkers; i++ )
+    {
+    MetricTypePointer clone = dynamic_cast< MetricType * >( this->m_Metric->Clone().GetPointer() );
+    if( clone.IsNull() )
+      {
+      itkWarningMacro("The metric could not be cloned. Evaluating the start points sequentially.");
+      this->m_ConcurrentMetrics.clear();
+      return false;
+      }
+    try
+      {
+      clone->SetMaximumNumberOfThreads( 1 );
+      clone->Initialize();
+      }
+    catch ( ExceptionObject & err )
+      {
+      itkWarningMacro("The metric clone could not be initialized (" << err.GetDescription()
+                      << "). Evaluating the start points sequentially.");
+      this->m_ConcurrentMetrics.clear();
+      return false;
+      }
+    this->m_ConcurrentMetrics.push_back( clone );
+    }
+
+  this->m_MetricValuesList.assign( this->m_NumberOfIterations, NumericTraits<MeasureType>::max() );
+  this->m_ConcurrentValidStarts.assign( this->m_NumberOfIterations, false );
+  this->m_NextStartIndex = static_cast<ParameterListSizeType>(0);
+  this->m_NumberOfFailedStarts = 0;
+  this->m_CurrentIteration = static_cast<SizeValueType>(0);
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( numberOfWorkers );
+  threader->SetSingleMethod( Self::ConcurrentEvaluationThreaderCallback, this );
+  threader->SingleMethodExecute();
+
+  this->m_ConcurrentMetrics.clear();
+
+  /* Workers take the starts in order, so the evaluated starts are those
+   * below m_NextStartIndex. As in the sequential search, the list holds
+   * the values of those that did not fail, in start order. */
+  MetricValuesListType::size_type numberOfValues = 0;
+  for( ParameterListSizeType index = 0; index < this->m_NextStartIndex; index++ )
+    {
+    if( this->m_ConcurrentValidStarts[index] )
+      {
+      this->m_MetricValuesList[numberOfValues++] = this->m_MetricValuesList[index];
+      }
+    }
+  this->m_MetricValuesList.resize( numberOfValues );
+  this->m_ConcurrentValidStarts.clear();
+
+  if( this->m_NumberOfFailedStarts > 0 )
+    {
+    itkWarningMacro("An exception occurred in " << this->m_NumberOfFailedStarts
+                    << " of the sub-optimizations.  If too many of these occur, you may need to set a different set of initial parameters.");
+    }
+  if( this->m_CurrentIteration > 0 )
+    {
+    this->m_Value = this->m_MinimumMetricValue;
+    }
+  this->InvokeEvent( IterationEvent() );
+
+  if( this->m_Stop && this->m_CurrentIteration < this->m_NumberOfIterations )
+    {
+    if( this->m_UseEarlyTermination && this->m_MinimumMetricValue <= this->m_EarlyTerminationValue )
+      {
+      this->m_StopConditionDescription << "Metric value " << this->m_MinimumMetricValue
+                                 << " reached the early termination value ("
+                                 << this->m_EarlyTerminationValue << ").";
+      this->m_StopCondition = CONVERGENCE_CHECKER_PASSED;
+      }
+    else
+      {
+      this->m_StopConditionDescription << "StopOptimization() called";
+      }
+    }
+  else
+    {
+    this->m_StopConditionDescription << "Maximum number of iterations ("
+                               << this->m_NumberOfIterations
+                               << ") exceeded.";
+    this->m_StopCondition = MAXIMUM_NUMBER_OF_ITERATIONS;
+    }
+  this->StopOptimization();
+  return true;
+}
+
+//-------------------------------------------------------------------
+ITK_THREAD_RETURN_TYPE
+MultiStartOptimizerv4
+::ConcurrentEvaluationThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  Self * self = static_cast<Self *>( info->UserData );
+  self->ThreadedEvaluateStarts( info->ThreadID );
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+//-------------------------------------------------------------------
+void
+MultiStartOptimizerv4
+::ThreadedEvaluateStarts( ThreadIdType threadId )
+{
+  if( static_cast<MetricListType::size_type>( threadId ) >= this->m_ConcurrentMetrics.size() )
+    {
+    return;
+    }
+  MetricType * metric = this->m_ConcurrentMetrics[threadId];
+
+  while( true )
+    {
+    ParameterListSizeType index;
+    this->m_ConcurrentEvaluationLock.Lock();
+    if( this->m_Stop || this->m_NextStartIndex >= this->m_NumberOfIterations )
+      {
+      this->m_ConcurrentEvaluationLock.Unlock();
+      break;
+      }
+    index = this->m_NextStartIndex++;
+    this->m_ConcurrentEvaluationLock.Unlock();
+
+    MeasureType value = NumericTraits<MeasureType>::max();
+    bool        valid = true;
+    try
+      {
+      ParametersType parameters( this->m_ParametersList[index] );
+      metric->SetParameters( parameters );
+      value = metric->GetValue();
+      }
+    catch ( ExceptionObject & )
+      {
+      /** As in the sequential search, a failing start point is simply
+       * skipped. Warnings are reported once all workers are done. */
+      valid = false;
+      }
+
+    this->m_ConcurrentEvaluationLock.Lock();
+    this->m_CurrentIteration++;
+    if( valid )
+      {
+      this->m_MetricValuesList[index] = value;
+      this->m_ConcurrentValidStarts[index] = true;
+      if( value < this->m_MinimumMetricValue
+          || ( value == this->m_MinimumMetricValue && index < this->m_BestParametersIndex ) )
+        {
+        this->m_MinimumMetricValue = value;
+        this->m_BestParametersIndex = index;
+        }
+      if( this->m_UseEarlyTermination && value <= this->m_EarlyTerminationValue )
+        {
+        this->m_Stop = true;
+        }
+      }
+    else
+      {
+      this->m_NumberOfFailedStarts++;
+      }
+    this->m_ConcurrentEvaluationLock.Unlock();
+    }
+}
+
 } //namespace itk
@@ -0,0 +1,205 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkMultiStartOptimizerv4.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkEuler2DTransform.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTimeProbe.h"
+
+/**
+ *  This test evaluates a rotation search with MultiStartOptimizerv4 and
+ *  MeanSquaresImageToImageMetricv4, once sequentially and once with
+ *  concurrent evaluation of the start points. Both searches must report
+ *  the same metric values and the same best start. The time taken by both
+ *  is reported. Early termination is also tested, where both searches must
+ *  list the values of the evaluated starts only.
+ */
+
+namespace
+{
+typedef itk::Image< double, 2 > MultiStartConcurrentImageType;
+
+/* An ellipse with an off-center blob, rotated by the given angle
+ * about the image center. */
+MultiStartConcurrentImageType::Pointer
+MultiStartConcurrentCreateImage( double angle )
+{
+  MultiStartConcurrentImageType::SizeType size;
+  size.Fill( 64 );
+  MultiStartConcurrentImageType::Pointer image = MultiStartConcurrentImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  const double cosine = vcl_cos( angle );
+  const double sine = vcl_sin( angle );
+  itk::ImageRegionIteratorWithIndex< MultiStartConcurrentImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 32.0;
+    const double y = it.GetIndex()[1] - 32.0;
+    const double u =  cosine * x + sine * y;
+    const double v = -sine * x + cosine * y;
+    const double ellipse = vcl_exp( -( u * u / 288.0 + v * v / 50.0 ) );
+    const double blob = vcl_exp( -( ( u - 12.0 ) * ( u - 12.0 ) + v * v ) / 8.0 );
+    it.Set( 100.0 * ( ellipse + blob ) );
+    }
+  return image;
+}
+}
+
+int itkMultiStartOptimizerv4ConcurrentEvaluationTest(int, char* [] )
+{
+  typedef MultiStartConcurrentImageType ImageType;
+  typedef itk::Euler2DTransform< double > TransformType;
+  typedef itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType > MetricType;
+  typedef itk::MultiStartOptimizerv4 OptimizerType;
+
+  const double trueAngle = vnl_math::pi / 6.0;
+  ImageType::Pointer fixedImage = MultiStartConcurrentCreateImage( 0.0 );
+  ImageType::Pointer movingImage = MultiStartConcurrentCreateImage( trueAngle );
+
+  TransformType::Pointer transform = TransformType::New();
+  TransformType::InputPointType center;
+  center.Fill( 32.0 );
+  transform->SetCenter( center );
+
+  MetricType::Pointer metric = MetricType::New();
+  metric->SetFixedImage( fixedImage );
+  metric->SetMovingImage( movingImage );
+  metric->SetMovingTransform( transform );
+  metric->Initialize();
+
+  /* Rotations in steps of one degree */
+  OptimizerType::ParametersListType parametersList;
+  for( int degrees = -180; degrees < 180; degrees++ )
+    {
+    OptimizerType::ParametersType parameters( transform->GetNumberOfParameters() );
+    parameters.Fill( 0.0 );
+    parameters[0] = degrees * vnl_math::pi / 180.0;
+    parametersList.push_back( parameters );
+    }
+
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->SetMetric( metric );
+  optimizer->SetParametersList( parametersList );
+
+  itk::TimeProbe sequentialClock;
+  sequentialClock.Start();
+  optimizer->StartOptimization();
+  sequentialClock.Stop();
+
+  const OptimizerType::MetricValuesListType sequentialValues = optimizer->GetMetricValuesList();
+  const OptimizerType::ParameterListSizeType sequentialBest = optimizer->GetBestParametersIndex();
+  std::cout << "Sequential search: best angle " << optimizer->GetBestParameters()[0]
+            << " in " << sequentialClock.GetMean() << " s" << std::endl;
+
+  if( vcl_fabs( optimizer->GetBestParameters()[0] - trueAngle ) > 1.0e-6 )
+    {
+    std::cerr << "Sequential search did not find the expected angle " << trueAngle << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  optimizer->UseConcurrentEvaluationOn();
+  if( !optimizer->GetUseConcurrentEvaluation() )
+    {
+    std::cerr << "UseConcurrentEvaluation was not set." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  itk::TimeProbe concurrentClock;
+  concurrentClock.Start();
+  optimizer->StartOptimization();
+  concurrentClock.Stop();
+
+  std::cout << "Concurrent search with " << optimizer->GetNumberOfThreads() << " threads: best angle "
+            << optimizer->GetBestParameters()[0] << " in " << concurrentClock.GetMean() << " s" << std::endl;
+
+  const OptimizerType::MetricValuesListType & concurrentValues = optimizer->GetMetricValuesList();
+  if( concurrentValues.size() != sequentialValues.size() )
+    {
+    std::cerr << "Expected " << sequentialValues.size() << " metric values, got "
+              << concurrentValues.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  for( OptimizerType::MetricValuesListType::size_type i = 0; i < concurrentValues.size(); i++ )
+    {
+    if( vcl_fabs( concurrentValues[i] - sequentialValues[i] ) > 1.0e-10 * ( 1.0 + vcl_fabs( sequentialValues[i] ) ) )
+      {
+      std::cerr << "Metric value mismatch for start " << i << ": sequential " << sequentialValues[i]
+                << ", concurrent " << concurrentValues[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if( optimizer->GetBestParametersIndex() != sequentialBest )
+    {
+    std::cerr << "Concurrent search found start " << optimizer->GetBestParametersIndex()
+              << " instead of " << sequentialBest << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( metric->GetParameters()[0] != optimizer->GetBestParameters()[0] )
+    {
+    std::cerr << "The metric was not set to the best parameters." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  /* Stop as soon as a start is close to the minimum. Both searches list
+   * the values of the evaluated starts only, in start order. */
+  optimizer->UseEarlyTerminationOn();
+  optimizer->SetEarlyTerminationValue( sequentialValues[sequentialBest] * 1.001 + 1.0e-10 );
+  optimizer->UseConcurrentEvaluationOff();
+  optimizer->StartOptimization();
+  const OptimizerType::MetricValuesListType sequentialEarlyValues = optimizer->GetMetricValuesList();
+  std::cout << "Sequential early termination after " << sequentialEarlyValues.size() << " starts: "
+            << optimizer->GetStopConditionDescription() << std::endl;
+
+  optimizer->UseConcurrentEvaluationOn();
+  optimizer->StartOptimization();
+  const OptimizerType::MetricValuesListType & concurrentEarlyValues = optimizer->GetMetricValuesList();
+  std::cout << "Concurrent early termination after " << concurrentEarlyValues.size() << " starts: "
+            << optimizer->GetStopConditionDescription() << std::endl;
+  if( optimizer->GetStopCondition() != OptimizerType::CONVERGENCE_CHECKER_PASSED )
+    {
+    std::cerr << "Expected the search to stop at the early termination value." << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( concurrentEarlyValues.size() < sequentialEarlyValues.size()
+      || concurrentEarlyValues.size() > parametersList.size() )
+    {
+    std::cerr << "Expected the concurrent search to list at least the " << sequentialEarlyValues.size()
+              << " values of the sequential search, got " << concurrentEarlyValues.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  for( OptimizerType::MetricValuesListType::size_type i = 0; i < concurrentEarlyValues.size(); i++ )
+    {
+    if( vcl_fabs( concurrentEarlyValues[i] - sequentialValues[i] ) > 1.0e-10 * ( 1.0 + vcl_fabs( sequentialValues[i] ) )
+        || ( i < sequentialEarlyValues.size() && sequentialEarlyValues[i] != sequentialValues[i] ) )
+      {
+      std::cerr << "Metric value mismatch for start " << i << " after early termination" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if( optimizer->GetBestParametersIndex() >= concurrentEarlyValues.size()
+      || concurrentEarlyValues[optimizer->GetBestParametersIndex()] > optimizer->GetEarlyTerminationValue() )
+    {
+    std::cerr << "The best value is above the early termination value." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -87,7 +87,7 @@ namespace itk {
  * value that measures the similarity between the two objects.
  *
  * \note Sparse sampling is not supported by this metric. An exception will be
- * thrown if m_UseFixedSampledPointSet is set. Support for sparse sampling
+ * thrown if m_UseFixedSampledPointSet or a SamplingStrategy is set. Support for sparse sampling
  * will require a parallel implementation of the neighborhood scanning, which
  * currently caches information as the neighborhood window moves.
  *
@@ -231,6 +231,9 @@ protected:
 
   virtual void PrintSelf(std::ostream & os, Indent indent) const;
 
+  /** Clone the metric, including its neighborhood radius settings. */
+  virtual typename LightObject::Pointer InternalClone() const;
+
 private:
   ANTSNeighborhoodCorrelationImageToImageMetricv4( const Self & ); //purposely not implemented
   void operator=(const Self &); //purposely not implemented
@@ -53,6 +53,10 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirt
     {
     itkExceptionMacro("UseFixedSampledPointSet is set, but not supported in this metric.");
     }
+  if( this->GetSamplingStrategy() != Superclass::NONE )
+    {
+    itkExceptionMacro("A SamplingStrategy is set, but sparse sampling is not supported in this metric.");
+    }
   Superclass::Initialize();
 }
 
@@ -94,6 +98,23 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirt
 }
 
 
+template<class TFixedImage, class TMovingImage, class TVirtualImage>
+typename LightObject::Pointer
+ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage>
+::InternalClone() const
+{
+  typename LightObject::Pointer loPtr = Superclass::InternalClone();
+
+  typename Self::Pointer rval = dynamic_cast<Self *>( loPtr.GetPointer() );
+  if( rval.IsNull() )
+    {
+    itkExceptionMacro(<< "downcast to type " << this->GetNameOfClass() << " failed.");
+    }
+  rval->m_Radius = this->m_Radius;
+
+  return loPtr;
+}
+
 template<class TFixedImage, class TMovingImage, class TVirtualImage>
 void
 ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage>
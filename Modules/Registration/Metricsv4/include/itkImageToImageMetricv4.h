@@ -28,6 +28,7 @@
 #include "itkThreadedImageRegionPartitioner.h"
 #include "itkImageToImageFilter.h"
 #include "itkImageToImageMetricv4GetValueAndDerivativeThreader.h"
+#include "itkImageToImageMetricv4SampledPointSetThreader.h"
 #include "itkGradientRecursiveGaussianImageFilter.h"
 #include "itkPointSet.h"
 
@@ -126,6 +127,18 @@ namespace itk
  * use a gradient image filter for it because it will only be
  * calculated once.
  *
+ * Instead of a user supplied point set, the metric can draw its own sample
+ * of the virtual domain by setting a SamplingStrategy other than NONE
+ * together with a SamplingPercentage. RANDOM draws voxels uniformly over
+ * the virtual domain region, and STRATIFIED divides the region into a
+ * regular grid of strata and draws one voxel in each. The sample is
+ * redrawn every ResamplingInterval evaluations, so that an optimizer
+ * sees a different mini-batch of the domain at each iteration. A
+ * ResamplingInterval of zero draws the sample only once, in Initialize.
+ * The sampled points are the voxel centers, and the draw depends only on
+ * SamplingSeed and the number of samples drawn so far, not on the number
+ * of threads.
+ *
  * Threading
  *
  * This class is threaded. Threading is handled by friend classes
@@ -486,6 +499,34 @@ public:
   /** Get the virtual domain sampling point set */
   itkGetConstObjectMacro(VirtualSampledPointSet, VirtualSampledPointSetType);
 
+  /** Strategies for drawing the virtual domain sample within the metric.
+   * See main documentation. */
+  enum SamplingStrategyType { NONE, RANDOM, STRATIFIED };
+
+  /** Set/Get the strategy used to sample the virtual domain. Default is
+   * NONE, i.e. dense sampling or the user supplied point set. */
+  itkSetMacro(SamplingStrategy, SamplingStrategyType);
+  itkGetConstMacro(SamplingStrategy, SamplingStrategyType);
+
+  /** Set/Get the fraction of the virtual domain voxels that are sampled,
+   * in (0,1]. Default is 1. */
+  itkSetClampMacro(SamplingPercentage, double, 0.0, 1.0);
+  itkGetConstMacro(SamplingPercentage, double);
+
+  /** Set/Get the number of evaluations after which the sample is redrawn.
+   * Zero means the sample is drawn once, in Initialize. Default is 1. */
+  itkSetMacro(ResamplingInterval, SizeValueType);
+  itkGetConstMacro(ResamplingInterval, SizeValueType);
+
+  /** Set/Get the seed of the sampling. Default is 0. */
+  itkSetMacro(SamplingSeed, SizeValueType);
+  itkGetConstMacro(SamplingSeed, SizeValueType);
+
+  /** Return true if the metric is evaluated over the virtual sampled point
+   * set, either from a user supplied fixed point set or from the sampling
+   * strategy, and false if it is evaluated densely. */
+  bool GetUseVirtualSampledPointSet() const;
+
   /** Set/Get the gradient filter */
   itkSetObjectMacro( FixedImageGradientFilter, FixedImageGradientFilterType );
   itkGetObjectMacro( FixedImageGradientFilter, FixedImageGradientFilterType );
@@ -516,7 +557,7 @@ public:
   /** Set number of threads to use. This the maximum number of threads to use
    * when multithreaded.  The actual number of threads used (may be less than
    * this value) can be obtained with \c GetNumberOfThreadsUsed. */
-  void SetMaximumNumberOfThreads( const ThreadIdType threads );
+  virtual void SetMaximumNumberOfThreads( const ThreadIdType threads );
   ThreadIdType GetMaximumNumberOfThreads() const;
 
   /** Get Fixed Gradient Image. */
@@ -625,6 +666,7 @@ protected:
   friend class ImageToImageMetricv4GetValueAndDerivativeThreaderBase< ThreadedIndexedContainerPartitioner, Self >;
   friend class ImageToImageMetricv4GetValueAndDerivativeThreader< ThreadedImageRegionPartitioner< VirtualImageDimension >, Self >;
   friend class ImageToImageMetricv4GetValueAndDerivativeThreader< ThreadedIndexedContainerPartitioner, Self >;
+  friend class ImageToImageMetricv4SampledPointSetThreader< Self >;
 
   /* A DenseGetValueAndDerivativeThreader
    * Derived classes must define this class and assign it in their constructor
@@ -778,6 +820,12 @@ protected:
   /** Flag to use FixedSampledPointSet, i.e. Sparse sampling. */
   bool                                    m_UseFixedSampledPointSet;
 
+  /** Sampling of the virtual domain within the metric. */
+  SamplingStrategyType                    m_SamplingStrategy;
+  double                                  m_SamplingPercentage;
+  SizeValueType                           m_ResamplingInterval;
+  SizeValueType                           m_SamplingSeed;
+
   /** Metric value, stored after evaluating */
   mutable MeasureType                     m_Value;
 
@@ -786,6 +834,14 @@ protected:
 
   void PrintSelf(std::ostream& os, Indent indent) const;
 
+  /** Create a copy of this metric that shares the images, interpolators,
+   * masks, gradient filters and sampled point set, and owns a clone of
+   * the moving transform, so that it can be evaluated at different
+   * parameters independently of this metric. The clone must be
+   * initialized before use. Derived classes with additional settings
+   * should extend this method. */
+  virtual typename LightObject::Pointer InternalClone() const;
+
   /** Verify that virtual domain and displacement field are the same size
    * and in the same physical space. */
   virtual void VerifyDisplacementFieldSizeAndPhysicalSpace();
@@ -802,6 +858,20 @@ private:
   /** Map the fixed point set samples to the virtual domain */
   void MapFixedSampledPointSetToVirtual( void );
 
+  /** Draw the virtual sampled point set according to the sampling strategy. */
+  void GenerateSampledPointSet() const;
+
+  /** Threader that draws the virtual sampled point set. */
+  typename ImageToImageMetricv4SampledPointSetThreader< Self >::Pointer m_SampledPointSetThreader;
+
+  /** Number of strata per dimension for STRATIFIED sampling. */
+  mutable VirtualSizeType m_SamplingStrata;
+
+  /** Number of sample sets drawn so far, and number of evaluations since
+   * the current sample set was drawn. */
+  mutable SizeValueType m_SamplingGeneration;
+  mutable SizeValueType m_EvaluationsSinceResampling;
+
   /** Flag for warning about use of GetValue. Will be removed when
    *  GetValue implementation is improved. */
   mutable bool m_HaveMadeGetValueWarning;
@@ -25,6 +25,7 @@
 #include "itkLinearInterpolateImageFunction.h"
 #include "itkIdentityTransform.h"
 #include "itkCentralDifferenceImageFunction.h"
+#include "vcl_cmath.h"
 
 namespace itk
 {
@@ -85,6 +86,16 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage >
   this->m_UseMovingImageGradientFilter = true;
   this->m_UseFixedSampledPointSet      = false;
 
+  this->m_SamplingStrategy   = NONE;
+  this->m_SamplingPercentage = 1.0;
+  this->m_ResamplingInterval = 1;
+  this->m_SamplingSeed       = 0;
+  this->m_SamplingStrata.Fill( 1 );
+  this->m_SamplingGeneration = 0;
+  this->m_EvaluationsSinceResampling = 0;
+  this->m_SampledPointSetThreader =
+    ImageToImageMetricv4SampledPointSetThreader< Self >::New();
+
   this->m_UserHasProvidedVirtualDomainImage = false;
 
   this->m_FloatingPointCorrectionResolution = 1e4;
@@ -100,6 +111,67 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage >
 {
 }
 
+template<class TFixedImage,class TMovingImage,class TVirtualImage>
+typename LightObject::Pointer
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage >
+::InternalClone() const
+{
+  typename LightObject::Pointer loPtr = Superclass::InternalClone();
+
+  typename Self::Pointer rval = dynamic_cast<Self *>( loPtr.GetPointer() );
+  if( rval.IsNull() )
+    {
+    itkExceptionMacro(<< "downcast to type " << this->GetNameOfClass() << " failed.");
+    }
+
+  rval->m_GradientSource = this->m_GradientSource;
+
+  rval->m_FixedImage  = this->m_FixedImage;
+  rval->m_MovingImage = this->m_MovingImage;
+  if( this->m_UserHasProvidedVirtualDomainImage )
+    {
+    rval->m_VirtualDomainImage = this->m_VirtualDomainImage;
+    rval->m_UserHasProvidedVirtualDomainImage = true;
+    }
+
+  /* The fixed transform is not optimized, so it can be shared. The moving
+   * transform is updated through SetParameters and must be owned by the
+   * clone. */
+  rval->m_FixedTransform = this->m_FixedTransform;
+  if( this->m_MovingTransform.IsNotNull() )
+    {
+    rval->m_MovingTransform = this->m_MovingTransform->Clone();
+    }
+
+  /* Interpolators and gradient calculators are only evaluated through
+   * const methods once initialized, as in the threaded evaluation,
+   * so they can be shared. */
+  rval->m_FixedInterpolator  = this->m_FixedInterpolator;
+  rval->m_MovingInterpolator = this->m_MovingInterpolator;
+  rval->m_FixedImageGradientCalculator  = this->m_FixedImageGradientCalculator;
+  rval->m_MovingImageGradientCalculator = this->m_MovingImageGradientCalculator;
+  rval->m_UseFixedImageGradientFilter  = this->m_UseFixedImageGradientFilter;
+  rval->m_UseMovingImageGradientFilter = this->m_UseMovingImageGradientFilter;
+  /* Sharing the gradient filters lets the clone reuse their up-to-date
+   * outputs instead of recomputing the gradient images. */
+  rval->m_FixedImageGradientFilter  = this->m_FixedImageGradientFilter;
+  rval->m_MovingImageGradientFilter = this->m_MovingImageGradientFilter;
+
+  rval->m_FixedImageMask  = this->m_FixedImageMask;
+  rval->m_MovingImageMask = this->m_MovingImageMask;
+  rval->m_FixedSampledPointSet    = this->m_FixedSampledPointSet;
+  rval->m_UseFixedSampledPointSet = this->m_UseFixedSampledPointSet;
+  rval->m_SamplingStrategy   = this->m_SamplingStrategy;
+  rval->m_SamplingPercentage = this->m_SamplingPercentage;
+  rval->m_ResamplingInterval = this->m_ResamplingInterval;
+  rval->m_SamplingSeed       = this->m_SamplingSeed;
+
+  rval->m_FloatingPointCorrectionResolution = this->m_FloatingPointCorrectionResolution;
+  rval->SetMaximumNumberOfThreads( this->GetMaximumNumberOfThreads() );
+
+  return loPtr;
+}
+
 template<class TFixedImage,class TMovingImage,class TVirtualImage>
 void
 ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage >
@@ -163,6 +235,15 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage >
     {
     this->MapFixedSampledPointSetToVirtual();
     }
+  else if( this->m_SamplingStrategy != NONE )
+    {
+    /* Draw the first sample set of the virtual domain. */
+    this->m_VirtualSampledPointSet = VirtualSampledPointSetType::New();
+    this->m_VirtualSampledPointSet->Initialize();
+    this->m_SamplingGeneration = 0;
+    this->m_EvaluationsSinceResampling = 0;
+    this->GenerateSampledPointSet();
+    }
 
   /* Special checks for when the moving transform is dense/high-dimensional */
   if( this->m_MovingTransform->HasLocalSupport() )
@@ -275,7 +356,7 @@ void
 ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage >
 ::GetValueAndDerivativeExecute() const
 {
-  if( this->m_UseFixedSampledPointSet ) // sparse sampling
+  if( this->GetUseVirtualSampledPointSet() ) // sparse sampling
     {
     SizeValueType numberOfPoints = this->GetNumberOfDomainPoints();
     if( numberOfPoints < 1 )
@@ -308,6 +389,79 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage >
   /* Clear derivative final result. This will
    * require an option to skip for use with multivariate metric. */
   this->m_DerivativeResult->Fill( NumericTraits< DerivativeValueType >::Zero );
+
+  /* Draw a new sample set of the virtual domain when the current one
+   * has been used for ResamplingInterval evaluations. */
+  if( ! this->m_UseFixedSampledPointSet && this->m_SamplingStrategy != NONE )
+    {
+    if( this->m_ResamplingInterval > 0 &&
+        this->m_EvaluationsSinceResampling >= this->m_ResamplingInterval )
+      {
+      this->m_SamplingGeneration++;
+      this->m_EvaluationsSinceResampling = 0;
+      this->GenerateSampledPointSet();
+      }
+    this->m_EvaluationsSinceResampling++;
+    }
+}
+
+template<class TFixedImage,class TMovingImage,class TVirtualImage>
+bool
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage >
+::GetUseVirtualSampledPointSet() const
+{
+  return this->m_UseFixedSampledPointSet || this->m_SamplingStrategy != NONE;
+}
+
+template<class TFixedImage,class TMovingImage,class TVirtualImage>
+void
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage >
+::GenerateSampledPointSet() const
+{
+  const VirtualRegionType region = this->GetVirtualDomainRegion();
+  const SizeValueType numberOfPixels = region.GetNumberOfPixels();
+  if( numberOfPixels == 0 )
+    {
+    itkExceptionMacro("The virtual domain region is empty, there are no points to sample.");
+    }
+
+  SizeValueType numberOfSamples = static_cast< SizeValueType >(
+    vcl_floor( numberOfPixels * this->m_SamplingPercentage ) );
+  if( numberOfSamples < 1 )
+    {
+    numberOfSamples = 1;
+    }
+
+  if( this->m_SamplingStrategy == STRATIFIED )
+    {
+    /* Divide each dimension into strata of about the same extent, such
+     * that there are about numberOfSamples strata in total. */
+    const double strataExtent = vcl_pow( static_cast< double >( numberOfPixels ) / numberOfSamples,
+                                         1.0 / VirtualImageDimension );
+    numberOfSamples = 1;
+    for( unsigned int d = 0; d < VirtualImageDimension; d++ )
+      {
+      const SizeValueType size = region.GetSize()[d];
+      SizeValueType strata = static_cast< SizeValueType >(
+        vcl_floor( size / strataExtent + 0.5 ) );
+      strata = std::max( strata, static_cast< SizeValueType >( 1 ) );
+      strata = std::min( strata, size );
+      this->m_SamplingStrata[d] = strata;
+      numberOfSamples *= strata;
+      }
+    }
+
+  /* Use a new container so that the previous sample set is not modified
+   * while it may still be referenced. */
+  typedef typename VirtualSampledPointSetType::PointsContainer PointsContainer;
+  typename PointsContainer::Pointer points = PointsContainer::New();
+  points->CreateIndex( numberOfSamples - 1 );
+  this->m_VirtualSampledPointSet->SetPoints( points );
+
+  typename ImageToImageMetricv4SampledPointSetThreader< Self >::DomainType range;
+  range[0] = 0;
+  range[1] = numberOfSamples - 1;
+  this->m_SampledPointSetThreader->Execute( const_cast< Self* >(this), range );
 }
 
 template<class TFixedImage,class TMovingImage,class TVirtualImage>
@@ -569,6 +723,7 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage >
   if( number != this->m_SparseGetValueAndDerivativeThreader->GetMaximumNumberOfThreads() )
     {
     this->m_SparseGetValueAndDerivativeThreader->SetMaximumNumberOfThreads( number );
+    this->m_SampledPointSetThreader->SetMaximumNumberOfThreads( number );
     this->Modified();
     }
   if( number != this->m_DenseGetValueAndDerivativeThreader->GetMaximumNumberOfThreads() )
@@ -583,7 +738,7 @@ ThreadIdType
 ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage >
 ::GetMaximumNumberOfThreads() const
 {
-  if( this->m_UseFixedSampledPointSet )
+  if( this->GetUseVirtualSampledPointSet() )
     {
     return this->m_SparseGetValueAndDerivativeThreader->GetMaximumNumberOfThreads();
     }
@@ -595,7 +750,7 @@ ThreadIdType
 ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage >
 ::GetNumberOfThreadsUsed() const
 {
-  if( this->m_UseFixedSampledPointSet )
+  if( this->GetUseVirtualSampledPointSet() )
     {
     return this->m_SparseGetValueAndDerivativeThreader->GetNumberOfThreadsUsed();
     }
@@ -766,7 +921,7 @@ SizeValueType
 ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage>
 ::GetNumberOfDomainPoints() const
 {
-  if( this->m_UseFixedSampledPointSet )
+  if( this->GetUseVirtualSampledPointSet() )
     {
     //The virtual sampled point set holds the actual points
     // over which we're evaluating over.
@@ -962,7 +1117,11 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage >
                << std::endl
                << "GetUseMovingImageGradientFilter: "
                << this->GetUseMovingImageGradientFilter()
-               << std::endl;
+               << std::endl
+               << "SamplingStrategy: " << this->m_SamplingStrategy << std::endl
+               << "SamplingPercentage: " << this->m_SamplingPercentage << std::endl
+               << "ResamplingInterval: " << this->m_ResamplingInterval << std::endl
+               << "SamplingSeed: " << this->m_SamplingSeed << std::endl;
 
   if( this->GetVirtualDomainImage() != NULL )
     {
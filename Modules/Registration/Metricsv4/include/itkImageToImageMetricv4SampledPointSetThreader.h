@@ -0,0 +1,95 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkImageToImageMetricv4SampledPointSetThreader_h
+#define __itkImageToImageMetricv4SampledPointSetThreader_h
+
+#include "itkDomainThreader.h"
+#include "itkThreadedIndexedContainerPartitioner.h"
+
+namespace itk
+{
+
+/** \class ImageToImageMetricv4SampledPointSetThreader
+ * \brief Generate the virtual sampled point set of ImageToImageMetricv4
+ * in parallel for its built-in sampling strategies.
+ *
+ * Each sample is drawn from a counter-based hash of the sampling seed,
+ * the number of the sample set and the sample index, so the generated
+ * point set does not depend on the number of threads used.
+ *
+ * \tparam TImageToImageMetricv4 Type of the ImageToImageMetricv4.
+ *
+ * \ingroup ITKMetricsv4
+ */
+template< class TImageToImageMetricv4 >
+class ImageToImageMetricv4SampledPointSetThreader
+  : public DomainThreader< ThreadedIndexedContainerPartitioner, TImageToImageMetricv4 >
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImageToImageMetricv4SampledPointSetThreader                         Self;
+  typedef DomainThreader< ThreadedIndexedContainerPartitioner, TImageToImageMetricv4 >
+                                                                              Superclass;
+  typedef SmartPointer< Self >                                                Pointer;
+  typedef SmartPointer< const Self >                                          ConstPointer;
+
+  itkTypeMacro( ImageToImageMetricv4SampledPointSetThreader, DomainThreader );
+
+  itkNewMacro( Self );
+
+  /** Superclass types. */
+  typedef typename Superclass::DomainType    DomainType;
+  typedef typename Superclass::AssociateType AssociateType;
+
+  /** Types of the associate metric. */
+  typedef TImageToImageMetricv4                               ImageToImageMetricv4Type;
+  typedef typename ImageToImageMetricv4Type::VirtualImageType  VirtualImageType;
+  typedef typename ImageToImageMetricv4Type::VirtualIndexType  VirtualIndexType;
+  typedef typename ImageToImageMetricv4Type::VirtualPointType  VirtualPointType;
+  typedef typename ImageToImageMetricv4Type::VirtualRegionType VirtualRegionType;
+  typedef typename ImageToImageMetricv4Type::VirtualSizeType   VirtualSizeType;
+  typedef typename ImageToImageMetricv4Type::VirtualSampledPointSetType
+                                                              VirtualSampledPointSetType;
+
+  itkStaticConstMacro( VirtualImageDimension, unsigned int, ImageToImageMetricv4Type::VirtualImageDimension );
+
+protected:
+  ImageToImageMetricv4SampledPointSetThreader() {}
+
+  /** Draw the samples with indices in \c subrange and store their physical
+   * points in the virtual sampled point set. */
+  virtual void ThreadedExecution( const DomainType & subrange,
+                                  const ThreadIdType threadId );
+
+  /** Return a uniformly distributed value in [0,1) that only depends on the
+   * seed, the sample set, the sample and the dimension. */
+  static double HashToUniform( SizeValueType seed, SizeValueType generation,
+                               SizeValueType sample, unsigned int dimension );
+
+private:
+  ImageToImageMetricv4SampledPointSetThreader( const Self & ); // purposely not implemented
+  void operator=( const Self & ); // purposely not implemented
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkImageToImageMetricv4SampledPointSetThreader.hxx"
+#endif
+
+#endif
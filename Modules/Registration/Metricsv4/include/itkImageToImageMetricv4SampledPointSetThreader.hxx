@@ -0,0 +1,102 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkImageToImageMetricv4SampledPointSetThreader_hxx
+#define __itkImageToImageMetricv4SampledPointSetThreader_hxx
+
+#include "itkImageToImageMetricv4SampledPointSetThreader.h"
+
+namespace itk
+{
+
+template< class TImageToImageMetricv4 >
+double
+ImageToImageMetricv4SampledPointSetThreader< TImageToImageMetricv4 >
+::HashToUniform( SizeValueType seed, SizeValueType generation,
+                 SizeValueType sample, unsigned int dimension )
+{
+  /* SplitMix64 finalizer applied to each key in turn. */
+  const uint64_t golden = ( static_cast< uint64_t >( 0x9E3779B9 ) << 32 ) | 0x7F4A7C15;
+  const uint64_t mix1   = ( static_cast< uint64_t >( 0xBF58476D ) << 32 ) | 0x1CE4E5B9;
+  const uint64_t mix2   = ( static_cast< uint64_t >( 0x94D049BB ) << 32 ) | 0x133111EB;
+  const uint64_t keys[4] = { static_cast< uint64_t >( seed ),
+                             static_cast< uint64_t >( generation ),
+                             static_cast< uint64_t >( sample ),
+                             static_cast< uint64_t >( dimension ) };
+  uint64_t z = 0;
+  for( unsigned int k = 0; k < 4; k++ )
+    {
+    z += keys[k] + golden;
+    z = ( z ^ ( z >> 30 ) ) * mix1;
+    z = ( z ^ ( z >> 27 ) ) * mix2;
+    z = z ^ ( z >> 31 );
+    }
+  /* Use the upper 53 bits for a double in [0,1). */
+  return static_cast< double >( z >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
+
+template< class TImageToImageMetricv4 >
+void
+ImageToImageMetricv4SampledPointSetThreader< TImageToImageMetricv4 >
+::ThreadedExecution( const DomainType & subrange,
+                     const ThreadIdType itkNotUsed(threadId) )
+{
+  AssociateType * associate = this->m_Associate;
+  const VirtualImageType * virtualImage = associate->GetVirtualDomainImage();
+  const VirtualRegionType region = associate->GetVirtualDomainRegion();
+  const VirtualSizeType & strata = associate->m_SamplingStrata;
+  const bool stratified = ( associate->m_SamplingStrategy == ImageToImageMetricv4Type::STRATIFIED );
+  const SizeValueType seed = associate->m_SamplingSeed;
+  const SizeValueType generation = associate->m_SamplingGeneration;
+
+  typename VirtualSampledPointSetType::PointsContainer * points =
+    associate->m_VirtualSampledPointSet->GetPoints();
+
+  VirtualIndexType index;
+  VirtualPointType point;
+  for( SizeValueType i = subrange[0]; i <= static_cast< SizeValueType >( subrange[1] ); ++i )
+    {
+    SizeValueType stratum = i;
+    for( unsigned int d = 0; d < VirtualImageDimension; d++ )
+      {
+      const SizeValueType size = region.GetSize()[d];
+      SizeValueType lower = 0;
+      SizeValueType upper = size;
+      if( stratified )
+        {
+        /* Strata are numbered with the first dimension varying fastest. */
+        const SizeValueType j = stratum % strata[d];
+        stratum /= strata[d];
+        lower = ( j * size ) / strata[d];
+        upper = ( ( j + 1 ) * size ) / strata[d];
+        }
+      SizeValueType offset = lower + static_cast< SizeValueType >(
+        HashToUniform( seed, generation, i, d ) * static_cast< double >( upper - lower ) );
+      if( offset >= upper )
+        {
+        offset = upper - 1;
+        }
+      index[d] = region.GetIndex()[d] + static_cast< IndexValueType >( offset );
+      }
+    virtualImage->TransformIndexToPhysicalPoint( index, point );
+    points->ElementAt( i ) = point;
+    }
+}
+
+} // end namespace itk
+
+#endif
@@ -200,6 +200,9 @@ protected:
   /** Standard PrintSelf method. */
   void PrintSelf(std::ostream & os, Indent indent) const;
 
+  /** Clone the metric, including its histogram settings. */
+  virtual typename LightObject::Pointer InternalClone() const;
+
   /** Count of the number of valid histogram points. */
   SizeValueType   m_JointHistogramTotalCount;
 
@@ -224,7 +224,7 @@ JointHistogramMutualInformationImageToImageMetricv4<TFixedImage,TMovingImage,TVi
   /**
    * First, we compute the joint histogram
    */
-  if( this->m_UseFixedSampledPointSet )
+  if( this->GetUseVirtualSampledPointSet() )
     {
     SizeValueType numberOfPoints = this->GetNumberOfDomainPoints();
     if( numberOfPoints < 1 )
@@ -375,6 +375,24 @@ JointHistogramMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, T
     jointPDFpoint[1] = b;
 }
 
+template <class TFixedImage, class TMovingImage, class TVirtualImage>
+typename LightObject::Pointer
+JointHistogramMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage>
+::InternalClone() const
+{
+  typename LightObject::Pointer loPtr = Superclass::InternalClone();
+
+  typename Self::Pointer rval = dynamic_cast<Self *>( loPtr.GetPointer() );
+  if( rval.IsNull() )
+    {
+    itkExceptionMacro(<< "downcast to type " << this->GetNameOfClass() << " failed.");
+    }
+  rval->m_NumberOfHistogramBins = this->m_NumberOfHistogramBins;
+  rval->m_VarianceForJointPDFSmoothing = this->m_VarianceForJointPDFSmoothing;
+
+  return loPtr;
+}
+
 template <class TFixedImage, class TMovingImage, class TVirtualImage>
 void
 JointHistogramMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage>
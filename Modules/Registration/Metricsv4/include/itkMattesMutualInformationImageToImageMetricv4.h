@@ -212,6 +212,9 @@ protected:
 
   void PrintSelf(std::ostream& os, Indent indent) const;
 
+  /** Clone the metric, including its histogram settings. */
+  virtual typename LightObject::Pointer InternalClone() const;
+
 
   typedef JointPDFType::IndexType             JointPDFIndexType;
   typedef JointPDFType::PixelType             JointPDFValueType;
@@ -377,6 +377,23 @@ MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualI
   }
 }
 
+template < class TFixedImage, class TMovingImage, class TVirtualImage  >
+typename LightObject::Pointer
+MattesMutualInformationImageToImageMetricv4<TFixedImage,TMovingImage,TVirtualImage>
+::InternalClone() const
+{
+  typename LightObject::Pointer loPtr = Superclass::InternalClone();
+
+  typename Self::Pointer rval = dynamic_cast<Self *>( loPtr.GetPointer() );
+  if( rval.IsNull() )
+    {
+    itkExceptionMacro(<< "downcast to type " << this->GetNameOfClass() << " failed.");
+    }
+  rval->m_NumberOfHistogramBins = this->m_NumberOfHistogramBins;
+
+  return loPtr;
+}
+
 /**
  * PrintSelf
  */
@@ -0,0 +1,211 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkTranslationTransform.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+/* Verify the sampling strategies of ImageToImageMetricv4:
+ * a full stratified sample evaluates every voxel, a random sample has
+ * the requested size, the sample is redrawn according to the resampling
+ * interval, and the sample does not depend on the number of threads. */
+
+namespace
+{
+typedef itk::Image< double, 2 >                                                ImageType;
+typedef itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType, ImageType > MetricType;
+typedef MetricType::VirtualSampledPointSetType::PointsContainer                PointsContainerType;
+
+ImageType::Pointer CreateImage( double shift )
+{
+  ImageType::SizeType size;
+  size.Fill( 32 );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 16.0 - shift;
+    const double y = it.GetIndex()[1] - 16.0;
+    it.Set( 100.0 * vcl_exp( -( x * x + y * y ) / 50.0 ) );
+    }
+  return image;
+}
+
+MetricType::Pointer CreateMetric( ImageType * fixedImage, ImageType * movingImage )
+{
+  typedef itk::TranslationTransform< double, 2 > TransformType;
+  TransformType::Pointer fixedTransform = TransformType::New();
+  TransformType::Pointer movingTransform = TransformType::New();
+  fixedTransform->SetIdentity();
+  movingTransform->SetIdentity();
+
+  MetricType::Pointer metric = MetricType::New();
+  metric->SetFixedImage( fixedImage );
+  metric->SetMovingImage( movingImage );
+  metric->SetFixedTransform( fixedTransform );
+  metric->SetMovingTransform( movingTransform );
+  return metric;
+}
+
+PointsContainerType::Pointer CopyPoints( const MetricType * metric )
+{
+  PointsContainerType::Pointer copy = PointsContainerType::New();
+  const PointsContainerType * points = metric->GetVirtualSampledPointSet()->GetPoints();
+  for( PointsContainerType::ConstIterator it = points->Begin(); it != points->End(); ++it )
+    {
+    copy->InsertElement( it.Index(), it.Value() );
+    }
+  return copy;
+}
+
+bool SamePoints( const PointsContainerType * a, const PointsContainerType * b )
+{
+  if( a->Size() != b->Size() )
+    {
+    return false;
+    }
+  for( PointsContainerType::ElementIdentifier i = 0; i < a->Size(); ++i )
+    {
+    if( a->ElementAt( i ) != b->ElementAt( i ) )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkImageToImageMetricv4SamplingTest(int, char * [])
+{
+  ImageType::Pointer fixedImage = CreateImage( 0.0 );
+  ImageType::Pointer movingImage = CreateImage( 2.0 );
+  const itk::SizeValueType numberOfPixels = fixedImage->GetLargestPossibleRegion().GetNumberOfPixels();
+
+  MetricType::MeasureType value;
+  MetricType::DerivativeType derivative;
+
+  try
+    {
+    /* Dense reference. */
+    MetricType::Pointer denseMetric = CreateMetric( fixedImage, movingImage );
+    denseMetric->Initialize();
+    MetricType::MeasureType denseValue;
+    MetricType::DerivativeType denseDerivative;
+    denseMetric->GetValueAndDerivative( denseValue, denseDerivative );
+
+    /* A full stratified sample holds every voxel once. */
+    MetricType::Pointer metric = CreateMetric( fixedImage, movingImage );
+    metric->SetSamplingStrategy( MetricType::STRATIFIED );
+    metric->SetSamplingPercentage( 1.0 );
+    metric->Initialize();
+    metric->GetValueAndDerivative( value, derivative );
+    std::cout << "Dense value: " << denseValue << " stratified value: " << value << std::endl;
+    if( metric->GetNumberOfDomainPoints() != numberOfPixels ||
+        metric->GetNumberOfValidPoints() != denseMetric->GetNumberOfValidPoints() )
+      {
+      std::cerr << "Full stratified sample has " << metric->GetNumberOfDomainPoints()
+                << " points, expected " << numberOfPixels << std::endl;
+      return EXIT_FAILURE;
+      }
+    if( vcl_fabs( value - denseValue ) > 1e-8 * vcl_fabs( denseValue ) )
+      {
+      std::cerr << "Full stratified sample value differs from dense value." << std::endl;
+      return EXIT_FAILURE;
+      }
+    for( unsigned int p = 0; p < derivative.Size(); p++ )
+      {
+      if( vcl_fabs( derivative[p] - denseDerivative[p] ) > 1e-8 * ( 1.0 + vcl_fabs( denseDerivative[p] ) ) )
+        {
+        std::cerr << "Full stratified sample derivative differs from dense derivative." << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+
+    /* A 5% random sample. */
+    metric = CreateMetric( fixedImage, movingImage );
+    metric->SetSamplingStrategy( MetricType::RANDOM );
+    metric->SetSamplingPercentage( 0.05 );
+    metric->SetResamplingInterval( 1 );
+    metric->Initialize();
+    const itk::SizeValueType expected = static_cast< itk::SizeValueType >( vcl_floor( numberOfPixels * 0.05 ) );
+    if( metric->GetNumberOfDomainPoints() != expected )
+      {
+      std::cerr << "Random sample has " << metric->GetNumberOfDomainPoints()
+                << " points, expected " << expected << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    /* With an interval of one, each evaluation after the first uses a new sample. */
+    metric->GetValueAndDerivative( value, derivative );
+    PointsContainerType::Pointer first = CopyPoints( metric );
+    metric->GetValueAndDerivative( value, derivative );
+    PointsContainerType::Pointer second = CopyPoints( metric );
+    if( SamePoints( first, second ) )
+      {
+      std::cerr << "Sample was not redrawn with a resampling interval of one." << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    /* With an interval of zero, the sample drawn in Initialize is kept. */
+    metric->SetResamplingInterval( 0 );
+    metric->Initialize();
+    if( ! SamePoints( first, CopyPoints( metric ) ) )
+      {
+      std::cerr << "Reinitializing with the same seed gave a different sample." << std::endl;
+      return EXIT_FAILURE;
+      }
+    metric->GetValueAndDerivative( value, derivative );
+    metric->GetValueAndDerivative( value, derivative );
+    if( ! SamePoints( first, CopyPoints( metric ) ) )
+      {
+      std::cerr << "Sample was redrawn with a resampling interval of zero." << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    /* The sample does not depend on the number of threads. */
+    MetricType::Pointer singleThreaded = CreateMetric( fixedImage, movingImage );
+    MetricType::Pointer multiThreaded = CreateMetric( fixedImage, movingImage );
+    singleThreaded->SetMaximumNumberOfThreads( 1 );
+    multiThreaded->SetMaximumNumberOfThreads( 4 );
+    MetricType::Pointer metrics[2] = { singleThreaded, multiThreaded };
+    for( unsigned int m = 0; m < 2; m++ )
+      {
+      metrics[m]->SetSamplingStrategy( MetricType::STRATIFIED );
+      metrics[m]->SetSamplingPercentage( 0.1 );
+      metrics[m]->SetSamplingSeed( 17 );
+      metrics[m]->Initialize();
+      metrics[m]->GetValueAndDerivative( value, derivative );
+      metrics[m]->GetValueAndDerivative( value, derivative );
+      }
+    if( ! SamePoints( CopyPoints( singleThreaded ), CopyPoints( multiThreaded ) ) )
+      {
+      std::cerr << "Sample depends on the number of threads." << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  catch( itk::ExceptionObject & exc )
+    {
+    std::cerr << "Caught unexpected exception: " << exc << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test PASSED." << std::endl;
+  return EXIT_SUCCESS;
+}
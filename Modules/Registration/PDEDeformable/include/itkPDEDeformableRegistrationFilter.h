@@ -232,6 +232,17 @@ public:
    * \sa GaussianOperator. */
   itkSetMacro(MaximumKernelWidth, unsigned int);
   itkGetConstMacro(MaximumKernelWidth, unsigned int);
+
+  /** Set/Get whether the displacement and update fields are smoothed in
+   * place. When on, each separable Gaussian pass filters the lines of
+   * the field along one dimension directly in its buffer, in parallel,
+   * using one line buffer per thread. This avoids the temporary full
+   * size fields of the filter based smoothing, which matters for large
+   * fields. The result is the same as with the filter based smoothing.
+   * Default is on. */
+  itkSetMacro(SmoothInPlace, bool);
+  itkGetConstMacro(SmoothInPlace, bool);
+  itkBooleanMacro(SmoothInPlace);
 protected:
   PDEDeformableRegistrationFilter();
   ~PDEDeformableRegistrationFilter() {}
@@ -272,6 +283,19 @@ protected:
    * UpdateFieldStandardDeviations. */
   virtual void SmoothUpdateField();
 
+  /** Smooth the given field in place with a separable Gaussian of the
+   * given standard deviations, in pixel units. Used by SmoothDisplacementField
+   * and SmoothUpdateField when SmoothInPlace is on. */
+  virtual void SmoothFieldInPlace(DisplacementFieldType *field,
+                                  const StandardDeviationsType & standardDeviations);
+
+  /** Filter the lines along \c direction that start in \c lineRegion
+   * with \c kernel. Called from the threads of SmoothFieldInPlace. */
+  virtual void ThreadedSmoothFieldInPlace(DisplacementFieldType *field,
+                                          unsigned int direction,
+                                          const std::vector< double > & kernel,
+                                          const typename DisplacementFieldType::RegionType & lineRegion);
+
   /** This method is called after the solution has been generated. In this case,
    * the filter release the memory of the internal buffers. */
   virtual void PostProcessOutput();
@@ -308,6 +332,22 @@ private:
   /** Temporary displacement field use for smoothing the
    * the displacement field. */
   DisplacementFieldPointer m_TempField;
+
+  /** Smooth the fields in place rather than with filters. */
+  bool m_SmoothInPlace;
+
+  /** Structure to pass information to the threads of SmoothFieldInPlace. */
+  struct SmoothFieldInPlaceThreadStruct {
+    PDEDeformableRegistrationFilter *Filter;
+    DisplacementFieldType *Field;
+    unsigned int Direction;
+    std::vector< double > Kernel;
+    typename DisplacementFieldType::RegionType LineRegion;
+  };
+
+  /** Split the line starts among the threads and call
+   * ThreadedSmoothFieldInPlace. */
+  static ITK_THREAD_RETURN_TYPE SmoothFieldInPlaceThreaderCallback(void *arg);
 private:
   /** Maximum error for Gaussian operator approximation. */
   double m_MaximumError;
@@ -26,6 +26,7 @@
 
 #include "itkGaussianOperator.h"
 #include "itkVectorNeighborhoodOperatorImageFilter.h"
+#include "itkImageRegionSplitter.h"
 
 #include "vnl/vnl_math.h"
 
@@ -58,6 +59,7 @@ PDEDeformableRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
 
   m_SmoothDisplacementField = true;
   m_SmoothUpdateField = false;
+  m_SmoothInPlace = true;
 }
 
 /*
@@ -221,6 +223,8 @@ PDEDeformableRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
   os << m_MaximumError << std::endl;
   os << indent << "MaximumKernelWidth: ";
   os << m_MaximumKernelWidth << std::endl;
+  os << indent << "SmoothInPlace: ";
+  os << m_SmoothInPlace << std::endl;
 }
 
 /*
@@ -390,6 +394,12 @@ PDEDeformableRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
 {
   DisplacementFieldPointer field = this->GetOutput();
 
+  if ( m_SmoothInPlace )
+    {
+    this->SmoothFieldInPlace( field, m_StandardDeviations );
+    return;
+    }
+
   // copy field to TempField
   m_TempField->SetOrigin( field->GetOrigin() );
   m_TempField->SetSpacing( field->GetSpacing() );
@@ -461,6 +471,12 @@ PDEDeformableRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
   // The update buffer will be overwritten with new data.
   DisplacementFieldPointer field = this->GetUpdateBuffer();
 
+  if ( m_SmoothInPlace )
+    {
+    this->SmoothFieldInPlace( field, this->GetUpdateFieldStandardDeviations() );
+    return;
+    }
+
   typedef typename DisplacementFieldType::PixelType       VectorType;
   typedef typename VectorType::ValueType                  ScalarType;
   typedef GaussianOperator< ScalarType, ImageDimension >  OperatorType;
@@ -508,6 +524,139 @@ PDEDeformableRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
                                    ->GetLargestPossibleRegion() );
   field->CopyInformation( smoothers[ImageDimension - 1]->GetOutput() );
 }
+
+/*
+ * Smooth a field in place using a separable Gaussian kernel
+ */
+template< class TFixedImage, class TMovingImage, class TDisplacementField >
+void
+PDEDeformableRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
+::SmoothFieldInPlace(DisplacementFieldType *field,
+                     const StandardDeviationsType & standardDeviations)
+{
+  typedef typename DisplacementFieldType::PixelType      VectorType;
+  typedef typename VectorType::ValueType                 ScalarType;
+  typedef GaussianOperator< ScalarType, ImageDimension > OperatorType;
+
+  SmoothFieldInPlaceThreadStruct str;
+  str.Filter = this;
+  str.Field = field;
+
+  for ( unsigned int j = 0; j < ImageDimension; j++ )
+    {
+    // smooth along this dimension
+    OperatorType oper;
+    oper.SetDirection(j);
+    oper.SetVariance( vnl_math_sqr(standardDeviations[j]) );
+    oper.SetMaximumError(m_MaximumError);
+    oper.SetMaximumKernelWidth(m_MaximumKernelWidth);
+    oper.CreateDirectional();
+
+    str.Direction = j;
+    str.Kernel.assign( oper.Begin(), oper.End() );
+
+    // each line along this dimension starts in the first slice
+    str.LineRegion = field->GetBufferedRegion();
+    typename DisplacementFieldType::SizeType lineStarts = str.LineRegion.GetSize();
+    lineStarts[j] = 1;
+    str.LineRegion.SetSize(lineStarts);
+
+    this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+    this->GetMultiThreader()->SetSingleMethod(this->SmoothFieldInPlaceThreaderCallback,
+                                              &str);
+    this->GetMultiThreader()->SingleMethodExecute();
+    }
+
+  field->Modified();
+}
+
+template< class TFixedImage, class TMovingImage, class TDisplacementField >
+ITK_THREAD_RETURN_TYPE
+PDEDeformableRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
+::SmoothFieldInPlaceThreaderCallback(void *arg)
+{
+  ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+  ThreadIdType threadCount = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->NumberOfThreads;
+
+  SmoothFieldInPlaceThreadStruct *str = (SmoothFieldInPlaceThreadStruct *)
+    ( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+
+  typedef ImageRegionSplitter< ImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+
+  ThreadIdType total = splitter->GetNumberOfSplits(str->LineRegion, threadCount);
+  if ( threadId < total )
+    {
+    str->Filter->ThreadedSmoothFieldInPlace( str->Field, str->Direction, str->Kernel,
+                                             splitter->GetSplit(threadId, total, str->LineRegion) );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TFixedImage, class TMovingImage, class TDisplacementField >
+void
+PDEDeformableRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
+::ThreadedSmoothFieldInPlace(DisplacementFieldType *field,
+                             unsigned int direction,
+                             const std::vector< double > & kernel,
+                             const typename DisplacementFieldType::RegionType & lineRegion)
+{
+  typedef typename DisplacementFieldType::PixelType VectorType;
+  typedef typename VectorType::ValueType            ScalarType;
+  typedef typename DisplacementFieldType::RegionType RegionType;
+
+  // extend the line starts to full lines along the direction
+  RegionType region = lineRegion;
+  typename RegionType::SizeType size = region.GetSize();
+  const long length = static_cast< long >( field->GetBufferedRegion().GetSize()[direction] );
+  size[direction] = length;
+  region.SetSize(size);
+
+  const long radius = static_cast< long >( kernel.size() / 2 );
+  const long kernelSize = static_cast< long >( kernel.size() );
+
+  // A copy of the current line, so that the line can be overwritten.
+  std::vector< VectorType > line(length);
+
+  ImageLinearIteratorWithIndex< DisplacementFieldType > it(field, region);
+  it.SetDirection(direction);
+  it.GoToBegin();
+  while ( !it.IsAtEnd() )
+    {
+    long i = 0;
+    while ( !it.IsAtEndOfLine() )
+      {
+      line[i++] = it.Get();
+      ++it;
+      }
+
+    // Accumulate in the same order and type as VectorNeighborhoodInnerProduct,
+    // with the zero flux Neumann boundary condition.
+    it.GoToBeginOfLine();
+    for ( i = 0; i < length; ++i )
+      {
+      VectorType sum;
+      for ( unsigned int c = 0; c < VectorType::Dimension; ++c )
+        {
+        sum[c] = NumericTraits< ScalarType >::Zero;
+        }
+      for ( long k = 0; k < kernelSize; ++k )
+        {
+        long n = i + k - radius;
+        n = ( n < 0 ) ? 0 : ( ( n >= length ) ? length - 1 : n );
+        const ScalarType coefficient = static_cast< ScalarType >( kernel[k] );
+        for ( unsigned int c = 0; c < VectorType::Dimension; ++c )
+          {
+          sum[c] += coefficient * line[n][c];
+          }
+        }
+      it.Set(sum);
+      ++it;
+      }
+    it.NextLine();
+    }
+}
 } // end namespace itk
 
 #endif
@@ -263,6 +263,46 @@ int itkDemonsRegistrationFilterTest(int, char* [] )
     return EXIT_FAILURE;
     }
 
+  // -----------------------------------------------------------
+  std::cout << "Compare in place and filter based smoothing." << std::endl;
+
+  FieldType::Pointer smoothedFields[2];
+  for ( unsigned int k = 0; k < 2; k++ )
+    {
+    RegistrationType::Pointer smoothingRegistrator = RegistrationType::New();
+    smoothingRegistrator->SetInitialDisplacementField( initField );
+    smoothingRegistrator->SetMovingImage( moving );
+    smoothingRegistrator->SetFixedImage( fixed );
+    smoothingRegistrator->SetNumberOfIterations( 20 );
+    smoothingRegistrator->SetStandardDeviations( 1.5 );
+    smoothingRegistrator->SmoothUpdateFieldOn();
+    smoothingRegistrator->SetUpdateFieldStandardDeviations( 1.0 );
+    smoothingRegistrator->SetSmoothInPlace( k == 0 );
+    smoothingRegistrator->Update();
+    smoothedFields[k] = smoothingRegistrator->GetOutput();
+    }
+
+  itk::ImageRegionIterator<FieldType> inPlaceIter( smoothedFields[0],
+      smoothedFields[0]->GetBufferedRegion() );
+  itk::ImageRegionIterator<FieldType> filterIter( smoothedFields[1],
+      smoothedFields[1]->GetBufferedRegion() );
+  double maxDifference = 0.0;
+  while( !inPlaceIter.IsAtEnd() )
+    {
+    maxDifference = vnl_math_max( maxDifference,
+      static_cast<double>( ( inPlaceIter.Get() - filterIter.Get() ).GetNorm() ) );
+    ++inPlaceIter;
+    ++filterIter;
+    }
+
+  std::cout << "Maximum difference: " << maxDifference << std::endl;
+
+  if( maxDifference > 1e-4 )
+    {
+    std::cout << "Test failed - in place smoothing differs from filter based smoothing." << std::endl;
+    return EXIT_FAILURE;
+    }
+
   registrator->Print( std::cout );
 
   // -----------------------------------------------------------
@@ -103,6 +103,7 @@ protected:
     m_Caster = CastImageFilter< FeatureImageType, ImageType >::New();
     m_Canny = CannyEdgeDetectionImageFilter< ImageType, ImageType >::New();
     m_Distance = DanielssonDistanceMapImageFilter< ImageType, ImageType >::New();
+    m_Distance->ComputeVectorDistanceMapOff();
   }
 
   virtual ~CannySegmentationLevelSetFunction() {}
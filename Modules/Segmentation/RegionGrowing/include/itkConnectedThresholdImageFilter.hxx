@@ -20,10 +20,7 @@
 
 #include "itkConnectedThresholdImageFilter.h"
 #include "itkBinaryThresholdImageFunction.h"
-#include "itkFloodFilledImageFunctionConditionalIterator.h"
-#include "itkProgressReporter.h"
-
-#include "itkShapedFloodFilledImageFunctionConditionalIterator.h"
+#include "itkScanlineFloodFiller.h"
 
 namespace itk
 {
@@ -285,45 +282,30 @@ ConnectedThresholdImageFilter< TInputImage, TOutputImage >
   outputImage->Allocate();
   outputImage->FillBuffer (NumericTraits< OutputImagePixelType >::Zero);
 
-  typedef BinaryThresholdImageFunction< InputImageType, double > FunctionType;
-
-  typename FunctionType::Pointer function = FunctionType::New();
-  function->SetInputImage (inputImage);
-  function->ThresholdBetween (m_Lower, m_Upper);
+  const bool fullyConnected = ( this->m_Connectivity == FullConnectivity );
 
-  ProgressReporter progress( this, 0, region.GetNumberOfPixels() );
-
-  if ( this->m_Connectivity == FaceConnectivity )
+  if ( inputImage->GetBufferedRegion() == region )
     {
-    typedef FloodFilledImageFunctionConditionalIterator< OutputImageType, FunctionType > IteratorType;
-    IteratorType it (outputImage, function, m_Seeds);
-    it.GoToBegin();
-
-    while ( !it.IsAtEnd() )
-      {
-      it.Set(m_ReplaceValue);
-      ++it;
-      progress.CompletedPixel();  // potential exception thrown here
-      }
+    // read the input pixels with the offsets of the output pixels
+    typedef Functor::BinaryThresholdFloodFillPredicate< InputImageType > PredicateType;
+    PredicateType predicate(inputImage, m_Lower, m_Upper);
+
+    ScanlineFloodFiller< OutputImageType, PredicateType > filler(outputImage, predicate, fullyConnected);
+    filler.Fill(m_Seeds, m_ReplaceValue, this);
     }
-  else if ( this->m_Connectivity == FullConnectivity )
+  else
     {
-    // use the fully connected iterator here. The fully connected iterator
-    // below is a superset of the above. However, it is reported to be 20%
-    // slower. Hence we use this "if" block to use the old iterator when
-    // we don't need full connectivity.
-
-    typedef ShapedFloodFilledImageFunctionConditionalIterator< OutputImageType, FunctionType > IteratorType;
-    IteratorType it (outputImage, function, m_Seeds);
-    it.FullyConnectedOn();
-    it.GoToBegin();
-
-    while ( !it.IsAtEnd() )
-      {
-      it.Set(m_ReplaceValue);
-      ++it;
-      progress.CompletedPixel();  // potential exception thrown here
-      }
+    typedef BinaryThresholdImageFunction< InputImageType, double > FunctionType;
+
+    typename FunctionType::Pointer function = FunctionType::New();
+    function->SetInputImage (inputImage);
+    function->ThresholdBetween (m_Lower, m_Upper);
+
+    typedef Functor::ImageFunctionFloodFillPredicate< FunctionType > PredicateType;
+    PredicateType predicate( function.GetPointer() );
+
+    ScanlineFloodFiller< OutputImageType, PredicateType > filler(outputImage, predicate, fullyConnected);
+    filler.Fill(m_Seeds, m_ReplaceValue, this);
     }
 }
 } // end namespace itk
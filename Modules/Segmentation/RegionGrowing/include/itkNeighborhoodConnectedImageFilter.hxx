@@ -20,8 +20,7 @@
 
 #include "itkNeighborhoodConnectedImageFilter.h"
 #include "itkNeighborhoodBinaryThresholdImageFunction.h"
-#include "itkFloodFilledImageFunctionConditionalIterator.h"
-#include "itkProgressReporter.h"
+#include "itkScanlineFloodFiller.h"
 
 namespace itk
 {
@@ -125,23 +124,18 @@ NeighborhoodConnectedImageFilter< TInputImage, TOutputImage >
   outputImage->Allocate();
   outputImage->FillBuffer (NumericTraits< OutputImagePixelType >::Zero);
 
-  typedef NeighborhoodBinaryThresholdImageFunction< InputImageType >                   FunctionType;
-  typedef FloodFilledImageFunctionConditionalIterator< OutputImageType, FunctionType > IteratorType;
+  typedef NeighborhoodBinaryThresholdImageFunction< InputImageType > FunctionType;
 
   typename FunctionType::Pointer function = FunctionType::New();
   function->SetInputImage (inputImage);
   function->ThresholdBetween (m_Lower, m_Upper);
   function->SetRadius (m_Radius);
-  IteratorType it = IteratorType (outputImage, function, m_Seeds);
 
-  ProgressReporter progress( this, 0,
-                             outputImage->GetRequestedRegion().GetNumberOfPixels() );
-  while ( !it.IsAtEnd() )
-    {
-    it.Set(m_ReplaceValue);
-    ++it;
-    progress.CompletedPixel();
-    }
+  typedef Functor::ImageFunctionFloodFillPredicate< FunctionType > PredicateType;
+  PredicateType predicate( function.GetPointer() );
+
+  ScanlineFloodFiller< OutputImageType, PredicateType > filler(outputImage, predicate);
+  filler.Fill(m_Seeds, m_ReplaceValue, this);
 }
 } // end namespace itk
 
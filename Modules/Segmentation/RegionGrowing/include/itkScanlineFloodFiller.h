@@ -0,0 +1,182 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkScanlineFloodFiller_h
+#define __itkScanlineFloodFiller_h
+
+#include "itkProcessObject.h"
+#include <vector>
+
+namespace itk
+{
+namespace Functor
+{
+/** \class BinaryThresholdFloodFillPredicate
+ * \brief Include the pixels whose value lies between two thresholds.
+ *
+ * The pixels are read by offset in the buffer of the image, which must have
+ * the same buffered region as the filled image.
+ *
+ * \ingroup ITKRegionGrowing
+ */
+template< class TImage >
+class BinaryThresholdFloodFillPredicate
+{
+public:
+  typedef typename TImage::PixelType       PixelType;
+  typedef typename TImage::IndexType       IndexType;
+  typedef typename TImage::OffsetValueType OffsetValueType;
+
+  BinaryThresholdFloodFillPredicate(const TImage *image,
+                                    const PixelType & lower,
+                                    const PixelType & upper):
+    m_Buffer( image->GetBufferPointer() ),
+    m_Lower(lower),
+    m_Upper(upper)
+  {}
+
+  bool operator()(OffsetValueType offset, const IndexType &) const
+  {
+    const PixelType & value = m_Buffer[offset];
+
+    return ( m_Lower <= value && value <= m_Upper );
+  }
+
+private:
+  const PixelType *m_Buffer;
+  PixelType        m_Lower;
+  PixelType        m_Upper;
+};
+
+/** \class ImageFunctionFloodFillPredicate
+ * \brief Include the pixels where a boolean image function is true.
+ *
+ * The function must be safe to evaluate from several threads.
+ *
+ * \ingroup ITKRegionGrowing
+ */
+template< class TFunction >
+class ImageFunctionFloodFillPredicate
+{
+public:
+  typedef typename TFunction::IndexType IndexType;
+
+  ImageFunctionFloodFillPredicate(const TFunction *function):
+    m_Function(function)
+  {}
+
+  bool operator()(OffsetValueType, const IndexType & index) const
+  {
+    return m_Function->EvaluateAtIndex(index);
+  }
+
+private:
+  const TFunction *m_Function;
+};
+} // end namespace Functor
+
+/** \class ScanlineFloodFiller
+ * \brief Set the pixels connected to seeds and satisfying a predicate to a
+ * value, on several threads.
+ *
+ * The pixels are filled by spans along the first dimension: each span is
+ * extended as far as the predicate holds, then the neighboring lines are
+ * scanned for new spans.  A pixel of the image equal to the fill value is
+ * considered as already filled, so the image is usually initialized with
+ * another value.
+ *
+ * The image is split in slabs of slices along the last dimension, one per
+ * thread.  Each thread fills the spans of its own slab, and hands over the
+ * spans found in the neighboring slabs to their threads for the next round.
+ * The filling stops when no span is handed over.  With a single thread, the
+ * whole image is filled in one round.
+ *
+ * The predicate is a functor called with the offset of the pixel in the
+ * buffer of the image and its index.  It is evaluated from several threads.
+ *
+ * This is used by ConnectedThresholdImageFilter and
+ * NeighborhoodConnectedImageFilter instead of the flood filled iterators.
+ *
+ * \sa FloodFilledImageFunctionConditionalIterator
+ * \ingroup ITKRegionGrowing
+ */
+template< class TImage, class TPredicate >
+class ScanlineFloodFiller
+{
+public:
+  typedef TImage                          ImageType;
+  typedef typename ImageType::PixelType   PixelType;
+  typedef typename ImageType::IndexType   IndexType;
+  typedef typename ImageType::RegionType  RegionType;
+  typedef typename ImageType::OffsetValueType OffsetValueType;
+  typedef TPredicate                      PredicateType;
+  typedef std::vector< IndexType >        SeedContainerType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int, ImageType::ImageDimension);
+
+  /** Fill the buffered region of the image.  With full connectivity, the
+   * pixels which share a corner are neighbors; otherwise only the pixels
+   * which share a face are. */
+  ScanlineFloodFiller(ImageType *image, const PredicateType & predicate,
+                      bool fullyConnected = false);
+
+  /** Fill the pixels connected to the seeds with the given value.  The
+   * seeds outside the image or where the predicate is false are ignored.
+   * The threads and the progress are the ones of the given filter. */
+  void Fill(const SeedContainerType & seeds, const PixelType & value,
+            ProcessObject *filter);
+
+protected:
+  /** Fill the slab of the given thread from the spans handed over to it. */
+  void ThreadedFill(ThreadIdType threadId);
+
+  static ITK_THREAD_RETURN_TYPE FillThreaderCallback(void *arg);
+
+private:
+  ScanlineFloodFiller(const ScanlineFloodFiller &); //purposely not implemented
+  void operator=(const ScanlineFloodFiller &);      //purposely not implemented
+
+  typedef std::vector< OffsetValueType > SpanContainerType;
+
+  ImageType    *m_Image;
+  PredicateType m_Predicate;
+  RegionType    m_Region;
+  PixelType     m_Value;
+  ProcessObject *m_Filter;
+
+  // Offsets to the neighboring lines, and the corresponding moves of the
+  // index along the dimensions other than the first one
+  std::vector< OffsetValueType > m_LineOffsets;
+  std::vector< IndexType >       m_LineMoves;
+  bool                           m_FullyConnected;
+
+  // Slabs of slices along the last dimension
+  std::vector< ThreadIdType > m_SliceOwner;
+  std::vector< SizeValueType > m_SlabSize;
+
+  // Seeds of the spans by round parity, source and destination thread
+  std::vector< std::vector< SpanContainerType > > m_Seeds[2];
+  unsigned int                                    m_Round;
+  float                                           m_Progress;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkScanlineFloodFiller.hxx"
+#endif
+
+#endif
@@ -0,0 +1,311 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkScanlineFloodFiller_hxx
+#define __itkScanlineFloodFiller_hxx
+
+#include "itkScanlineFloodFiller.h"
+#include "itkProgressReporter.h"
+#include <algorithm>
+
+namespace itk
+{
+template< class TImage, class TPredicate >
+ScanlineFloodFiller< TImage, TPredicate >
+::ScanlineFloodFiller(ImageType *image, const PredicateType & predicate,
+                      bool fullyConnected):
+  m_Image(image),
+  m_Predicate(predicate),
+  m_Filter(NULL),
+  m_FullyConnected(fullyConnected),
+  m_Round(0),
+  m_Progress(0.0f)
+{
+  m_Region = m_Image->GetBufferedRegion();
+
+  // The neighboring lines are at a distance of at most one along each
+  // dimension other than the first one, and only along one of them
+  // without full connectivity
+  const OffsetValueType *offsetTable = m_Image->GetOffsetTable();
+
+  IndexType move;
+  move.Fill(-1);
+  move[0] = 0;
+  while ( true )
+    {
+    unsigned int moved = 0;
+    OffsetValueType offset = 0;
+    for ( unsigned int d = 1; d < ImageDimension; d++ )
+      {
+      if ( move[d] != 0 )
+        {
+        ++moved;
+        offset += move[d] * offsetTable[d];
+        }
+      }
+    if ( moved == 1 || ( moved > 1 && m_FullyConnected ) )
+      {
+      m_LineOffsets.push_back(offset);
+      m_LineMoves.push_back(move);
+      }
+
+    unsigned int d = 1;
+    while ( d < ImageDimension && move[d] == 1 )
+      {
+      move[d++] = -1;
+      }
+    if ( d == ImageDimension )
+      {
+      break;
+      }
+    ++move[d];
+    }
+}
+
+template< class TImage, class TPredicate >
+void
+ScanlineFloodFiller< TImage, TPredicate >
+::Fill(const SeedContainerType & seeds, const PixelType & value,
+       ProcessObject *filter)
+{
+  m_Value = value;
+  m_Filter = filter;
+
+  // The lines along the first dimension must not be split
+  const unsigned int    lastDimension = ImageDimension - 1;
+  const SizeValueType   numberOfSlices = m_Region.GetSize()[lastDimension];
+  ThreadIdType          numberOfThreads = filter->GetNumberOfThreads();
+  if ( lastDimension == 0 )
+    {
+    numberOfThreads = 1;
+    }
+  if ( numberOfThreads > numberOfSlices )
+    {
+    numberOfThreads = static_cast< ThreadIdType >( numberOfSlices );
+    }
+
+  m_SliceOwner.resize(numberOfSlices);
+  m_SlabSize.resize(numberOfThreads);
+  const SizeValueType pixelsPerSlice = m_Region.GetNumberOfPixels() / numberOfSlices;
+  for ( ThreadIdType t = 0; t < numberOfThreads; t++ )
+    {
+    const SizeValueType begin = ( numberOfSlices * t ) / numberOfThreads;
+    const SizeValueType end = ( numberOfSlices * ( t + 1 ) ) / numberOfThreads;
+    std::fill(m_SliceOwner.begin() + begin, m_SliceOwner.begin() + end, t);
+    m_SlabSize[t] = ( end - begin ) * pixelsPerSlice;
+    }
+
+  for ( unsigned int parity = 0; parity < 2; parity++ )
+    {
+    m_Seeds[parity].assign( numberOfThreads,
+                            std::vector< SpanContainerType >(numberOfThreads) );
+    }
+
+  // Hand the seeds over to the threads of their slabs
+  m_Round = 0;
+  for ( typename SeedContainerType::const_iterator it = seeds.begin(); it != seeds.end(); ++it )
+    {
+    if ( m_Region.IsInside(*it) && m_Predicate(m_Image->ComputeOffset(*it), *it) )
+      {
+      const ThreadIdType owner =
+        m_SliceOwner[( *it )[lastDimension] - m_Region.GetIndex()[lastDimension]];
+      m_Seeds[0][0][owner].push_back( m_Image->ComputeOffset(*it) );
+      }
+    }
+
+  filter->GetMultiThreader()->SetNumberOfThreads(numberOfThreads);
+  filter->GetMultiThreader()->SetSingleMethod(this->FillThreaderCallback, this);
+
+  filter->UpdateProgress(0.0f);
+
+  bool handedOver = true;
+  while ( handedOver )
+    {
+    // The progress of the rounds is not known in advance, each one goes on
+    // from the previous one
+    m_Progress = filter->GetProgress();
+    filter->GetMultiThreader()->SingleMethodExecute();
+
+    m_Round = 1 - m_Round;
+    handedOver = false;
+    for ( ThreadIdType s = 0; s < numberOfThreads && !handedOver; s++ )
+      {
+      for ( ThreadIdType t = 0; t < numberOfThreads; t++ )
+        {
+        if ( !m_Seeds[m_Round][s][t].empty() )
+          {
+          handedOver = true;
+          break;
+          }
+        }
+      }
+    }
+
+  for ( unsigned int parity = 0; parity < 2; parity++ )
+    {
+    m_Seeds[parity].clear();
+    }
+  m_Filter = NULL;
+}
+
+template< class TImage, class TPredicate >
+ITK_THREAD_RETURN_TYPE
+ScanlineFloodFiller< TImage, TPredicate >
+::FillThreaderCallback(void *arg)
+{
+  ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+
+  ScanlineFloodFiller *filler = (ScanlineFloodFiller *)
+    ( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+
+  filler->ThreadedFill(threadId);
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TImage, class TPredicate >
+void
+ScanlineFloodFiller< TImage, TPredicate >
+::ThreadedFill(ThreadIdType threadId)
+{
+  const unsigned int    lastDimension = ImageDimension - 1;
+  const IndexType &     start = m_Region.GetIndex();
+  const IndexValueType  lineEnd = start[0] + static_cast< IndexValueType >( m_Region.GetSize()[0] );
+  PixelType *           buffer = m_Image->GetBufferPointer();
+
+  // Gather the seeds handed over in the previous round
+  SpanContainerType stack;
+  for ( size_t s = 0; s < m_Seeds[m_Round].size(); s++ )
+    {
+    SpanContainerType & seeds = m_Seeds[m_Round][s][threadId];
+    stack.insert( stack.end(), seeds.begin(), seeds.end() );
+    seeds.clear();
+    }
+
+  std::vector< SpanContainerType > & handOver = m_Seeds[1 - m_Round][threadId];
+
+  ProgressReporter progress( m_Filter, threadId, m_SlabSize[threadId], 100,
+                             m_Progress, 1.0f - m_Progress );
+
+  // All the seeds satisfy the predicate
+  while ( !stack.empty() )
+    {
+    const OffsetValueType seed = stack.back();
+    stack.pop_back();
+
+    if ( buffer[seed] == m_Value )
+      {
+      continue;
+      }
+
+    // Extend the span along the line
+    IndexType       index = m_Image->ComputeIndex(seed);
+    const OffsetValueType line = seed - ( index[0] - start[0] );
+
+    IndexValueType first = index[0];
+    IndexValueType last = index[0];
+
+    for ( index[0] = first - 1; index[0] >= start[0]; --index[0] )
+      {
+      const OffsetValueType offset = line + ( index[0] - start[0] );
+      if ( buffer[offset] == m_Value || !m_Predicate(offset, index) )
+        {
+        break;
+        }
+      first = index[0];
+      }
+    for ( index[0] = last + 1; index[0] < lineEnd; ++index[0] )
+      {
+      const OffsetValueType offset = line + ( index[0] - start[0] );
+      if ( buffer[offset] == m_Value || !m_Predicate(offset, index) )
+        {
+        break;
+        }
+      last = index[0];
+      }
+
+    for ( IndexValueType x = first; x <= last; ++x )
+      {
+      buffer[line + ( x - start[0] )] = m_Value;
+      progress.CompletedPixel();
+      }
+
+    // Look for spans on the neighboring lines
+    IndexValueType scanFirst = first;
+    IndexValueType scanLast = last;
+    if ( m_FullyConnected )
+      {
+      scanFirst = std::max(first - 1, start[0]);
+      scanLast = std::min(last + 1, lineEnd - 1);
+      }
+
+    for ( size_t n = 0; n < m_LineOffsets.size(); n++ )
+      {
+      IndexType neighbor = index;
+      bool      inside = true;
+      for ( unsigned int d = 1; d < ImageDimension; d++ )
+        {
+        neighbor[d] += m_LineMoves[n][d];
+        if ( neighbor[d] < start[d]
+             || neighbor[d] >= start[d] + static_cast< IndexValueType >( m_Region.GetSize()[d] ) )
+          {
+          inside = false;
+          break;
+          }
+        }
+      if ( !inside )
+        {
+        continue;
+        }
+
+      const OffsetValueType neighborLine = line + m_LineOffsets[n];
+      const ThreadIdType    owner = m_SliceOwner[neighbor[lastDimension] - start[lastDimension]];
+
+      // The pixels of the other slabs may be written by their threads, the
+      // spans found there are checked by them in the next round
+      const bool own = ( owner == threadId );
+
+      bool inSpan = false;
+      for ( neighbor[0] = scanFirst; neighbor[0] <= scanLast; ++neighbor[0] )
+        {
+        const OffsetValueType offset = neighborLine + ( neighbor[0] - start[0] );
+        if ( ( !own || buffer[offset] != m_Value ) && m_Predicate(offset, neighbor) )
+          {
+          if ( !inSpan )
+            {
+            if ( own )
+              {
+              stack.push_back(offset);
+              }
+            else
+              {
+              handOver[owner].push_back(offset);
+              }
+            inSpan = true;
+            }
+          }
+        else
+          {
+          inSpan = false;
+          }
+        }
+      }
+    }
+}
+} // end namespace itk
+
+#endif
@@ -0,0 +1,229 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkConnectedThresholdImageFilter.h"
+#include "itkNeighborhoodConnectedImageFilter.h"
+#include "itkFloodFilledImageFunctionConditionalIterator.h"
+#include "itkShapedFloodFilledImageFunctionConditionalIterator.h"
+#include "itkBinaryThresholdImageFunction.h"
+#include "itkNeighborhoodBinaryThresholdImageFunction.h"
+#include "itkImageRegionIterator.h"
+
+namespace
+{
+typedef itk::Image< short, 3 >         InputImageType;
+typedef itk::Image< unsigned char, 3 > OutputImageType;
+typedef std::vector< InputImageType::IndexType > SeedContainerType;
+
+// Fill the output with the flood filled iterators
+template< class TIterator, class TFunction >
+OutputImageType::Pointer
+FloodFill( TFunction *function, const SeedContainerType & seeds,
+           const InputImageType::RegionType & region, bool fullyConnected )
+{
+  OutputImageType::Pointer output = OutputImageType::New();
+  output->SetRegions( region );
+  output->Allocate();
+  output->FillBuffer( 0 );
+
+  TIterator it( output, function, const_cast< SeedContainerType & >( seeds ) );
+  if( fullyConnected )
+    {
+    it.FullyConnectedOn();
+    }
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( 255 );
+    }
+  return output;
+}
+
+template< class TIterator, class TFunction >
+OutputImageType::Pointer
+FloodFill( TFunction *function, const SeedContainerType & seeds,
+           const InputImageType::RegionType & region )
+{
+  OutputImageType::Pointer output = OutputImageType::New();
+  output->SetRegions( region );
+  output->Allocate();
+  output->FillBuffer( 0 );
+
+  TIterator it( output, function, const_cast< SeedContainerType & >( seeds ) );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( 255 );
+    }
+  return output;
+}
+
+bool
+CompareImages( const OutputImageType *expected, const OutputImageType *output,
+               const char *name, unsigned int numberOfThreads )
+{
+  itk::ImageRegionConstIterator< OutputImageType >
+    eit( expected, expected->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< OutputImageType >
+    oit( output, output->GetBufferedRegion() );
+
+  unsigned int numberOfFilled = 0;
+  unsigned int numberOfDifferences = 0;
+  for( ; !eit.IsAtEnd(); ++eit, ++oit )
+    {
+    numberOfFilled += ( eit.Get() != 0 );
+    numberOfDifferences += ( eit.Get() != oit.Get() );
+    }
+
+  std::cout << name << " with " << numberOfThreads << " threads: "
+            << numberOfFilled << " filled pixels, "
+            << numberOfDifferences << " differences" << std::endl;
+
+  return ( numberOfDifferences == 0 && numberOfFilled > 0 );
+}
+}
+
+int itkScanlineFloodFillerTest( int, char* [] )
+{
+  // A noisy image where the thresholded pixels form winding regions
+  InputImageType::SizeType size = {{ 41, 33, 27 }};
+  InputImageType::RegionType region;
+  region.SetSize( size );
+
+  InputImageType::Pointer image = InputImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+
+  unsigned int seed = 4321;
+  itk::ImageRegionIterator< InputImageType > it( image, region );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    seed = seed * 1103515245 + 12345;
+    it.Set( static_cast< short >( ( seed >> 16 ) % 100 ) );
+    }
+
+  SeedContainerType seeds;
+  InputImageType::IndexType index;
+  index[0] = 3;
+  index[1] = 5;
+  index[2] = 20;
+  seeds.push_back( index );
+  index[0] = 30;
+  index[1] = 20;
+  index[2] = 2;
+  seeds.push_back( index );
+
+  // Make sure the neighborhoods of the seeds are inside the thresholds
+  for( size_t i = 0; i < seeds.size(); i++ )
+    {
+    InputImageType::IndexType neighbor = seeds[i];
+    for( int y = -1; y <= 1; y++ )
+      {
+      for( int x = -1; x <= 1; x++ )
+        {
+        neighbor[0] = seeds[i][0] + x;
+        neighbor[1] = seeds[i][1] + y;
+        image->SetPixel( neighbor, 10 );
+        }
+      }
+    }
+  index[0] = 100; // outside of the image
+  seeds.push_back( index );
+
+  const short lower = 0;
+  const short upper = 68;
+
+  typedef itk::BinaryThresholdImageFunction< InputImageType, double > FunctionType;
+  FunctionType::Pointer function = FunctionType::New();
+  function->SetInputImage( image );
+  function->ThresholdBetween( lower, upper );
+
+  OutputImageType::Pointer faceExpected = FloodFill<
+    itk::FloodFilledImageFunctionConditionalIterator< OutputImageType, FunctionType > >
+      ( function.GetPointer(), seeds, region );
+  OutputImageType::Pointer fullExpected = FloodFill<
+    itk::ShapedFloodFilledImageFunctionConditionalIterator< OutputImageType, FunctionType > >
+      ( function.GetPointer(), seeds, region, true );
+
+  typedef itk::NeighborhoodBinaryThresholdImageFunction< InputImageType > NeighborhoodFunctionType;
+  NeighborhoodFunctionType::Pointer neighborhoodFunction = NeighborhoodFunctionType::New();
+  neighborhoodFunction->SetInputImage( image );
+  neighborhoodFunction->ThresholdBetween( lower, 90 );
+  InputImageType::SizeType radius;
+  radius.Fill( 1 );
+  radius[2] = 0;
+  neighborhoodFunction->SetRadius( radius );
+
+  OutputImageType::Pointer neighborhoodExpected = FloodFill<
+    itk::FloodFilledImageFunctionConditionalIterator< OutputImageType, NeighborhoodFunctionType > >
+      ( neighborhoodFunction.GetPointer(), seeds, region );
+
+  typedef itk::ConnectedThresholdImageFilter< InputImageType, OutputImageType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( image );
+  filter->SetLower( lower );
+  filter->SetUpper( upper );
+  filter->SetReplaceValue( 255 );
+  for( size_t i = 0; i < seeds.size(); i++ )
+    {
+    filter->AddSeed( seeds[i] );
+    }
+
+  typedef itk::NeighborhoodConnectedImageFilter< InputImageType, OutputImageType >
+    NeighborhoodFilterType;
+  NeighborhoodFilterType::Pointer neighborhoodFilter = NeighborhoodFilterType::New();
+  neighborhoodFilter->SetInput( image );
+  neighborhoodFilter->SetLower( lower );
+  neighborhoodFilter->SetUpper( 90 );
+  neighborhoodFilter->SetRadius( radius );
+  neighborhoodFilter->SetReplaceValue( 255 );
+  for( size_t i = 0; i < seeds.size(); i++ )
+    {
+    neighborhoodFilter->AddSeed( seeds[i] );
+    }
+
+  bool passed = true;
+
+  const unsigned int numberOfThreads[3] = { 1, 3, 8 };
+  for( unsigned int t = 0; t < 3; t++ )
+    {
+    filter->SetNumberOfThreads( numberOfThreads[t] );
+
+    filter->SetConnectivity( FilterType::FaceConnectivity );
+    filter->Update();
+    passed &= CompareImages( faceExpected, filter->GetOutput(),
+                             "Face connectivity", numberOfThreads[t] );
+
+    filter->SetConnectivity( FilterType::FullConnectivity );
+    filter->Update();
+    passed &= CompareImages( fullExpected, filter->GetOutput(),
+                             "Full connectivity", numberOfThreads[t] );
+
+    neighborhoodFilter->SetNumberOfThreads( numberOfThreads[t] );
+    neighborhoodFilter->Update();
+    passed &= CompareImages( neighborhoodExpected, neighborhoodFilter->GetOutput(),
+                             "Neighborhood", numberOfThreads[t] );
+    }
+
+  if( !passed )
+    {
+    std::cout << "Test failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
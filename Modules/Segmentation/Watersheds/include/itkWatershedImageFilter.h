@@ -23,6 +23,10 @@
 #include "itkWatershedSegmentTreeGenerator.h"
 #include "itkWatershedRelabeler.h"
 #include "itkWatershedMiniPipelineProgressCommand.h"
+#include "itkWatershedSegmenter.h"
+#include <map>
+#include <string>
+#include <vector>
 
 namespace itk
 {
@@ -32,7 +36,7 @@ namespace itk
  *
  * \par Overview and terminology
  * \par
- * This filter implements a non-streaming version of an image segmentation
+ * This filter implements an image segmentation
  * algorithm commonly known as ``watershed segmentation''.   Watershed
  * segmentation gets its name from the manner in which the algorithm  segments
  * regions into catchment basins. If a function \f$ f \f$ is a continuous
@@ -75,9 +79,10 @@ namespace itk
  * algorithm components in the namespace ``watershed'').  For a more complete
  * picture of the implementation, refer to the documentation of those components.
  * The component classes were designed to operate in either a data-streaming or
- * a non-data-streaming mode.  The pipeline constructed in this class'
- * GenerateData() method does not support streaming, but is the common use case
- * for the components.
+ * a non-data-streaming mode.  By default the pipeline constructed in this
+ * class' GenerateData() method processes the whole input at once, which is
+ * the common use case for the components.  See the notes on streaming below
+ * for the alternative.
  *
  * \par Description of the input to this filter
  * The input to this filter is a scalar itk::Image of any dimensionality.  This
@@ -139,9 +144,25 @@ namespace itk
  * Get/SetThreshold() and Get/SetLevel() methods.
  *
  * \par Notes on streaming the watershed segmentation code
- *  Coming soon... 12/06/01
- *
+ * When NumberOfStreamDivisions is greater than one, the input is requested
+ * from the upstream pipeline in slabs along its outermost dimension, and each
+ * slab is segmented by its own watershed::Segmenter with boundary analysis
+ * turned on.  Up to GetNumberOfThreads() slabs are segmented at the same
+ * time.  The basins and flat regions that continue across the face between
+ * two slabs are joined, the adjacencies across that face are added to the
+ * segment table, and a single merge tree is computed from the combined
+ * table.  The filter then produces the output requested region only,
+ * segmenting again the slabs that overlap it.  Between executions it keeps
+ * only the segment table, the equivalencies and the merge tree, so a
+ * streaming consumer such as itk::StreamingImageFilter can produce the
+ * labeled image piece by piece without holding the whole input or output in
+ * memory.
  *
+ * \par
+ * The streamed segmentation has the same regions as the non-streamed one,
+ * but different label values.  The only exception is a flat region that
+ * crosses a slab face and has several lowest neighbors of equal value: it
+ * may flow into a different one of them.
  *
  * \ingroup WatershedSegmentation
  * \ingroup ITKWatersheds
@@ -233,14 +254,27 @@ public:
     return m_Segmenter->GetOutputImage();
   }
 
-  /** Get the segmentation tree from from the TreeGenerator member filter. */
+  /** Get the segmentation tree from from the TreeGenerator member filter.
+   * When the filter streams, this is the tree computed from the combined
+   * segment table of all the slabs. */
   typename watershed::SegmentTreeGenerator< ScalarType >::SegmentTreeType *
   GetSegmentTree()
   {
+    if ( m_NumberOfStreamDivisions > 1 )
+      {
+      return m_StreamedSegmentTree;
+      }
     return m_TreeGenerator->GetOutputSegmentTree();
   }
 
-  // Override since the filter produces all of its output
+  /** Set/Get the number of slabs the input is divided into.  A value of
+   * one (the default) segments the whole input at once.  Larger values
+   * stream the input and let the output be requested in pieces.  See the
+   * notes on streaming above. */
+  void SetNumberOfStreamDivisions(unsigned int);
+  itkGetConstMacro(NumberOfStreamDivisions, unsigned int);
+
+  // Override since the filter produces all of its output, unless it streams
   void EnlargeOutputRequestedRegion(DataObject *data);
 
 #ifdef ITK_USE_CONCEPT_CHECKING
@@ -268,6 +302,50 @@ private:
   WatershedImageFilter(const Self &);  //purposely not implemented
   void operator=(const Self &); //purposely not implemented
 
+  typedef watershed::Segmenter< InputImageType >  SegmenterType;
+  typedef watershed::SegmentTable< ScalarType >   SegmentTableType;
+  typedef watershed::SegmentTree< ScalarType >    SegmentTreeType;
+  typedef watershed::Boundary< ScalarType, itkGetStaticConstMacro(ImageDimension) > BoundaryType;
+
+  /** Data shared with the threads that segment the slabs. */
+  struct StreamingThreadStruct {
+    std::vector< typename SegmenterType::Pointer > Segmenters;
+    std::vector< std::string >                     Errors;
+  };
+
+  /** GenerateData() when NumberOfStreamDivisions is greater than one. */
+  void StreamedGenerateData();
+
+  /** Request a region of the input from the upstream pipeline and return a
+   * thresholded copy of it whose largest possible region is the one of
+   * the input. */
+  typename InputImageType::Pointer ReadStreamedRegion(const RegionType & region);
+
+  /** Update the segmenters of a batch of slabs in parallel. */
+  void UpdateStreamedSegmenters(std::vector< typename SegmenterType::Pointer > & segmenters);
+
+  static ITK_THREAD_RETURN_TYPE StreamingThreaderCallback(void *arg);
+
+  /** A flat region that reaches the face between two slabs, with the
+   * lowest pixel found around it so far.  A lowest label of
+   * watershed::Segmenter::NULL_LABEL means that no lower pixel is known. */
+  struct StreamedPlateauType {
+    ScalarType Value;
+    ScalarType LowestValue;
+    IdentifierType LowestLabel;
+  };
+  typedef std::map< IdentifierType, StreamedPlateauType > StreamedPlateauMapType;
+
+  /** Join the segments across the face between two slabs.  Labels that
+   * flow across the face are made equivalent, as watershed::BoundaryResolver
+   * does, except for flat regions: those only record the pixel they
+   * descend to, because where a flat region goes depends on all of its
+   * parts.  The adjacencies across the face are added to the streamed
+   * segment table, with heights computed as in watershed::Segmenter. */
+  void ResolveStreamedSeam(BoundaryType *boundaryA, const InputImageType *valuesA,
+                           BoundaryType *boundaryB, const InputImageType *valuesB,
+                           unsigned int face, StreamedPlateauMapType & plateaus);
+
   /** A Percentage of the maximum depth (max - min pixel value) in the input
    *  image.  This percentage will be used to threshold the minimum values in
    *  the image. */
@@ -296,6 +374,16 @@ private:
   bool m_InputChanged;
 
   TimeStamp m_GenerateDataMTime;
+
+  /** State of the streaming mode kept between executions.  The segment
+   * table holds the combined segments of all the slabs before any merge,
+   * the equivalency table the labels joined across slab faces. */
+  unsigned int                       m_NumberOfStreamDivisions;
+  ScalarType                         m_StreamedThreshold;
+  typename SegmentTableType::Pointer m_StreamedSegmentTable;
+  EquivalencyTable::Pointer          m_StreamedEquivalencyTable;
+  typename SegmentTreeType::Pointer  m_StreamedSegmentTree;
+  double                             m_StreamedFloodLevel;
 };
 } // end namespace itk
 
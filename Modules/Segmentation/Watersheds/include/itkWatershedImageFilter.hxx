@@ -18,6 +18,9 @@
 #ifndef __itkWatershedImageFilter_hxx
 #define __itkWatershedImageFilter_hxx
 #include "itkWatershedImageFilter.h"
+#include "itkImageRegionSplitter.h"
+#include "itkImageRegionIterator.h"
+#include "itkMultiThreader.h"
 
 namespace itk
 {
@@ -70,10 +73,35 @@ WatershedImageFilter< TInputImage >
     }
 }
 
+template< class TInputImage >
+void
+WatershedImageFilter< TInputImage >
+::SetNumberOfStreamDivisions(unsigned int val)
+{
+  if ( val < 1 )
+    {
+    val = 1;
+    }
+
+  if ( val != m_NumberOfStreamDivisions )
+    {
+    m_NumberOfStreamDivisions = val;
+
+    // the slabs, and so the streamed labels, depend on the divisions
+    m_StreamedSegmentTable = 0;
+    m_StreamedSegmentTree = 0;
+    this->Modified();
+    }
+}
+
 template< class TInputImage >
 WatershedImageFilter< TInputImage >
 ::WatershedImageFilter():m_Threshold(0.0), m_Level(0.0)
 {
+  m_NumberOfStreamDivisions = 1;
+  m_StreamedThreshold = NumericTraits< ScalarType >::Zero;
+  m_StreamedFloodLevel = 0.0;
+
   // Set up the mini-pipeline for the first execution.
   m_Segmenter    = watershed::Segmenter< InputImageType >::New();
   m_TreeGenerator = watershed::SegmentTreeGenerator< ScalarType >::New();
@@ -111,7 +139,10 @@ WatershedImageFilter< TInputImage >
 ::EnlargeOutputRequestedRegion(DataObject *data)
 {
   Superclass::EnlargeOutputRequestedRegion(data);
-  data->SetRequestedRegionToLargestPossibleRegion();
+  if ( m_NumberOfStreamDivisions <= 1 )
+    {
+    data->SetRequestedRegionToLargestPossibleRegion();
+    }
 }
 
 template< class TInputImage >
@@ -143,6 +174,9 @@ WatershedImageFilter< TInputImage >
     m_Relabeler->PrepareOutputs();
 
     m_TreeGenerator->SetHighestCalculatedFloodLevel(0.0);
+
+    m_StreamedSegmentTable = 0;
+    m_StreamedSegmentTree = 0;
     }
 
   // If the flood level changed but is below the Tree
@@ -164,6 +198,11 @@ WatershedImageFilter< TInputImage >
       m_TreeGenerator->PrepareOutputs();
       m_Relabeler->PrepareOutputs();
       }
+
+    if ( m_Level > m_StreamedFloodLevel )
+      {
+      m_StreamedSegmentTree = 0;
+      }
     }
 }
 
@@ -172,6 +211,17 @@ void
 WatershedImageFilter< TInputImage >
 ::GenerateData()
 {
+  if ( m_NumberOfStreamDivisions > 1 )
+    {
+    this->StreamedGenerateData();
+
+    m_GenerateDataMTime.Modified();
+    m_InputChanged = false;
+    m_LevelChanged = false;
+    m_ThresholdChanged = false;
+    return;
+    }
+
   // Set the largest possible region in the segmenter
   m_Segmenter->SetLargestPossibleRegion( this->GetInput()
                                          ->GetLargestPossibleRegion() );
@@ -211,6 +261,493 @@ WatershedImageFilter< TInputImage >
   Superclass::PrintSelf(os, indent);
   os << indent << "Threshold: " << m_Threshold << std::endl;
   os << indent << "Level: " << m_Level << std::endl;
+  os << indent << "NumberOfStreamDivisions: " << m_NumberOfStreamDivisions << std::endl;
+}
+
+template< class TInputImage >
+void
+WatershedImageFilter< TInputImage >
+::StreamedGenerateData()
+{
+  InputImageType * input = const_cast< InputImageType * >( this->GetInput() );
+  OutputImageType *output = this->GetOutput();
+
+  const RegionType largestRegion = input->GetLargestPossibleRegion();
+  const RegionType outputRegion  = output->GetRequestedRegion();
+
+  output->SetBufferedRegion(outputRegion);
+  output->Allocate();
+
+  // Divide the input into slabs along the axis the region splitter uses.
+  // Every slab keeps at least two slices so that its two faces differ.
+  unsigned int splitAxis = ImageDimension - 1;
+  while ( splitAxis > 0 && largestRegion.GetSize()[splitAxis] == 1 )
+    {
+    --splitAxis;
+    }
+  unsigned int numberOfDivisions = m_NumberOfStreamDivisions;
+  const SizeValueType slices = largestRegion.GetSize()[splitAxis];
+  if ( numberOfDivisions > slices / 2 )
+    {
+    numberOfDivisions = std::max( static_cast< unsigned int >( slices / 2 ), 1u );
+    }
+
+  typedef ImageRegionSplitter< ImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+  const unsigned int numberOfSlabs = splitter->GetNumberOfSplits(largestRegion, numberOfDivisions);
+
+  // The segmenters need their region padded by one pixel on the faces
+  // shared with another slab.  Each slab labels from its own base so that
+  // labels are unique over the whole image; a slab never uses more labels
+  // than it has pixels.
+  std::vector< RegionType >     slabs(numberOfSlabs);
+  std::vector< RegionType >     paddedSlabs(numberOfSlabs);
+  std::vector< IdentifierType > labelBase(numberOfSlabs);
+  IdentifierType                nextLabel = 1;
+  for ( unsigned int k = 0; k < numberOfSlabs; k++ )
+    {
+    slabs[k] = splitter->GetSplit(k, numberOfSlabs, largestRegion);
+    IndexType index = slabs[k].GetIndex();
+    SizeType  size = slabs[k].GetSize();
+    if ( k > 0 )
+      {
+      --index[splitAxis];
+      ++size[splitAxis];
+      }
+    if ( k + 1 < numberOfSlabs )
+      {
+      ++size[splitAxis];
+      }
+    paddedSlabs[k].SetIndex(index);
+    paddedSlabs[k].SetSize(size);
+
+    labelBase[k] = nextLabel;
+    nextLabel += paddedSlabs[k].GetNumberOfPixels();
+    }
+
+  const bool buildTables = m_StreamedSegmentTable.IsNull();
+  if ( buildTables )
+    {
+    // The threshold is a percentage of the depth of the whole input, so a
+    // first pass finds its range.
+    ScalarType minimum = NumericTraits< ScalarType >::max();
+    ScalarType maximum = NumericTraits< ScalarType >::NonpositiveMin();
+    for ( unsigned int k = 0; k < numberOfSlabs; k++ )
+      {
+      input->SetRequestedRegion(slabs[k]);
+      input->PropagateRequestedRegion();
+      input->UpdateOutputData();
+
+      ImageRegionConstIterator< InputImageType > it(input, slabs[k]);
+      for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+        {
+        const ScalarType value = it.Get();
+        if ( value < minimum )
+          {
+          minimum = value;
+          }
+        if ( value > maximum )
+          {
+          maximum = value;
+          }
+        }
+      }
+    if ( NumericTraits< ScalarType >::is_integer
+         && maximum == NumericTraits< ScalarType >::max() )
+      {
+      maximum -= NumericTraits< ScalarType >::One;
+      }
+    m_StreamedThreshold =
+      static_cast< ScalarType >( ( m_Threshold * ( maximum - minimum ) ) + minimum );
+
+    m_StreamedSegmentTable = SegmentTableType::New();
+    m_StreamedSegmentTable->SetMaximumDepth(maximum - minimum);
+    m_StreamedEquivalencyTable = EquivalencyTable::New();
+    m_StreamedSegmentTree = 0;
+    }
+
+  // Segment the slabs in batches of one slab per thread.  Building the
+  // tables needs every slab, the output only the slabs it overlaps.
+  const unsigned int batchSize = std::max( this->GetNumberOfThreads(), 1u );
+
+  typename BoundaryType::Pointer   previousBoundary;
+  typename InputImageType::Pointer previousValues;
+  StreamedPlateauMapType           plateaus;
+
+  for ( unsigned int first = 0; first < numberOfSlabs; first += batchSize )
+    {
+    const unsigned int last = std::min(first + batchSize, numberOfSlabs);
+
+    std::vector< unsigned int >                    ids;
+    std::vector< typename InputImageType::Pointer > images;
+    std::vector< typename SegmenterType::Pointer > segmenters;
+    for ( unsigned int k = first; k < last; k++ )
+      {
+      RegionType overlap = slabs[k];
+      if ( !buildTables && !overlap.Crop(outputRegion) )
+        {
+        continue;
+        }
+
+      typename InputImageType::Pointer image = this->ReadStreamedRegion(paddedSlabs[k]);
+
+      typename SegmenterType::Pointer segmenter = SegmenterType::New();
+      segmenter->SetInputImage(image);
+      segmenter->SetThreshold(0.0);
+      segmenter->SetDoBoundaryAnalysis(true);
+      segmenter->SetSortEdgeLists(false);
+      segmenter->SetCurrentLabel(labelBase[k]);
+      segmenter->SetLargestPossibleRegion(largestRegion);
+      segmenter->GetOutputImage()->SetRequestedRegion(paddedSlabs[k]);
+
+      ids.push_back(k);
+      images.push_back(image);
+      segmenters.push_back(segmenter);
+      }
+
+    this->UpdateStreamedSegmenters(segmenters);
+
+    for ( unsigned int i = 0; i < segmenters.size(); i++ )
+      {
+      const unsigned int k = ids[i];
+
+      RegionType overlap = slabs[k];
+      if ( overlap.Crop(outputRegion) )
+        {
+        ImageRegionConstIterator< OutputImageType > in(segmenters[i]->GetOutputImage(), overlap);
+        ImageRegionIterator< OutputImageType >      out(output, overlap);
+        for ( in.GoToBegin(), out.GoToBegin(); !in.IsAtEnd(); ++in, ++out )
+          {
+          out.Set( in.Get() );
+          }
+        }
+
+      if ( !buildTables )
+        {
+        continue;
+        }
+
+      typename SegmentTableType::Pointer table = segmenters[i]->GetSegmentTable();
+      for ( typename SegmentTableType::Iterator it = table->Begin(); it != table->End(); ++it )
+        {
+        m_StreamedSegmentTable->Add( ( *it ).first, ( *it ).second );
+        }
+      table->Clear();
+
+      typename BoundaryType::Pointer boundary = segmenters[i]->GetBoundary();
+      if ( k > 0 )
+        {
+        this->ResolveStreamedSeam(previousBoundary, previousValues, boundary, images[i],
+                                  splitAxis, plateaus);
+        }
+
+      // keep what the face with the next slab needs
+      if ( k + 1 < numberOfSlabs )
+        {
+        typename BoundaryType::IndexType highFace(splitAxis, 1);
+        const RegionType faceRegion = boundary->GetFace(highFace)->GetBufferedRegion();
+
+        previousValues = InputImageType::New();
+        previousValues->SetRegions(faceRegion);
+        previousValues->Allocate();
+        ImageRegionConstIterator< InputImageType > in(images[i], faceRegion);
+        ImageRegionIterator< InputImageType >      out(previousValues, faceRegion);
+        for ( in.GoToBegin(), out.GoToBegin(); !in.IsAtEnd(); ++in, ++out )
+          {
+          out.Set( in.Get() );
+          }
+        previousBoundary = boundary;
+        }
+      }
+
+    this->UpdateProgress( 0.8f * static_cast< float >( last ) / numberOfSlabs );
+    }
+
+  if ( buildTables )
+    {
+    // A flat region split by slab faces descends, as a whole, to the lowest
+    // pixel around any of its parts; without one it is a basin of its own.
+    m_StreamedEquivalencyTable->Flatten();
+
+    StreamedPlateauMapType lowest;
+    for ( typename StreamedPlateauMapType::const_iterator it = plateaus.begin(); it != plateaus.end(); ++it )
+      {
+      const IdentifierType label = m_StreamedEquivalencyTable->Lookup( ( *it ).first );
+      std::pair< typename StreamedPlateauMapType::iterator, bool > entry =
+        lowest.insert( typename StreamedPlateauMapType::value_type(label, ( *it ).second) );
+      if ( !entry.second && ( *it ).second.LowestValue < ( *entry.first ).second.LowestValue )
+        {
+        ( *entry.first ).second.LowestValue = ( *it ).second.LowestValue;
+        ( *entry.first ).second.LowestLabel = ( *it ).second.LowestLabel;
+        }
+      }
+    for ( typename StreamedPlateauMapType::const_iterator it = lowest.begin(); it != lowest.end(); ++it )
+      {
+      if ( ( *it ).second.LowestLabel != SegmenterType::NULL_LABEL )
+        {
+        m_StreamedEquivalencyTable->Add( ( *it ).first, ( *it ).second.LowestLabel );
+        }
+      }
+    m_StreamedEquivalencyTable->Flatten();
+    }
+
+  // Compute the merge tree of the combined table.  The tree generator
+  // merges the equivalent segments into the table it is given, so it
+  // works on a copy.
+  if ( m_StreamedSegmentTree.IsNull() )
+    {
+    typename SegmentTableType::Pointer table = SegmentTableType::New();
+    table->Copy(*m_StreamedSegmentTable);
+
+    typedef watershed::SegmentTreeGenerator< ScalarType > TreeGeneratorType;
+    typename TreeGeneratorType::Pointer treeGenerator = TreeGeneratorType::New();
+    treeGenerator->SetInputSegmentTable(table);
+    treeGenerator->SetInputEquivalencyTable(m_StreamedEquivalencyTable);
+    treeGenerator->SetMerge(true);
+    treeGenerator->SetConsumeInput(true);
+    treeGenerator->SetFloodLevel(m_Level);
+    treeGenerator->Update();
+
+    m_StreamedSegmentTree = treeGenerator->GetOutputSegmentTree();
+    m_StreamedFloodLevel = m_Level;
+    }
+  this->UpdateProgress(0.9f);
+
+  // Relabel the output as watershed::Relabeler does, after joining the
+  // labels across the slab faces.
+  EquivalencyTable::Pointer merges = EquivalencyTable::New();
+  if ( !m_StreamedSegmentTree->Empty() )
+    {
+    const ScalarType mergeLimit =
+      static_cast< ScalarType >( m_Level * m_StreamedSegmentTree->Back().saliency );
+    for ( typename SegmentTreeType::Iterator it = m_StreamedSegmentTree->Begin();
+          it != m_StreamedSegmentTree->End() && ( *it ).saliency <= mergeLimit; ++it )
+      {
+      merges->Add( ( *it ).from, ( *it ).to );
+      }
+    merges->Flatten();
+    }
+
+  ImageRegionIterator< OutputImageType > it(output, outputRegion);
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( merges->Lookup( m_StreamedEquivalencyTable->Lookup( it.Get() ) ) );
+    }
+  this->UpdateProgress(1.0f);
+}
+
+template< class TInputImage >
+typename WatershedImageFilter< TInputImage >::InputImageType::Pointer
+WatershedImageFilter< TInputImage >
+::ReadStreamedRegion(const RegionType & region)
+{
+  InputImageType *input = const_cast< InputImageType * >( this->GetInput() );
+
+  input->SetRequestedRegion(region);
+  input->PropagateRequestedRegion();
+  input->UpdateOutputData();
+
+  typename InputImageType::Pointer image = InputImageType::New();
+  image->CopyInformation(input);
+  image->SetBufferedRegion(region);
+  image->SetRequestedRegion(region);
+  image->Allocate();
+
+  // Threshold against the whole input the way watershed::Segmenter
+  // thresholds its own input, so that the segmenters can run with a zero
+  // threshold.
+  const ScalarType threshold = m_StreamedThreshold;
+  ImageRegionConstIterator< InputImageType > in(input, region);
+  ImageRegionIterator< InputImageType >      out(image, region);
+  for ( in.GoToBegin(), out.GoToBegin(); !in.IsAtEnd(); ++in, ++out )
+    {
+    const ScalarType value = in.Get();
+    if ( value < threshold )
+      {
+      out.Set(threshold);
+      }
+    else if ( NumericTraits< ScalarType >::is_integer
+              && value == NumericTraits< ScalarType >::max() )
+      {
+      out.Set(value - NumericTraits< ScalarType >::One);
+      }
+    else
+      {
+      out.Set(value);
+      }
+    }
+
+  return image;
+}
+
+template< class TInputImage >
+void
+WatershedImageFilter< TInputImage >
+::UpdateStreamedSegmenters(std::vector< typename SegmenterType::Pointer > & segmenters)
+{
+  if ( segmenters.empty() )
+    {
+    return;
+    }
+
+  StreamingThreadStruct str;
+  str.Segmenters = segmenters;
+  str.Errors.resize( segmenters.size() );
+
+  this->GetMultiThreader()->SetNumberOfThreads( segmenters.size() );
+  this->GetMultiThreader()->SetSingleMethod(this->StreamingThreaderCallback, &str);
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  for ( unsigned int i = 0; i < str.Errors.size(); i++ )
+    {
+    if ( !str.Errors[i].empty() )
+      {
+      itkExceptionMacro(<< str.Errors[i]);
+      }
+    }
+}
+
+template< class TInputImage >
+ITK_THREAD_RETURN_TYPE
+WatershedImageFilter< TInputImage >
+::StreamingThreaderCallback(void *arg)
+{
+  ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+  ThreadIdType threadCount = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->NumberOfThreads;
+
+  StreamingThreadStruct *str = (StreamingThreadStruct *)
+    ( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+
+  // the multithreader may run fewer threads than asked for
+  for ( ThreadIdType i = threadId; i < str->Segmenters.size(); i += threadCount )
+    {
+    try
+      {
+      str->Segmenters[i]->Update();
+      }
+    catch ( ExceptionObject & err )
+      {
+      str->Errors[i] = err.GetDescription();
+      }
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TInputImage >
+void
+WatershedImageFilter< TInputImage >
+::ResolveStreamedSeam(BoundaryType *boundaryA, const InputImageType *valuesA,
+                      BoundaryType *boundaryB, const InputImageType *valuesB,
+                      unsigned int face, StreamedPlateauMapType & plateaus)
+{
+  typedef typename BoundaryType::face_t FaceType;
+  typename BoundaryType::IndexType highFace(face, 1);
+  typename BoundaryType::IndexType lowFace(face, 0);
+
+  typename FaceType::Pointer faceA = boundaryA->GetFace(highFace);
+  typename FaceType::Pointer faceB = boundaryB->GetFace(lowFace);
+
+  // The flat regions on both sides start from the lowest pixel their
+  // segmenter found around them.
+  typename BoundaryType::flat_hash_t *flats[2] = { boundaryA->GetFlatHash(highFace),
+                                                   boundaryB->GetFlatHash(lowFace) };
+  for ( unsigned int side = 0; side < 2; side++ )
+    {
+    for ( typename BoundaryType::flat_hash_t::const_iterator it = flats[side]->begin();
+          it != flats[side]->end(); ++it )
+      {
+      StreamedPlateauType plateau;
+      plateau.Value = ( *it ).second.value;
+      plateau.LowestValue = ( *it ).second.value;
+      plateau.LowestLabel = SegmenterType::NULL_LABEL;
+      if ( ( *it ).second.bounds_min < ( *it ).second.value )
+        {
+        plateau.LowestValue = ( *it ).second.bounds_min;
+        plateau.LowestLabel = ( *it ).second.min_label;
+        }
+      plateaus.insert( typename StreamedPlateauMapType::value_type( ( *it ).first, plateau ) );
+      }
+    }
+
+  // Segments that face each other across the seam are adjacent; the height
+  // of their edge is the lowest one along the seam.
+  typedef std::map< std::pair< IdentifierType, IdentifierType >, ScalarType > SeamType;
+  SeamType seam;
+
+  ImageRegionConstIterator< FaceType >       itA( faceA, faceA->GetBufferedRegion() );
+  ImageRegionConstIterator< FaceType >       itB( faceB, faceB->GetBufferedRegion() );
+  ImageRegionConstIterator< InputImageType > vA( valuesA, faceA->GetBufferedRegion() );
+  ImageRegionConstIterator< InputImageType > vB( valuesB, faceB->GetBufferedRegion() );
+  for ( itA.GoToBegin(), itB.GoToBegin(), vA.GoToBegin(), vB.GoToBegin();
+        !itA.IsAtEnd(); ++itA, ++itB, ++vA, ++vB )
+    {
+    const IdentifierType labelA = itA.Get().label;
+    const IdentifierType labelB = itB.Get().label;
+    if ( labelA == labelB
+         || labelA == SegmenterType::NULL_LABEL || labelB == SegmenterType::NULL_LABEL )
+      {
+      continue;
+      }
+
+    // Pick the pixel that flows across the face, if any, and the one it
+    // flows into.
+    IdentifierType from = SegmenterType::NULL_LABEL;
+    IdentifierType to = SegmenterType::NULL_LABEL;
+    ScalarType     toValue = vB.Get();
+    if ( vA.Get() == vB.Get() )
+      {
+      // two parts of the same flat region
+      m_StreamedEquivalencyTable->Add(labelA, labelB);
+      }
+    else if ( vB.Get() < vA.Get() && itA.Get().flow != SegmenterType::NULL_FLOW )
+      {
+      from = labelA;
+      to = labelB;
+      }
+    else if ( vA.Get() < vB.Get() && itB.Get().flow != SegmenterType::NULL_FLOW )
+      {
+      from = labelB;
+      to = labelA;
+      toValue = vA.Get();
+      }
+
+    if ( from != SegmenterType::NULL_LABEL )
+      {
+      typename StreamedPlateauMapType::iterator plateau = plateaus.find(from);
+      if ( plateau == plateaus.end() )
+        {
+        m_StreamedEquivalencyTable->Add(from, to);
+        }
+      else if ( toValue < ( *plateau ).second.LowestValue )
+        {
+        ( *plateau ).second.LowestValue = toValue;
+        ( *plateau ).second.LowestLabel = to;
+        }
+      }
+
+    const ScalarType height = std::max( vA.Get(), vB.Get() );
+    std::pair< typename SeamType::iterator, bool > entry =
+      seam.insert( typename SeamType::value_type(std::make_pair(labelA, labelB), height) );
+    if ( !entry.second && height < ( *entry.first ).second )
+      {
+      ( *entry.first ).second = height;
+      }
+    }
+
+  for ( typename SeamType::const_iterator it = seam.begin(); it != seam.end(); ++it )
+    {
+    typename SegmentTableType::segment_t *segmentA = m_StreamedSegmentTable->Lookup( ( *it ).first.first );
+    typename SegmentTableType::segment_t *segmentB = m_StreamedSegmentTable->Lookup( ( *it ).first.second );
+    if ( segmentA == 0 || segmentB == 0 )
+      {
+      continue;
+      }
+    segmentA->edge_list.push_back( typename SegmentTableType::edge_pair_t( ( *it ).first.second,
+                                                                           ( *it ).second ) );
+    segmentB->edge_list.push_back( typename SegmentTableType::edge_pair_t( ( *it ).first.first,
+                                                                           ( *it ).second ) );
+    }
 }
 } // end namespace itk
 
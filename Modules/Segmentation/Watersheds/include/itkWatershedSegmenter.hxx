@@ -192,6 +192,13 @@ void Segmenter< TInputImage >::GenerateData()
     {
     maximum -= NumericTraits< InputPixelType >::One;
     }
+  // The boundary analysis looks at the padding on the data set boundary
+  // before the retaining wall is built there, so give it the wall value.
+  if ( m_DoBoundaryAnalysis == true )
+    {
+    thresholdImage->FillBuffer(maximum + NumericTraits< InputPixelType >::One);
+    }
+
   // threshold the image.
   Self::Threshold( thresholdImage, input, regionToProcess, regionToProcess,
                    static_cast< InputPixelType >( ( m_Threshold * ( maximum - minimum ) ) + minimum ) );
@@ -436,7 +443,7 @@ void Segmenter< TInputImage >
   // NOTE: For ease of initial implementation, this method does
   // not support arbitrary connectivity across boundaries (yet). 10-8-01 jc
   //
-  unsigned int nCenter, i, nPos, cPos;
+  unsigned int nCenter, i, nPos, cPos, cIdx;
   bool         isSteepest;
 
   ConstNeighborhoodIterator< InputImageType >              searchIt;
@@ -481,17 +488,20 @@ void Segmenter< TInputImage >
       searchIt.GoToBegin();
       labelIt.GoToBegin();
 
+      // The connectivity lists the negative directions from the last
+      // dimension down, then the positive directions from the first up
+      // (see GenerateConnectivity).
       if ( ( idx ).second == 0 )
         {
         // Low face
-        cPos = m_Connectivity.index[( idx ).first];
+        cIdx = ( ImageDimension - 1 ) - ( idx ).first;
         }
       else
         {
         // High face
-        cPos = m_Connectivity.index[( ImageDimension - 1 )
-                                    + ( ImageDimension - ( idx ).first )];
+        cIdx = ImageDimension + ( idx ).first;
         }
+      cPos = m_Connectivity.index[cIdx];
 
       while ( !searchIt.IsAtEnd() )
         {
@@ -547,11 +557,14 @@ void Segmenter< TInputImage >
           {
           if ( searchIt.GetPixel(cPos) < searchIt.GetPixel(nCenter) )
             {
+            // Break ties the way GradientDescent does: the first of the
+            // lowest neighbors in connectivity order is the steepest.
             isSteepest = true;
             for ( i = 0; i < m_Connectivity.size; i++ )
               {
               nPos = m_Connectivity.index[i];
-              if ( searchIt.GetPixel(nPos) < searchIt.GetPixel(cPos) )
+              if ( searchIt.GetPixel(nPos) < searchIt.GetPixel(cPos)
+                   || ( i < cIdx && searchIt.GetPixel(nPos) == searchIt.GetPixel(cPos) ) )
                 {
                 isSteepest = false;
                 break;
@@ -587,7 +600,9 @@ void Segmenter< TInputImage >
                   + output->ComputeOffset( labelIt.GetIndex() );
                 tempFlatRegion.value =
                   searchIt.GetPixel(nCenter);
-                tempFlatRegion.is_on_boundary = false;
+                // Where this flat region descends is decided across the
+                // chunks, so keep it from descending within this one.
+                tempFlatRegion.is_on_boundary = true;
                 flatRegions[m_CurrentLabel] = tempFlatRegion;
                 break;
                 }
@@ -797,9 +812,12 @@ void Segmenter< TInputImage >
         nPos = m_Connectivity.index[i];
 
         if  ( labelIt.GetPixel(nPos) != labelIt.GetPixel(nCenter)
-              && searchIt.GetPixel(nPos) < ( *flatPtr ).second.bounds_min )
+              && searchIt.GetPixel(nPos) < ( *flatPtr ).second.bounds_min
+              && region.IsInside( searchIt.GetIndex(nPos) ) )
           { // If this is a boundary pixel && has a lesser value than
-            // the currently recorded value...
+            // the currently recorded value...  Pixels outside the region
+            // are either the retaining wall or the overlap with another
+            // chunk, which is accounted for when the chunks are joined.
           ( *flatPtr ).second.bounds_min = searchIt.GetPixel(nPos);
           ( *flatPtr ).second.min_label_ptr = labelIt[nPos];
           }
@@ -1156,6 +1174,10 @@ void Segmenter< TInputImage >
       ( *b ).second.bounds_min = ( *a ).second.bounds_min;
       ( *b ).second.min_label_ptr = ( *a ).second.min_label_ptr;
       }
+    if ( ( *a ).second.is_on_boundary )
+      {
+      ( *b ).second.is_on_boundary = true;
+      }
 
     regions.erase(a);
     }
@@ -0,0 +1,120 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkWatershedImageFilter.h"
+#include "itkStreamingImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include <map>
+
+namespace
+{
+typedef itk::Image< float, 3 >                ImageType;
+typedef itk::Image< itk::IdentifierType, 3 >  LabelImageType;
+typedef itk::WatershedImageFilter< ImageType > WatershedType;
+
+// Returns true if the two label images describe the same partition, i.e. if
+// the labels of one map one to one onto the labels of the other.
+bool SamePartition(const LabelImageType *a, const LabelImageType *b)
+{
+  std::map< itk::IdentifierType, itk::IdentifierType > ab, ba;
+
+  itk::ImageRegionConstIterator< LabelImageType > itA( a, a->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< LabelImageType > itB( b, b->GetBufferedRegion() );
+  unsigned int mismatches = 0;
+  for ( ; !itA.IsAtEnd(); ++itA, ++itB )
+    {
+    std::pair< std::map< itk::IdentifierType, itk::IdentifierType >::iterator, bool > r1 =
+      ab.insert( std::make_pair( itA.Get(), itB.Get() ) );
+    std::pair< std::map< itk::IdentifierType, itk::IdentifierType >::iterator, bool > r2 =
+      ba.insert( std::make_pair( itB.Get(), itA.Get() ) );
+    if ( r1.first->second != itB.Get() || r2.first->second != itA.Get() )
+      {
+      ++mismatches;
+      }
+    }
+  std::cout << "  " << ab.size() << " / " << ba.size() << " labels, "
+            << mismatches << " mismatching pixels" << std::endl;
+  return mismatches == 0;
+}
+}
+
+int itkWatershedImageFilterStreamingTest(int, char* [] )
+{
+  // A smooth height function with many basins.
+  ImageType::SizeType size;
+  size[0] = 48;
+  size[1] = 40;
+  size[2] = 36;
+  ImageType::RegionType region;
+  region.SetSize(size);
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+
+  itk::ImageRegionIterator< ImageType > it( image, region );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType idx = it.GetIndex();
+    it.Set( static_cast< float >( vcl_sin( 0.37 * idx[0] ) * vcl_cos( 0.29 * idx[1] )
+                                  + vcl_sin( 0.23 * idx[2] + 0.11 * idx[0] )
+                                  + 0.01 * ( ( idx[0] * 7 + idx[1] * 13 + idx[2] * 17 ) % 11 ) ) );
+    }
+
+  bool passed = true;
+  const double levels[] = { 0.0, 0.1, 0.3 };
+  for ( unsigned int l = 0; l < 3; l++ )
+    {
+    WatershedType::Pointer reference = WatershedType::New();
+    reference->SetInput(image);
+    reference->SetThreshold(0.01);
+    reference->SetLevel(levels[l]);
+    reference->Update();
+
+    const unsigned int divisions[] = { 2, 5 };
+    for ( unsigned int d = 0; d < 2; d++ )
+      {
+      WatershedType::Pointer streamed = WatershedType::New();
+      streamed->SetInput(image);
+      streamed->SetThreshold(0.01);
+      streamed->SetLevel(levels[l]);
+      streamed->SetNumberOfStreamDivisions(divisions[d]);
+      streamed->SetNumberOfThreads(3);
+
+      // produce the output in pieces
+      typedef itk::StreamingImageFilter< LabelImageType, LabelImageType > StreamerType;
+      StreamerType::Pointer streamer = StreamerType::New();
+      streamer->SetInput( streamed->GetOutput() );
+      streamer->SetNumberOfStreamDivisions(4);
+      streamer->Update();
+
+      std::cout << "Level " << levels[l] << ", " << divisions[d] << " divisions" << std::endl;
+      if ( !SamePartition( reference->GetOutput(), streamer->GetOutput() ) )
+        {
+        passed = false;
+        }
+      }
+    }
+
+  if ( !passed )
+    {
+    std::cerr << "The streamed segmentation differs from the reference" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
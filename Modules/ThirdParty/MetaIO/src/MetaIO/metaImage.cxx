@@ -109,6 +109,8 @@ MetaImage()
   m_CompressionTable = new MET_CompressionTableType;
   m_CompressionTable->compressedStream = NULL;
   m_CompressionTable->buffer = NULL;
+  m_ParallelForFunction = NULL;
+  m_ParallelForClientData = NULL;
   Clear();
   }
 
@@ -125,6 +127,8 @@ MetaImage(const char *_headerName)
   m_CompressionTable = new MET_CompressionTableType;
   m_CompressionTable->compressedStream = NULL;
   m_CompressionTable->buffer = NULL;
+  m_ParallelForFunction = NULL;
+  m_ParallelForClientData = NULL;
   Clear();
 
   Read(_headerName);
@@ -143,6 +147,8 @@ MetaImage(MetaImage *_im)
   m_CompressionTable = new MET_CompressionTableType;
   m_CompressionTable->compressedStream = NULL;
   m_CompressionTable->buffer = NULL;
+  m_ParallelForFunction = NULL;
+  m_ParallelForClientData = NULL;
   Clear();
 
   InitializeEssential(_im->NDims(),
@@ -173,6 +179,8 @@ MetaImage(int _nDims,
   m_CompressionTable = new MET_CompressionTableType;
   m_CompressionTable->buffer = NULL;
   m_CompressionTable->compressedStream = NULL;
+  m_ParallelForFunction = NULL;
+  m_ParallelForClientData = NULL;
   Clear();
 
   if(_elementData == NULL)
@@ -212,6 +220,8 @@ MetaImage(int _x, int _y,
   m_CompressionTable = new MET_CompressionTableType;
   m_CompressionTable->compressedStream = NULL;
   m_CompressionTable->buffer = NULL;
+  m_ParallelForFunction = NULL;
+  m_ParallelForClientData = NULL;
   Clear();
 
   int ds[2];
@@ -263,6 +273,8 @@ MetaImage(int _x, int _y, int _z,
   m_CompressionTable = new MET_CompressionTableType;
   m_CompressionTable->compressedStream = NULL;
   m_CompressionTable->buffer = NULL;
+  m_ParallelForFunction = NULL;
+  m_ParallelForClientData = NULL;
   Clear();
 
   int ds[3];
@@ -387,6 +399,9 @@ PrintInfo() const
   METAIO_STREAM::cout << "ElementDataFileName = "
                       << m_ElementDataFileName << METAIO_STREAM::endl;
 
+  METAIO_STREAM::cout << "CompressedDataChunkSize = "
+                      << m_CompressedDataChunkSize << METAIO_STREAM::endl;
+
   }
 
 void MetaImage::
@@ -471,6 +486,8 @@ void MetaImage::Clear(void)
 
   strcpy(m_ElementDataFileName, "");
 
+  m_CompressedDataChunkSize = 0;
+
   MetaObject::Clear();
 
   // Change the default for this object
@@ -937,6 +954,29 @@ ElementDataFileName(const char * _elementDataFileName)
   strcpy(m_ElementDataFileName, _elementDataFileName);
   }
 
+//
+//
+//
+int MetaImage::
+CompressedDataChunkSize(void) const
+  {
+  return m_CompressedDataChunkSize;
+  }
+
+void MetaImage::
+CompressedDataChunkSize(int _compressedDataChunkSize)
+  {
+  m_CompressedDataChunkSize = _compressedDataChunkSize;
+  }
+
+void MetaImage::
+ParallelForFunction(MET_ParallelForFunctionType _parallelFor,
+                    void * _clientData)
+  {
+  m_ParallelForFunction = _parallelFor;
+  m_ParallelForClientData = _clientData;
+  }
+
 //
 //
 //
@@ -1621,6 +1661,8 @@ WriteStream(METAIO_STREAM::ofstream * _stream,
   m_WriteStream = _stream;
 
   unsigned char * compressedElementData = NULL;
+  // the chunk table, if any, is written after the compressed stream
+  METAIO_STL::streamoff compressedElementDataSize = 0;
   if(m_BinaryData && m_CompressedData && !strstr(m_ElementDataFileName, "%"))
     // compressed & !slice/file
     {
@@ -1628,19 +1670,36 @@ WriteStream(METAIO_STREAM::ofstream * _stream,
     MET_SizeOfType(m_ElementType, &elementSize);
     int elementNumberOfBytes = elementSize*m_ElementNumberOfChannels;
 
-    if(_constElementData == NULL)
+    const unsigned char * elementData =
+      (const unsigned char *)(_constElementData == NULL ? m_ElementData
+                                                         : _constElementData);
+    if(m_CompressedDataChunkSize > 0)
       {
-      compressedElementData = MET_PerformCompression(
-                                  (const unsigned char *)m_ElementData,
+      METAIO_STL::streamoff chunkTableSize = 0;
+      compressedElementData = MET_PerformChunkedCompression(
+                                  elementData,
                                   m_Quantity * elementNumberOfBytes,
-                                  & m_CompressedDataSize );
+                                  m_CompressedDataChunkSize,
+                                  & m_CompressedDataSize,
+                                  & chunkTableSize,
+                                  m_ParallelForFunction,
+                                  m_ParallelForClientData );
+      if(compressedElementData == NULL)
+        {
+        METAIO_STREAM::cerr << "MetaImage: WriteStream: compression failed"
+                            << METAIO_STREAM::endl;
+        m_WriteStream = NULL;
+        return false;
+        }
+      compressedElementDataSize = m_CompressedDataSize + chunkTableSize;
       }
     else
       {
       compressedElementData = MET_PerformCompression(
-                                  (const unsigned char *)_constElementData,
+                                  elementData,
                                   m_Quantity * elementNumberOfBytes,
                                   & m_CompressedDataSize );
+      compressedElementDataSize = m_CompressedDataSize;
       }
     }
 
@@ -1655,7 +1714,7 @@ WriteStream(METAIO_STREAM::ofstream * _stream,
       {
       M_WriteElements(m_WriteStream,
                       compressedElementData,
-                      m_CompressedDataSize);
+                      compressedElementDataSize);
 
       delete [] compressedElementData;
       m_CompressedDataSize = 0;
@@ -2163,6 +2222,10 @@ M_SetupReadFields(void)
   MET_InitReadField(mF, "ElementToIntensityFunctionOffset", MET_FLOAT, false);
   m_Fields.push_back(mF);
 
+  mF = new MET_FieldRecordType;
+  MET_InitReadField(mF, "CompressedDataChunkSize", MET_INT, false);
+  m_Fields.push_back(mF);
+
   mF = new MET_FieldRecordType;
   MET_InitReadField(mF, "ElementType", MET_STRING, true);
   mF->required = true;
@@ -2271,6 +2334,16 @@ M_SetupWriteFields(void)
     m_Fields.push_back(mF);
     }
 
+  // Only written for a single compressed stream, see WriteStream()
+  if(m_BinaryData && m_CompressedData && m_CompressedDataChunkSize > 0
+     && !strstr(m_ElementDataFileName, "%"))
+    {
+    mF = new MET_FieldRecordType;
+    MET_InitWriteField(mF, "CompressedDataChunkSize", MET_INT,
+                       m_CompressedDataChunkSize);
+    m_Fields.push_back(mF);
+    }
+
   mF = new MET_FieldRecordType;
   MET_TypeToString(m_ElementType, s);
   MET_InitWriteField(mF, "ElementType", MET_STRING, strlen(s), s);
@@ -2416,6 +2489,12 @@ M_Read(void)
     m_ElementToIntensityFunctionOffset = mF->value[0];
     }
 
+  mF = MET_GetFieldRecord("CompressedDataChunkSize", &m_Fields);
+  if(mF && mF->defined)
+    {
+    m_CompressedDataChunkSize = (int)mF->value[0];
+    }
+
   mF = MET_GetFieldRecord("ElementType", &m_Fields);
   if(mF && mF->defined)
     {
@@ -2476,6 +2555,12 @@ M_ReadElements(METAIO_STREAM::ifstream * _fstream, void * _data,
   // If compressed we inflate
   if(m_BinaryData && m_CompressedData)
     {
+    if(M_ReadChunkedCompressedData(_fstream, _fstream->tellg(), readSize,
+                                   0, (unsigned char *)_data, readSize))
+      {
+      return true;
+      }
+
     // if m_CompressedDataSize is not defined we assume the size of the
     // file is the size of the compressed data
     bool compressedDataDeterminedFromFile = false;
@@ -3077,6 +3162,22 @@ M_ReadElementsROI(METAIO_STREAM::ifstream * _fstream, void * _data,
   // If compressed we inflate
   if(m_BinaryData && m_CompressedData)
     {
+    // Chunked data: every line of the region is copied from the chunks
+    // it overlaps.  Only the two chunks inflated last are kept, which
+    // consecutive lines mostly share.
+    METAIO_STL::vector<METAIO_STL::streamoff> chunkOffsets;
+    const METAIO_STL::streamoff totalSize =
+      _totalDataQuantity*elementNumberOfBytes;
+    const bool chunked =
+      M_ReadChunkTable(_fstream, dataPos, totalSize, chunkOffsets);
+    if(!chunked)
+      {
+      _fstream->clear();
+      _fstream->seekg(dataPos, METAIO_STREAM::ios::beg);
+      }
+    unsigned char * chunks[2] = { NULL, NULL };
+    int chunkIds[2] = { -1, -1 };
+
     // if m_CompressedDataSize is not defined we assume the size of the
     // file is the size of the compressed data
     if(m_CompressedDataSize==0)
@@ -3127,13 +3228,28 @@ M_ReadElementsROI(METAIO_STREAM::ifstream * _fstream, void * _data,
         if(subSamplingFactor > 1)
           {
           unsigned char* subdata = new unsigned char[bytesToRead];
-          METAIO_STL::streamoff rOff =
-            MET_UncompressStream(_fstream, seekoff, subdata,
-                                 bytesToRead, m_CompressedDataSize,
-                                 m_CompressionTable);
+          METAIO_STL::streamoff rOff = bytesToRead;
+          if(chunked)
+            {
+            if(!M_ReadChunkedCompressedRange(_fstream, dataPos, chunkOffsets,
+                                             totalSize, seekoff, subdata,
+                                             bytesToRead, chunks, chunkIds))
+              {
+              rOff = -1;
+              }
+            }
+          else
+            {
+            rOff = MET_UncompressStream(_fstream, seekoff, subdata,
+                                        bytesToRead, m_CompressedDataSize,
+                                        m_CompressionTable);
+            }
           // if there was a read error
           if(rOff == -1)
             {
+            delete [] subdata;
+            delete [] chunks[0];
+            delete [] chunks[1];
             delete [] currentIndex;
             return false;
             }
@@ -3153,12 +3269,26 @@ M_ReadElementsROI(METAIO_STREAM::ifstream * _fstream, void * _data,
           }
         else
           {
-          METAIO_STL::streamoff rOff =
-            MET_UncompressStream(_fstream, seekoff, data,
-                                 bytesToRead, m_CompressedDataSize,
-                                 m_CompressionTable);
+          METAIO_STL::streamoff rOff = bytesToRead;
+          if(chunked)
+            {
+            if(!M_ReadChunkedCompressedRange(_fstream, dataPos, chunkOffsets,
+                                             totalSize, seekoff, data,
+                                             bytesToRead, chunks, chunkIds))
+              {
+              rOff = -1;
+              }
+            }
+          else
+            {
+            rOff = MET_UncompressStream(_fstream, seekoff, data,
+                                        bytesToRead, m_CompressedDataSize,
+                                        m_CompressionTable);
+            }
           if(rOff == -1)
             {
+            delete [] chunks[0];
+            delete [] chunks[1];
             delete [] currentIndex;
             return false;
             }
@@ -3205,10 +3335,14 @@ M_ReadElementsROI(METAIO_STREAM::ifstream * _fstream, void * _data,
                   << METAIO_STREAM::endl;
         METAIO_STREAM::cerr << "   ideal = " << readSize << " : actual = " << gc
                   << METAIO_STREAM::endl;
+        delete [] chunks[0];
+        delete [] chunks[1];
         delete [] currentIndex;
         return false;
         }
 
+      delete [] chunks[0];
+      delete [] chunks[1];
       delete [] currentIndex;
     }
   else // if not compressed
@@ -3446,6 +3580,229 @@ M_ReadElementData(METAIO_STREAM::ifstream * _fstream,
   return true;
   }
 
+bool MetaImage::
+M_ReadChunkedCompressedData(METAIO_STREAM::ifstream * _fstream,
+                            METAIO_STL::streampos _dataPos,
+                            METAIO_STL::streamoff _totalSize,
+                            METAIO_STL::streamoff _seekPosition,
+                            unsigned char * _data,
+                            METAIO_STL::streamoff _size)
+  {
+  METAIO_STL::vector<METAIO_STL::streamoff> chunkOffsets;
+  bool valid = M_ReadChunkTable(_fstream, _dataPos, _totalSize, chunkOffsets);
+
+  if(valid && _size > 0)
+    {
+    const int numberOfChunks = static_cast<int>(chunkOffsets.size()) - 1;
+    const int firstChunk =
+      static_cast<int>(_seekPosition / m_CompressedDataChunkSize);
+    const int lastChunk = static_cast<int>(
+      (_seekPosition + _size - 1) / m_CompressedDataChunkSize);
+    if(lastChunk >= numberOfChunks)
+      {
+      valid = false;
+      }
+    else
+      {
+      const METAIO_STL::streamoff comprSize =
+        chunkOffsets[lastChunk+1] - chunkOffsets[firstChunk];
+      unsigned char * compr = new unsigned char[comprSize];
+
+      _fstream->clear();
+      _fstream->seekg(_dataPos + chunkOffsets[firstChunk],
+                      METAIO_STREAM::ios::beg);
+      valid = M_ReadElementData(_fstream, compr, comprSize)
+              && MET_PerformChunkedUncompression(compr, chunkOffsets,
+                                      m_CompressedDataChunkSize,
+                                      _totalSize, _seekPosition,
+                                      _data, _size,
+                                      m_ParallelForFunction,
+                                      m_ParallelForClientData);
+      delete [] compr;
+      }
+    }
+
+  if(!valid)
+    {
+    _fstream->clear();
+    _fstream->seekg(_dataPos, METAIO_STREAM::ios::beg);
+    }
+
+  return valid;
+  }
+
+bool MetaImage::
+M_ReadChunkTable(METAIO_STREAM::ifstream * _fstream,
+                 METAIO_STL::streampos _dataPos,
+                 METAIO_STL::streamoff _totalSize,
+                 METAIO_STL::vector<METAIO_STL::streamoff> & _chunkOffsets)
+  {
+  if(m_CompressedDataChunkSize <= 0
+     || strstr(m_ElementDataFileName, "%")
+     || !strncmp("LIST", m_ElementDataFileName, 4))
+    {
+    return false;
+    }
+
+  const int numberOfChunks =
+    MET_GetNumberOfCompressedChunks(_totalSize, m_CompressedDataChunkSize);
+  const METAIO_STL::streamoff tableSize = 8 * (numberOfChunks + 1);
+  const METAIO_STL::streamoff dataPos = _dataPos;
+
+  _fstream->clear();
+
+  // The chunk table follows the compressed stream.  Without the size of
+  // the stream in the header, the table ends the file.
+  METAIO_STL::streamoff tablePos;
+  if(m_CompressedDataSize > 0)
+    {
+    tablePos = dataPos + m_CompressedDataSize;
+    }
+  else
+    {
+    _fstream->seekg(0, METAIO_STREAM::ios::end);
+    tablePos = static_cast<METAIO_STL::streamoff>(_fstream->tellg())
+               - tableSize;
+    }
+
+  bool valid = false;
+  if(tablePos > dataPos)
+    {
+    unsigned char * table = new unsigned char[tableSize];
+    _fstream->seekg(tablePos, METAIO_STREAM::ios::beg);
+    _fstream->read((char *)table, tableSize);
+    valid = _fstream->gcount() == tableSize
+            && MET_DecodeChunkTable(table, numberOfChunks,
+                                    tablePos - dataPos, _chunkOffsets);
+    delete [] table;
+    }
+
+  return valid;
+  }
+
+bool MetaImage::
+M_ReadChunkedCompressedRange(METAIO_STREAM::ifstream * _fstream,
+                 METAIO_STL::streampos _dataPos,
+                 const METAIO_STL::vector<METAIO_STL::streamoff> & _chunkOffsets,
+                 METAIO_STL::streamoff _totalSize,
+                 METAIO_STL::streamoff _seekPosition,
+                 unsigned char * _data,
+                 METAIO_STL::streamoff _size,
+                 unsigned char * _chunks[2],
+                 int _chunkIds[2])
+  {
+  const METAIO_STL::streamoff chunkSize = m_CompressedDataChunkSize;
+  const int numberOfChunks = static_cast<int>(_chunkOffsets.size()) - 1;
+  const METAIO_STL::streamoff end = _seekPosition + _size;
+
+  METAIO_STL::streamoff pos = _seekPosition;
+  while(pos < end)
+    {
+    const int chunk = static_cast<int>(pos / chunkSize);
+    if(chunk >= numberOfChunks)
+      {
+      return false;
+      }
+    const METAIO_STL::streamoff chunkStart = chunk * chunkSize;
+    METAIO_STL::streamoff chunkLength = _totalSize - chunkStart;
+    if(chunkLength > chunkSize)
+      {
+      chunkLength = chunkSize;
+      }
+
+    // Chunks lying wholly in the range are inflated straight into it,
+    // concurrently
+    if(pos == chunkStart && chunkStart + chunkLength <= end
+       && _chunkIds[0] != chunk && _chunkIds[1] != chunk)
+      {
+      int lastChunk = chunk;
+      METAIO_STL::streamoff wholeEnd = chunkStart + chunkLength;
+      while(lastChunk + 1 < numberOfChunks)
+        {
+        METAIO_STL::streamoff nextEnd = wholeEnd + chunkSize;
+        if(nextEnd > _totalSize)
+          {
+          nextEnd = _totalSize;
+          }
+        if(nextEnd > end)
+          {
+          break;
+          }
+        ++lastChunk;
+        wholeEnd = nextEnd;
+        }
+
+      const METAIO_STL::streamoff comprSize =
+        _chunkOffsets[lastChunk+1] - _chunkOffsets[chunk];
+      unsigned char * compr = new unsigned char[comprSize];
+      _fstream->clear();
+      _fstream->seekg(_dataPos + _chunkOffsets[chunk],
+                      METAIO_STREAM::ios::beg);
+      const bool ok = M_ReadElementData(_fstream, compr, comprSize)
+                      && MET_PerformChunkedUncompression(compr,
+                                    _chunkOffsets, chunkSize, _totalSize,
+                                    chunkStart, _data, wholeEnd - chunkStart,
+                                    m_ParallelForFunction,
+                                    m_ParallelForClientData);
+      delete [] compr;
+      if(!ok)
+        {
+        return false;
+        }
+      _data += wholeEnd - chunkStart;
+      pos = wholeEnd;
+      continue;
+      }
+
+    if(_chunkIds[0] != chunk)
+      {
+      // Inflate the chunk in place of the least recently used one
+      if(_chunkIds[1] != chunk)
+        {
+        if(_chunks[1] == NULL)
+          {
+          _chunks[1] = new unsigned char[chunkSize];
+          }
+        _chunkIds[1] = -1;
+
+        const METAIO_STL::streamoff comprSize =
+          _chunkOffsets[chunk+1] - _chunkOffsets[chunk];
+        unsigned char * compr = new unsigned char[comprSize];
+        _fstream->clear();
+        _fstream->seekg(_dataPos + _chunkOffsets[chunk],
+                        METAIO_STREAM::ios::beg);
+        const bool ok = M_ReadElementData(_fstream, compr, comprSize)
+                        && MET_PerformChunkedUncompression(compr,
+                                      _chunkOffsets, chunkSize, _totalSize,
+                                      chunkStart, _chunks[1], chunkLength);
+        delete [] compr;
+        if(!ok)
+          {
+          return false;
+          }
+        _chunkIds[1] = chunk;
+        }
+
+      unsigned char * chunkData = _chunks[0];
+      _chunks[0] = _chunks[1];
+      _chunks[1] = chunkData;
+      const int chunkId = _chunkIds[0];
+      _chunkIds[0] = _chunkIds[1];
+      _chunkIds[1] = chunkId;
+      }
+
+    METAIO_STL::streamoff copySize = chunkStart + chunkLength - pos;
+    if(copySize > end - pos)
+      {
+      copySize = end - pos;
+      }
+    memcpy(_data, _chunks[0] + (pos - chunkStart), (size_t)copySize);
+    _data += copySize;
+    pos += copySize;
+    }
+
+  return true;
+  }
 
 #if (METAIO_USE_NAMESPACE)
 }
@@ -213,6 +213,23 @@ class METAIO_EXPORT MetaImage : public MetaObject
     const char * ElementDataFileName(void) const;
     void         ElementDataFileName(const char * _dataFileName);
 
+    //    CompressedDataChunkSize(...)
+    //       Optional Field
+    //       When > 0, compressed data is deflated in independent chunks
+    //       of this many uncompressed bytes, followed by a table of the
+    //       chunk offsets.  The chunks form a single zlib stream, so
+    //       readers ignoring this field still inflate the data; readers
+    //       using it (de)compress the chunks in parallel and inflate only
+    //       the chunks overlapping a ReadROI() request.
+    int   CompressedDataChunkSize(void) const;
+    void  CompressedDataChunkSize(int _compressedDataChunkSize);
+
+    //    ParallelForFunction(...)
+    //       Hook used to (de)compress the chunks concurrently, see
+    //       MET_ParallelForFunctionType.  Not reset by Clear().
+    void  ParallelForFunction(MET_ParallelForFunctionType _parallelFor,
+                              void * _clientData=NULL);
+
     //
     //
     //
@@ -326,6 +343,11 @@ class METAIO_EXPORT MetaImage : public MetaObject
 
     char               m_ElementDataFileName[255];
 
+    int                m_CompressedDataChunkSize;
+
+    MET_ParallelForFunctionType m_ParallelForFunction;
+    void *             m_ParallelForClientData;
+
 
     void  M_Destroy(void);
 
@@ -356,6 +378,43 @@ class METAIO_EXPORT MetaImage : public MetaObject
                            void * _data,
                            METAIO_STL::streamoff _dataQuantity);
 
+    // Inflate _size bytes starting at uncompressed byte _seekPosition
+    // from the chunked compressed data starting at _dataPos.  Returns
+    // false, leaving the stream at _dataPos, when the data is not chunked
+    // or its chunk table is invalid.  _totalSize is the uncompressed size
+    // of the whole image.
+    bool M_ReadChunkedCompressedData(METAIO_STREAM::ifstream * _fstream,
+                           METAIO_STL::streampos _dataPos,
+                           METAIO_STL::streamoff _totalSize,
+                           METAIO_STL::streamoff _seekPosition,
+                           unsigned char * _data,
+                           METAIO_STL::streamoff _size);
+
+    // Read and validate the chunk table of the chunked compressed data
+    // starting at _dataPos.  Returns false when the data is not chunked
+    // or its table is invalid.  The stream position is not restored.
+    bool M_ReadChunkTable(METAIO_STREAM::ifstream * _fstream,
+                           METAIO_STL::streampos _dataPos,
+                           METAIO_STL::streamoff _totalSize,
+                           METAIO_STL::vector<METAIO_STL::streamoff> & _chunkOffsets);
+
+    // Copy _size uncompressed bytes starting at _seekPosition from the
+    // chunks they overlap.  Chunks wholly in the range are inflated into
+    // _data, the others one at a time into _chunks.  _chunks and
+    // _chunkIds hold the two chunks inflated last, most recent first,
+    // with ids of -1 for empty slots; they are kept between calls so
+    // that consecutive lines of a region reuse them, and the caller
+    // deletes the chunks.
+    bool M_ReadChunkedCompressedRange(METAIO_STREAM::ifstream * _fstream,
+                           METAIO_STL::streampos _dataPos,
+                           const METAIO_STL::vector<METAIO_STL::streamoff> & _chunkOffsets,
+                           METAIO_STL::streamoff _totalSize,
+                           METAIO_STL::streamoff _seekPosition,
+                           unsigned char * _data,
+                           METAIO_STL::streamoff _size,
+                           unsigned char * _chunks[2],
+                           int _chunkIds[2]);
+
     bool  M_WriteElements(METAIO_STREAM::ofstream * _fstream,
                           const void * _data,
                           METAIO_STL::streamoff _dataQuantity);
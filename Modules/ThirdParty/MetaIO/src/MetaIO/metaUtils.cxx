@@ -797,6 +797,388 @@ bool MET_PerformUncompression(const unsigned char * sourceCompressed,
   return true;
   }
 
+//
+//
+//
+int MET_GetNumberOfCompressedChunks(METAIO_STL::streamoff uncompressedDataSize,
+                                    METAIO_STL::streamoff chunkSize)
+  {
+  if(chunkSize <= 0 || uncompressedDataSize <= chunkSize)
+    {
+    return 1;
+    }
+  return static_cast<int>((uncompressedDataSize + chunkSize - 1) / chunkSize);
+  }
+
+static void MET_RunTasks(MET_TaskFunctionType _task,
+                         void * _taskData,
+                         int _numberOfTasks,
+                         MET_ParallelForFunctionType _parallelFor,
+                         void * _clientData)
+  {
+  if(_parallelFor != NULL && _numberOfTasks > 1)
+    {
+    _parallelFor(_task, _taskData, _numberOfTasks, _clientData);
+    }
+  else
+    {
+    for(int i=0; i<_numberOfTasks; i++)
+      {
+      _task(_taskData, i);
+      }
+    }
+  }
+
+static void MET_WriteChunkOffset(unsigned char * _buffer,
+                                 METAIO_STL::streamoff _offset)
+  {
+  for(int i=0; i<8; i++)
+    {
+    _buffer[i] = static_cast<unsigned char>((_offset >> (8*i)) & 0xff);
+    }
+  }
+
+static METAIO_STL::streamoff MET_ReadChunkOffset(const unsigned char * _buffer)
+  {
+  METAIO_STL::streamoff offset = 0;
+  for(int i=7; i>=0; i--)
+    {
+    offset = (offset << 8) | _buffer[i];
+    }
+  return offset;
+  }
+
+typedef struct MET_ChunkedCompressionData
+  {
+  const unsigned char *                       source;
+  METAIO_STL::streamoff                       sourceSize;
+  METAIO_STL::streamoff                       chunkSize;
+  int                                         numberOfChunks;
+  METAIO_STL::vector<unsigned char *>         chunks;
+  METAIO_STL::vector<METAIO_STL::streamoff>   chunkSizes;
+  METAIO_STL::vector<uLong>                   checksums;
+  } MET_ChunkedCompressionDataType;
+
+static void MET_CompressChunk(void * _taskData, int _chunk)
+  {
+  MET_ChunkedCompressionDataType * data =
+    static_cast<MET_ChunkedCompressionDataType *>(_taskData);
+
+  METAIO_STL::streamoff start = _chunk * data->chunkSize;
+  METAIO_STL::streamoff length = data->sourceSize - start;
+  if(length > data->chunkSize)
+    {
+    length = data->chunkSize;
+    }
+  const bool lastChunk = (_chunk == data->numberOfChunks - 1);
+
+  data->chunkSizes[_chunk] = -1;
+  data->checksums[_chunk] = adler32(adler32(0L, Z_NULL, 0),
+                                    data->source + start, (uInt)length);
+
+  z_stream z;
+  z.zalloc  = (alloc_func)0;
+  z.zfree   = (free_func)0;
+  z.opaque  = (voidpf)0;
+
+  // Raw deflate: the zlib header and checksum are written once for the
+  // whole stream by MET_PerformChunkedCompression.
+  if(deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                  Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+    return;
+    }
+
+  // The sync flush ending the intermediate chunks adds a few bytes
+  // to the bound
+  uLong bufferSize = deflateBound(&z, (uLong)length) + 64;
+  unsigned char * buffer = new unsigned char[bufferSize];
+
+  z.next_in   = const_cast<unsigned char *>(data->source + start);
+  z.avail_in  = (uInt)length;
+  z.next_out  = buffer;
+  z.avail_out = (uInt)bufferSize;
+
+  // A fresh deflate state per chunk means no back-reference crosses a chunk
+  // boundary, and the sync flush byte-aligns the end of every chunk but the
+  // last, so each chunk can be inflated on its own.
+  int err = deflate(&z, lastChunk ? Z_FINISH : Z_SYNC_FLUSH);
+  bool ok = lastChunk ? (err == Z_STREAM_END)
+                      : (err == Z_OK && z.avail_in == 0 && z.avail_out > 0);
+  deflateEnd(&z);
+
+  if(!ok)
+    {
+    delete [] buffer;
+    return;
+    }
+
+  data->chunks[_chunk] = buffer;
+  data->chunkSizes[_chunk] = bufferSize - z.avail_out;
+  }
+
+//
+//
+//
+unsigned char * MET_PerformChunkedCompression(const unsigned char * source,
+                          METAIO_STL::streamoff sourceSize,
+                          METAIO_STL::streamoff chunkSize,
+                          METAIO_STL::streamoff * compressedDataSize,
+                          METAIO_STL::streamoff * chunkTableSize,
+                          MET_ParallelForFunctionType parallelFor,
+                          void * clientData)
+  {
+  if(chunkSize <= 0)
+    {
+    return NULL;
+    }
+
+  MET_ChunkedCompressionDataType data;
+  data.source = source;
+  data.sourceSize = sourceSize;
+  data.chunkSize = chunkSize;
+  data.numberOfChunks = MET_GetNumberOfCompressedChunks(sourceSize, chunkSize);
+  data.chunks.resize(data.numberOfChunks, NULL);
+  data.chunkSizes.resize(data.numberOfChunks, -1);
+  data.checksums.resize(data.numberOfChunks, 0);
+
+  MET_RunTasks(MET_CompressChunk, &data, data.numberOfChunks,
+               parallelFor, clientData);
+
+  // zlib header, chunks and adler32 checksum of the whole data
+  METAIO_STL::streamoff streamSize = 2 + 4;
+  bool ok = true;
+  int i;
+  for(i=0; i<data.numberOfChunks; i++)
+    {
+    if(data.chunkSizes[i] < 0)
+      {
+      ok = false;
+      }
+    streamSize += data.chunkSizes[i];
+    }
+
+  unsigned char * compressedData = NULL;
+  if(ok)
+    {
+    const METAIO_STL::streamoff tableSize = 8 * (data.numberOfChunks + 1);
+    compressedData = new unsigned char[streamSize + tableSize];
+    unsigned char * table = compressedData + streamSize;
+
+    // Deflate, 32K window, default compression level
+    compressedData[0] = 0x78;
+    compressedData[1] = 0x9c;
+
+    METAIO_STL::streamoff pos = 2;
+    uLong checksum = data.checksums[0];
+    for(i=0; i<data.numberOfChunks; i++)
+      {
+      MET_WriteChunkOffset(table + 8*i, pos);
+      memcpy(compressedData + pos, data.chunks[i],
+             (size_t)data.chunkSizes[i]);
+      pos += data.chunkSizes[i];
+      if(i > 0)
+        {
+        METAIO_STL::streamoff length = sourceSize - i * chunkSize;
+        if(length > chunkSize)
+          {
+          length = chunkSize;
+          }
+        checksum = adler32_combine(checksum, data.checksums[i],
+                                   (z_off_t)length);
+        }
+      }
+    MET_WriteChunkOffset(table + 8*data.numberOfChunks, pos);
+
+    compressedData[pos++] = static_cast<unsigned char>((checksum >> 24) & 0xff);
+    compressedData[pos++] = static_cast<unsigned char>((checksum >> 16) & 0xff);
+    compressedData[pos++] = static_cast<unsigned char>((checksum >> 8) & 0xff);
+    compressedData[pos++] = static_cast<unsigned char>(checksum & 0xff);
+
+    *compressedDataSize = streamSize;
+    *chunkTableSize = tableSize;
+    }
+
+  for(i=0; i<data.numberOfChunks; i++)
+    {
+    delete [] data.chunks[i];
+    }
+
+  return compressedData;
+  }
+
+//
+//
+//
+bool MET_DecodeChunkTable(const unsigned char * chunkTable,
+                          int numberOfChunks,
+                          METAIO_STL::streamoff compressedDataSize,
+                          METAIO_STL::vector<METAIO_STL::streamoff> & chunkOffsets)
+  {
+  chunkOffsets.resize(numberOfChunks + 1);
+  for(int i=0; i<=numberOfChunks; i++)
+    {
+    chunkOffsets[i] = MET_ReadChunkOffset(chunkTable + 8*i);
+    if(i > 0 && chunkOffsets[i] <= chunkOffsets[i-1])
+      {
+      return false;
+      }
+    }
+
+  // The table must describe the stream it follows
+  if(chunkOffsets[0] != 2)
+    {
+    return false;
+    }
+  if(compressedDataSize > 0
+     && chunkOffsets[numberOfChunks] + 4 != compressedDataSize)
+    {
+    return false;
+    }
+
+  return true;
+  }
+
+typedef struct MET_ChunkedUncompressionData
+  {
+  const unsigned char *                             source;
+  const METAIO_STL::vector<METAIO_STL::streamoff> * chunkOffsets;
+  METAIO_STL::streamoff                             chunkSize;
+  METAIO_STL::streamoff                             totalSize;
+  METAIO_STL::streamoff                             seekPosition;
+  METAIO_STL::streamoff                             size;
+  unsigned char *                                   destination;
+  int                                               firstChunk;
+  METAIO_STL::vector<char>                          ok;
+  } MET_ChunkedUncompressionDataType;
+
+static void MET_UncompressChunk(void * _taskData, int _task)
+  {
+  MET_ChunkedUncompressionDataType * data =
+    static_cast<MET_ChunkedUncompressionDataType *>(_taskData);
+  const METAIO_STL::vector<METAIO_STL::streamoff> & offsets =
+    *(data->chunkOffsets);
+
+  const int chunk = data->firstChunk + _task;
+  const METAIO_STL::streamoff chunkStart = chunk * data->chunkSize;
+  METAIO_STL::streamoff chunkLength = data->totalSize - chunkStart;
+  if(chunkLength > data->chunkSize)
+    {
+    chunkLength = data->chunkSize;
+    }
+
+  // Part of the chunk that is requested
+  METAIO_STL::streamoff begin = chunkStart;
+  if(begin < data->seekPosition)
+    {
+    begin = data->seekPosition;
+    }
+  METAIO_STL::streamoff end = chunkStart + chunkLength;
+  if(end > data->seekPosition + data->size)
+    {
+    end = data->seekPosition + data->size;
+    }
+
+  const bool direct = (begin == chunkStart && end == chunkStart + chunkLength);
+  unsigned char * output = direct
+    ? data->destination + (chunkStart - data->seekPosition)
+    : new unsigned char[chunkLength];
+
+  z_stream d_stream;
+  d_stream.zalloc = (alloc_func)0;
+  d_stream.zfree = (free_func)0;
+  d_stream.opaque = (voidpf)0;
+
+  bool ok = false;
+  if(inflateInit2(&d_stream, -MAX_WBITS) == Z_OK)
+    {
+    d_stream.next_in = const_cast<unsigned char *>(data->source
+      + (offsets[chunk] - offsets[data->firstChunk]));
+    d_stream.avail_in = (uInt)(offsets[chunk+1] - offsets[chunk]);
+    d_stream.next_out = output;
+    d_stream.avail_out = (uInt)chunkLength;
+
+    int err = inflate(&d_stream, Z_NO_FLUSH);
+    ok = d_stream.avail_out == 0
+         && (err == Z_OK || err == Z_STREAM_END || err == Z_BUF_ERROR);
+    inflateEnd(&d_stream);
+    }
+
+  if(!direct)
+    {
+    if(ok)
+      {
+      memcpy(data->destination + (begin - data->seekPosition),
+             output + (begin - chunkStart), (size_t)(end - begin));
+      }
+    delete [] output;
+    }
+
+  data->ok[_task] = ok;
+  }
+
+//
+//
+//
+bool MET_PerformChunkedUncompression(const unsigned char * sourceCompressed,
+                          const METAIO_STL::vector<METAIO_STL::streamoff> & chunkOffsets,
+                          METAIO_STL::streamoff chunkSize,
+                          METAIO_STL::streamoff totalUncompressedDataSize,
+                          METAIO_STL::streamoff uncompressedSeekPosition,
+                          unsigned char * uncompressedData,
+                          METAIO_STL::streamoff uncompressedDataSize,
+                          MET_ParallelForFunctionType parallelFor,
+                          void * clientData)
+  {
+  if(uncompressedDataSize <= 0)
+    {
+    return true;
+    }
+  if(chunkSize <= 0
+     || uncompressedSeekPosition < 0
+     || uncompressedSeekPosition + uncompressedDataSize
+        > totalUncompressedDataSize)
+    {
+    return false;
+    }
+
+  const int numberOfChunks =
+    MET_GetNumberOfCompressedChunks(totalUncompressedDataSize, chunkSize);
+  if(static_cast<int>(chunkOffsets.size()) != numberOfChunks + 1)
+    {
+    return false;
+    }
+
+  MET_ChunkedUncompressionDataType data;
+  data.source = sourceCompressed;
+  data.chunkOffsets = &chunkOffsets;
+  data.chunkSize = chunkSize;
+  data.totalSize = totalUncompressedDataSize;
+  data.seekPosition = uncompressedSeekPosition;
+  data.size = uncompressedDataSize;
+  data.destination = uncompressedData;
+  data.firstChunk = static_cast<int>(uncompressedSeekPosition / chunkSize);
+
+  const int lastChunk = static_cast<int>(
+    (uncompressedSeekPosition + uncompressedDataSize - 1) / chunkSize);
+  const int numberOfTasks = lastChunk - data.firstChunk + 1;
+  data.ok.resize(numberOfTasks, 0);
+
+  MET_RunTasks(MET_UncompressChunk, &data, numberOfTasks,
+               parallelFor, clientData);
+
+  for(int i=0; i<numberOfTasks; i++)
+    {
+    if(!data.ok[i])
+      {
+      METAIO_STREAM::cerr << "Uncompress failed" << METAIO_STREAM::endl;
+      return false;
+      }
+    }
+
+  return true;
+  }
+
 //
 //
 //
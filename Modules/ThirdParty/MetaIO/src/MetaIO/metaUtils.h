@@ -78,6 +78,17 @@ typedef struct MET_CompressionTable
   METAIO_STL::streamoff bufferSize;
   } MET_CompressionTableType;
 
+// Hook used to run independent tasks (e.g. the chunks of a chunked
+// compressed stream) concurrently.  The function must call
+// _task(_taskData, i) exactly once for every i in [0, _numberOfTasks).
+// When no hook is given, the tasks are run in order on the calling thread.
+typedef void (*MET_TaskFunctionType)(void * _taskData, int _taskId);
+
+typedef void (*MET_ParallelForFunctionType)(MET_TaskFunctionType _task,
+                                            void * _taskData,
+                                            int _numberOfTasks,
+                                            void * _clientData);
+
 /////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////
 METAIO_EXPORT MET_FieldRecordType *
@@ -320,6 +331,50 @@ METAIO_STL::streamoff MET_UncompressStream(METAIO_STREAM::ifstream * stream,
                           METAIO_STL::streamoff compressedDataSize,
                           MET_CompressionTableType * compressionTable);
 
+// Chunked compression: the data is split in chunks of _chunkSize
+// uncompressed bytes that are deflated independently and concatenated
+// into a single valid zlib stream, so readers unaware of the chunks can
+// still inflate it in one pass.  The returned buffer holds the zlib stream
+// (*compressedDataSize bytes) followed by the chunk offset table
+// (*chunkTableSize bytes): one little endian 64 bit offset per chunk,
+// relative to the start of the stream, plus the offset of the stream
+// checksum.
+METAIO_EXPORT
+int MET_GetNumberOfCompressedChunks(METAIO_STL::streamoff uncompressedDataSize,
+                                    METAIO_STL::streamoff chunkSize);
+
+METAIO_EXPORT
+unsigned char * MET_PerformChunkedCompression(const unsigned char * source,
+                          METAIO_STL::streamoff sourceSize,
+                          METAIO_STL::streamoff chunkSize,
+                          METAIO_STL::streamoff * compressedDataSize,
+                          METAIO_STL::streamoff * chunkTableSize,
+                          MET_ParallelForFunctionType parallelFor = NULL,
+                          void * clientData = NULL);
+
+// Decode and validate a chunk offset table read from disk.  _chunkOffsets
+// receives numberOfChunks+1 offsets.
+METAIO_EXPORT
+bool MET_DecodeChunkTable(const unsigned char * chunkTable,
+                          int numberOfChunks,
+                          METAIO_STL::streamoff compressedDataSize,
+                          METAIO_STL::vector<METAIO_STL::streamoff> & chunkOffsets);
+
+// Inflate the uncompressed range [uncompressedSeekPosition,
+// uncompressedSeekPosition+uncompressedDataSize) of a chunked stream.
+// sourceCompressed holds the stream bytes starting at the offset of the
+// first chunk overlapping the range.
+METAIO_EXPORT
+bool MET_PerformChunkedUncompression(const unsigned char * sourceCompressed,
+                          const METAIO_STL::vector<METAIO_STL::streamoff> & chunkOffsets,
+                          METAIO_STL::streamoff chunkSize,
+                          METAIO_STL::streamoff totalUncompressedDataSize,
+                          METAIO_STL::streamoff uncompressedSeekPosition,
+                          unsigned char * uncompressedData,
+                          METAIO_STL::streamoff uncompressedDataSize,
+                          MET_ParallelForFunctionType parallelFor = NULL,
+                          void * clientData = NULL);
+
 
 /////////////////////////////////////////////////////////
 // FILES NAMES
@@ -947,6 +947,7 @@ enum {
   nrrdIoStateZlibLevel,
   nrrdIoStateZlibStrategy,
   nrrdIoStateBzip2BlockSize,
+  nrrdIoStateZlibChunkSize,
   nrrdIoStateLast
 };
 
@@ -1792,6 +1793,20 @@ typedef struct NrrdEncoding_t {
                const Nrrd *nrrd, struct NrrdIoState_t *nio);
 } NrrdEncoding;
 
+/*
+******** nrrdTask, nrrdParallelFor
+**
+** hook with which the caller can run independent tasks (currently, the
+** (de)compression of the members of chunked gzip data, see zlibChunkSize
+** in NrrdIoState) concurrently.  A nrrdParallelFor must call
+** task(taskData, ti) exactly once for every ti in [0, taskNum), and
+** return when all of them are done.  NrrdIO itself has no threads; when
+** no hook is given, the tasks are run in order.
+*/
+typedef void (*nrrdTask)(void *taskData, unsigned int taskIdx);
+typedef void (*nrrdParallelFor)(nrrdTask task, void *taskData,
+                                unsigned int taskNum, void *clientData);
+
 /*
 ******** NrrdIoState struct
 **
@@ -1918,12 +1933,25 @@ typedef struct NrrdIoState_t {
     bzip2BlockSize,         /* block size used for compression, 
                                roughly equivalent to better but slower
                                (1-9, -1 for default[9]). */
+    zlibChunkSize,          /* ON WRITE: if > 0, gzip data is written as
+                               a series of gzip members, each holding
+                               this many uncompressed bytes (the last
+                               may hold fewer) and recording its own
+                               size in an "NC" extra field, so that the
+                               members can be compressed and, ON READ,
+                               found and decompressed independently.
+                               Any gzip reader reads the result as one
+                               stream.  Default 0: a single member. */
     learningHeaderStrlen;   /* ON WRITE, for nrrds, learn and save the total
                                length of header into headerStrlen. This is
                                used to allocate a buffer for header */
   void *oldData;            /* ON READ: if non-NULL, pointer to space that 
                                has already been allocated for oldDataSize */
   size_t oldDataSize;       /* ON READ: size of mem pointed to by oldData */
+  nrrdParallelFor parallelFor; /* if non-NULL, runs the independent tasks of
+                               chunked gzip data (see zlibChunkSize),
+                               ON READ and ON WRITE */
+  void *parallelForData;    /* passed as clientData to parallelFor */
 
   /* The format and encoding.  These are initialized to nrrdFormatUnknown
      and nrrdEncodingUnknown, respectively. USE THESE VALUES for 
@@ -31,6 +31,387 @@ typedef union {
 } ptrHack;
 
 
+#if TEEM_ZLIB
+/*
+** Chunked gzip data (see zlibChunkSize in NrrdIoState) is a series of
+** gzip members, each starting with a 10 byte gzip header with only the
+** FEXTRA flag set, followed by an extra field holding a single "NC"
+** subfield:
+**
+**   XLEN (2 bytes) = 12, 'N', 'C', LEN (2 bytes) = 8,
+**   member size (4 bytes), uncompressed size (4 bytes)
+**
+** then by the raw deflate data, the CRC32 and the uncompressed size.
+** All the numbers are little endian, and the member size counts the
+** whole member.  Knowing where every member starts, the members can
+** be decompressed independently, while gzip readers unaware of the
+** subfield simply read the members one after the other.
+*/
+#define _NRRD_GZ_CHUNK_HEADER  24  /* gzip header, XLEN, "NC" subfield */
+#define _NRRD_GZ_CHUNK_TRAILER  8  /* CRC32 and uncompressed size */
+
+typedef struct {
+  const unsigned char *raw;     /* all the uncompressed data */
+  size_t rawSize,               /* its size */
+    chunkSize;                  /* uncompressed bytes per member */
+  int level, strategy;          /* deflate parameters */
+  unsigned char **member;       /* the compressed members */
+  size_t *memberSize;           /* their sizes */
+} _nrrdGzChunkWriteData;
+
+typedef struct {
+  unsigned char *raw;           /* where to decompress the data */
+  size_t rawSize,
+    chunkSize;
+  const unsigned char *compr;   /* all the members */
+  size_t *memberOffset,         /* where they start in compr */
+    *memberSize;
+  int *ok;                      /* whether each one was decompressed */
+} _nrrdGzChunkReadData;
+
+static void
+_nrrdGzChunkPutLong(unsigned char *buff, size_t val) {
+  unsigned int bi;
+
+  for (bi=0; bi<4; bi++) {
+    buff[bi] = AIR_CAST(unsigned char, (val >> 8*bi) & 0xff);
+  }
+}
+
+static size_t
+_nrrdGzChunkGetLong(const unsigned char *buff) {
+  
+  return (AIR_CAST(size_t, buff[0])
+          | AIR_CAST(size_t, buff[1]) << 8
+          | AIR_CAST(size_t, buff[2]) << 16
+          | AIR_CAST(size_t, buff[3]) << 24);
+}
+
+static void
+_nrrdGzChunkRun(nrrdTask task, void *data, unsigned int taskNum,
+                NrrdIoState *nio) {
+  unsigned int ti;
+
+  if (nio->parallelFor && taskNum > 1) {
+    nio->parallelFor(task, data, taskNum, nio->parallelForData);
+  } else {
+    for (ti=0; ti<taskNum; ti++) {
+      task(data, ti);
+    }
+  }
+}
+
+static size_t
+_nrrdGzChunkRawSize(size_t rawSize, size_t chunkSize, unsigned int ci) {
+  size_t start;
+
+  start = chunkSize*ci;
+  return AIR_MIN(chunkSize, rawSize - start);
+}
+
+/*
+** compresses member ci; leaves member[ci] NULL if that fails.  Runs
+** concurrently with the other members, so no biff here
+*/
+static void
+_nrrdGzChunkCompress(void *_data, unsigned int ci) {
+  _nrrdGzChunkWriteData *data;
+  const unsigned char *raw;
+  unsigned char *member;
+  size_t rawSize, bound, memberSize;
+  z_stream zs;
+  int ret;
+
+  data = AIR_CAST(_nrrdGzChunkWriteData *, _data);
+  raw = data->raw + data->chunkSize*ci;
+  rawSize = _nrrdGzChunkRawSize(data->rawSize, data->chunkSize, ci);
+
+  zs.zalloc = Z_NULL;
+  zs.zfree = Z_NULL;
+  zs.opaque = Z_NULL;
+  /* raw deflate: the gzip header and trailer are written here */
+  if (Z_OK != deflateInit2(&zs, data->level, Z_DEFLATED, -MAX_WBITS, 8,
+                           data->strategy)) {
+    return;
+  }
+  bound = deflateBound(&zs, AIR_CAST(uLong, rawSize));
+  member = AIR_CAST(unsigned char *, malloc(_NRRD_GZ_CHUNK_HEADER + bound
+                                            + _NRRD_GZ_CHUNK_TRAILER));
+  if (!member) {
+    deflateEnd(&zs);
+    return;
+  }
+  zs.next_in = AIR_CAST(Bytef *, raw);
+  zs.avail_in = AIR_CAST(uInt, rawSize);
+  zs.next_out = member + _NRRD_GZ_CHUNK_HEADER;
+  zs.avail_out = AIR_CAST(uInt, bound);
+  ret = deflate(&zs, Z_FINISH);
+  deflateEnd(&zs);
+  if (Z_STREAM_END != ret) {
+    free(member);
+    return;
+  }
+  memberSize = (_NRRD_GZ_CHUNK_HEADER + bound - zs.avail_out
+                + _NRRD_GZ_CHUNK_TRAILER);
+
+  member[0] = 0x1f;             /* gzip magic */
+  member[1] = 0x8b;
+  member[2] = Z_DEFLATED;
+  member[3] = 0x04;             /* FEXTRA */
+  memset(member + 4, 0, 4);     /* no modification time */
+  member[8] = 0;                /* no extra flags */
+  member[9] = 0xff;             /* unknown OS */
+  member[10] = 12;              /* XLEN */
+  member[11] = 0;
+  member[12] = 'N';
+  member[13] = 'C';
+  member[14] = 8;               /* LEN */
+  member[15] = 0;
+  _nrrdGzChunkPutLong(member + 16, memberSize);
+  _nrrdGzChunkPutLong(member + 20, rawSize);
+  _nrrdGzChunkPutLong(member + memberSize - _NRRD_GZ_CHUNK_TRAILER,
+                      crc32(crc32(0L, Z_NULL, 0), raw,
+                            AIR_CAST(uInt, rawSize)));
+  _nrrdGzChunkPutLong(member + memberSize - 4, rawSize);
+
+  data->member[ci] = member;
+  data->memberSize[ci] = memberSize;
+}
+
+static int
+_nrrdGzChunkedWrite(FILE *file, const void *_data, size_t sizeData,
+                    NrrdIoState *nio) {
+  static const char me[]="_nrrdGzChunkedWrite";
+  _nrrdGzChunkWriteData data;
+  size_t chunkNum;
+  unsigned int ci;
+  int error;
+
+  data.raw = AIR_CAST(const unsigned char *, _data);
+  data.rawSize = sizeData;
+  data.chunkSize = AIR_CAST(size_t, nio->zlibChunkSize);
+  chunkNum = sizeData ? (sizeData + data.chunkSize - 1)/data.chunkSize : 1;
+  if (chunkNum > UINT_MAX) {
+    biffAddf(NRRD, "%s: zlibChunkSize %d too small for " _AIR_SIZE_T_CNV
+             " bytes", me, nio->zlibChunkSize, sizeData);
+    return 1;
+  }
+  data.level = (AIR_IN_CL(0, nio->zlibLevel, 9)
+                ? nio->zlibLevel
+                : Z_DEFAULT_COMPRESSION);
+  switch (nio->zlibStrategy) {
+  case nrrdZlibStrategyHuffman:
+    data.strategy = Z_HUFFMAN_ONLY;
+    break;
+  case nrrdZlibStrategyFiltered:
+    data.strategy = Z_FILTERED;
+    break;
+  case nrrdZlibStrategyDefault:
+  default:
+    data.strategy = Z_DEFAULT_STRATEGY;
+    break;
+  }
+  data.member = AIR_CAST(unsigned char **,
+                         calloc(chunkNum, sizeof(unsigned char *)));
+  data.memberSize = AIR_CAST(size_t *, calloc(chunkNum, sizeof(size_t)));
+  if (!( data.member && data.memberSize )) {
+    biffAddf(NRRD, "%s: couldn't allocate " _AIR_SIZE_T_CNV " members",
+             me, chunkNum);
+    airFree(data.member);
+    airFree(data.memberSize);
+    return 1;
+  }
+
+  _nrrdGzChunkRun(_nrrdGzChunkCompress, &data,
+                  AIR_CAST(unsigned int, chunkNum), nio);
+
+  /* the members are written in order once they are all compressed */
+  error = 0;
+  for (ci=0; ci<chunkNum; ci++) {
+    if (!data.member[ci]) {
+      biffAddf(NRRD, "%s: couldn't compress member %u of " _AIR_SIZE_T_CNV,
+               me, ci, chunkNum);
+      error = 1;
+      break;
+    }
+    if (fwrite(data.member[ci], 1, data.memberSize[ci], file)
+        != data.memberSize[ci]) {
+      biffAddf(NRRD, "%s: couldn't write member %u of " _AIR_SIZE_T_CNV,
+               me, ci, chunkNum);
+      error = 1;
+      break;
+    }
+  }
+  for (ci=0; ci<chunkNum; ci++) {
+    airFree(data.member[ci]);
+  }
+  airFree(data.member);
+  airFree(data.memberSize);
+  return error;
+}
+
+/*
+** decompresses member ci into its place in the data.  Runs
+** concurrently with the other members, so no biff here
+*/
+static void
+_nrrdGzChunkDecompress(void *_data, unsigned int ci) {
+  _nrrdGzChunkReadData *data;
+  const unsigned char *member;
+  unsigned char *raw;
+  size_t rawSize, memberSize;
+  z_stream zs;
+  int ret;
+
+  data = AIR_CAST(_nrrdGzChunkReadData *, _data);
+  member = data->compr + data->memberOffset[ci];
+  memberSize = data->memberSize[ci];
+  raw = data->raw + data->chunkSize*ci;
+  rawSize = _nrrdGzChunkRawSize(data->rawSize, data->chunkSize, ci);
+  data->ok[ci] = AIR_FALSE;
+
+  zs.zalloc = Z_NULL;
+  zs.zfree = Z_NULL;
+  zs.opaque = Z_NULL;
+  zs.next_in = Z_NULL;
+  zs.avail_in = 0;
+  if (Z_OK != inflateInit2(&zs, -MAX_WBITS)) {
+    return;
+  }
+  zs.next_in = AIR_CAST(Bytef *, member + _NRRD_GZ_CHUNK_HEADER);
+  zs.avail_in = AIR_CAST(uInt, memberSize - _NRRD_GZ_CHUNK_HEADER
+                         - _NRRD_GZ_CHUNK_TRAILER);
+  zs.next_out = raw;
+  zs.avail_out = AIR_CAST(uInt, rawSize);
+  ret = inflate(&zs, Z_FINISH);
+  inflateEnd(&zs);
+  data->ok[ci] = (Z_STREAM_END == ret
+                  && !zs.avail_out
+                  && (_nrrdGzChunkGetLong(member + memberSize
+                                          - _NRRD_GZ_CHUNK_TRAILER)
+                      == (crc32(crc32(0L, Z_NULL, 0), raw,
+                                AIR_CAST(uInt, rawSize)) & 0xffffffff))
+                  && (_nrrdGzChunkGetLong(member + memberSize - 4)
+                      == rawSize));
+}
+
+/*
+** reads sizeData bytes of chunked gzip data starting at the current
+** position of the file.  Returns -1, with the file position unchanged,
+** if the data there is not chunked gzip data holding sizeData bytes;
+** 0 once the data has been read; 1 on error
+*/
+static int
+_nrrdGzChunkedRead(FILE *file, void *_data, size_t sizeData,
+                   NrrdIoState *nio) {
+  static const char me[]="_nrrdGzChunkedRead";
+  _nrrdGzChunkReadData data;
+  unsigned char header[_NRRD_GZ_CHUNK_HEADER];
+  size_t chunkNum, comprSize, rawSize;
+  unsigned int ci;
+  long int start;
+  int error;
+
+  start = ftell(file);
+  if (start < 0) {
+    return -1;
+  }
+
+  /* all members but the last hold as many bytes as the first one */
+  data.raw = AIR_CAST(unsigned char *, _data);
+  data.rawSize = sizeData;
+  data.chunkSize = 0;
+  data.compr = NULL;
+  data.memberOffset = data.memberSize = NULL;
+  data.ok = NULL;
+  chunkNum = 1;
+  comprSize = 0;
+  error = -1;
+  for (ci=0; ci<chunkNum; ci++) {
+    if (fseek(file, start + AIR_CAST(long int, comprSize), SEEK_SET)
+        || fread(header, 1, _NRRD_GZ_CHUNK_HEADER, file)
+           != _NRRD_GZ_CHUNK_HEADER
+        || !( 0x1f == header[0] && 0x8b == header[1]
+              && Z_DEFLATED == header[2] && 0x04 == header[3]
+              && 12 == header[10] && 0 == header[11]
+              && 'N' == header[12] && 'C' == header[13]
+              && 8 == header[14] && 0 == header[15] )) {
+      break;
+    }
+    rawSize = _nrrdGzChunkGetLong(header + 20);
+    if (!ci) {
+      if (rawSize > sizeData || (!rawSize && sizeData)) {
+        break;
+      }
+      data.chunkSize = rawSize;
+      chunkNum = (sizeData
+                  ? (sizeData + data.chunkSize - 1)/data.chunkSize
+                  : 1);
+      if (chunkNum > UINT_MAX) {
+        break;
+      }
+      data.memberOffset = AIR_CAST(size_t *, calloc(chunkNum,
+                                                    sizeof(size_t)));
+      data.memberSize = AIR_CAST(size_t *, calloc(chunkNum, sizeof(size_t)));
+      data.ok = AIR_CAST(int *, calloc(chunkNum, sizeof(int)));
+      if (!( data.memberOffset && data.memberSize && data.ok )) {
+        biffAddf(NRRD, "%s: couldn't allocate " _AIR_SIZE_T_CNV " members",
+                 me, chunkNum);
+        error = 1;
+        break;
+      }
+    } else if (rawSize != _nrrdGzChunkRawSize(sizeData, data.chunkSize, ci)) {
+      break;
+    }
+    data.memberOffset[ci] = comprSize;
+    data.memberSize[ci] = _nrrdGzChunkGetLong(header + 16);
+    if (data.memberSize[ci] < (_NRRD_GZ_CHUNK_HEADER
+                               + _NRRD_GZ_CHUNK_TRAILER)) {
+      break;
+    }
+    comprSize += data.memberSize[ci];
+  }
+
+  if (ci == chunkNum) {
+    /* found all the members, read them at once */
+    data.compr = AIR_CAST(unsigned char *, malloc(comprSize));
+    if (!data.compr) {
+      biffAddf(NRRD, "%s: couldn't allocate " _AIR_SIZE_T_CNV " bytes",
+               me, comprSize);
+      error = 1;
+    } else if (fseek(file, start, SEEK_SET)
+               || fread(AIR_CAST(void *, data.compr), 1, comprSize, file)
+                  != comprSize) {
+      biffAddf(NRRD, "%s: couldn't read " _AIR_SIZE_T_CNV
+               " bytes of compressed data", me, comprSize);
+      error = 1;
+    } else {
+      _nrrdGzChunkRun(_nrrdGzChunkDecompress, &data,
+                      AIR_CAST(unsigned int, chunkNum), nio);
+      error = 0;
+      for (ci=0; ci<chunkNum; ci++) {
+        if (!data.ok[ci]) {
+          biffAddf(NRRD, "%s: couldn't decompress member %u of "
+                   _AIR_SIZE_T_CNV, me, ci, chunkNum);
+          error = 1;
+          break;
+        }
+      }
+    }
+  }
+  if (-1 == error) {
+    /* not chunked: leave the data to the gzFile */
+    fseek(file, start, SEEK_SET);
+  }
+
+  airFree(AIR_CAST(void *, data.compr));
+  airFree(data.memberOffset);
+  airFree(data.memberSize);
+  airFree(data.ok);
+  return error;
+}
+#endif
+
 int
 _nrrdEncodingGzip_available(void) {
 
@@ -58,6 +439,17 @@ _nrrdEncodingGzip_read(FILE *file, void *_data, size_t elNum,
   ptrHack hack;
 
   sizeData = nrrdElementSize(nrrd)*elNum;
+  if (!nio->byteSkip) {
+    /* chunked gzip data is decompressed one member per task */
+    error = _nrrdGzChunkedRead(file, _data, sizeData, nio);
+    if (1 == error) {
+      biffAddf(NRRD, "%s: error reading chunked gzip data", me);
+      return 1;
+    }
+    if (!error) {
+      return 0;
+    }
+  }
   /* Create the gzFile for reading in the gzipped data. */
   if ((gzfin = _nrrdGzOpen(file, "rb")) == Z_NULL) {
     /* there was a problem */
@@ -201,6 +593,14 @@ _nrrdEncodingGzip_write(FILE *file, const void *_data, size_t elNum,
   unsigned int wrote;
   
   sizeData = nrrdElementSize(nrrd)*elNum;
+  if (nio->zlibChunkSize > 0) {
+    /* members are compressed one per task */
+    if (_nrrdGzChunkedWrite(file, _data, sizeData, nio)) {
+      biffAddf(NRRD, "%s: error writing chunked gzip data", me);
+      return 1;
+    }
+    return 0;
+  }
 
   /* Set format string based on the NrrdIoState parameters. */
   fmt[fmt_i++] = 'w';
@@ -95,9 +95,12 @@ nrrdIoStateInit(NrrdIoState *nio) {
     nio->zlibLevel = -1;
     nio->zlibStrategy = nrrdZlibStrategyDefault;
     nio->bzip2BlockSize = -1;
+    nio->zlibChunkSize = 0;
     nio->learningHeaderStrlen = AIR_FALSE;
     nio->oldData = NULL;
     nio->oldDataSize = 0;
+    nio->parallelFor = NULL;
+    nio->parallelForData = NULL;
     nio->format = nrrdFormatUnknown;
     nio->encoding = nrrdEncodingUnknown;
   }
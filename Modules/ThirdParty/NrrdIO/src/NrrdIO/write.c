@@ -92,6 +92,13 @@ nrrdIoStateSet(NrrdIoState *nio, int parm, int value) {
     }
     nio->bzip2BlockSize = value;
     break;
+  case nrrdIoStateZlibChunkSize:
+    if (value < 0) {
+      biffAddf(NRRD, "%s: zlibChunkSize %d invalid", me, value);
+      return 1;
+    }
+    nio->zlibChunkSize = value;
+    break;
   default:
     fprintf(stderr, "!%s: PANIC: didn't recognize parm %d\n", me, parm);
     exit(1);
@@ -185,6 +192,9 @@ nrrdIoStateGet(NrrdIoState *nio, int parm) {
   case nrrdIoStateBzip2BlockSize:
     value = nio->bzip2BlockSize;
     break;
+  case nrrdIoStateZlibChunkSize:
+    value = nio->zlibChunkSize;
+    break;
   default:
     fprintf(stderr, "!%s: PANIC: didn't recognize parm %d\n", me, parm);
     exit(1);